@@ -0,0 +1,90 @@
+// Scaling benchmark of CollisionBatch: sweeps the same batch of spheres against a random mesh
+// with 1..N threads and reports throughput and speedup relative to one thread.
+//
+// usage: batch_benchmark [max_threads [queries_count [triangles_count]]]
+
+#include "../Collisions/collision_batch.h"
+#include "../Collisions/mesh_bvh.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace Collisions;
+
+namespace
+{
+    double random_double(double from, double to)
+    {
+        return from + (to - from)*rand()/RAND_MAX;
+    }
+
+    Point random_point(double size)
+    {
+        return Point( random_double(-size, size), random_double(-size, size), random_double(-size, size) );
+    }
+
+    const unsigned REPEATS = 5; // the best of repeats is reported
+}
+
+int main(int argc, char *argv[])
+{
+    const unsigned max_threads = argc > 1 ? atoi( argv[1] ) : std::max( 1u, std::thread::hardware_concurrency() );
+    const unsigned queries_count = argc > 2 ? atoi( argv[2] ) : 50000;
+    const unsigned triangles_count = argc > 3 ? atoi( argv[3] ) : 20000;
+    const double size = 100;
+
+    srand(1);
+    std::vector<Triangle> triangles;
+    for( unsigned i = 0; i < triangles_count; ++i )
+    {
+        const Point center = random_point(size);
+        triangles.push_back( Triangle( center + random_point(2), center + random_point(2), center + random_point(2) ) );
+    }
+    const MeshBVH mesh( triangles );
+
+    std::vector<SweepQuery> queries;
+    for( unsigned i = 0; i < queries_count; ++i )
+    {
+        const Point start = random_point(size);
+        queries.push_back( SweepQuery( start, start + random_point(size/10), random_double(0.1, 2) ) );
+    }
+
+    printf( "%u queries against %u triangles\n", queries_count, triangles_count );
+    printf( "%8s %16s %10s %10s\n", "threads", "queries/sec", "speedup", "hit rate" );
+
+    double single_thread_rate = 0;
+    std::vector<BatchResult> results;
+    for( unsigned threads = 1; threads <= max_threads; ++threads )
+    {
+        CollisionBatch batch( threads );
+        double best_seconds = 0;
+        for( unsigned repeat = 0; repeat < REPEATS; ++repeat )
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            batch.sweep_sphere( mesh, queries, results );
+            const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            if( repeat == 0 || seconds < best_seconds )
+            {
+                best_seconds = seconds;
+            }
+        }
+
+        unsigned hits = 0;
+        for( unsigned i = 0; i < results.size(); ++i )
+        {
+            if( results[i].status == CollisionStatus::Hit )
+            {
+                ++hits;
+            }
+        }
+
+        const double rate = queries_count/best_seconds;
+        if( threads == 1 )
+        {
+            single_thread_rate = rate;
+        }
+        printf( "%8u %16.0f %9.2fx %9.1f%%\n", threads, rate, rate/single_thread_rate, 100.0*hits/queries_count );
+    }
+    return 0;
+}
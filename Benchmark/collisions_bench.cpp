@@ -0,0 +1,1116 @@
+// Microbenchmarks of every public function of the library on fixed-seed random workloads.
+// For each function and scenario reports ns/call, calls/sec and hit rate (the share of calls
+// returning true, for predicates and collision finders). Sphere and triangle collisions are
+// measured separately for queries resolved by the plane, an edge, a vertex, and for misses.
+//
+// usage: collisions_bench [--json <file>] [--min-time <seconds>] [--filter <substring>]
+
+#include "../Collisions/collisions.h"
+#include "../Collisions/triangle_soup.h"
+#include "../Collisions/mesh_bvh.h"
+#include "../Collisions/indexed_mesh.h"
+#include "../Collisions/mapped_mesh.h"
+#include "../Collisions/mesh_import.h"
+#include "../Collisions/instance_bvh.h"
+#include "../Collisions/sphere_packet.h"
+#include "../Collisions/distance_field.h"
+#include "../Collisions/meshlets.h"
+#include "../Collisions/collision_batch.h"
+#include "../Collisions/moving_spheres.h"
+#include "../Collisions/sweep_and_prune.h"
+#include "../Collisions/spatial_hash_grid.h"
+#include "../Collisions/stats.h"
+#include "../Collisions/simd.h"
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace Collisions;
+
+namespace
+{
+    const unsigned WORKLOAD_SIZE = 1024;  // inputs per scenario, calls cycle through them
+    const unsigned SEED = 20240613;
+    double min_seconds = 0.1;             // every scenario runs at least that long
+    const char *filter = NULL;            // if set, only functions containing it are run
+
+    struct Measurement
+    {
+        std::string function;
+        std::string scenario;
+        unsigned long long calls;
+        double ns_per_call;
+        double calls_per_sec;
+        double hit_rate; // negative for functions without a hit/miss result
+    };
+
+    std::vector<Measurement> measurements;
+
+    volatile double sink; // results are accumulated here, so that calls are not optimized out
+
+    // calls `call(i)' for i cycling through [0, size) until `min_seconds' pass; call returns
+    // true for a hit (or anything, if `counts_hits' is false)
+    template <class Call>
+    void _measure(const char *function, const char *scenario, unsigned size, bool counts_hits, Call call)
+    {
+        if( filter != NULL && strstr( function, filter ) == NULL )
+        {
+            return;
+        }
+        if( size == 0 )
+        {
+            printf( "%-48s %-10s %s\n", function, scenario, "(no inputs)" );
+            return;
+        }
+
+        // warm up caches and branch predictors
+        for( unsigned i = 0; i < size; ++i )
+        {
+            call( i );
+        }
+
+        unsigned long long calls = 0;
+        unsigned long long hits = 0;
+        double seconds = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        do
+        {
+            for( unsigned i = 0; i < size; ++i )
+            {
+                hits += call( i ) ? 1 : 0;
+            }
+            calls += size;
+            seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        }
+        while( seconds < min_seconds );
+
+        Measurement measurement;
+        measurement.function = function;
+        measurement.scenario = scenario;
+        measurement.calls = calls;
+        measurement.ns_per_call = seconds*1e9/calls;
+        measurement.calls_per_sec = calls/seconds;
+        measurement.hit_rate = counts_hits ? static_cast<double>( hits )/calls : -1;
+        measurements.push_back( measurement );
+
+        if( counts_hits )
+        {
+            printf( "%-48s %-10s %10.1f ns %14.0f /s %6.1f%%\n", function, scenario, measurement.ns_per_call, measurement.calls_per_sec, 100*measurement.hit_rate );
+        }
+        else
+        {
+            printf( "%-48s %-10s %10.1f ns %14.0f /s %7s\n", function, scenario, measurement.ns_per_call, measurement.calls_per_sec, "-" );
+        }
+    }
+
+    // for functions returning true on hit
+    template <class Call>
+    void measure(const char *function, const char *scenario, unsigned size, Call call)
+    {
+        _measure( function, scenario, size, true, call );
+    }
+
+    // for functions returning a value
+    template <class Call>
+    void measure_value(const char *function, unsigned size, Call call)
+    {
+        _measure( function, "all", size, false, call );
+    }
+
+    bool write_json(const char *path)
+    {
+        FILE *file = fopen( path, "w" );
+        if( file == NULL )
+        {
+            return false;
+        }
+        fprintf( file, "{\n  \"seed\": %u,\n  \"workload_size\": %u,\n  \"benchmarks\": [\n", SEED, WORKLOAD_SIZE );
+        for( unsigned i = 0; i < measurements.size(); ++i )
+        {
+            const Measurement &m = measurements[i];
+            fprintf( file, "    {\"function\": \"%s\", \"scenario\": \"%s\", \"calls\": %llu, \"ns_per_call\": %.3f, \"calls_per_sec\": %.1f, \"hit_rate\": ",
+                     m.function.c_str(), m.scenario.c_str(), m.calls, m.ns_per_call, m.calls_per_sec );
+            if( m.hit_rate < 0 )
+            {
+                fprintf( file, "null}" );
+            }
+            else
+            {
+                fprintf( file, "%.6f}", m.hit_rate );
+            }
+            fprintf( file, i + 1 < measurements.size() ? ",\n" : "\n" );
+        }
+        fprintf( file, "  ]\n}\n" );
+        fclose( file );
+        return true;
+    }
+
+    // -------------------------------- W o r k l o a d s --------------------------------------
+
+    double random_double(double from, double to)
+    {
+        return from + (to - from)*rand()/RAND_MAX;
+    }
+
+    Point random_point(double size)
+    {
+        return Point( random_double(-size, size), random_double(-size, size), random_double(-size, size) );
+    }
+
+    Triangle random_triangle(double size)
+    {
+        for(;;)
+        {
+            const Triangle triangle( random_point(size), random_point(size), random_point(size) );
+            if( !triangle.is_degenerated() )
+            {
+                return triangle;
+            }
+        }
+    }
+
+    struct PointPair
+    {
+        Point first, second;
+    };
+
+    struct SphereSweep
+    {
+        Point start, end;
+        double radius;
+        Point target[2]; // segment or plane (point and normal) to collide with
+    };
+
+    struct TriangleSweep
+    {
+        Point start, end;
+        double radius;
+        Triangle triangle;
+        PreparedTriangle prepared;
+
+        TriangleSweep(const Point &start, const Point &end, double radius, const Triangle &triangle)
+            : start(start), end(end), radius(radius), triangle(triangle), prepared(triangle) {}
+    };
+
+    struct TriangleSweepF
+    {
+        PointF start, end;
+        float radius;
+        PreparedTriangleF prepared;
+
+        explicit TriangleSweepF(const TriangleSweep &sweep)
+            : start(sweep.start), end(sweep.end), radius( static_cast<float>( sweep.radius ) ),
+              prepared( PointF( sweep.triangle[0] ), PointF( sweep.triangle[1] ), PointF( sweep.triangle[2] ) ) {}
+    };
+
+    enum TriangleFeature { PLANE, EDGE, VERTEX, MISS, FEATURES_COUNT };
+    const char * const FEATURE_NAMES[FEATURES_COUNT] = { "plane", "edges", "vertices", "misses" };
+
+    // which part of the triangle the sphere hits first
+    TriangleFeature classify(const TriangleSweep &sweep)
+    {
+        Point point;
+        if( !sphere_and_triangle_collision( sweep.start, sweep.end, sweep.radius, sweep.triangle, point ) )
+        {
+            return MISS;
+        }
+        const double TOLERANCE = 1e-9;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( distance( point, sweep.triangle[i] ) < TOLERANCE )
+            {
+                return VERTEX;
+            }
+        }
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( distance_between_point_and_segment( point, sweep.triangle[i], sweep.triangle[(i+1)%3] ) < TOLERANCE )
+            {
+                return EDGE;
+            }
+        }
+        return PLANE;
+    }
+
+    // random sweeps, grouped by the feature hit
+    void make_triangle_sweeps(/*out*/ std::vector<TriangleSweep> (&sweeps)[FEATURES_COUNT])
+    {
+        const unsigned MAX_ATTEMPTS = 100*1000*1000;
+        for( unsigned attempt = 0; attempt < MAX_ATTEMPTS; ++attempt )
+        {
+            const Point start = random_point(4);
+            const TriangleSweep sweep( start, start + random_point(4), random_double(0.1, 1), random_triangle(3) );
+            std::vector<TriangleSweep> &group = sweeps[ classify( sweep ) ];
+            if( group.size() < WORKLOAD_SIZE )
+            {
+                group.push_back( sweep );
+            }
+
+            bool full = true;
+            for( unsigned i = 0; i < FEATURES_COUNT; ++i )
+            {
+                full = full && sweeps[i].size() == WORKLOAD_SIZE;
+            }
+            if( full )
+            {
+                return;
+            }
+        }
+    }
+
+    // -------------------------------- B e n c h m a r k s ------------------------------------
+
+    void bench_helpers()
+    {
+        std::vector<double> numbers;
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            numbers.push_back( random_double(-10, 10) );
+        }
+        measure( "equal", "same", WORKLOAD_SIZE, [&](unsigned i) { return equal( numbers[i], numbers[i] ); } );
+        measure( "equal", "near", WORKLOAD_SIZE, [&](unsigned i) { return equal( numbers[i], numbers[i]*(1 + 1e-15) ); } );
+        measure( "equal", "different", WORKLOAD_SIZE, [&](unsigned i) { return equal( numbers[i], numbers[(i+1) % WORKLOAD_SIZE] ); } );
+        measure( "equal(max_ulps)", "near", WORKLOAD_SIZE, [&](unsigned i) { return equal( numbers[i], numbers[i]*(1 + 1e-15), DEFAULT_MAX_ULPS ); } );
+        measure( "Simd::equal(DefaultPack)", "near", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return Simd::bits( Simd::equal<DefaultTolerance>( Simd::DefaultPack( numbers[i] ), Simd::DefaultPack( numbers[i]*(1 + 1e-15) ) ) ) != 0;
+        } );
+
+        std::vector<PointPair> pairs( WORKLOAD_SIZE );
+        std::vector<Triangle> triangles;
+        std::vector<PreparedTriangle> prepared;
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            pairs[i].first = random_point(5);
+            pairs[i].second = random_point(5);
+            triangles.push_back( random_triangle(5) );
+            prepared.push_back( PreparedTriangle( triangles.back() ) );
+        }
+        const unsigned N = WORKLOAD_SIZE;
+
+        measure_value( "Vector::operator*(Vector)", N, [&](unsigned i) { sink = pairs[i].first*pairs[i].second; return false; } );
+        measure_value( "cross_product", N, [&](unsigned i) { sink = cross_product( pairs[i].first, pairs[i].second ).x; return false; } );
+        measure_value( "Vector::normalized", N, [&](unsigned i) { sink = pairs[i].first.normalized().x; return false; } );
+        measure_value( "distance", N, [&](unsigned i) { sink = distance( pairs[i].first, pairs[i].second ); return false; } );
+        measure( "Vector::operator==", "different", N, [&](unsigned i) { return pairs[i].first == pairs[i].second; } );
+        measure( "Vector::operator==", "same", N, [&](unsigned i) { return pairs[i].first == pairs[i].first; } );
+        measure( "Simd::equal3", "same", N, [&](unsigned i) { return Simd::equal3<DefaultTolerance>( pairs[i].first, pairs[i].first ); } );
+        measure( "Vector::is_zero", "nonzero", N, [&](unsigned i) { return pairs[i].first.is_zero(); } );
+        measure( "Vector::is_collinear_to", "all", N, [&](unsigned i) { return pairs[i].first.is_collinear_to( pairs[i].second ); } );
+        measure( "Vector::is_orthogonal_to", "all", N, [&](unsigned i) { return pairs[i].first.is_orthogonal_to( pairs[i].second ); } );
+        measure_value( "Triangle::normal", N, [&](unsigned i) { sink = triangles[i].normal().x; return false; } );
+        measure( "Triangle::is_degenerated", "all", N, [&](unsigned i) { return triangles[i].is_degenerated(); } );
+        measure_value( "PreparedTriangle::PreparedTriangle", N, [&](unsigned i) { sink = PreparedTriangle( triangles[i] ).plane_offset(); return false; } );
+        measure_value( "PreparedTriangle::barycentric", N, [&](unsigned i)
+        {
+            double u, v;
+            prepared[i].barycentric( pairs[i].first, u, v );
+            sink = u + v;
+            return false;
+        } );
+
+        measure( "is_point_between", "all", N, [&](unsigned i) { return is_point_between( (pairs[i].first + pairs[i].second)/2, pairs[i].first, pairs[i].second ); } );
+        measure_value( "distance_between_point_and_line", N, [&](unsigned i)
+        {
+            Point nearest;
+            sink = distance_between_point_and_line( triangles[i][0], pairs[i].first, pairs[i].second, nearest );
+            return false;
+        } );
+        measure_value( "distance_between_point_and_segment", N, [&](unsigned i)
+        {
+            sink = distance_between_point_and_segment( triangles[i][0], pairs[i].first, pairs[i].second );
+            return false;
+        } );
+        measure_value( "distance_between_two_lines", N, [&](unsigned i)
+        {
+            sink = distance_between_two_lines( pairs[i].first, pairs[i].second, triangles[i][0], triangles[i][1] );
+            return false;
+        } );
+        measure_value( "nearest_points_on_lines", N, [&](unsigned i)
+        {
+            Point first, second;
+            nearest_points_on_lines( pairs[i].first, pairs[i].second, triangles[i][0], triangles[i][1], first, second );
+            sink = first.x + second.x;
+            return false;
+        } );
+        measure_value( "perpendicular_base", N, [&](unsigned i)
+        {
+            sink = perpendicular_base( pairs[i].first, pairs[i].second, triangles[i][0], 1 ).x;
+            return false;
+        } );
+
+        // points in the plane of triangle: half inside, half outside
+        std::vector<Point> plane_points;
+        for( unsigned i = 0; i < N; ++i )
+        {
+            const double u = random_double(0, 1);
+            const double v = random_double(0, 1);
+            const double scale = (i % 2 == 0) ? 1/( 1 + u + v ) : 1.5;
+            plane_points.push_back( triangles[i][0] + scale*( u*(triangles[i][1] - triangles[i][0]) + v*(triangles[i][2] - triangles[i][0]) ) );
+        }
+        measure( "is_point_inside_triangle(Triangle)", "all", N, [&](unsigned i) { return is_point_inside_triangle( plane_points[i], triangles[i] ); } );
+        measure( "is_point_inside_triangle(PreparedTriangle)", "all", N, [&](unsigned i) { return is_point_inside_triangle( plane_points[i], prepared[i] ); } );
+    }
+
+    void bench_simple_finders()
+    {
+        const unsigned N = WORKLOAD_SIZE;
+        std::vector<SphereSweep> sweeps( N );
+        for( unsigned i = 0; i < N; ++i )
+        {
+            sweeps[i].start = random_point(5);
+            sweeps[i].end = random_point(5);
+            sweeps[i].radius = random_double(0.1, 1);
+            sweeps[i].target[0] = random_point(5);
+            sweeps[i].target[1] = random_point(5);
+        }
+
+        measure( "line_and_plane_collision", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return line_and_plane_collision( sweeps[i].start, sweeps[i].end - sweeps[i].start, sweeps[i].target[0], sweeps[i].target[1], point );
+        } );
+        measure( "segment_and_plane_collision", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return segment_and_plane_collision( sweeps[i].start, sweeps[i].end, sweeps[i].target[0], sweeps[i].target[1], point );
+        } );
+        measure( "sphere_and_plane_collision", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return sphere_and_plane_collision( sweeps[i].start, sweeps[i].end, sweeps[i].radius, sweeps[i].target[0], sweeps[i].target[1], point );
+        } );
+        measure( "sphere_and_point_collision", "all", N, [&](unsigned i)
+        {
+            return sphere_and_point_collision( sweeps[i].start, sweeps[i].end, sweeps[i].radius, sweeps[i].target[0] );
+        } );
+        measure( "sphere_and_segment_collision", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return sphere_and_segment_collision( sweeps[i].start, sweeps[i].end, sweeps[i].radius, sweeps[i].target[0], sweeps[i].target[1], point );
+        } );
+    }
+
+    void bench_triangle_finders()
+    {
+        std::vector<TriangleSweep> sweeps[FEATURES_COUNT];
+        make_triangle_sweeps( sweeps );
+
+        for( unsigned feature = 0; feature < FEATURES_COUNT; ++feature )
+        {
+            const std::vector<TriangleSweep> &group = sweeps[feature];
+            measure( "sphere_and_triangle_collision(Triangle)", FEATURE_NAMES[feature], static_cast<unsigned>( group.size() ), [&](unsigned i)
+            {
+                Point point;
+                return sphere_and_triangle_collision( group[i].start, group[i].end, group[i].radius, group[i].triangle, point );
+            } );
+        }
+        for( unsigned feature = 0; feature < FEATURES_COUNT; ++feature )
+        {
+            const std::vector<TriangleSweep> &group = sweeps[feature];
+            measure( "sphere_and_triangle_collision(PreparedTriangle)", FEATURE_NAMES[feature], static_cast<unsigned>( group.size() ), [&](unsigned i)
+            {
+                Point point;
+                return sphere_and_triangle_collision( group[i].start, group[i].end, group[i].radius, group[i].prepared, point );
+            } );
+        }
+        for( unsigned feature = 0; feature < FEATURES_COUNT; ++feature )
+        {
+            const std::vector<TriangleSweep> &group = sweeps[feature];
+            measure( "sphere_and_triangle_collision(PreparedTriangle, AnyHit)", FEATURE_NAMES[feature], static_cast<unsigned>( group.size() ), [&](unsigned i)
+            {
+                return sphere_and_triangle_collision( group[i].start, group[i].end, group[i].radius, group[i].prepared, AnyHit() );
+            } );
+        }
+        // the same sweeps in single precision (a few of them may be classified differently)
+        for( unsigned feature = 0; feature < FEATURES_COUNT; ++feature )
+        {
+            const std::vector<TriangleSweep> &group = sweeps[feature];
+            std::vector<TriangleSweepF> group_float;
+            for( unsigned i = 0; i < group.size(); ++i )
+            {
+                group_float.push_back( TriangleSweepF( group[i] ) );
+            }
+            measure( "sphere_and_triangle_collision(PreparedTriangleF)", FEATURE_NAMES[feature], static_cast<unsigned>( group_float.size() ), [&](unsigned i)
+            {
+                PointF point;
+                return sphere_and_triangle_collision( group_float[i].start, group_float[i].end, group_float[i].radius, group_float[i].prepared, point );
+            } );
+        }
+
+        // segments through the neighbourhood of triangles: the composition of plane and inside tests, used for
+        // them before, against the dedicated test
+        const unsigned N = WORKLOAD_SIZE;
+        std::vector<Triangle> triangles;
+        std::vector<PreparedTriangle> prepared;
+        std::vector<SphereSweep> segments( N );
+        for( unsigned i = 0; i < N; ++i )
+        {
+            triangles.push_back( Triangle( random_point(5), random_point(5), random_point(5) ) );
+            prepared.push_back( PreparedTriangle( triangles[i] ) );
+            segments[i].start = random_point(10);
+            segments[i].end = segments[i].start + 2*( triangles[i][0] + random_point(3) - segments[i].start );
+        }
+        measure( "segment_and_plane+is_point_inside_triangle", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return segment_and_plane_collision( segments[i].start, segments[i].end, triangles[i][0], triangles[i].normal(), point ) &&
+                   is_point_inside_triangle( point, triangles[i] );
+        } );
+        measure( "segment_and_triangle_collision(Triangle)", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return segment_and_triangle_collision( segments[i].start, segments[i].end, triangles[i], point );
+        } );
+        measure( "segment_and_triangle_collision(PreparedTriangle)", "all", N, [&](unsigned i)
+        {
+            Point point;
+            return segment_and_triangle_collision( segments[i].start, segments[i].end, prepared[i], point );
+        } );
+    }
+
+    void bench_sweeps()
+    {
+        const unsigned SMALL_MESH = 256;
+        const unsigned BIG_MESH = 16384;
+
+        std::vector<Triangle> triangles;
+        for( unsigned i = 0; i < BIG_MESH; ++i )
+        {
+            const Point center = random_point(50);
+            triangles.push_back( Triangle( center + random_point(1), center + random_point(1), center + random_point(1) ) );
+        }
+        std::vector<SphereSweep> sweeps( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            sweeps[i].start = random_point(50);
+            sweeps[i].end = sweeps[i].start + random_point(5);
+            sweeps[i].radius = random_double(0.1, 1);
+        }
+
+        const std::vector<Triangle> small_triangles( triangles.begin(), triangles.begin() + SMALL_MESH );
+        const std::vector<PreparedTriangle> small_prepared( small_triangles.begin(), small_triangles.end() );
+        const std::vector<PreparedTriangle> big_prepared( triangles.begin(), triangles.end() );
+        const TriangleSoup small_soup( small_triangles );
+        const TriangleSoup big_soup( triangles );
+        const MeshBVH small_mesh( small_triangles );
+        const MeshBVH big_mesh( triangles );
+
+        SweepHit hit;
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "256 tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_prepared, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(TriangleSoup)", "256 tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_soup, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "16k tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_prepared, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(TriangleSoup)", "16k tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_soup, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(MeshBVH)", "256 tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_mesh, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(MeshBVH)", "16k tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+
+        // occlusion: long ways across the whole mesh, most of them blocked by many triangles
+        std::vector<SphereSweep> long_sweeps( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            long_sweeps[i].start = random_point(50);
+            long_sweeps[i].end = random_point(50);
+            long_sweeps[i].radius = random_double(0.1, 1);
+        }
+        std::vector<SweepHit> hits;
+        measure( "sweep_sphere(MeshBVH)", "16k tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(MeshBVH, AnyHit)", "16k tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, AnyHit(), hit );
+        } );
+        measure( "sweep_sphere(MeshBVH, AllHits)", "16k tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, AllHits(), hits );
+        } );
+        measure( "sweep_sphere(vector<PreparedTriangle>, AnyHit)", "256 tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_prepared, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, AnyHit(), hit );
+        } );
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "256 tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_prepared, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(TriangleSoup)", "256 tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( small_soup, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "16k tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_prepared, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(TriangleSoup)", "16k tris, long", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_soup, long_sweeps[i].start, long_sweeps[i].end, long_sweeps[i].radius, hit );
+        } );
+
+        // rays along the same long ways, against a sphere of zero radius
+        measure( "sweep_sphere(MeshBVH)", "16k tris, rays", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, long_sweeps[i].start, long_sweeps[i].end, 0, hit );
+        } );
+        RayHit ray_hit;
+        measure( "raycast(MeshBVH)", "16k tris, rays", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return raycast( big_mesh, long_sweeps[i].start, long_sweeps[i].end - long_sweeps[i].start, 1, ray_hit );
+        } );
+        measure( "raycast(MeshBVH, AnyHit)", "16k tris, rays", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return raycast( big_mesh, long_sweeps[i].start, long_sweeps[i].end - long_sweeps[i].start, 1, AnyHit(), ray_hit );
+        } );
+        measure( "raycast(vector<PreparedTriangle>)", "256 tris, rays", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return raycast( small_prepared, long_sweeps[i].start, long_sweeps[i].end - long_sweeps[i].start, 1, ray_hit );
+        } );
+        measure( "raycast(TriangleSoup)", "256 tris, rays", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return raycast( small_soup, long_sweeps[i].start, long_sweeps[i].end - long_sweeps[i].start, 1, ray_hit );
+        } );
+
+        // bundles: spheres of a bundle start near the same origin and go about the same way, one sweep
+        // against packets of 4 and 8 of them (time per call is per packet)
+        std::vector<SphereSweep> bundle_sweeps( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; i += SpherePacket::MAX_SIZE )
+        {
+            const Point origin = random_point(50);
+            const Vector way = random_point(1).normalized()*30;
+            for( unsigned j = i; j < i + SpherePacket::MAX_SIZE; ++j )
+            {
+                bundle_sweeps[j].start = origin + random_point(0.2);
+                bundle_sweeps[j].end = origin + way + random_point(2);
+                bundle_sweeps[j].radius = random_double(0.1, 1);
+            }
+        }
+        measure( "sweep_sphere(MeshBVH)", "16k tris, bundles", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( big_mesh, bundle_sweeps[i].start, bundle_sweeps[i].end, bundle_sweeps[i].radius, hit );
+        } );
+        for( unsigned packet_size = 4; packet_size <= SpherePacket::MAX_SIZE; packet_size *= 2 )
+        {
+            std::vector<SpherePacket> packets( WORKLOAD_SIZE/packet_size );
+            for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+            {
+                packets[i/packet_size].add( bundle_sweeps[i].start, bundle_sweeps[i].end, bundle_sweeps[i].radius );
+            }
+            BatchResult results[SpherePacket::MAX_SIZE];
+            measure( "sweep_sphere(SpherePacket)", packet_size == 4 ? "16k tris, 4 per packet" : "16k tris, 8 per packet", static_cast<unsigned>( packets.size() ), [&](unsigned i)
+            {
+                sweep_sphere( big_mesh, packets[i], results );
+                return results[0].status == CollisionStatus::Hit;
+            } );
+        }
+
+        // closest points: probes along paths through the mesh, without a limit of distance; groups are
+        // consecutive probes of a path (time per call is per probe)
+        std::vector<Point> probes( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; i += CLOSEST_POINT_GROUP_SIZE )
+        {
+            const Point start = random_point(50);
+            const Vector step = random_point(0.5);
+            for( unsigned j = 0; j < CLOSEST_POINT_GROUP_SIZE; ++j )
+            {
+                probes[i + j] = start + j*step;
+            }
+        }
+        const double UNLIMITED = std::numeric_limits<double>::infinity();
+        ClosestPoint nearest;
+        measure( "closest_point(vector<PreparedTriangle>)", "256 tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return closest_point( small_prepared, probes[i], UNLIMITED, nearest );
+        } );
+        measure( "closest_point(MeshBVH)", "256 tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return closest_point( small_mesh, probes[i], UNLIMITED, nearest );
+        } );
+        measure( "closest_point(MeshBVH)", "16k tris", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return closest_point( big_mesh, probes[i], UNLIMITED, nearest );
+        } );
+        ClosestPoint group_results[CLOSEST_POINT_GROUP_SIZE];
+        CollisionStatus group_statuses[CLOSEST_POINT_GROUP_SIZE];
+        measure( "closest_point(MeshBVH, points)", "16k tris, groups", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            // every group is found at its first probe, the rest of them are free
+            if( i % CLOSEST_POINT_GROUP_SIZE == 0 )
+            {
+                closest_point( big_mesh, &probes[i], CLOSEST_POINT_GROUP_SIZE, UNLIMITED, group_results, group_statuses );
+            }
+            return group_statuses[i % CLOSEST_POINT_GROUP_SIZE] == CollisionStatus::Hit;
+        } );
+    }
+
+    // closed UV sphere: `rings' x `segments' quads, split into triangles with normals aimed outside
+    void uv_sphere(double radius, unsigned rings, unsigned segments, /*out*/ std::vector<Point> &vertices, /*out*/ std::vector<unsigned> &indices)
+    {
+        const double PI = 3.14159265358979323846;
+        vertices.push_back( Point( 0, 0, radius ) );
+        for( unsigned i = 1; i < rings; ++i )
+        {
+            for( unsigned j = 0; j < segments; ++j )
+            {
+                const double theta = PI*i/rings;
+                const double phi = 2*PI*j/segments;
+                vertices.push_back( Point( radius*sin(theta)*cos(phi), radius*sin(theta)*sin(phi), radius*cos(theta) ) );
+            }
+        }
+        vertices.push_back( Point( 0, 0, -radius ) );
+        const unsigned south = static_cast<unsigned>( vertices.size() ) - 1;
+
+        for( unsigned i = 0; i < rings; ++i )
+        {
+            for( unsigned j = 0; j < segments; ++j )
+            {
+                const unsigned next = (j + 1)%segments;
+                // corners of the quad (the upper ones are the pole on the first ring, the lower ones - on the last)
+                const unsigned a = i == 0 ? 0 : 1 + (i - 1)*segments + j;
+                const unsigned b = i == 0 ? 0 : 1 + (i - 1)*segments + next;
+                const unsigned c = i + 1 == rings ? south : 1 + i*segments + j;
+                const unsigned d = i + 1 == rings ? south : 1 + i*segments + next;
+                // clockwise, as seen from outside (see Triangle::normal)
+                if( i != 0 )
+                {
+                    const unsigned upper[] = { a, b, c };
+                    indices.insert( indices.end(), upper, upper + 3 );
+                }
+                if( i + 1 != rings )
+                {
+                    const unsigned lower[] = { b, d, c };
+                    indices.insert( indices.end(), lower, lower + 3 );
+                }
+            }
+        }
+    }
+
+    void bench_meshes()
+    {
+        std::vector<Point> vertices;
+        std::vector<unsigned> indices;
+        uv_sphere( 10, 32, 32, vertices, indices );
+        const IndexedMesh mesh( vertices, indices );
+        std::vector<PreparedTriangle> prepared;
+        for( unsigned i = 0; i < mesh.triangles_count(); ++i )
+        {
+            prepared.push_back( PreparedTriangle( mesh.triangle( i ) ) );
+        }
+
+        // sweeps from outside the sphere towards it, most of them hitting
+        std::vector<SphereSweep> sweeps( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            sweeps[i].start = random_point(1).normalized()*random_double(12, 15);
+            sweeps[i].end = sweeps[i].start*random_double(-0.5, 0.5) + random_point(5);
+            sweeps[i].radius = random_double(0.1, 1);
+        }
+
+        SweepHit hit;
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "sphere", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( prepared, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(IndexedMesh)", "sphere", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( mesh, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        if( filter == NULL || strstr( "IndexedMesh", filter ) != NULL )
+        {
+            printf( "memory of %u triangles: IndexedMesh %u bytes, vector<PreparedTriangle> %u bytes\n", mesh.triangles_count(),
+                    static_cast<unsigned>( mesh.memory_size() ), static_cast<unsigned>( prepared.size()*sizeof(PreparedTriangle) ) );
+        }
+
+        // particles: short sweeps of small spheres around the sphere mesh, most of them in free space,
+        // against its hierarchy or its distance field
+        const MeshBVH sphere_mesh( prepared );
+        std::vector<SphereSweep> particles( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            particles[i].start = random_point(1).normalized()*random_double(10.5, 20);
+            particles[i].end = particles[i].start + random_point(0.5);
+            particles[i].radius = random_double(0.05, 0.2);
+        }
+        measure( "DistanceField::DistanceField", "sphere, voxel 0.25", 1, [&](unsigned)
+        {
+            return DistanceField( sphere_mesh, 0.25, 1 ).stored_bricks() != 0;
+        } );
+        const DistanceField field( sphere_mesh, 0.25, 1 );
+        measure( "sweep_sphere(MeshBVH)", "sphere, particles", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( sphere_mesh, particles[i].start, particles[i].end, particles[i].radius, hit );
+        } );
+        measure( "sweep_sphere(DistanceField)", "sphere, particles", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( field, sphere_mesh, particles[i].start, particles[i].end, particles[i].radius, hit );
+        } );
+        measure( "sweep_sphere(MeshBVH)", "sphere", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( sphere_mesh, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(DistanceField)", "sphere", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( field, sphere_mesh, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+
+        // the same prop, split into meshlets, which are culled by bounding spheres and normal cones
+        const MeshletMesh meshlets( prepared );
+        measure( "sweep_sphere(MeshletMesh)", "sphere", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( meshlets, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        measure( "sweep_sphere(MeshletMesh)", "sphere, particles", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( meshlets, particles[i].start, particles[i].end, particles[i].radius, hit );
+        } );
+        measure( "sweep_sphere(vector<PreparedTriangle>)", "sphere, particles", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( prepared, particles[i].start, particles[i].end, particles[i].radius, hit );
+        } );
+
+        // loading a big mesh: building the hierarchy at startup, or mapping it from a file
+        vertices.clear();
+        indices.clear();
+        uv_sphere( 10, 512, 512, vertices, indices );
+        std::vector<Triangle> triangles;
+        for( unsigned i = 0; i < indices.size(); i += 3 )
+        {
+            triangles.push_back( Triangle( vertices[ indices[i] ], vertices[ indices[i + 1] ], vertices[ indices[i + 2] ] ) );
+        }
+        const char * const path = "collisions_bench_mesh.bin";
+        MappedMesh::write( path, vertices, indices );
+        measure( "MeshBVH::MeshBVH", "512k tris", 1, [&](unsigned)
+        {
+            return !MeshBVH( triangles ).empty();
+        } );
+        measure( "MappedMesh::MappedMesh", "512k tris", 1, [&](unsigned)
+        {
+            return !MappedMesh( path ).empty();
+        } );
+        {
+            const MappedMesh mapped( path );
+            measure( "MappedMesh::verify", "512k tris", 1, [&](unsigned)
+            {
+                return mapped.verify();
+            } );
+            measure( "sweep_sphere(MappedMesh)", "512k tris", WORKLOAD_SIZE, [&](unsigned i)
+            {
+                return sweep_sphere( mapped, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+            } );
+        }
+        remove( path );
+
+        // importing it from text
+        const char * const obj_path = "collisions_bench_mesh.obj";
+        std::FILE *file = fopen( obj_path, "wb" );
+        for( unsigned i = 0; i < vertices.size(); ++i )
+        {
+            fprintf( file, "v %.17g %.17g %.17g\n", vertices[i].x, vertices[i].y, vertices[i].z );
+        }
+        for( unsigned i = 0; i < indices.size(); i += 3 )
+        {
+            fprintf( file, "f %u %u %u\n", indices[i] + 1, indices[i + 1] + 1, indices[i + 2] + 1 );
+        }
+        fclose( file );
+        ImportedMesh imported;
+        measure( "import_obj", "512k tris", 1, [&](unsigned)
+        {
+            import_obj( obj_path, imported );
+            return imported.triangles_count() != 0;
+        } );
+        {
+            CollisionBatch batch;
+            measure( "import_obj(batch)", "512k tris", 1, [&](unsigned)
+            {
+                import_obj( obj_path, imported, batch );
+                return imported.triangles_count() != 0;
+            } );
+        }
+        remove( obj_path );
+    }
+
+    void bench_instances()
+    {
+        // a thousand instances of two rocks, scattered in a cube
+        const unsigned INSTANCES_COUNT = 1000;
+        const double SCENE_SIZE = 100;
+        std::vector<Triangle> meshes[2];
+        for( unsigned m = 0; m < 2; ++m )
+        {
+            std::vector<Point> vertices;
+            std::vector<unsigned> indices;
+            uv_sphere( 2, 16 + 8*m, 16 + 8*m, vertices, indices );
+            for( unsigned i = 0; i < indices.size(); i += 3 )
+            {
+                meshes[m].push_back( Triangle( vertices[ indices[i] ], vertices[ indices[i + 1] ], vertices[ indices[i + 2] ] ) );
+            }
+        }
+        const MeshBVH rock( meshes[0] ), big_rock( meshes[1] );
+        InstanceBVH instances;
+        instances.add_mesh( rock );
+        instances.add_mesh( big_rock );
+        std::vector<Transform> transforms( INSTANCES_COUNT );
+        std::vector<Triangle> world;
+        for( unsigned i = 0; i < INSTANCES_COUNT; ++i )
+        {
+            transforms[i] = Transform( random_point(SCENE_SIZE), random_point(1), random_double(-3, 3), random_double(0.5, 2) );
+            instances.add_instance( i % 2, transforms[i] );
+            for( unsigned j = 0; j < meshes[i % 2].size(); ++j )
+            {
+                const Triangle &triangle = meshes[i % 2][j];
+                world.push_back( Triangle( transforms[i].apply( triangle[0] ), transforms[i].apply( triangle[1] ), transforms[i].apply( triangle[2] ) ) );
+            }
+        }
+        instances.rebuild();
+        const MeshBVH flattened( world );
+
+        // sweeps of 20 units across the scene
+        std::vector<SphereSweep> sweeps( WORKLOAD_SIZE );
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            sweeps[i].start = random_point(SCENE_SIZE);
+            sweeps[i].end = sweeps[i].start + random_point(1).normalized()*20;
+            sweeps[i].radius = random_double(0.1, 1);
+        }
+
+        SweepHit hit;
+        unsigned instance_index;
+        measure( "sweep_sphere(InstanceBVH)", "1k inst", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( instances, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit, instance_index );
+        } );
+        measure( "sweep_sphere(InstanceBVH, AnyHit)", "1k inst", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( instances, sweeps[i].start, sweeps[i].end, sweeps[i].radius, AnyHit(), hit, instance_index );
+        } );
+        measure( "sweep_sphere(MeshBVH)", "flattened", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            return sweep_sphere( flattened, sweeps[i].start, sweeps[i].end, sweeps[i].radius, hit );
+        } );
+        if( filter == NULL || strstr( "sweep_sphere(InstanceBVH)", filter ) != NULL )
+        {
+            const size_t shared = ( rock.size() + big_rock.size() )*( sizeof(PreparedTriangle) + sizeof(unsigned) ) +
+                                  ( rock.nodes_count() + big_rock.nodes_count() )*sizeof(MeshBVH::Node);
+            const size_t top = instances.size()*( sizeof(InstanceBVH::Instance) + 2*sizeof(unsigned) ) +
+                               instances.nodes_count()*( sizeof(MeshBVH::Node) + sizeof(unsigned) );
+            const size_t whole = flattened.size()*( sizeof(PreparedTriangle) + sizeof(unsigned) ) + flattened.nodes_count()*sizeof(MeshBVH::Node);
+            printf( "memory of %u instances (%u triangles): meshes %u bytes + top level %u bytes, flattened MeshBVH %u bytes\n",
+                    instances.size(), flattened.size(), static_cast<unsigned>( shared ), static_cast<unsigned>( top ), static_cast<unsigned>( whole ) );
+        }
+
+        // moving instances: refitting the top level, or rebuilding it
+        measure( "InstanceBVH::set_transform", "1k inst", INSTANCES_COUNT, [&](unsigned i)
+        {
+            instances.set_transform( i, transforms[(i + 1) % INSTANCES_COUNT] );
+            return true;
+        } );
+        measure( "InstanceBVH::rebuild", "1k inst", 1, [&](unsigned)
+        {
+            instances.rebuild();
+            return true;
+        } );
+    }
+
+    // prints the rate of pairs tested by the last measurement, which tested `pairs' per call
+    void print_pairs_rate(const char *function, double pairs)
+    {
+        if( filter == NULL || strstr( function, filter ) != NULL )
+        {
+            printf( "  %.0f pairs/s\n", pairs*measurements.back().calls_per_sec );
+        }
+    }
+
+    void bench_spheres()
+    {
+        // spheres moving inside a box, about 1% of pairs colliding
+        std::vector<SphereSweep> sweeps( WORKLOAD_SIZE );
+        MovingSpheres spheres;
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            sweeps[i].start = random_point(50);
+            sweeps[i].end = sweeps[i].start + random_point(5);
+            sweeps[i].radius = random_double(0.5, 2);
+            spheres.add( sweeps[i].start, sweeps[i].end, sweeps[i].radius );
+        }
+
+        Point point;
+        double time;
+        measure( "sphere_and_sphere_collision", "random", WORKLOAD_SIZE, [&](unsigned i)
+        {
+            const SphereSweep &other = sweeps[ (i*7 + 1) % WORKLOAD_SIZE ];
+            return sphere_and_sphere_collision( sweeps[i].start, sweeps[i].end, sweeps[i].radius, other.start, other.end, other.radius, point, time );
+        } );
+
+        std::vector<SpherePairHit> hits;
+        measure( "sphere_and_sphere_collisions(all pairs)", "1k spheres", 1, [&](unsigned)
+        {
+            sphere_and_sphere_collisions( spheres, hits );
+            return !hits.empty();
+        } );
+        print_pairs_rate( "sphere_and_sphere_collisions(all pairs)", WORKLOAD_SIZE*(WORKLOAD_SIZE - 1)/2.0 );
+
+        std::vector<SpherePair> pairs;
+        for( unsigned i = 0; i < 64*WORKLOAD_SIZE; ++i )
+        {
+            pairs.push_back( SpherePair( rand() % WORKLOAD_SIZE, rand() % WORKLOAD_SIZE ) );
+        }
+        measure( "sphere_and_sphere_collisions(pairs)", "64k pairs", 1, [&](unsigned)
+        {
+            sphere_and_sphere_collisions( spheres, pairs, hits );
+            return !hits.empty();
+        } );
+        print_pairs_rate( "sphere_and_sphere_collisions(pairs)", static_cast<double>( pairs.size() ) );
+
+        // a frame: the spheres move a bit forth or back, the broadphase is updated and its pairs are tested
+        SweepAndPrune sap;
+        for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+        {
+            sap.add( sweeps[i].start, sweeps[i].end, sweeps[i].radius );
+        }
+        sap.update_pairs();
+        unsigned frame = 0;
+        measure( "SweepAndPrune::update_pairs", "1k spheres", 1, [&](unsigned)
+        {
+            const Vector shift = (frame++ % 2 == 0 ? 0.1 : -0.1)*Vector(1, 1, 1);
+            for( unsigned i = 0; i < WORKLOAD_SIZE; ++i )
+            {
+                sweeps[i].start = sweeps[i].start + shift;
+                sweeps[i].end = sweeps[i].end + shift;
+                sap.update_box( i, sweeps[i].start, sweeps[i].end, sweeps[i].radius );
+            }
+            sap.update_pairs();
+            sap.get_pairs( pairs );
+            sphere_and_sphere_collisions( spheres, pairs, hits );
+            return !sap.added_pairs().empty() || !sap.removed_pairs().empty();
+        } );
+        if( filter == NULL || strstr( "SweepAndPrune::update_pairs", filter ) != NULL )
+        {
+            printf( "  %u candidate pairs of %u\n", sap.pairs_count(), WORKLOAD_SIZE*(WORKLOAD_SIZE - 1)/2 );
+        }
+
+        // the same frame with the grid, rebuilt from scratch
+        SpatialHashGrid grid;
+        measure( "SpatialHashGrid::find_pairs", "1k spheres", 1, [&](unsigned)
+        {
+            grid.rebuild( spheres );
+            grid.find_pairs( pairs );
+            sphere_and_sphere_collisions( spheres, pairs, hits );
+            return !pairs.empty();
+        } );
+
+        // a big crowd of the same density
+        const unsigned CROWD_SIZE = 1000*WORKLOAD_SIZE;
+        MovingSpheres crowd;
+        for( unsigned i = 0; i < CROWD_SIZE; ++i )
+        {
+            const Point start = 10*random_point(50);
+            crowd.add( start, start + random_point(5), random_double(0.5, 2) );
+        }
+        measure( "SpatialHashGrid::rebuild", "1M spheres", 1, [&](unsigned)
+        {
+            grid.rebuild( crowd );
+            return grid.large_count() != 0;
+        } );
+        measure( "SpatialHashGrid::find_pairs", "1M spheres", 1, [&](unsigned)
+        {
+            grid.find_pairs( pairs );
+            return !pairs.empty();
+        } );
+        if( filter == NULL || strstr( "SpatialHashGrid::find_pairs", filter ) != NULL )
+        {
+            printf( "  %u cells, %u large spheres, %u candidate pairs\n", grid.cells_count(), grid.large_count(), static_cast<unsigned>( pairs.size() ) );
+        }
+
+        // the same on all hardware threads
+        CollisionBatch batch;
+        measure( "SpatialHashGrid::rebuild(batch)", "1M spheres", 1, [&](unsigned)
+        {
+            grid.rebuild( crowd, batch );
+            return grid.large_count() != 0;
+        } );
+        measure( "SpatialHashGrid::find_pairs(batch)", "1M spheres", 1, [&](unsigned)
+        {
+            grid.find_pairs( pairs, batch );
+            return !pairs.empty();
+        } );
+        if( filter == NULL || strstr( "SpatialHashGrid::find_pairs(batch)", filter ) != NULL )
+        {
+            printf( "  %u threads\n", batch.threads_count() );
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *json_path = NULL;
+    for( int i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[i], "--json" ) == 0 && i + 1 < argc )
+        {
+            json_path = argv[++i];
+        }
+        else if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+        {
+            min_seconds = atof( argv[++i] );
+        }
+        else if( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc )
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf( stderr, "usage: %s [--json <file>] [--min-time <seconds>] [--filter <substring>]\n", argv[0] );
+            return 1;
+        }
+    }
+
+    printf( "%-48s %-10s %13s %17s %7s\n", "function", "scenario", "time/call", "calls/sec", "hits" );
+
+    // every group starts from the same seed, so its workload doesn't depend on the others
+    srand( SEED );
+    bench_helpers();
+    srand( SEED );
+    bench_simple_finders();
+    srand( SEED );
+    bench_triangle_finders();
+    srand( SEED );
+    bench_sweeps();
+    srand( SEED );
+    bench_meshes();
+    srand( SEED );
+    bench_instances();
+    srand( SEED );
+    bench_spheres();
+
+    if( stats_enabled() )
+    {
+        std::cout << std::endl << "counters (including workload generation):" << std::endl << stats();
+    }
+
+    if( json_path != NULL && !write_json( json_path ) )
+    {
+        fprintf( stderr, "cannot write %s\n", json_path );
+        return 1;
+    }
+    return 0;
+}
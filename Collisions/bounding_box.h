@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include "vector.h"
+
+namespace Collisions
+{
+    // axis-aligned bounding box
+    class BoundingBox
+    {
+    public:
+        Point min, max;
+
+        // empty box, containing nothing
+        BoundingBox() : min(  std::numeric_limits<double>::infinity(),  std::numeric_limits<double>::infinity(),  std::numeric_limits<double>::infinity() ),
+                        max( -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() ) {}
+        BoundingBox(const Point &min, const Point &max) : min(min), max(max) {}
+
+        bool is_empty() const
+        {
+            return min.x > max.x || min.y > max.y || min.z > max.z;
+        }
+
+        // extend the box to contain given point/box
+        BoundingBox & add(const Point &point)
+        {
+            min = Point( std::min( min.x, point.x ), std::min( min.y, point.y ), std::min( min.z, point.z ) );
+            max = Point( std::max( max.x, point.x ), std::max( max.y, point.y ), std::max( max.z, point.z ) );
+            return *this;
+        }
+        BoundingBox & add(const BoundingBox &another)
+        {
+            if( !another.is_empty() )
+            {
+                add( another.min );
+                add( another.max );
+            }
+            return *this;
+        }
+
+        Point center() const
+        {
+            return (min + max)/2;
+        }
+        Vector size() const
+        {
+            return max - min;
+        }
+        double surface_area() const
+        {
+            if( is_empty() )
+            {
+                return 0;
+            }
+            const Vector s = size();
+            return 2*( s.x*s.y + s.y*s.z + s.z*s.x );
+        }
+
+        // returns the box, extended by `margin' in all directions (Minkowski sum with a cube)
+        BoundingBox inflated(double margin) const
+        {
+            const Vector shift( margin, margin, margin );
+            return BoundingBox( min - shift, max + shift );
+        }
+
+        bool contains(const Point &point) const
+        {
+            return min.x <= point.x && point.x <= max.x &&
+                   min.y <= point.y && point.y <= max.y &&
+                   min.z <= point.z && point.z <= max.z;
+        }
+        bool intersects(const BoundingBox &another) const
+        {
+            return min.x <= another.max.x && another.min.x <= max.x &&
+                   min.y <= another.max.y && another.min.y <= max.y &&
+                   min.z <= another.max.z && another.min.z <= max.z;
+        }
+        // squared distance from the point to the nearest point of the box: 0 inside it, infinity for the empty box
+        double squared_distance(const Point &point) const
+        {
+            const double dx = std::max( std::max( min.x - point.x, point.x - max.x ), 0.0 );
+            const double dy = std::max( std::max( min.y - point.y, point.y - max.y ), 0.0 );
+            const double dz = std::max( std::max( min.z - point.z, point.z - max.z ), 0.0 );
+            return dx*dx + dy*dy + dz*dz;
+        }
+    };
+
+    inline BoundingBox bounding_box(const Triangle &triangle)
+    {
+        return BoundingBox().add( triangle[0] ).add( triangle[1] ).add( triangle[2] );
+    }
+    inline BoundingBox bounding_box(const PreparedTriangle &triangle)
+    {
+        return BoundingBox().add( triangle[0] ).add( triangle[1] ).add( triangle[2] );
+    }
+    // bounding box of a sphere, moving along the segment
+    inline BoundingBox bounding_box(const Point &segment_start, const Point &segment_end, double sphere_radius)
+    {
+        return BoundingBox().add( segment_start ).add( segment_end ).inflated( sphere_radius );
+    }
+
+    // Segment, prepared for many tests against boxes: inverse of its vector is computed once
+    class BoxRay
+    {
+    public:
+        Point start;
+        Vector vector;
+        Vector inverse; // 1/vector per coordinate (infinite for zero coordinates)
+
+        BoxRay(const Point &segment_start, const Point &segment_end)
+            : start(segment_start), vector(segment_end - segment_start),
+              inverse( 1/vector.x, 1/vector.y, 1/vector.z )
+        {
+        }
+    };
+
+    // Returns true if the segment start + t*vector, t in [0, max_time], crosses the box,
+    // and writes the time of entering the box (0, if it starts inside)
+    inline bool segment_and_box_collision(const BoxRay &ray, const BoundingBox &box, double max_time,
+                                          /*out*/ double &entry_time)
+    {
+        double enter = 0;
+        double leave = max_time;
+        const double starts[3] = { ray.start.x, ray.start.y, ray.start.z };
+        const double vectors[3] = { ray.vector.x, ray.vector.y, ray.vector.z };
+        const double inverses[3] = { ray.inverse.x, ray.inverse.y, ray.inverse.z };
+        const double mins[3] = { box.min.x, box.min.y, box.min.z };
+        const double maxs[3] = { box.max.x, box.max.y, box.max.z };
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( vectors[i] == 0 )
+            {
+                // parallel to the slab: either always inside it, or never
+                if( starts[i] < mins[i] || starts[i] > maxs[i] )
+                {
+                    return false;
+                }
+                continue;
+            }
+            double t1 = (mins[i] - starts[i])*inverses[i];
+            double t2 = (maxs[i] - starts[i])*inverses[i];
+            if( t1 > t2 )
+            {
+                std::swap( t1, t2 );
+            }
+            enter = std::max( enter, t1 );
+            leave = std::min( leave, t2 );
+            if( enter > leave )
+            {
+                return false;
+            }
+        }
+        entry_time = enter;
+        return true;
+    }
+};
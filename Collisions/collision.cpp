@@ -1,4 +1,5 @@
 #include "collisions.h"
+#include "kernels.h"
 #include <algorithm>
 #include <cmath>
 
@@ -7,30 +8,40 @@ namespace Collisions
     // -------------------------- H e l p e r s ------------------------------------------
 
     // Returns true, if first point is between second and third
-    bool is_point_between(const Point &inner_point, const Point &outer_point1, const Point &outer_point2)
+    template <class T>
+    bool is_point_between(const BasicPoint<T> &inner_point, const BasicPoint<T> &outer_point1, const BasicPoint<T> &outer_point2)
     {
-        const double squared_length = (outer_point2 - outer_point1).sqared_norm();
+        const T squared_length = (outer_point2 - outer_point1).sqared_norm();
         return ( less_or_equal( (inner_point - outer_point1).sqared_norm(), squared_length ) &&
                  less_or_equal( (outer_point2 - inner_point).sqared_norm(), squared_length ) );
     }
 
-    double distance_between_point_and_line(const Point &point, const Point &line_point, const Vector &line_vector,
-                                           /*out*/ Point &nearest_point )
-    {
-        check_nonzero_vector( line_vector, InvalidLineVectorError() );
+    // Functions with leading underscore are unchecked versions of helpers: they expect already validated input.
 
-        const double t = line_vector*(point - line_point) / line_vector.sqared_norm();
-        const Point perpendicular_base = line_point + t*line_vector;
+    template <class T>
+    inline T _distance_between_point_and_line(const BasicPoint<T> &point, const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                              /*out*/ BasicPoint<T> &nearest_point )
+    {
+        const T t = line_vector*(point - line_point) / line_vector.sqared_norm();
+        const BasicPoint<T> perpendicular_base = line_point + t*line_vector;
         nearest_point = perpendicular_base;
         return distance( point, perpendicular_base );
     }
 
-    double distance_between_point_and_segment(const Point &point, const Point &segment_start, const Point &segment_end)
+    template <class T>
+    T distance_between_point_and_line(const BasicPoint<T> &point, const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                      /*out*/ BasicPoint<T> &nearest_point )
     {
-        check_segment( segment_start, segment_end );
+        check_nonzero_vector( line_vector, InvalidLineVectorError() );
+
+        return _distance_between_point_and_line( point, line_point, line_vector, nearest_point );
+    }
 
-        Point nearest;
-        double dst = distance_between_point_and_line( point, segment_start, segment_end - segment_start, nearest );
+    template <class T>
+    inline T _distance_between_point_and_segment(const BasicPoint<T> &point, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end)
+    {
+        BasicPoint<T> nearest;
+        T dst = _distance_between_point_and_line( point, segment_start, segment_end - segment_start, nearest );
         if( ! is_point_between( nearest, segment_start, segment_end ) )
         {
             dst = std::min( distance( point, segment_start ), distance( point, segment_end ) );
@@ -38,49 +49,57 @@ namespace Collisions
         return dst;
     }
 
-    Point _nearest_on_parallels(const Point &line_point1, const Point &line_point2, const Vector &line_vector)
+    template <class T>
+    T distance_between_point_and_segment(const BasicPoint<T> &point, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end)
+    {
+        check_segment( segment_start, segment_end );
+
+        return _distance_between_point_and_segment( point, segment_start, segment_end );
+    }
+
+    template <class T>
+    BasicPoint<T> _nearest_on_parallels(const BasicPoint<T> &line_point1, const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector)
     // returns the point on first line, nearest to line_point2
     {
-        const Vector L1 = line_vector.normalized();
+        const BasicVector<T> L1 = line_vector.normalized();
         return line_point1 + ( (line_point2 - line_point1)*L1 )*L1; // A1 plus proection of A2-A1 onto L1
     }
 
-    double distance_between_two_lines(const Point &line_point1, const Vector &line_vector1,
-                                      const Point &line_point2, const Vector &line_vector2)
+    template <class T>
+    T distance_between_two_lines(const BasicPoint<T> &line_point1, const BasicVector<T> &line_vector1,
+                                 const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector2)
     {
         check_nonzero_vector( line_vector1, InvalidLineVectorError() );
         check_nonzero_vector( line_vector2, InvalidLineVectorError() );
-        const Vector h = cross_product( line_vector1, line_vector2 ).normalized(); // perpendicular
-        double dst;
+        const BasicVector<T> h = cross_product( line_vector1, line_vector2 ).normalized(); // perpendicular
+        T dst;
         if( h.is_zero() )
         {
             // lines are parallel
-            const Point H = _nearest_on_parallels( line_point1, line_point2, line_vector1 );
+            const BasicPoint<T> H = _nearest_on_parallels( line_point1, line_point2, line_vector1 );
             dst = distance( H, line_point2 );
         }
         else
         {
             // lines are not parallel
-            dst = fabs( (line_point2 - line_point1)*h ); // legth of projection of 'vector from one line to another' to the perpendicular
+            dst = std::fabs( (line_point2 - line_point1)*h ); // legth of projection of 'vector from one line to another' to the perpendicular
         }
         return dst;
     }
 
-    void nearest_points_on_lines(const Point &line_point1, const Vector &line_vector1,
-                                 const Point &line_point2, const Vector &line_vector2,
-                                 /*out*/ Point &result1, Point &result2)
+    template <class T>
+    void _nearest_points_on_lines(const BasicPoint<T> &line_point1, const BasicVector<T> &line_vector1,
+                                  const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector2,
+                                  /*out*/ BasicPoint<T> &result1, BasicPoint<T> &result2)
     {
-        check_nonzero_vector( line_vector1, InvalidLineVectorError() );
-        check_nonzero_vector( line_vector2, InvalidLineVectorError() );
-
-        const Point &A1 = line_point1; // aliases
-        const Point &A2 = line_point2;
-        const Point &L1 = line_vector1;
-        const Point &L2 = line_vector2;
+        const BasicPoint<T> &A1 = line_point1; // aliases
+        const BasicPoint<T> &A2 = line_point2;
+        const BasicPoint<T> &L1 = line_vector1;
+        const BasicPoint<T> &L2 = line_vector2;
 
-        const double cross_product_sqared_norm = cross_product( L1, L2 ).sqared_norm();
+        const T cross_product_sqared_norm = cross_product( L1, L2 ).sqared_norm();
         
-        if( equal( 0.0, cross_product_sqared_norm ) )
+        if( equal( T(0), cross_product_sqared_norm ) )
         {
             // lines are parallel
             result1 = _nearest_on_parallels( line_point1, line_point2, line_vector1 );
@@ -91,11 +110,11 @@ namespace Collisions
             // lines are not parallel
 
             // MATH CHEAT: linear system solved by wxMaxima (see nearest_points.wxm)
-            const double t1 = ( ((A2.y-A1.y)*L1.y + (A2.x-A1.x)*L1.x)*L2.z*L2.z + (((A1.y-A2.y)*L1.z + (A1.z-A2.z)*L1.y)*L2.y
+            const T t1 = ( ((A2.y-A1.y)*L1.y + (A2.x-A1.x)*L1.x)*L2.z*L2.z + (((A1.y-A2.y)*L1.z + (A1.z-A2.z)*L1.y)*L2.y
                               + ((A1.x-A2.x)*L1.z + (A1.z-A2.z)*L1.x)*L2.x)*L2.z + ((A2.z-A1.z)*L1.z + (A2.x-A1.x)*L1.x)*L2.y*L2.y
                               + ((A1.x-A2.x)*L1.y + (A1.y-A2.y)*L1.x)*L2.x*L2.y + ((A2.z-A1.z)*L1.z + (A2.y-A1.y)*L1.y)*L2.x*L2.x
                               ) / cross_product_sqared_norm;
-            const double t2 = ( (((A2.y-A1.y)*L1.y + (A2.x-A1.x)*L1.x)*L1.z + (A1.z-A2.z)*L1.y*L1.y + (A1.z-A2.z)*L1.x*L1.x)*L2.z
+            const T t2 = ( (((A2.y-A1.y)*L1.y + (A2.x-A1.x)*L1.x)*L1.z + (A1.z-A2.z)*L1.y*L1.y + (A1.z-A2.z)*L1.x*L1.x)*L2.z
                               + ((A1.y-A2.y)*L1.z*L1.z + (A2.z-A1.z)*L1.y*L1.z + (A2.x-A1.x)*L1.x*L1.y + (A1.y-A2.y)*L1.x*L1.x)*L2.y
                               + ((A1.x-A2.x)*L1.z*L1.z + (A2.z-A1.z)*L1.x*L1.z + (A1.x-A2.x)*L1.y*L1.y + (A2.y-A1.y)*L1.x*L1.y)*L2.x
                               ) / cross_product_sqared_norm;
@@ -105,145 +124,246 @@ namespace Collisions
         }
     }
 
-    bool is_point_inside_triangle(const Point &point, const Triangle &triangle)
+    template <class T>
+    void nearest_points_on_lines(const BasicPoint<T> &line_point1, const BasicVector<T> &line_vector1,
+                                 const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector2,
+                                 /*out*/ BasicPoint<T> &result1, BasicPoint<T> &result2)
     {
-        // TODO: check whether the point is in the same plane as triangle.
-        // By now this function returns true if the _projection_ of the point is inside triangle
-        const Vector u = triangle[1] - triangle[0];
-        const Vector v = triangle[2] - triangle[0];
-        const Vector r = point - triangle[0];
-        
-        // find components of r along u and v
-        const double determinant = (u*u)*(v*v) - (u*v)*(u*v);
-        check( determinant != 0, DegeneratedTriangleError() );
+        check_nonzero_vector( line_vector1, InvalidLineVectorError() );
+        check_nonzero_vector( line_vector2, InvalidLineVectorError() );
+
+        _nearest_points_on_lines( line_point1, line_vector1, line_point2, line_vector2, result1, result2 );
+    }
 
-        const double ru = ( (r*u)*(v*v) - (u*v)*(r*v) ) / determinant;
-        const double rv = ( (u*u)*(r*v) - (r*u)*(u*v) ) / determinant;
+    template <class T>
+    bool is_point_inside_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle)
+    {
+        const BasicVector<T> u = triangle[1] - triangle[0];
+        const BasicVector<T> v = triangle[2] - triangle[0];
+        check( (u*u)*(v*v) - (u*v)*(u*v) != 0, DegeneratedTriangleError() );
 
-        return greater_or_equal( ru, 0 ) && greater_or_equal( rv, 0 ) && less_or_equal( ru + rv, 1 );
+        return _is_point_inside_triangle( point, triangle );
     }
 
-    // Returns base of perpendicular, dropped from first line to second, with given length.
-    // Returns "earlier" point (looking along first line vector)
-    Point perpendicular_base(const Vector &line_vector1, const Vector &line_vector2, const Point &crosspoint, double perpendicular_length)
+    template <class T>
+    bool is_point_inside_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle)
     {
-        check_nonzero_vector( line_vector1, InvalidLineVectorError() );
-        check_nonzero_vector( line_vector2, InvalidLineVectorError() );
+        return _is_point_inside_triangle( point, triangle );
+    }
+
+    template <class T>
+    BasicPoint<T> closest_point_on_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle)
+    {
+        return _closest_point_on_triangle( point, triangle );
+    }
+
+    template <class T>
+    BasicPoint<T> closest_point_on_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle)
+    {
+        return _closest_point_on_triangle( point, triangle );
+    }
+
+    template <class T>
+    T distance_between_point_and_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle)
+    {
+        return distance( point, _closest_point_on_triangle( point, triangle ) );
+    }
+
+    template <class T>
+    T distance_between_point_and_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle)
+    {
+        return distance( point, _closest_point_on_triangle( point, triangle ) );
+    }
 
-        const Vector L1 = line_vector1.normalized();
-        const Vector L2 = line_vector2.normalized();
-        const double cosine = L1*L2;
-        const double angle = acos(cosine);
+    // returns false instead of throwing ParallelLinesError
+    template <class T>
+    bool _perpendicular_base(const BasicVector<T> &line_vector1, const BasicVector<T> &line_vector2, const BasicPoint<T> &crosspoint, Scalar<T> perpendicular_length,
+                             /*out*/ BasicPoint<T> &result)
+    {
+        const BasicVector<T> L1 = line_vector1.normalized();
+        const BasicVector<T> L2 = line_vector2.normalized();
+        const T cosine = L1*L2;
+        const T angle = acos(cosine);
         if( equal( 0, cosine ) )
         {
             // L1 is ortogonal to L2
-            return crosspoint;
+            result = crosspoint;
         }
         else if( equal( 0, sin(angle) ) )
         {
             // L1 is parallel to L2
-            throw ParallelLinesError();
+            return false;
         }
         else
         {
-            const double distance = perpendicular_length/tan(angle);
-            return crosspoint - distance*L2;
+            const T distance = perpendicular_length/tan(angle);
+            result = crosspoint - distance*L2;
         }
+        return true;
+    }
+
+    // Returns base of perpendicular, dropped from first line to second, with given length.
+    // Returns "earlier" point (looking along first line vector)
+    template <class T>
+    BasicPoint<T> perpendicular_base(const BasicVector<T> &line_vector1, const BasicVector<T> &line_vector2, const BasicPoint<T> &crosspoint, Scalar<T> perpendicular_length)
+    {
+        check_nonzero_vector( line_vector1, InvalidLineVectorError() );
+        check_nonzero_vector( line_vector2, InvalidLineVectorError() );
+
+        BasicPoint<T> result;
+        check( _perpendicular_base( line_vector1, line_vector2, crosspoint, perpendicular_length, result ), ParallelLinesError() );
+        return result;
     }
 
-    // if vector pointing outside triangle, while crossing given side
-    inline bool _is_vector_outside(Vector vector, Triangle triangle, unsigned side)
+    // outer normal of triangle's side, reusing already calculated triangle normal
+    template <class T>
+    inline BasicVector<T> _side_outer_normal(const BasicTriangle<T> &triangle, const BasicVector<T> &normal, unsigned side)
+    {
+        return cross_product( triangle[side] - triangle[ (side+1)%3 ], normal ).normalized();
+    }
+    // ... or just taking a cached one
+    template <class T>
+    inline BasicVector<T> _side_outer_normal(const BasicPreparedTriangle<T> &triangle, const BasicVector<T> &, unsigned side)
     {
-        return vector*triangle.side_outer_normal(side) < 0;
+        return triangle.side_outer_normal( side );
     }
 
-    // -------------------- C o l l i s i o n   f i n d e r s -----------------------------
+    // -------------------- C o l l i s i o n   k e r n e l s -----------------------------
+    // Unchecked versions of collision finders: they neither validate input nor throw.
     // All functions return true, if there is a collision, false - if none;
-    // and write collision point into `collison_point', if there is any.
+    // and write collision point into `collison_point' and time of impact into `time', if there is any.
 
-    bool line_and_plane_collision(const Point &line_point, const Vector &line_vector,
-                                  const Point &plane_point, const Vector &plane_normal,
-                                  /*out*/ Point &collision_point)
+    template <class T>
+    inline bool _line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                          const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                          /*out*/ BasicPoint<T> &collision_point, T &time)
     {
-        check_nonzero_vector( line_vector, InvalidLineVectorError() );
-        check_nonzero_vector( plane_normal, InvalidNormalError() );
-
-        const double denominator = line_vector * plane_normal;
+        const T denominator = line_vector * plane_normal;
         if( equal( 0, denominator ) )
         {
             return false;
         }
         else
         {
-            const double t = (plane_point - line_point)*plane_normal/denominator;
+            const T t = (plane_point - line_point)*plane_normal/denominator;
             collision_point = line_point + t*line_vector;
+            time = t;
             return true;
         }
     }
 
-    bool segment_and_plane_collision(const Point &segment_start, const Point &segment_end,
-                                     const Point &plane_point, const Vector &plane_normal,
-                                     /*out*/ Point &collision_point)
+    template <class T>
+    inline bool _segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                             const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                             /*out*/ BasicPoint<T> &collision_point, T &time)
     {
-        check_segment( segment_start, segment_end );
-        check_nonzero_vector( plane_normal, InvalidNormalError() );
-
-        Point point;
-        bool result = line_and_plane_collision( segment_start, segment_end - segment_start,
-                                                plane_point, plane_normal, point );
+        BasicPoint<T> point;
+        T t;
+        bool result = _line_and_plane_collision( segment_start, segment_end - segment_start,
+                                                 plane_point, plane_normal, point, t );
         if( result )
         {
             result = is_point_between( point, segment_start, segment_end );
             if( result )
             {
                 collision_point = point;
+                time = t;
             }
         }
         return result;
     }
 
-    bool sphere_and_plane_collision(const Point &segment_start, const Point &segment_end, double sphere_radius,
-                                    const Point &plane_point, const Vector &plane_normal,
-                                    /*out*/ Point &collision_point)
+    template <class T>
+    inline bool _sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                            const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                            /*out*/ BasicPoint<T> &collision_point, T &time)
     {
-        check_segment( segment_start, segment_end );
-        check_nonzero_vector( plane_normal, InvalidNormalError() );
-
-        const Vector line_vector = segment_end - segment_start;
-        const Vector shift = sign( line_vector*plane_normal )*sphere_radius*plane_normal; // shift trajectory up or down depending on whether collision is lower or upper
-        Point point;
-        const bool result = segment_and_plane_collision( segment_start + shift,
-                                                         segment_end   + shift,
-                                                         plane_point, plane_normal, point );
+        const BasicVector<T> line_vector = segment_end - segment_start;
+        const BasicVector<T> shift = sign( line_vector*plane_normal )*sphere_radius*plane_normal; // shift trajectory up or down depending on whether collision is lower or upper
+        BasicPoint<T> point;
+        T t;
+        const bool result = _segment_and_plane_collision( segment_start + shift,
+                                                          segment_end   + shift,
+                                                          plane_point, plane_normal, point, t ); // shifted trajectory has the same timing
         if( result )
         {
             collision_point = point;
+            time = t;
         }
         return result;
     }
 
-    bool sphere_and_point_collision(const Point &segment_start, const Point &segment_end, double sphere_radius,
-                                    const Point &point)
+    template <class T>
+    inline bool _sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                            const BasicPoint<T> &point, /*out*/ T &time)
     {
-        check_segment( segment_start, segment_end );
-
-        return greater_or_equal( sphere_radius, distance_between_point_and_segment( point, segment_start, segment_end ) );
+        if( !greater_or_equal( sphere_radius, _distance_between_point_and_segment( point, segment_start, segment_end ) ) )
+        {
+            return false;
+        }
+        // sphere touches the point first, when |segment_start + t*L - point| == sphere_radius
+        const BasicVector<T> L = segment_end - segment_start;
+        const BasicVector<T> w = segment_start - point;
+        const T c = w*w - sphere_radius*sphere_radius;
+        if( c <= 0 )
+        {
+            time = 0; // touching it from the very start
+        }
+        else
+        {
+            const T b = w*L;
+            const T discriminant = std::max( b*b - L.sqared_norm()*c, T(0) ); // may be a bit less than 0 within tolerance
+            time = std::min( std::max( ( -b - std::sqrt( discriminant ) )/L.sqared_norm(), T(0) ), T(1) );
+        }
+        return true;
     }
 
-    bool sphere_and_segment_collision(const Point &sphere_segment_start, const Point &sphere_segment_end, double sphere_radius,
-                                      const Point &segment_start, const Point &segment_end,
-                                      /*out*/ Point &collision_point)
+    // Two moving spheres touch, when the distance between centers is the sum of radii: in motion relative
+    // to the second sphere this is a sphere of that radius moving against its start point, one quadratic solve
+    template <class T>
+    inline bool _sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                             const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                             /*out*/ BasicPoint<T> &collision_point, T &time)
     {
-        check_segment( segment_start, segment_end );
-        check_segment( sphere_segment_start, sphere_segment_end );
+        const BasicVector<T> L = (segment_end1 - segment_start1) - (segment_end2 - segment_start2);
+        const BasicVector<T> w = segment_start1 - segment_start2;
+        const T radii_sum = sphere_radius1 + sphere_radius2;
+        const T L_squared = L.sqared_norm();
+        T t;
+        if( L_squared == 0 )
+        {
+            // moving in parallel: the distance stays the same
+            if( !greater_or_equal( radii_sum, w.norm() ) )
+            {
+                return false;
+            }
+            t = 0;
+        }
+        else if( !_sphere_and_point_entry( L, L_squared, w, radii_sum, t ) )
+        {
+            return false;
+        }
+        const BasicPoint<T> center1 = segment_start1 + t*(segment_end1 - segment_start1);
+        const BasicPoint<T> center2 = segment_start2 + t*(segment_end2 - segment_start2);
+        collision_point = center2 + (sphere_radius2/radii_sum)*(center1 - center2);
+        time = t;
+        return true;
+    }
 
-        const Vector L_sphere = (sphere_segment_end - sphere_segment_start).normalized();
-        const Vector L_segment = (segment_end - segment_start).normalized();
+    // The original version: finds the touch point from the nearest points of the lines and the angle between them.
+    // Kept for comparison (see COLLISIONS_TRIGONOMETRIC_SEGMENT option in CMakeLists.txt)
+    template <class T>
+    bool _sphere_and_segment_collision_trigonometric(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+        const BasicVector<T> L_sphere = (sphere_segment_end - sphere_segment_start).normalized();
+        const BasicVector<T> L_segment = (segment_end - segment_start).normalized();
         
-        Point nearest_on_sphere_way, nearest_on_segment;
-        nearest_points_on_lines( sphere_segment_start, L_sphere, segment_start, L_segment, nearest_on_sphere_way, nearest_on_segment);
+        BasicPoint<T> nearest_on_sphere_way, nearest_on_segment;
+        _nearest_points_on_lines( sphere_segment_start, L_sphere, segment_start, L_segment, nearest_on_sphere_way, nearest_on_segment);
         
-        const double dist = distance( nearest_on_sphere_way, nearest_on_segment );
+        const T dist = distance( nearest_on_sphere_way, nearest_on_segment );
         
         if( L_sphere.is_collinear_to( L_segment ) )
         {
@@ -254,8 +374,12 @@ namespace Collisions
         if( greater_or_equal( sphere_radius, dist ) )
         {
             // if distance between lines is less than radius
-            const double perpendicular_length = sqrt( sphere_radius*sphere_radius - dist*dist );
-            Point result = perpendicular_base( L_sphere, L_segment, nearest_on_segment, perpendicular_length );
+            const Scalar<T> perpendicular_length = std::sqrt( sphere_radius*sphere_radius - dist*dist );
+            BasicPoint<T> result;
+            if( !_perpendicular_base( L_sphere, L_segment, nearest_on_segment, perpendicular_length, result ) )
+            {
+                return false;
+            }
 
             // now check that this collision point is inside the segment
             if( !is_point_between( result, segment_start, segment_end ) )
@@ -263,20 +387,20 @@ namespace Collisions
                 return false;
             }
 
-            Vector normal; // normal, aimed from L_segment to L_sphere
+            BasicVector<T> normal; // normal, aimed from L_segment to L_sphere
             if( L_sphere.is_orthogonal_to(L_segment) )
             {
                 normal = - L_sphere.normalized();
             }
             else
             {
-                const Vector L_segment_other = (result - nearest_on_segment).normalized();
+                const BasicVector<T> L_segment_other = (result - nearest_on_segment).normalized();
                 assert( L_segment_other == L_segment || L_segment_other == -L_segment );
                 // calculating normal, aimed from L_segment to L_sphere as double cross-product. L_segment_other is used instead of L_segment in order to avoid sign mess
                 normal = cross_product( cross_product( L_sphere, L_segment_other ), L_segment_other ).normalized();
             }
             assert( !normal.is_zero() );
-            Point sphere_center = result + perpendicular_length*normal + (nearest_on_sphere_way - nearest_on_segment); // sphere center is here at the moment of collision
+            BasicPoint<T> sphere_center = result + perpendicular_length*normal + (nearest_on_sphere_way - nearest_on_segment); // sphere center is here at the moment of collision
 
             // now check that sphere center at the moment of collision is inside the segment
             if( !is_point_between( sphere_center, sphere_segment_start, sphere_segment_end ) )
@@ -285,7 +409,9 @@ namespace Collisions
             }
 
             // all checks passed => there is a collision
+            const BasicVector<T> L = sphere_segment_end - sphere_segment_start;
             collision_point = result;
+            time = (sphere_center - sphere_segment_start)*L/L.sqared_norm();
             return true;
         }
         else
@@ -295,69 +421,1248 @@ namespace Collisions
         }
     }
 
-    bool sphere_and_triangle_collision(const Point &segment_start, const Point &segment_end, double sphere_radius, const Triangle &triangle,
-                                       /*out*/ Point &collision_point)
+    template <class T>
+    bool _sphere_and_segment_collision_quadratic(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                 const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                 /*out*/ BasicPoint<T> &collision_point, T &time)
     {
-        check_segment( segment_start, segment_end );
-        const Vector L_sphere = segment_end - segment_start;
+        const BasicVector<T> D = segment_end - segment_start;
+        T t, u;
+        if( !_sphere_and_line_entry( sphere_segment_end - sphere_segment_start, sphere_segment_start - segment_start, D, sphere_radius, t, u ) ||
+            !greater_or_equal( u, 0 ) || !less_or_equal( u, 1 ) )
+        {
+            return false;
+        }
+        collision_point = segment_start + u*D;
+        time = t;
+        return true;
+    }
+
+    template <class T>
+    inline bool _sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                              const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                              /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+#ifdef COLLISIONS_TRIGONOMETRIC_SEGMENT
+        return _sphere_and_segment_collision_trigonometric( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                            segment_start, segment_end, collision_point, time );
+#else
+        return _sphere_and_segment_collision_quadratic( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                        segment_start, segment_end, collision_point, time );
+#endif
+    }
+
+    // The original version: a plane, three segments and three points, tested one by one.
+    // Kept for comparison (see COLLISIONS_DECOMPOSED_TRIANGLE option in CMakeLists.txt).
+    // TriangleType is either BasicTriangle<T> or BasicPreparedTriangle<T>: the latter has normals cached
+    template <class T, template <class> class TriangleType>
+    bool _sphere_and_triangle_collision_decomposed(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const TriangleType<T> &triangle,
+                                                   /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+        COLLISIONS_COUNT( Counter::TriangleKernelCalls );
+        const BasicVector<T> L_sphere = segment_end - segment_start;
+        const BasicVector<T> normal = triangle.normal();
         
         // 1) is it touching a plane of triangle?
-        Point result_point;
-        bool result = sphere_and_plane_collision( segment_start, segment_end, sphere_radius, triangle[0], triangle.normal(), result_point );
+        BasicPoint<T> result_point;
+        T result_time;
+        bool result = _sphere_and_plane_collision( segment_start, segment_end, sphere_radius, triangle[0], normal, result_point, result_time );
         if( result )
         {
             // 1.1) is touching point really inside triangle
-            if( is_point_inside_triangle( result_point, triangle ) )
+            if( _is_point_inside_triangle( result_point, triangle ) )
             {
+                COLLISIONS_COUNT( Counter::TrianglePlaneHits );
                 collision_point = result_point;
+                time = result_time;
                 return true;
             }
+            COLLISIONS_COUNT( Counter::TrianglePlaneOutside );
         }
         
+        // sphere should move inside the triangle while crossing side #i to hit it
+        bool moving_inside[3];
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            moving_inside[i] = _is_vector_outside( L_sphere, _side_outer_normal( triangle, normal, i ) );
+        }
+
         // 2) if not, is it touching any side of triangle?
         bool any_result = false; // will be true, if there is a collision with at least one side
-        Point best_result_point; // best point is the point, nearest to the start of sphere's way
+        BasicPoint<T> best_result_point; // best point is the point, touched first
+        T best_result_time = 0;
+        COLLISIONS_COUNT_N( Counter::TriangleEdgeTests, 3 );
         for( unsigned i = 0; i < 3; ++i )
         {
-            result = sphere_and_segment_collision( segment_start, segment_end, sphere_radius,
-                                                   triangle[i], triangle[ (i+1)%3 ], result_point );
-            if( result && _is_vector_outside( L_sphere, triangle, i ) )
+            result = _sphere_and_segment_collision( segment_start, segment_end, sphere_radius,
+                                                    triangle[i], triangle[ (i+1)%3 ], result_point, result_time );
+            COLLISIONS_COUNT_IF( result && !moving_inside[i], Counter::TriangleEdgesMovingOutside );
+            if( result && moving_inside[i] )
             {
                 // if there is a collision, and sphere is moving inside, not outside
-                if( !any_result || distance( best_result_point, segment_start ) > distance( result_point, segment_start ) )
+                if( !any_result || best_result_time > result_time )
                 {
                     // if no best result, or if the best result is worst than current
                     best_result_point = result_point;
+                    best_result_time = result_time;
                 }
                 any_result = true;
             }
         }
         if( any_result )
         {
+            COLLISIONS_COUNT( Counter::TriangleEdgeHits );
             collision_point = best_result_point;
+            time = best_result_time;
             return true;
         }
 
         // 3) if not, is it touching any vertex of triangle?
         any_result = false;
+        COLLISIONS_COUNT_N( Counter::TriangleVertexTests, 3 );
         for( unsigned i = 0; i < 3; ++i )
         {
-            result = sphere_and_point_collision( segment_start, segment_end, sphere_radius, triangle[i] );
-            if( result &&  _is_vector_outside( L_sphere, triangle, i ) && _is_vector_outside( L_sphere, triangle, (i+2)%3 ) )
+            result = _sphere_and_point_collision( segment_start, segment_end, sphere_radius, triangle[i], result_time );
+            if( result && moving_inside[i] && moving_inside[ (i+2)%3 ] )
             {
-                if( !any_result || distance( best_result_point, segment_start ) > distance( triangle[i], segment_start ) )
+                if( !any_result || best_result_time > result_time )
                 {
                     // if no best result, or if the best result is worst than current
                     best_result_point = triangle[i];
+                    best_result_time = result_time;
                 }
                 any_result = true;
             }
         }
         if( any_result )
         {
+            COLLISIONS_COUNT( Counter::TriangleVertexHits );
             collision_point = best_result_point;
+            time = best_result_time;
+            return true;
+        }
+        COLLISIONS_COUNT( Counter::TriangleMisses );
+        return false;
+    }
+
+    // side #i of triangle: from vertex #i to vertex #i+1
+    template <class T>
+    inline BasicVector<T> _side(const BasicTriangle<T> &triangle, unsigned side)
+    {
+        return triangle[ (side+1)%3 ] - triangle[side];
+    }
+    template <class T>
+    inline BasicVector<T> const & _side(const BasicPreparedTriangle<T> &triangle, unsigned side)
+    {
+        return triangle.side( side );
+    }
+
+    // outer normal of triangle's side, not normalized: only its direction is needed
+    template <class T>
+    inline BasicVector<T> _side_outer_direction(const BasicTriangle<T> &, const BasicVector<T> &normal, unsigned, const BasicVector<T> &side_vector)
+    {
+        return cross_product( -side_vector, normal );
+    }
+    template <class T>
+    inline BasicVector<T> const & _side_outer_direction(const BasicPreparedTriangle<T> &triangle, const BasicVector<T> &, unsigned side, const BasicVector<T> &)
+    {
+        return triangle.side_outer_normal( side );
+    }
+
+    // Single-pass version of the decomposition above: the sphere way, vectors from vertices to the sphere
+    // and distances to the plane are computed once and shared by all tests. Only regions, which can be hit,
+    // are tested: nothing, if the sphere never comes near the plane; the face; sides, through which the sphere
+    // is moving inside; vertices, if no side is hit and the sphere is moving inside through both adjacent sides.
+    // Returns the same results as _sphere_and_triangle_collision_decomposed. Without `Earliest' returns the first
+    // side or vertex touch found, not the earliest one: whether there is a collision is the same.
+    template <bool Earliest, class T, template <class> class TriangleType>
+    bool _sphere_and_triangle_collision_fused(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const TriangleType<T> &triangle,
+                                              /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+        COLLISIONS_COUNT( Counter::TriangleKernelCalls );
+        const BasicVector<T> L = segment_end - segment_start;
+        const BasicVector<T> normal = triangle.normal();
+        const BasicVector<T> w[3] = { segment_start - triangle[0], segment_start - triangle[1], segment_start - triangle[2] };
+
+        // 0) signed distances from the sphere center to the plane at the start and at the end
+        const T L_normal = L*normal;
+        const T start_height = w[0]*normal;
+        const T end_height = start_height + L_normal;
+        if( start_height*end_height > 0 &&
+            !less_or_equal<_PlaneRejectTolerance>( std::min( start_height*start_height, end_height*end_height ), sphere_radius*sphere_radius ) )
+        {
+            COLLISIONS_COUNT( Counter::TrianglePlaneRejects );
+            COLLISIONS_COUNT( Counter::TriangleMisses );
+            return false;
+        }
+
+        // 1) is it touching a plane of triangle inside it?
+        if( !equal( 0, L_normal ) )
+        {
+            const T shift = sign( L_normal )*sphere_radius; // trajectory shifted up or down by it touches the plane
+            const T t = -( start_height + shift )/L_normal;
+            if( greater_or_equal( t, 0 ) && less_or_equal( t, 1 ) )
+            {
+                const BasicPoint<T> point = segment_start + shift*normal + t*L;
+                if( _is_point_inside_triangle( point, triangle ) )
+                {
+                    COLLISIONS_COUNT( Counter::TrianglePlaneHits );
+                    collision_point = point;
+                    time = t;
+                    return true;
+                }
+                COLLISIONS_COUNT( Counter::TrianglePlaneOutside );
+            }
+        }
+
+        // 2) sides, through which the sphere is moving inside the triangle
+        BasicVector<T> sides[3];
+        bool moving_inside[3];
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            sides[i] = _side( triangle, i );
+            moving_inside[i] = _is_vector_outside( L, _side_outer_direction( triangle, normal, i, sides[i] ) );
+        }
+        bool any_result = false;
+        T best_time = 0;
+        T best_position = 0;
+        unsigned best_side = 0;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( !moving_inside[i] )
+                continue;
+            COLLISIONS_COUNT( Counter::TriangleEdgeTests );
+            T t, u;
+            if( _sphere_and_line_entry( L, w[i], sides[i], sphere_radius, t, u ) &&
+                greater_or_equal( u, 0 ) && less_or_equal( u, 1 ) &&
+                ( !any_result || best_time > t ) )
+            {
+                best_time = t;
+                best_position = u;
+                best_side = i;
+                any_result = true;
+                if( !Earliest )
+                    break;
+            }
+        }
+        if( any_result )
+        {
+            COLLISIONS_COUNT( Counter::TriangleEdgeHits );
+            collision_point = triangle[best_side] + best_position*sides[best_side];
+            time = best_time;
+            return true;
+        }
+
+        // 3) vertices between such sides
+        const T L_squared = L.sqared_norm();
+        unsigned best_vertex = 0;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( !moving_inside[i] || !moving_inside[ (i+2)%3 ] )
+                continue;
+            COLLISIONS_COUNT( Counter::TriangleVertexTests );
+            T t;
+            if( _sphere_and_point_entry( L, L_squared, w[i], sphere_radius, t ) && ( !any_result || best_time > t ) )
+            {
+                best_time = t;
+                best_vertex = i;
+                any_result = true;
+                if( !Earliest )
+                    break;
+            }
+        }
+        if( any_result )
+        {
+            COLLISIONS_COUNT( Counter::TriangleVertexHits );
+            collision_point = triangle[best_vertex];
+            time = best_time;
             return true;
         }
+        COLLISIONS_COUNT( Counter::TriangleMisses );
         return false;
     }
+
+    template <class T, template <class> class TriangleType>
+    inline bool _sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const TriangleType<T> &triangle,
+                                               /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+#ifdef COLLISIONS_DECOMPOSED_TRIANGLE
+        return _sphere_and_triangle_collision_decomposed( segment_start, segment_end, sphere_radius, triangle, collision_point, time );
+#else
+        return _sphere_and_triangle_collision_fused<true>( segment_start, segment_end, sphere_radius, triangle, collision_point, time );
+#endif
+    }
+
+    // the same, but any touch of the triangle will do (see AnyHit)
+    template <class T, template <class> class TriangleType>
+    inline bool _sphere_and_triangle_any_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const TriangleType<T> &triangle,
+                                                   /*out*/ BasicPoint<T> &collision_point, T &time)
+    {
+#ifdef COLLISIONS_DECOMPOSED_TRIANGLE
+        return _sphere_and_triangle_collision_decomposed( segment_start, segment_end, sphere_radius, triangle, collision_point, time );
+#else
+        return _sphere_and_triangle_collision_fused<false>( segment_start, segment_end, sphere_radius, triangle, collision_point, time );
+#endif
+    }
+
+    // sphere center at the given time of moving along the segment
+    template <class T>
+    inline BasicPoint<T> _sphere_center(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, T time)
+    {
+        return segment_start + time*(segment_end - segment_start);
+    }
+
+    // Moller-Trumbore: origin + t*direction == vertex0 + u*edge1 + v*edge2 is solved by Cramer's rule, with
+    // determinants as triple products, sharing two cross products. Accepts t up to `max_time' and writes it
+    // with barycentric coordinates u and v. The way, parallel to the plane of the triangle (relative to
+    // lengths of the direction and the edges), misses it.
+    // Most tests are misses, which are hard to predict: bounds are checked on numerators, scaled by the
+    // determinant, all at once without branches, and the division is left for hits only.
+    template <class T>
+    inline bool _ray_and_triangle_collision(const BasicPoint<T> &origin, const BasicVector<T> &direction, T max_time,
+                                            const BasicPoint<T> &vertex0, const BasicVector<T> &edge1, const BasicVector<T> &edge2,
+                                            /*out*/ T &time, T &u, T &v)
+    {
+        const T epsilon = static_cast<T>( DefaultToleranceFor<T>::type::epsilon );
+        const BasicVector<T> p = cross_product( direction, edge2 );
+        const T determinant = edge1*p;
+        const T sign = determinant < 0 ? -1 : 1;
+        const T scale = sign*determinant;
+
+        const BasicVector<T> s = origin - vertex0;
+        const BasicVector<T> q = cross_product( s, edge1 );
+        const T scaled_u = sign*(s*p);
+        const T scaled_v = sign*(direction*q);
+        const T scaled_t = sign*(edge2*q);
+        const T tolerance = epsilon*scale;
+
+        const bool hit = ( determinant*determinant > epsilon*epsilon*direction.sqared_norm()*edge1.sqared_norm()*edge2.sqared_norm() ) &
+                         ( scaled_u >= -tolerance ) & ( scaled_v >= -tolerance ) & ( scaled_u + scaled_v <= scale + tolerance ) &
+                         ( scaled_t >= -tolerance ) & ( scaled_t <= max_time*scale + tolerance );
+        if( !hit )
+        {
+            return false;
+        }
+        const T inverse_scale = 1/scale;
+        time = scaled_t*inverse_scale;
+        u = scaled_u*inverse_scale;
+        v = scaled_v*inverse_scale;
+        return true;
+    }
+
+    template <class T>
+    inline bool _ray_and_triangle_collision(const BasicPoint<T> &origin, const BasicVector<T> &direction, T max_time, const BasicTriangle<T> &triangle,
+                                            /*out*/ T &time, T &u, T &v)
+    {
+        return _ray_and_triangle_collision( origin, direction, max_time, triangle[0], triangle[1] - triangle[0], triangle[2] - triangle[0], time, u, v );
+    }
+
+    // sides of prepared triangle are cached
+    template <class T>
+    inline bool _ray_and_triangle_collision(const BasicPoint<T> &origin, const BasicVector<T> &direction, T max_time, const BasicPreparedTriangle<T> &triangle,
+                                            /*out*/ T &time, T &u, T &v)
+    {
+        return _ray_and_triangle_collision( origin, direction, max_time, triangle[0], triangle.side(0), -triangle.side(2), time, u, v );
+    }
+
+    // --------- E x c e p t i o n - f r e e   c o l l i s i o n   f i n d e r s ----------
+
+    namespace NoThrow
+    {
+        template <class T>
+        CollisionStatus line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                                 const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                 /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::LineAndPlaneCalls );
+            if( line_vector.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+            if( plane_normal.is_zero() )
+                return CollisionStatus::InvalidNormal;
+
+            const bool result = _line_and_plane_collision( line_point, line_vector, plane_point, plane_normal, collision_point, time_of_impact );
+            COLLISIONS_COUNT_IF( result, Counter::LineAndPlaneHits );
+            return to_status( result );
+        }
+
+        template <class T>
+        CollisionStatus line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                                 const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                 /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            T time_of_impact;
+            return NoThrow::line_and_plane_collision( line_point, line_vector, plane_point, plane_normal, collision_point, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                    /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SegmentAndPlaneCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+            if( plane_normal.is_zero() )
+                return CollisionStatus::InvalidNormal;
+
+            const bool result = _segment_and_plane_collision( segment_start, segment_end, plane_point, plane_normal, collision_point, time_of_impact );
+            COLLISIONS_COUNT_IF( result, Counter::SegmentAndPlaneHits );
+            return to_status( result );
+        }
+
+        template <class T>
+        CollisionStatus segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                    /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            T time_of_impact;
+            return NoThrow::segment_and_plane_collision( segment_start, segment_end, plane_point, plane_normal, collision_point, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                   /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndPlaneCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+            if( plane_normal.is_zero() )
+                return CollisionStatus::InvalidNormal;
+
+            if( !_sphere_and_plane_collision( segment_start, segment_end, sphere_radius, plane_point, plane_normal, collision_point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndPlaneHits );
+            sphere_center = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                   /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            BasicPoint<T> sphere_center;
+            T time_of_impact;
+            return NoThrow::sphere_and_plane_collision( segment_start, segment_end, sphere_radius, plane_point, plane_normal,
+                                                        collision_point, sphere_center, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &point,
+                                                   /*out*/ BasicPoint<T> &sphere_center, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndPointCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            if( !_sphere_and_point_collision( segment_start, segment_end, sphere_radius, point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndPointHits );
+            sphere_center = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &point) noexcept
+        {
+            BasicPoint<T> sphere_center;
+            T time_of_impact;
+            return NoThrow::sphere_and_point_collision( segment_start, segment_end, sphere_radius, point, sphere_center, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                                    const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                                    /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndSphereCalls );
+            if( segment_start1 == segment_end1 && segment_start2 == segment_end2 )
+                return CollisionStatus::DegenerateSegment;
+
+            if( !_sphere_and_sphere_collision( segment_start1, segment_end1, sphere_radius1, segment_start2, segment_end2, sphere_radius2,
+                                               collision_point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndSphereHits );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                                    const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                                    /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            T time_of_impact;
+            return NoThrow::sphere_and_sphere_collision( segment_start1, segment_end1, sphere_radius1, segment_start2, segment_end2, sphere_radius2,
+                                                         collision_point, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndSegmentCalls );
+            if( segment_start == segment_end || sphere_segment_start == sphere_segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            if( !_sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                segment_start, segment_end, collision_point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndSegmentHits );
+            sphere_center = _sphere_center( sphere_segment_start, sphere_segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, BasicVector<T> &contact_normal, T &time_of_impact) noexcept
+        {
+            const CollisionStatus status = NoThrow::sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius, segment_start, segment_end,
+                                                                                  collision_point, sphere_center, time_of_impact );
+            if( status == CollisionStatus::Hit )
+            {
+                contact_normal = (sphere_center - collision_point)/sphere_radius;
+            }
+            return status;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            BasicPoint<T> sphere_center;
+            T time_of_impact;
+            return NoThrow::sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius, segment_start, segment_end,
+                                                          collision_point, sphere_center, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndTriangleCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+            if( triangle.is_degenerated() )
+                return CollisionStatus::DegenerateTriangle;
+
+            if( !_sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndTriangleHits );
+            sphere_center = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            BasicPoint<T> sphere_center;
+            T time_of_impact;
+            return NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, sphere_center, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndTriangleCalls );
+            // prepared triangle is validated on construction
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            if( !_sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, time_of_impact ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndTriangleHits );
+            sphere_center = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            BasicPoint<T> sphere_center;
+            T time_of_impact;
+            return NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, sphere_center, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     /*out*/ BasicSweepHit<T> &hit) noexcept
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::sweep_sphere( first, static_cast<unsigned>( triangles.size() ), segment_start, segment_end, sphere_radius, hit );
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     /*out*/ BasicSweepHit<T> &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            // after each collision found, the rest of triangles is tested against the segment shortened
+            // to that collision: time along the shortened segment is scaled by `time_scale'
+            bool any_result = false;
+            BasicPoint<T> current_end = segment_end;
+            T time_scale = 1;
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::SweepTrianglesTested );
+                BasicPoint<T> point;
+                T time;
+                if( _sphere_and_triangle_collision( segment_start, current_end, sphere_radius, triangles[i], point, time ) &&
+                    ( !any_result || time < 1 ) )
+                {
+                    hit.collision_point = point;
+                    hit.time = time*time_scale;
+                    hit.triangle_index = i;
+                    any_result = true;
+
+                    time_scale = hit.time;
+                    current_end = _sphere_center( segment_start, segment_end, hit.time );
+                    if( current_end == segment_start )
+                    {
+                        break; // nothing can be hit earlier
+                    }
+                }
+            }
+            if( !any_result )
+                return CollisionStatus::Miss;
+
+            hit.sphere_center = _sphere_center( segment_start, segment_end, hit.time );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      AnyHit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndTriangleCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+            if( triangle.is_degenerated() )
+                return CollisionStatus::DegenerateTriangle;
+
+            BasicPoint<T> collision_point;
+            T time;
+            if( !_sphere_and_triangle_any_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, time ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndTriangleHits );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      AnyHit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SphereAndTriangleCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            BasicPoint<T> collision_point;
+            T time;
+            if( !_sphere_and_triangle_any_collision( segment_start, segment_end, sphere_radius, triangle, collision_point, time ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SphereAndTriangleHits );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AnyHit, /*out*/ BasicSweepHit<T> &hit) noexcept
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::sweep_sphere( first, static_cast<unsigned>( triangles.size() ), segment_start, segment_end, sphere_radius, AnyHit(), hit );
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AnyHit, /*out*/ BasicSweepHit<T> &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            // the first triangle touched ends the sweep
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::SweepTrianglesTested );
+                if( _sphere_and_triangle_any_collision( segment_start, segment_end, sphere_radius, triangles[i], hit.collision_point, hit.time ) )
+                {
+                    hit.triangle_index = i;
+                    hit.sphere_center = _sphere_center( segment_start, segment_end, hit.time );
+                    return CollisionStatus::Hit;
+                }
+            }
+            return CollisionStatus::Miss;
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits)
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::sweep_sphere( first, static_cast<unsigned>( triangles.size() ), segment_start, segment_end, sphere_radius, AllHits(), hits );
+        }
+
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits)
+        {
+            COLLISIONS_COUNT( Counter::SweepCalls );
+            hits.clear();
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            // the whole segment for every triangle
+            BasicSweepHit<T> hit;
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::SweepTrianglesTested );
+                if( _sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangles[i], hit.collision_point, hit.time ) )
+                {
+                    hit.triangle_index = i;
+                    hit.sphere_center = _sphere_center( segment_start, segment_end, hit.time );
+                    hits.push_back( hit );
+                }
+            }
+            return hits.empty() ? CollisionStatus::Miss : CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SegmentAndTriangleCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+            if( triangle.is_degenerated() )
+                return CollisionStatus::DegenerateTriangle;
+
+            T u, v;
+            if( !_ray_and_triangle_collision( segment_start, segment_end - segment_start, static_cast<T>( 1 ), triangle, time_of_impact, u, v ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SegmentAndTriangleHits );
+            collision_point = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            T time_of_impact;
+            return NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SegmentAndTriangleCalls );
+            // prepared triangle is validated on construction
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            T u, v;
+            if( !_ray_and_triangle_collision( segment_start, segment_end - segment_start, static_cast<T>( 1 ), triangle, time_of_impact, u, v ) )
+                return CollisionStatus::Miss;
+
+            COLLISIONS_COUNT( Counter::SegmentAndTriangleHits );
+            collision_point = _sphere_center( segment_start, segment_end, time_of_impact );
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point) noexcept
+        {
+            T time_of_impact;
+            return NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point, time_of_impact );
+        }
+
+        template <class T>
+        CollisionStatus raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                /*out*/ BasicRayHit<T> &hit) noexcept
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::raycast( first, static_cast<unsigned>( triangles.size() ), origin, direction, max_time, hit );
+        }
+
+        template <class T>
+        CollisionStatus raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                /*out*/ BasicRayHit<T> &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::RaycastCalls );
+            if( direction.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+
+            // after each hit found, the rest of triangles is tested up to it only
+            bool any_result = false;
+            T best_time = max_time;
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::RayTrianglesTested );
+                T time, u, v;
+                if( _ray_and_triangle_collision( origin, direction, best_time, triangles[i], time, u, v ) &&
+                    ( !any_result || time < best_time ) )
+                {
+                    hit.time = time;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.triangle_index = i;
+                    any_result = true;
+                    best_time = time;
+                }
+            }
+            if( !any_result )
+                return CollisionStatus::Miss;
+
+            hit.collision_point = origin + hit.time*direction;
+            return CollisionStatus::Hit;
+        }
+
+        template <class T>
+        CollisionStatus raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                AnyHit, /*out*/ BasicRayHit<T> &hit) noexcept
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::raycast( first, static_cast<unsigned>( triangles.size() ), origin, direction, max_time, AnyHit(), hit );
+        }
+
+        template <class T>
+        CollisionStatus raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                AnyHit, /*out*/ BasicRayHit<T> &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::RaycastCalls );
+            if( direction.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::RayTrianglesTested );
+                if( _ray_and_triangle_collision( origin, direction, static_cast<T>( max_time ), triangles[i], hit.time, hit.u, hit.v ) )
+                {
+                    hit.triangle_index = i;
+                    hit.collision_point = origin + hit.time*direction;
+                    return CollisionStatus::Hit;
+                }
+            }
+            return CollisionStatus::Miss;
+        }
+
+        template <class T>
+        CollisionStatus closest_point(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &point, Scalar<T> max_distance,
+                                      /*out*/ BasicClosestPoint<T> &result) noexcept
+        {
+            const BasicPreparedTriangle<T> *first = triangles.empty() ? NULL : &triangles[0];
+            return NoThrow::closest_point( first, static_cast<unsigned>( triangles.size() ), point, max_distance, result );
+        }
+
+        template <class T>
+        CollisionStatus closest_point(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &point, Scalar<T> max_distance,
+                                      /*out*/ BasicClosestPoint<T> &result) noexcept
+        {
+            COLLISIONS_COUNT( Counter::ClosestPointCalls );
+            if( !( max_distance >= 0 ) )
+                return CollisionStatus::Miss;
+
+            // squared distances are compared, the root is taken once for the result
+            bool any_result = false;
+            T best_squared = max_distance*max_distance;
+            for( unsigned i = 0; i < count; ++i )
+            {
+                COLLISIONS_COUNT( Counter::ClosestPointTrianglesTested );
+                const BasicPoint<T> nearest = _closest_point_on_triangle( point, triangles[i] );
+                const T squared = (nearest - point).sqared_norm();
+                if( squared < best_squared || ( !any_result && squared <= best_squared ) )
+                {
+                    result.point = nearest;
+                    result.triangle_index = i;
+                    any_result = true;
+                    best_squared = squared;
+                }
+            }
+            if( !any_result )
+                return CollisionStatus::Miss;
+
+            result.distance = std::sqrt( best_squared );
+            return CollisionStatus::Hit;
+        }
+    };
+
+    // -------------------- C o l l i s i o n   f i n d e r s -----------------------------
+
+    template <class T>
+    bool line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                  const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                  /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::line_and_plane_collision( line_point, line_vector, plane_point, plane_normal, collision_point ) );
+    }
+
+    template <class T>
+    bool line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                  const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                  /*out*/ BasicPoint<T> &collision_point, T &time_of_impact)
+    {
+        return check_status( NoThrow::line_and_plane_collision( line_point, line_vector, plane_point, plane_normal, collision_point, time_of_impact ) );
+    }
+
+    template <class T>
+    bool segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                     const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                     /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::segment_and_plane_collision( segment_start, segment_end, plane_point, plane_normal, collision_point ) );
+    }
+
+    template <class T>
+    bool segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                     const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                     /*out*/ BasicPoint<T> &collision_point, T &time_of_impact)
+    {
+        return check_status( NoThrow::segment_and_plane_collision( segment_start, segment_end, plane_point, plane_normal, collision_point, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                    /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::sphere_and_plane_collision( segment_start, segment_end, sphere_radius, plane_point, plane_normal, collision_point ) );
+    }
+
+    template <class T>
+    bool sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                    /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_plane_collision( segment_start, segment_end, sphere_radius, plane_point, plane_normal,
+                                                                  collision_point, sphere_center, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &point)
+    {
+        return check_status( NoThrow::sphere_and_point_collision( segment_start, segment_end, sphere_radius, point ) );
+    }
+
+    template <class T>
+    bool sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &point,
+                                    /*out*/ BasicPoint<T> &sphere_center, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_point_collision( segment_start, segment_end, sphere_radius, point, sphere_center, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                     const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                     /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::sphere_and_sphere_collision( segment_start1, segment_end1, sphere_radius1, segment_start2, segment_end2, sphere_radius2,
+                                                                   collision_point ) );
+    }
+
+    template <class T>
+    bool sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                     const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                     /*out*/ BasicPoint<T> &collision_point, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_sphere_collision( segment_start1, segment_end1, sphere_radius1, segment_start2, segment_end2, sphere_radius2,
+                                                                   collision_point, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                                    segment_start, segment_end, collision_point ) );
+    }
+
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                                    segment_start, segment_end, collision_point, sphere_center, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, BasicVector<T> &contact_normal, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_segment_collision( sphere_segment_start, sphere_segment_end, sphere_radius,
+                                                                    segment_start, segment_end, collision_point, sphere_center, contact_normal, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle,
+                                                                     collision_point, sphere_center, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, collision_point ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle,
+                                                                     collision_point, sphere_center, time_of_impact ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      /*out*/ BasicSweepHit<T> &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      /*out*/ BasicSweepHit<T> &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, count, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       AnyHit)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, AnyHit() ) );
+    }
+
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       AnyHit)
+    {
+        return check_status( NoThrow::sphere_and_triangle_collision( segment_start, segment_end, sphere_radius, triangle, AnyHit() ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AnyHit, /*out*/ BasicSweepHit<T> &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, segment_start, segment_end, sphere_radius, AnyHit(), hit ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AnyHit, /*out*/ BasicSweepHit<T> &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, count, segment_start, segment_end, sphere_radius, AnyHit(), hit ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, segment_start, segment_end, sphere_radius, AllHits(), hits ) );
+    }
+
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits)
+    {
+        return check_status( NoThrow::sweep_sphere( triangles, count, segment_start, segment_end, sphere_radius, AllHits(), hits ) );
+    }
+
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point ) );
+    }
+
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point, T &time_of_impact)
+    {
+        return check_status( NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point, time_of_impact ) );
+    }
+
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point)
+    {
+        return check_status( NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point ) );
+    }
+
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point, T &time_of_impact)
+    {
+        return check_status( NoThrow::segment_and_triangle_collision( segment_start, segment_end, triangle, collision_point, time_of_impact ) );
+    }
+
+    template <class T>
+    bool raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 /*out*/ BasicRayHit<T> &hit)
+    {
+        return check_status( NoThrow::raycast( triangles, origin, direction, max_time, hit ) );
+    }
+
+    template <class T>
+    bool raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 /*out*/ BasicRayHit<T> &hit)
+    {
+        return check_status( NoThrow::raycast( triangles, count, origin, direction, max_time, hit ) );
+    }
+
+    template <class T>
+    bool raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 AnyHit, /*out*/ BasicRayHit<T> &hit)
+    {
+        return check_status( NoThrow::raycast( triangles, origin, direction, max_time, AnyHit(), hit ) );
+    }
+
+    template <class T>
+    bool raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 AnyHit, /*out*/ BasicRayHit<T> &hit)
+    {
+        return check_status( NoThrow::raycast( triangles, count, origin, direction, max_time, AnyHit(), hit ) );
+    }
+
+    template <class T>
+    bool closest_point(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &point, Scalar<T> max_distance,
+                       /*out*/ BasicClosestPoint<T> &result)
+    {
+        return check_status( NoThrow::closest_point( triangles, point, max_distance, result ) );
+    }
+
+    template <class T>
+    bool closest_point(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &point, Scalar<T> max_distance,
+                       /*out*/ BasicClosestPoint<T> &result)
+    {
+        return check_status( NoThrow::closest_point( triangles, count, point, max_distance, result ) );
+    }
+
+    // -------------------- I n s t a n t i a t i o n s -----------------------------------
+    // Helpers and finders above are templates over the scalar type, defined here once for both
+    // precisions: double (Point, Triangle, ...) and float (PointF, TriangleF, ...)
+
+#define COLLISIONS_INSTANTIATE_FINDERS(T) \
+    template bool is_point_between(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&);                                                                                                                                \
+    template T distance_between_point_and_line(const BasicPoint<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&);                                                                                                   \
+    template T distance_between_point_and_segment(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&);                                                                                                                 \
+    template T distance_between_two_lines(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&);                                                                                                 \
+    template void nearest_points_on_lines(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, BasicPoint<T>&);                                                                 \
+    template bool is_point_inside_triangle(const BasicPoint<T>&, const BasicTriangle<T>&);                                                                                                                                           \
+    template bool is_point_inside_triangle(const BasicPoint<T>&, const BasicPreparedTriangle<T>&);                                                                                                                                   \
+    template BasicPoint<T> perpendicular_base(const BasicVector<T>&, const BasicVector<T>&, const BasicPoint<T>&, Scalar<T>);                                                                                                        \
+    template bool line_and_plane_collision(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&);                                                                                \
+    template bool line_and_plane_collision(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, T&);                                                                            \
+    template bool segment_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&);                                                                              \
+    template bool segment_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, T&);                                                                          \
+    template bool sphere_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&);                                                                    \
+    template bool sphere_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, BasicPoint<T>&, T&);                                                \
+    template bool sphere_and_point_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&);                                                                                                           \
+    template bool sphere_and_point_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, BasicPoint<T>&, T&);                                                                                       \
+    template bool sphere_and_sphere_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicPoint<T>&);                                                         \
+    template bool sphere_and_sphere_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicPoint<T>&, T&);                                                     \
+    template bool sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&);                                                                   \
+    template bool sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&, BasicPoint<T>&, T&);                                               \
+    template bool sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&, BasicPoint<T>&, BasicVector<T>&, T&);                              \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, BasicPoint<T>&);                                                                                     \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, BasicPoint<T>&, BasicPoint<T>&, T&);                                                                 \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, BasicPoint<T>&);                                                                             \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, BasicPoint<T>&, BasicPoint<T>&, T&);                                                         \
+    template bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicSweepHit<T>&);                                                                            \
+    template bool sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicSweepHit<T>&);                                                                                 \
+    template CollisionStatus NoThrow::line_and_plane_collision(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&) noexcept;                                                   \
+    template CollisionStatus NoThrow::line_and_plane_collision(const BasicPoint<T>&, const BasicVector<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, T&) noexcept;                                               \
+    template CollisionStatus NoThrow::segment_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&) noexcept;                                                 \
+    template CollisionStatus NoThrow::segment_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, T&) noexcept;                                             \
+    template CollisionStatus NoThrow::sphere_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&) noexcept;                                       \
+    template CollisionStatus NoThrow::sphere_and_plane_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicVector<T>&, BasicPoint<T>&, BasicPoint<T>&, T&) noexcept;                   \
+    template CollisionStatus NoThrow::sphere_and_point_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&) noexcept;                                                                              \
+    template CollisionStatus NoThrow::sphere_and_point_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, BasicPoint<T>&, T&) noexcept;                                                          \
+    template CollisionStatus NoThrow::sphere_and_sphere_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicPoint<T>&) noexcept;                            \
+    template CollisionStatus NoThrow::sphere_and_sphere_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicPoint<T>&, T&) noexcept;                        \
+    template CollisionStatus NoThrow::sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&) noexcept;                                      \
+    template CollisionStatus NoThrow::sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&, BasicPoint<T>&, T&) noexcept;                  \
+    template CollisionStatus NoThrow::sphere_and_segment_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPoint<T>&, const BasicPoint<T>&, BasicPoint<T>&, BasicPoint<T>&, BasicVector<T>&, T&) noexcept; \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, BasicPoint<T>&) noexcept;                                                        \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, BasicPoint<T>&, BasicPoint<T>&, T&) noexcept;                                    \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, BasicPoint<T>&) noexcept;                                                \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, BasicPoint<T>&, BasicPoint<T>&, T&) noexcept;                            \
+    template CollisionStatus NoThrow::sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicSweepHit<T>&) noexcept;                                               \
+    template CollisionStatus NoThrow::sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, BasicSweepHit<T>&) noexcept;                                                    \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, AnyHit);                                                                                             \
+    template bool sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, AnyHit);                                                                                     \
+    template bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AnyHit, BasicSweepHit<T>&);                                                                    \
+    template bool sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AnyHit, BasicSweepHit<T>&);                                                                         \
+    template bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AllHits, std::vector< BasicSweepHit<T> >&);                                                    \
+    template bool sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AllHits, std::vector< BasicSweepHit<T> >&);                                                         \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicTriangle<T>&, AnyHit) noexcept;                                                                \
+    template CollisionStatus NoThrow::sphere_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, const BasicPreparedTriangle<T>&, AnyHit) noexcept;                                                        \
+    template CollisionStatus NoThrow::sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AnyHit, BasicSweepHit<T>&) noexcept;                                       \
+    template CollisionStatus NoThrow::sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AnyHit, BasicSweepHit<T>&) noexcept;                                            \
+    template CollisionStatus NoThrow::sweep_sphere(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AllHits, std::vector< BasicSweepHit<T> >&);                                \
+    template CollisionStatus NoThrow::sweep_sphere(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicPoint<T>&, Scalar<T>, AllHits, std::vector< BasicSweepHit<T> >&);                                     \
+    template bool segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicTriangle<T>&, BasicPoint<T>&);                                                                                               \
+    template bool segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicTriangle<T>&, BasicPoint<T>&, T&);                                                                                           \
+    template bool segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPreparedTriangle<T>&, BasicPoint<T>&);                                                                                       \
+    template bool segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPreparedTriangle<T>&, BasicPoint<T>&, T&);                                                                                   \
+    template bool raycast(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, BasicRayHit<T>&);                                                                                  \
+    template bool raycast(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, BasicRayHit<T>&);                                                                                       \
+    template bool raycast(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, AnyHit, BasicRayHit<T>&);                                                                          \
+    template bool raycast(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, AnyHit, BasicRayHit<T>&);                                                                               \
+    template CollisionStatus NoThrow::segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicTriangle<T>&, BasicPoint<T>&) noexcept;                                                                  \
+    template CollisionStatus NoThrow::segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicTriangle<T>&, BasicPoint<T>&, T&) noexcept;                                                              \
+    template CollisionStatus NoThrow::segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPreparedTriangle<T>&, BasicPoint<T>&) noexcept;                                                          \
+    template CollisionStatus NoThrow::segment_and_triangle_collision(const BasicPoint<T>&, const BasicPoint<T>&, const BasicPreparedTriangle<T>&, BasicPoint<T>&, T&) noexcept;                                                      \
+    template CollisionStatus NoThrow::raycast(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, BasicRayHit<T>&) noexcept;                                                     \
+    template CollisionStatus NoThrow::raycast(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, BasicRayHit<T>&) noexcept;                                                          \
+    template CollisionStatus NoThrow::raycast(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, AnyHit, BasicRayHit<T>&) noexcept;                                             \
+    template CollisionStatus NoThrow::raycast(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, const BasicVector<T>&, Scalar<T>, AnyHit, BasicRayHit<T>&) noexcept;                                                  \
+    template BasicPoint<T> closest_point_on_triangle(const BasicPoint<T>&, const BasicTriangle<T>&);                                                                                                                                 \
+    template BasicPoint<T> closest_point_on_triangle(const BasicPoint<T>&, const BasicPreparedTriangle<T>&);                                                                                                                         \
+    template T distance_between_point_and_triangle(const BasicPoint<T>&, const BasicTriangle<T>&);                                                                                                                                   \
+    template T distance_between_point_and_triangle(const BasicPoint<T>&, const BasicPreparedTriangle<T>&);                                                                                                                           \
+    template bool closest_point(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, Scalar<T>, BasicClosestPoint<T>&);                                                                                             \
+    template bool closest_point(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, Scalar<T>, BasicClosestPoint<T>&);                                                                                                  \
+    template CollisionStatus NoThrow::closest_point(const std::vector< BasicPreparedTriangle<T> >&, const BasicPoint<T>&, Scalar<T>, BasicClosestPoint<T>&) noexcept;                                                                \
+    template CollisionStatus NoThrow::closest_point(const BasicPreparedTriangle<T>*, unsigned, const BasicPoint<T>&, Scalar<T>, BasicClosestPoint<T>&) noexcept;
+
+    COLLISIONS_INSTANTIATE_FINDERS(double);
+    COLLISIONS_INSTANTIATE_FINDERS(float);
 };
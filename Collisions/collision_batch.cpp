@@ -0,0 +1,327 @@
+#include "collision_batch.h"
+#include "mesh_bvh.h"
+#include "triangle_soup.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Collisions
+{
+    const unsigned CollisionBatch::CHUNK_SIZE;
+
+    // ------------------------------ W o r k   r a n g e s ------------------------------------
+
+    // range of queries [begin, end), owned by a thread: both bounds are packed into one word,
+    // so that the owner (taking chunks from the front) and thieves (taking halves from the back)
+    // update it with a single compare-and-swap
+    struct alignas(CACHE_LINE_SIZE) _WorkRange
+    {
+        std::atomic<unsigned long long> bounds;
+
+        _WorkRange() : bounds(0) {}
+    };
+
+    inline unsigned long long _pack(unsigned begin, unsigned end)
+    {
+        return ( static_cast<unsigned long long>( end ) << 32 ) | begin;
+    }
+
+    inline unsigned _begin(unsigned long long bounds)
+    {
+        return static_cast<unsigned>( bounds & 0xFFFFFFFFu );
+    }
+
+    inline unsigned _end(unsigned long long bounds)
+    {
+        return static_cast<unsigned>( bounds >> 32 );
+    }
+
+    // takes a chunk from the front of own range
+    bool _take_chunk(_WorkRange &range, /*out*/ unsigned &begin, unsigned &end)
+    {
+        unsigned long long bounds = range.bounds.load();
+        for(;;)
+        {
+            begin = _begin( bounds );
+            end = _end( bounds );
+            if( begin >= end )
+            {
+                return false;
+            }
+            const unsigned chunk_end = std::min( end, begin + CollisionBatch::CHUNK_SIZE );
+            if( range.bounds.compare_exchange_weak( bounds, _pack( chunk_end, end ) ) )
+            {
+                end = chunk_end;
+                return true;
+            }
+        }
+    }
+
+    // takes the back half of the biggest range of other threads and makes it own range
+    bool _steal(std::vector<_WorkRange> &ranges, unsigned thief)
+    {
+        for(;;)
+        {
+            unsigned victim = thief;
+            unsigned long long victim_bounds = 0;
+            unsigned biggest = 0;
+            for( unsigned i = 0; i < ranges.size(); ++i )
+            {
+                const unsigned long long bounds = ranges[i].bounds.load();
+                const unsigned size = _end( bounds ) > _begin( bounds ) ? _end( bounds ) - _begin( bounds ) : 0;
+                if( i != thief && size > biggest )
+                {
+                    victim = i;
+                    victim_bounds = bounds;
+                    biggest = size;
+                }
+            }
+            if( biggest == 0 )
+            {
+                return false;
+            }
+
+            const unsigned begin = _begin( victim_bounds );
+            const unsigned end = _end( victim_bounds );
+            const unsigned middle = begin + (end - begin)/2;
+            if( ranges[victim].bounds.compare_exchange_strong( victim_bounds, _pack( begin, middle ) ) )
+            {
+                // own range is empty, so nobody else changes it now
+                ranges[thief].bounds.store( _pack( middle, end ) );
+                return true;
+            }
+        }
+    }
+
+    // ----------------------------------- P o o l ---------------------------------------------
+
+    class CollisionBatch::Pool
+    {
+    public:
+        typedef std::function<void (unsigned begin, unsigned end)> Job;
+
+    private:
+        std::vector<std::thread> threads;
+        std::vector<_WorkRange> ranges; // one per thread, the caller is the last one
+
+        std::mutex mutex;
+        std::condition_variable started;
+        std::condition_variable finished;
+        unsigned generation; // number of batches started
+        unsigned running;    // pool threads still working on the current batch
+        bool stopping;
+
+        const Job *job;
+        std::exception_ptr error; // the first exception thrown by the job in the current batch
+
+        void work(unsigned worker)
+        {
+            try
+            {
+                unsigned begin, end;
+                do
+                {
+                    while( _take_chunk( ranges[worker], begin, end ) )
+                    {
+                        (*job)( begin, end );
+                    }
+                }
+                while( _steal( ranges, worker ) );
+            }
+            catch( ... )
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                if( !error )
+                {
+                    error = std::current_exception();
+                }
+                // the rest of chunks are dropped, so that other threads stop soon
+                for( unsigned i = 0; i < ranges.size(); ++i )
+                {
+                    ranges[i].bounds.store( 0 );
+                }
+            }
+        }
+
+        // rethrows the exception of the finished batch, if any
+        void rethrow_error()
+        {
+            if( error )
+            {
+                std::exception_ptr batch_error;
+                std::swap( batch_error, error );
+                std::rethrow_exception( batch_error );
+            }
+        }
+
+        void thread_main(unsigned worker)
+        {
+            unsigned seen_generation = 0;
+            for(;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock( mutex );
+                    started.wait( lock, [&]() { return stopping || generation != seen_generation; } );
+                    if( stopping )
+                    {
+                        return;
+                    }
+                    seen_generation = generation;
+                }
+
+                work( worker );
+
+                std::lock_guard<std::mutex> lock( mutex );
+                if( --running == 0 )
+                {
+                    finished.notify_one();
+                }
+            }
+        }
+
+    public:
+        explicit Pool(unsigned threads_count)
+            : ranges(threads_count), generation(0), running(0), stopping(false), job(NULL)
+        {
+            for( unsigned i = 0; i + 1 < threads_count; ++i )
+            {
+                threads.push_back( std::thread( &Pool::thread_main, this, i ) );
+            }
+        }
+
+        ~Pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stopping = true;
+            }
+            started.notify_all();
+            for( unsigned i = 0; i < threads.size(); ++i )
+            {
+                threads[i].join();
+            }
+        }
+
+        unsigned threads_count() const
+        {
+            return static_cast<unsigned>( ranges.size() );
+        }
+
+        // calls `job' for chunks of [0, count) and returns when all of them are done; if the job throws,
+        // returns when all threads have stopped and rethrows the first exception
+        void run(unsigned count, const Job &batch_job)
+        {
+            const unsigned threads_count = this->threads_count();
+            for( unsigned i = 0; i < threads_count; ++i )
+            {
+                ranges[i].bounds.store( _pack( static_cast<unsigned>( static_cast<unsigned long long>( count )*i/threads_count ),
+                                               static_cast<unsigned>( static_cast<unsigned long long>( count )*(i + 1)/threads_count ) ) );
+            }
+            job = &batch_job;
+
+            if( threads.empty() )
+            {
+                work( 0 );
+                rethrow_error();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                ++generation;
+                running = static_cast<unsigned>( threads.size() );
+            }
+            started.notify_all();
+
+            work( threads_count - 1 );
+
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                finished.wait( lock, [&]() { return running == 0; } );
+            }
+            rethrow_error();
+        }
+    };
+
+    // ---------------------------- C o l l i s i o n   b a t c h ------------------------------
+
+    CollisionBatch::CollisionBatch(unsigned threads_count)
+    {
+        if( threads_count == 0 )
+        {
+            threads_count = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+        pool = new Pool( threads_count );
+    }
+
+    CollisionBatch::~CollisionBatch()
+    {
+        delete pool;
+    }
+
+    unsigned CollisionBatch::threads_count() const
+    {
+        return pool->threads_count();
+    }
+
+    void CollisionBatch::run(unsigned count, const std::function<void (unsigned begin, unsigned end)> &job)
+    {
+        pool->run( count, job );
+    }
+
+    template <class Mesh>
+    void _run_sweeps(CollisionBatch::Pool &pool, const Mesh &mesh,
+                     const Point *segment_starts, const Point *segment_ends, const double *sphere_radii, unsigned count,
+                     /*out*/ BatchResult *results)
+    {
+        pool.run( count, [&](unsigned begin, unsigned end)
+        {
+            for( unsigned i = begin; i < end; ++i )
+            {
+                results[i].status = NoThrow::sweep_sphere( mesh, segment_starts[i], segment_ends[i], sphere_radii[i], results[i].hit );
+            }
+        } );
+    }
+
+    template <class Mesh>
+    void _run_sweeps(CollisionBatch::Pool &pool, const Mesh &mesh, const std::vector<SweepQuery> &queries,
+                     /*out*/ std::vector<BatchResult> &results)
+    {
+        results.resize( queries.size() );
+        pool.run( static_cast<unsigned>( queries.size() ), [&](unsigned begin, unsigned end)
+        {
+            for( unsigned i = begin; i < end; ++i )
+            {
+                const SweepQuery &query = queries[i];
+                results[i].status = NoThrow::sweep_sphere( mesh, query.segment_start, query.segment_end, query.sphere_radius, results[i].hit );
+            }
+        } );
+    }
+
+    void CollisionBatch::sweep_sphere(const MeshBVH &mesh, const std::vector<SweepQuery> &queries,
+                                      /*out*/ std::vector<BatchResult> &results)
+    {
+        _run_sweeps( *pool, mesh, queries, results );
+    }
+
+    void CollisionBatch::sweep_sphere(const TriangleSoup &soup, const std::vector<SweepQuery> &queries,
+                                      /*out*/ std::vector<BatchResult> &results)
+    {
+        _run_sweeps( *pool, soup, queries, results );
+    }
+
+    void CollisionBatch::sweep_sphere(const MeshBVH &mesh, const Point *segment_starts, const Point *segment_ends, const double *sphere_radii, unsigned count,
+                                      /*out*/ BatchResult *results)
+    {
+        _run_sweeps( *pool, mesh, segment_starts, segment_ends, sphere_radii, count, results );
+    }
+
+    void CollisionBatch::sweep_sphere(const TriangleSoup &soup, const Point *segment_starts, const Point *segment_ends, const double *sphere_radii, unsigned count,
+                                      /*out*/ BatchResult *results)
+    {
+        _run_sweeps( *pool, soup, segment_starts, segment_ends, sphere_radii, count, results );
+    }
+};
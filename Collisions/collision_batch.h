@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include "collisions.h"
+
+namespace Collisions
+{
+    class MeshBVH;
+    class TriangleSoup;
+
+    const unsigned CACHE_LINE_SIZE = 64;
+
+    // one sphere sweep of a batch
+    struct SweepQuery
+    {
+        Point segment_start;
+        Point segment_end;
+        double sphere_radius;
+
+        SweepQuery() : sphere_radius(0) {}
+        SweepQuery(const Point &segment_start, const Point &segment_end, double sphere_radius)
+            : segment_start(segment_start), segment_end(segment_end), sphere_radius(sphere_radius) {}
+    };
+
+    // Output slot of one query. Slots are padded to cache lines, so that threads writing
+    // neighbouring results don't share lines.
+    struct alignas(CACHE_LINE_SIZE) BatchResult
+    {
+        SweepHit hit;           // valid only if status is Hit
+        CollisionStatus status; // Hit, Miss, or why the query is invalid
+    };
+
+    // Runs batches of independent queries on a pool of threads. Queries are divided into ranges,
+    // one per thread; a thread processes its range by chunks of CHUNK_SIZE queries and, when it is
+    // over, steals a half of the biggest remaining range of another thread. The calling thread
+    // works as one of the pool, so a batch with one thread runs entirely in the caller.
+    // A batch is not reentrant: run one batch at a time.
+    class CollisionBatch
+    {
+    public:
+        static const unsigned CHUNK_SIZE = 64;
+
+        // threads_count == 0 means the number of hardware threads
+        explicit CollisionBatch(unsigned threads_count = 0);
+        ~CollisionBatch();
+
+        unsigned threads_count() const;
+
+        // results are resized to the number of queries: results[i] is for queries[i]
+        void sweep_sphere(const MeshBVH &mesh, const std::vector<SweepQuery> &queries,
+                          /*out*/ std::vector<BatchResult> &results);
+        void sweep_sphere(const TriangleSoup &soup, const std::vector<SweepQuery> &queries,
+                          /*out*/ std::vector<BatchResult> &results);
+
+        // the same for separate arrays of `count' trajectories and radii
+        void sweep_sphere(const MeshBVH &mesh, const Point *segment_starts, const Point *segment_ends, const double *sphere_radii, unsigned count,
+                          /*out*/ BatchResult *results);
+        void sweep_sphere(const TriangleSoup &soup, const Point *segment_starts, const Point *segment_ends, const double *sphere_radii, unsigned count,
+                          /*out*/ BatchResult *results);
+
+        // calls `job' for chunks of [0, count) on the threads of the batch and returns when all of them are done
+        // (for other kinds of work, like rebuilding a SpatialHashGrid). If the job throws on any thread, the rest
+        // of chunks are not processed, and the first exception is rethrown here, when all threads have stopped.
+        void run(unsigned count, const std::function<void (unsigned begin, unsigned end)> &job);
+
+        // thread pool, defined in collision_batch.cpp
+        class Pool;
+
+    private:
+        Pool *pool;
+
+        // not copyable
+        CollisionBatch(const CollisionBatch &);
+        CollisionBatch & operator=(const CollisionBatch &);
+    };
+};
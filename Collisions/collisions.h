@@ -2,55 +2,417 @@
 #include "errors.h"
 #include "vector.h"
 #include "floating_point.h"
+#include <vector>
 
 namespace Collisions
 {
+    // All helpers and finders are templates over the scalar type T, instantiated for double (Point, Vector,
+    // Triangle, PreparedTriangle) and float (PointF, VectorF, TriangleF, PreparedTriangleF). Scalar<T>
+    // parameters accept any number, the type is deduced from points.
+
     // -------------------------- H e l p e r s ------------------------------------------
 
     // Returns true, if first point is between second and third
-    bool is_point_between(const Point &inner_point, const Point &outer_point1, const Point &outer_point2);
+    template <class T>
+    bool is_point_between(const BasicPoint<T> &inner_point, const BasicPoint<T> &outer_point1, const BasicPoint<T> &outer_point2);
+
+    template <class T>
+    T distance_between_point_and_line(const BasicPoint<T> &point, const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                      /*out*/ BasicPoint<T> &nearest_point);
 
-    double distance_between_point_and_line(const Point &point, const Point &line_point, const Vector &line_vector,
-                                           /*out*/ Point &nearest_point);
+    template <class T>
+    T distance_between_point_and_segment(const BasicPoint<T> &point, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end);
 
-    double distance_between_point_and_segment(const Point &point, const Point &segment_start, const Point &segment_end);
+    template <class T>
+    T distance_between_two_lines(const BasicPoint<T> &line_point1, const BasicVector<T> &line_vector1,
+                                 const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector2);
 
-    double distance_between_two_lines(const Point &line_point1, const Vector &line_vector1,
-                                      const Point &line_point2, const Vector &line_vector2);
+    template <class T>
+    void nearest_points_on_lines(const BasicPoint<T> &line_point1, const BasicVector<T> &line_vector1,
+                                 const BasicPoint<T> &line_point2, const BasicVector<T> &line_vector2,
+                                 /*out*/ BasicPoint<T> &result1, BasicPoint<T> &result2);
 
-    void nearest_points_on_lines(const Point &line_point1, const Vector &line_vector1,
-                                 const Point &line_point2, const Vector &line_vector2,
-                                 /*out*/ Point &result1, Point &result2);
+    // true, if the projection of the point onto the plane of the triangle is inside it
+    template <class T>
+    bool is_point_inside_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle);
+    template <class T>
+    bool is_point_inside_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle);
 
-    bool is_point_inside_triangle(const Point &point, const Triangle &triangle);
+    // Returns the point of the triangle, nearest to the given one: the point itself, if it lies on the triangle,
+    // or the nearest point of its face, sides or vertices. Doesn't throw: a degenerated triangle is taken as its sides.
+    template <class T>
+    BasicPoint<T> closest_point_on_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle);
+    template <class T>
+    BasicPoint<T> closest_point_on_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle);
+
+    template <class T>
+    T distance_between_point_and_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle);
+    template <class T>
+    T distance_between_point_and_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle);
 
     // Returns base of perpendicular, dropped from first of crossing lines to second, having given length.
     // Returns "earlier" point (looking along first line vector)
-    Point perpendicular_base(const Vector &line_vector1, const Vector &line_vector2, const Point &crosspoint, double perpendicular_length);
+    template <class T>
+    BasicPoint<T> perpendicular_base(const BasicVector<T> &line_vector1, const BasicVector<T> &line_vector2, const BasicPoint<T> &crosspoint, Scalar<T> perpendicular_length);
+
+    // result of sweeping a sphere against a set of triangles
+    template <class T>
+    struct BasicSweepHit
+    {
+        BasicPoint<T> collision_point;
+        BasicPoint<T> sphere_center; // sphere center at the moment of collision
+        T time;                      // time of impact: from 0 at segment start to 1 at segment end
+        unsigned triangle_index;     // index of the triangle hit
+    };
+    typedef BasicSweepHit<double> SweepHit;
+    typedef BasicSweepHit<float> SweepHitF;
+
+    // result of casting a ray (see raycast) against a set of triangles
+    template <class T>
+    struct BasicRayHit
+    {
+        BasicPoint<T> collision_point;
+        T time;                  // along the ray in units of its direction: collision_point == origin + time*direction
+        T u, v;                  // barycentric coordinates of the collision point, corresponding to vertices #1 and #2
+        unsigned triangle_index; // index of the triangle hit
+    };
+    typedef BasicRayHit<double> RayHit;
+    typedef BasicRayHit<float> RayHitF;
+
+    // result of searching the point of a set of triangles, nearest to the given one (see closest_point)
+    template <class T>
+    struct BasicClosestPoint
+    {
+        BasicPoint<T> point;     // the nearest point found
+        T distance;              // from the given point to it
+        unsigned triangle_index; // index of the triangle it lies on
+    };
+    typedef BasicClosestPoint<double> ClosestPoint;
+    typedef BasicClosestPoint<float> ClosestPointF;
+
+    // Query modes of sweeps, given as the tag argument of their overloads: the mode is resolved at compile
+    // time, so that work it doesn't need is compiled out of the kernel and of the traversal.
+    struct ClosestHit {};   // the earliest collision, as overloads without a mode find
+    struct AnyHit {};       // whether there is any collision ("is the way blocked?"): the first triangle found ends
+                            // the query, and its first touch found is taken, not the earliest one. There is a hit
+                            // exactly when ClosestHit finds one.
+    struct AllHits {};      // every triangle touched on the whole way, each with its earliest touch, in no particular order
 
     // -------------------- C o l l i s i o n   f i n d e r s -----------------------------
     // All functions return true, if there is a collision, false - if none;
     // and write collision point into `collison_point', if there is any.
+    // Overloads with `time_of_impact' also write the time of the first touch: from 0 at segment start
+    // to 1 at segment end (for a line - in units of line vector), and the sphere center at that moment.
 
-    bool line_and_plane_collision(const Point &line_point, const Vector &line_vector,
-                                  const Point &plane_point, const Vector &plane_normal,
-                                  /*out*/ Point &collision_point);
+    template <class T>
+    bool line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                  const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                  /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                  const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                  /*out*/ BasicPoint<T> &collision_point, T &time_of_impact);
 
-    bool segment_and_plane_collision(const Point &segment_start, const Point &segment_end,
-                                     const Point &plane_point, const Vector &plane_normal,
-                                     /*out*/ Point &collision_point);
+    template <class T>
+    bool segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                     const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                     /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                     const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                     /*out*/ BasicPoint<T> &collision_point, T &time_of_impact);
 
-    bool sphere_and_plane_collision(const Point &segment_start, const Point &segment_end, double sphere_radius,
-                                    const Point &plane_point, const Vector &plane_normal,
-                                    /*out*/ Point &collision_point);
+    template <class T>
+    bool sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                    /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                    /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact);
 
-    bool sphere_and_point_collision(const Point &segment_start, const Point &segment_end, double sphere_radius,
-                                    const Point &point);
+    template <class T>
+    bool sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &point);
+    template <class T>
+    bool sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                    const BasicPoint<T> &point,
+                                    /*out*/ BasicPoint<T> &sphere_center, T &time_of_impact);
 
-    bool sphere_and_segment_collision(const Point &sphere_segment_start, const Point &sphere_segment_end, double sphere_radius,
-                                      const Point &segment_start, const Point &segment_end,
-                                      /*out*/ Point &collision_point);
+    // Two spheres moving along their segments at the same time: finds the first touch in their relative
+    // motion. The collision point lies between the centers at that moment. A sphere may stay in place
+    // (the segment start is equal to the end), but not both of them.
+    template <class T>
+    bool sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                     const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                     /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                     const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                     /*out*/ BasicPoint<T> &collision_point, T &time_of_impact);
+
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact);
+    // ... and also the unit normal at the collision point, aimed from the segment to the sphere center
+    template <class T>
+    bool sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                      const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, BasicVector<T> &contact_normal, T &time_of_impact);
     
-    bool sphere_and_triangle_collision(const Point &segment_start, const Point &segment_end, double sphere_radius, const Triangle &triangle,
-                                       /*out*/ Point &collision_point);
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact);
+
+    // the same, but using precomputed normals of triangle: prefer it for static geometry
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact);
+
+    // Sweeps a sphere against all triangles and finds the earliest collision. After each collision found,
+    // the segment is shortened to it, so that later triangles are rejected earlier.
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      /*out*/ BasicSweepHit<T> &hit);
+    // the same for `count' triangles, starting from `triangles' (hit.triangle_index is counted from it)
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      /*out*/ BasicSweepHit<T> &hit);
+
+    // the same with a query mode (see AnyHit): a single triangle only tells whether it is touched
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                       AnyHit);
+    template <class T>
+    bool sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                       AnyHit);
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AnyHit, /*out*/ BasicSweepHit<T> &hit);
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AnyHit, /*out*/ BasicSweepHit<T> &hit);
+    template <class T>
+    bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits);
+    template <class T>
+    bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                      AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits);
+    template <class T>
+    inline bool sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                             ClosestHit, /*out*/ BasicSweepHit<T> &hit)
+    {
+        return sweep_sphere( triangles, segment_start, segment_end, sphere_radius, hit );
+    }
+    template <class T>
+    inline bool sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                             ClosestHit, /*out*/ BasicSweepHit<T> &hit)
+    {
+        return sweep_sphere( triangles, count, segment_start, segment_end, sphere_radius, hit );
+    }
+
+    // Segment and triangle, like a sphere of zero radius, but with a kernel of its own: Moller-Trumbore test,
+    // which solves segment_start + t*(segment_end - segment_start) == vertex #0 + u*side #0 - v*side #2 by two
+    // cross products and one division. Both faces of the triangle are hit; a segment, parallel to its plane
+    // (lying in it as well), misses it.
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point, T &time_of_impact);
+    // prepared triangles have their sides precomputed
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point);
+    template <class T>
+    bool segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                        /*out*/ BasicPoint<T> &collision_point, T &time_of_impact);
+
+    // Casts a ray from `origin' along `direction' as far as origin + max_time*direction against all triangles
+    // (with the same test as segment_and_triangle_collision) and finds the nearest hit: the one with the least
+    // index for equal times. Throws InvalidLineVectorError for zero direction.
+    template <class T>
+    bool raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 /*out*/ BasicRayHit<T> &hit);
+    template <class T>
+    bool raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 /*out*/ BasicRayHit<T> &hit);
+    // the first triangle hit ends the cast ("is the line of sight blocked?")
+    template <class T>
+    bool raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 AnyHit, /*out*/ BasicRayHit<T> &hit);
+    template <class T>
+    bool raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                 AnyHit, /*out*/ BasicRayHit<T> &hit);
+
+    // Finds the point of all triangles, nearest to the given one (see closest_point_on_triangle), no farther
+    // than max_distance from it: the one of the least index for equal distances. Returns false, if there is none.
+    template <class T>
+    bool closest_point(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &point, Scalar<T> max_distance,
+                       /*out*/ BasicClosestPoint<T> &result);
+    template <class T>
+    bool closest_point(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &point, Scalar<T> max_distance,
+                       /*out*/ BasicClosestPoint<T> &result);
+
+    // --------- E x c e p t i o n - f r e e   c o l l i s i o n   f i n d e r s ----------
+    // The same functions as above, but instead of throwing errors for invalid input they return
+    // a status: Hit, Miss, or what is wrong with the input. Input is validated once at the entry,
+    // so a bad query in a batch doesn't abort the whole batch. Collision finders above are wrappers
+    // around these, converting status with check_status.
+
+    namespace NoThrow
+    {
+        template <class T>
+        CollisionStatus line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                                 const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                 /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus line_and_plane_collision(const BasicPoint<T> &line_point, const BasicVector<T> &line_vector,
+                                                 const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                 /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                    /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus segment_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                    const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                    /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                   /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_plane_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &plane_point, const BasicVector<T> &plane_normal,
+                                                   /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_point_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                                   const BasicPoint<T> &point,
+                                                   /*out*/ BasicPoint<T> &sphere_center, T &time_of_impact) noexcept;
+
+        // both spheres staying in place is DegenerateSegment
+        template <class T>
+        CollisionStatus sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                                    const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                                    /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_sphere_collision(const BasicPoint<T> &segment_start1, const BasicPoint<T> &segment_end1, Scalar<T> sphere_radius1,
+                                                    const BasicPoint<T> &segment_start2, const BasicPoint<T> &segment_end2, Scalar<T> sphere_radius2,
+                                                    /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_segment_collision(const BasicPoint<T> &sphere_segment_start, const BasicPoint<T> &sphere_segment_end, Scalar<T> sphere_radius,
+                                                     const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end,
+                                                     /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, BasicVector<T> &contact_normal, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept;
+
+        // prepared triangles are validated on construction, so only the segment is checked here
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      /*out*/ BasicPoint<T> &collision_point, BasicPoint<T> &sphere_center, T &time_of_impact) noexcept;
+
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     /*out*/ BasicSweepHit<T> &hit) noexcept;
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     /*out*/ BasicSweepHit<T> &hit) noexcept;
+
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicTriangle<T> &triangle,
+                                                      AnyHit) noexcept;
+        template <class T>
+        CollisionStatus sphere_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius, const BasicPreparedTriangle<T> &triangle,
+                                                      AnyHit) noexcept;
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AnyHit, /*out*/ BasicSweepHit<T> &hit) noexcept;
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AnyHit, /*out*/ BasicSweepHit<T> &hit) noexcept;
+        // input errors are returned, but growing `hits' may throw std::bad_alloc
+        template <class T>
+        CollisionStatus sweep_sphere(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits);
+        template <class T>
+        CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                     AllHits, /*out*/ std::vector< BasicSweepHit<T> > &hits);
+        template <class T>
+        inline CollisionStatus sweep_sphere(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, Scalar<T> sphere_radius,
+                                            ClosestHit, /*out*/ BasicSweepHit<T> &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( triangles, count, segment_start, segment_end, sphere_radius, hit );
+        }
+
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept;
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point) noexcept;
+        template <class T>
+        CollisionStatus segment_and_triangle_collision(const BasicPoint<T> &segment_start, const BasicPoint<T> &segment_end, const BasicPreparedTriangle<T> &triangle,
+                                                       /*out*/ BasicPoint<T> &collision_point, T &time_of_impact) noexcept;
+
+        // zero direction is InvalidLineVector
+        template <class T>
+        CollisionStatus raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                /*out*/ BasicRayHit<T> &hit) noexcept;
+        template <class T>
+        CollisionStatus raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                /*out*/ BasicRayHit<T> &hit) noexcept;
+        template <class T>
+        CollisionStatus raycast(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                AnyHit, /*out*/ BasicRayHit<T> &hit) noexcept;
+        template <class T>
+        CollisionStatus raycast(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &origin, const BasicVector<T> &direction, Scalar<T> max_time,
+                                AnyHit, /*out*/ BasicRayHit<T> &hit) noexcept;
+
+        // any input is valid: the status is Hit or Miss
+        template <class T>
+        CollisionStatus closest_point(const std::vector< BasicPreparedTriangle<T> > &triangles, const BasicPoint<T> &point, Scalar<T> max_distance,
+                                      /*out*/ BasicClosestPoint<T> &result) noexcept;
+        template <class T>
+        CollisionStatus closest_point(const BasicPreparedTriangle<T> *triangles, unsigned count, const BasicPoint<T> &point, Scalar<T> max_distance,
+                                      /*out*/ BasicClosestPoint<T> &result) noexcept;
+    };
 };
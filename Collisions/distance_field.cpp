@@ -0,0 +1,511 @@
+#include "distance_field.h"
+#include "collision_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+namespace Collisions
+{
+    const unsigned DistanceField::VERSION;
+    const unsigned DistanceField::BRICK_SIZE;
+    const unsigned DistanceField::BRICK_SAMPLES;
+    const unsigned DistanceField::FAR_BRICK;
+    const unsigned DistanceField::SECTION_ALIGNMENT;
+
+    // ------------------------------------ F o r m a t ----------------------------------------
+
+    const char _FIELD_SIGNATURE[8] = { 'C', 'O', 'L', 'S', 'D', 'F', '\0', '\0' };
+    // written as a number: reads back the same only with the same byte order
+    const uint32_t _FIELD_BYTE_ORDER_MARK = 0x01020304;
+    // the grid is limited, so that indices of bricks fit in 32 bits with room to spare. Indices of samples go up
+    // to _MAX_BRICKS*DistanceField::BRICK_SAMPLES, past 32 bits, so they are computed in size_t (a blob that big
+    // does not fit in memory with a 32-bit size_t anyway)
+    const uint64_t _MAX_BRICKS = 1u << 28;
+
+    // The blob is this header, followed by sections: brick indices (uint32_t per brick of the grid), center
+    // distances (float per brick of the grid) and samples (float, DistanceField::BRICK_SAMPLES per stored brick,
+    // x fastest), each starting at a multiple of DistanceField::SECTION_ALIGNMENT.
+    struct _FieldHeader
+    {
+        char signature[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t brick_size;
+        uint32_t sample_size;
+        uint32_t bricks[3];
+        uint32_t stored_bricks;
+        double origin[3];
+        double voxel_size;
+        double band;
+        uint64_t blob_size;
+        uint64_t indices_offset;
+        uint64_t distances_offset;
+        uint64_t samples_offset;
+    };
+
+    inline uint64_t _field_aligned(uint64_t offset)
+    {
+        return ( offset + DistanceField::SECTION_ALIGNMENT - 1 )/DistanceField::SECTION_ALIGNMENT*DistanceField::SECTION_ALIGNMENT;
+    }
+
+    // fills offsets and the size of the blob by counts of the header
+    void _layout(/*inout*/ _FieldHeader &header)
+    {
+        const uint64_t grid_bricks = static_cast<uint64_t>( header.bricks[0] )*header.bricks[1]*header.bricks[2];
+        header.indices_offset = _field_aligned( sizeof(_FieldHeader) );
+        header.distances_offset = _field_aligned( header.indices_offset + grid_bricks*sizeof(uint32_t) );
+        header.samples_offset = _field_aligned( header.distances_offset + grid_bricks*sizeof(float) );
+        header.blob_size = _field_aligned( header.samples_offset + static_cast<uint64_t>( header.stored_bricks )*DistanceField::BRICK_SAMPLES*sizeof(float) );
+    }
+
+    // views the blob without checks
+    DistanceFieldView _field_view(const unsigned char *data, const _FieldHeader &header)
+    {
+        DistanceFieldView view;
+        view.origin = Point( header.origin[0], header.origin[1], header.origin[2] );
+        view.voxel_size = header.voxel_size;
+        view.band = header.band;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            view.bricks[i] = header.bricks[i];
+        }
+        view.brick_indices = reinterpret_cast<const unsigned *>( data + header.indices_offset );
+        view.center_distances = reinterpret_cast<const float *>( data + header.distances_offset );
+        view.samples = reinterpret_cast<const float *>( data + header.samples_offset );
+        return view;
+    }
+
+    DistanceFieldView view_distance_field(const void *blob, size_t bytes)
+    {
+        check( blob != NULL && reinterpret_cast<uintptr_t>( blob ) % sizeof(double) == 0 && bytes >= sizeof(_FieldHeader), InvalidDistanceFieldError() );
+        const unsigned char *data = static_cast<const unsigned char *>( blob );
+        _FieldHeader header;
+        memcpy( &header, data, sizeof(header) );
+        check( memcmp( header.signature, _FIELD_SIGNATURE, sizeof(_FIELD_SIGNATURE) ) == 0 && header.version == DistanceField::VERSION &&
+               header.byte_order == _FIELD_BYTE_ORDER_MARK, InvalidDistanceFieldError() );
+        check( header.brick_size == DistanceField::BRICK_SIZE && header.sample_size == sizeof(float), InvalidDistanceFieldError() );
+        const uint64_t grid_bricks = static_cast<uint64_t>( header.bricks[0] )*header.bricks[1]*header.bricks[2];
+        check( grid_bricks <= _MAX_BRICKS && header.stored_bricks <= grid_bricks, InvalidDistanceFieldError() );
+        check( header.voxel_size > 0 && header.band >= 0, InvalidDistanceFieldError() );
+
+        _FieldHeader expected = header;
+        _layout( expected );
+        check( header.blob_size == bytes && header.blob_size == expected.blob_size && header.indices_offset == expected.indices_offset &&
+               header.distances_offset == expected.distances_offset && header.samples_offset == expected.samples_offset, InvalidDistanceFieldError() );
+
+        const DistanceFieldView view = _field_view( data, header );
+
+        // the table is small (a brick per 512 voxels): check it, so that lookups never leave the blob
+        for( uint64_t i = 0; i < grid_bricks; ++i )
+        {
+            check( view.brick_indices[i] == DistanceField::FAR_BRICK || view.brick_indices[i] < header.stored_bricks, InvalidDistanceFieldError() );
+        }
+        return view;
+    }
+
+    // ------------------------------------ B u i l d e r --------------------------------------
+
+    // signed distance from the point to the mesh, up to max_distance: the sign is taken from the normal
+    // of the nearest triangle; `ordered' maps original indices of triangles to their places in the mesh
+    bool _signed_distance(const BvhView &mesh, const std::vector<unsigned> &ordered, const Point &point, double max_distance,
+                          /*out*/ double &result)
+    {
+        ClosestPoint nearest;
+        if( NoThrow::closest_point( mesh, point, max_distance, nearest ) != CollisionStatus::Hit )
+            return false;
+
+        const PreparedTriangle &triangle = mesh.triangles[ ordered[nearest.triangle_index] ];
+        result = (point - nearest.point)*triangle.normal() < 0 ? -nearest.distance : nearest.distance;
+        return true;
+    }
+
+    DistanceField::DistanceField(const MeshBVH &mesh, double voxel_size, double band) : bytes(0)
+    {
+        build( mesh.view(), voxel_size, band, NULL );
+    }
+
+    DistanceField::DistanceField(const BvhView &mesh, double voxel_size, double band) : bytes(0)
+    {
+        build( mesh, voxel_size, band, NULL );
+    }
+
+    DistanceField::DistanceField(const BvhView &mesh, double voxel_size, double band, CollisionBatch &batch) : bytes(0)
+    {
+        build( mesh, voxel_size, band, &batch );
+    }
+
+    DistanceField::DistanceField(const void *blob, size_t size) : bytes(0)
+    {
+        view_distance_field( blob, size ); // throws, if needed
+        words.resize( ( size + sizeof(words[0]) - 1 )/sizeof(words[0]) );
+        memcpy( words.data(), blob, size );
+        bytes = size;
+    }
+
+    void DistanceField::build(const BvhView &mesh, double voxel_size, double band, CollisionBatch *batch)
+    {
+        check( voxel_size > 0 && band >= 0 && voxel_size < std::numeric_limits<double>::infinity() &&
+               band < std::numeric_limits<double>::infinity(), InvalidVoxelSizeError() );
+
+        _FieldHeader header;
+        memset( &header, 0, sizeof(header) );
+        memcpy( header.signature, _FIELD_SIGNATURE, sizeof(_FIELD_SIGNATURE) );
+        header.version = VERSION;
+        header.byte_order = _FIELD_BYTE_ORDER_MARK;
+        header.brick_size = BRICK_SIZE;
+        header.sample_size = sizeof(float);
+        header.voxel_size = voxel_size;
+        header.band = band;
+
+        // the field covers the mesh with a margin of the band and a voxel: beyond it every point is
+        // farther than the band
+        const double brick_extent = BRICK_SIZE*voxel_size;
+        if( mesh.triangles_count != 0 )
+        {
+            const BoundingBox box = mesh.nodes[0].box.inflated( band + voxel_size );
+            const double lowest[3] = { box.min.x, box.min.y, box.min.z };
+            const double extents[3] = { box.max.x - box.min.x, box.max.y - box.min.y, box.max.z - box.min.z };
+            uint64_t grid_bricks = 1;
+            for( unsigned i = 0; i < 3; ++i )
+            {
+                const double count = std::max( std::ceil( extents[i]/brick_extent ), 1.0 );
+                check( count <= _MAX_BRICKS, InvalidVoxelSizeError() );
+                header.bricks[i] = static_cast<uint32_t>( count );
+                header.origin[i] = lowest[i];
+                grid_bricks *= header.bricks[i];
+                check( grid_bricks <= _MAX_BRICKS, InvalidVoxelSizeError() );
+            }
+        }
+        const unsigned grid_bricks = header.bricks[0]*header.bricks[1]*header.bricks[2];
+        const Point origin( header.origin[0], header.origin[1], header.origin[2] );
+
+        std::vector<unsigned> ordered( mesh.triangles_count );
+        for( unsigned i = 0; i < mesh.triangles_count; ++i )
+        {
+            ordered[ mesh.original_indices[i] ] = i;
+        }
+
+        // centers of all bricks: a brick is stored, if the band reaches it
+        const double half_diagonal = brick_extent*std::sqrt( 3.0 )/2;
+        std::vector<double> centers( grid_bricks );
+        const std::function<void (unsigned, unsigned)> center_job = [&](unsigned begin, unsigned end)
+        {
+            for( unsigned brick = begin; brick < end; ++brick )
+            {
+                const unsigned x = brick % header.bricks[0];
+                const unsigned y = brick/header.bricks[0] % header.bricks[1];
+                const unsigned z = brick/header.bricks[0]/header.bricks[1];
+                const Point center = origin + brick_extent*Vector( x + 0.5, y + 0.5, z + 0.5 );
+                _signed_distance( mesh, ordered, center, std::numeric_limits<double>::infinity(), centers[brick] );
+            }
+        };
+        if( batch != NULL )
+            batch->run( grid_bricks, center_job );
+        else
+            center_job( 0, grid_bricks );
+
+        std::vector<unsigned> indices( grid_bricks, FAR_BRICK );
+        std::vector<unsigned> stored; // bricks of the grid by their indices
+        for( unsigned brick = 0; brick < grid_bricks; ++brick )
+        {
+            if( std::fabs( centers[brick] ) <= half_diagonal + band )
+            {
+                indices[brick] = static_cast<unsigned>( stored.size() );
+                stored.push_back( brick );
+            }
+        }
+        header.stored_bricks = static_cast<uint32_t>( stored.size() );
+        _layout( header );
+
+        words.assign( static_cast<size_t>( header.blob_size/sizeof(words[0]) ), 0 );
+        bytes = static_cast<size_t>( header.blob_size );
+        unsigned char *data = reinterpret_cast<unsigned char *>( words.data() );
+        memcpy( data, &header, sizeof(header) );
+        std::copy( indices.begin(), indices.end(), reinterpret_cast<uint32_t *>( data + header.indices_offset ) );
+        float *distances = reinterpret_cast<float *>( data + header.distances_offset );
+        for( unsigned brick = 0; brick < grid_bricks; ++brick )
+        {
+            distances[brick] = static_cast<float>( centers[brick] );
+        }
+
+        // Samples are exact up to the band and the half of the brick diagonal; farther ones are cut down to it (which
+        // keeps safe_distance below the real distance), with the sign of the brick center: that far from the surface
+        // the sample and the center are on the same side of it.
+        const double cap = band + half_diagonal;
+        float *samples = reinterpret_cast<float *>( data + header.samples_offset );
+        const unsigned SIDE = BRICK_SIZE + 1;
+        const std::function<void (unsigned, unsigned)> samples_job = [&](unsigned begin, unsigned end)
+        {
+            for( unsigned index = begin; index < end; ++index )
+            {
+                const unsigned brick = stored[index];
+                const unsigned x = brick % header.bricks[0];
+                const unsigned y = brick/header.bricks[0] % header.bricks[1];
+                const unsigned z = brick/header.bricks[0]/header.bricks[1];
+                const Point corner = origin + brick_extent*Vector( x, y, z );
+                const double far_value = centers[brick] < 0 ? -cap : cap;
+                float *brick_samples = samples + static_cast<size_t>( index )*BRICK_SAMPLES;
+                for( unsigned i = 0; i < BRICK_SAMPLES; ++i )
+                {
+                    const Point point = corner + voxel_size*Vector( i % SIDE, i/SIDE % SIDE, i/SIDE/SIDE );
+                    double value;
+                    brick_samples[i] = static_cast<float>( _signed_distance( mesh, ordered, point, cap, value ) ? value : far_value );
+                }
+            }
+        };
+        if( batch != NULL )
+            batch->run( header.stored_bricks, samples_job );
+        else
+            samples_job( 0, header.stored_bricks );
+    }
+
+    DistanceFieldView DistanceField::view() const
+    {
+        // the blob is checked, when the field is built or copied
+        _FieldHeader header;
+        memcpy( &header, data(), sizeof(header) );
+        return _field_view( static_cast<const unsigned char *>( data() ), header );
+    }
+
+    unsigned DistanceField::stored_bricks() const
+    {
+        _FieldHeader header;
+        memcpy( &header, data(), sizeof(header) );
+        return header.stored_bricks;
+    }
+
+    void DistanceField::write(const char *path) const
+    {
+        std::FILE *file = fopen( path, "wb" );
+        check( file != NULL, FileError() );
+        const bool written = fwrite( data(), 1, bytes, file ) == bytes;
+        check( ( fclose( file ) == 0 ) && written, FileError() );
+    }
+
+    DistanceField DistanceField::read(const char *path)
+    {
+        std::FILE *file = fopen( path, "rb" );
+        check( file != NULL, FileError() );
+        std::vector<unsigned long long> blob;
+        size_t size = 0;
+        unsigned char chunk[64*1024];
+        for(;;)
+        {
+            const size_t got = fread( chunk, 1, sizeof(chunk), file );
+            blob.resize( ( size + got + sizeof(blob[0]) - 1 )/sizeof(blob[0]) );
+            memcpy( reinterpret_cast<unsigned char *>( blob.data() ) + size, chunk, got );
+            size += got;
+            if( got < sizeof(chunk) )
+                break;
+        }
+        const bool failed = ferror( file ) != 0;
+        fclose( file );
+        check( !failed, FileError() );
+        return DistanceField( blob.data(), size );
+    }
+
+    // -------------------------------------- L o o k u p --------------------------------------
+
+    // where the point is in the grid of the field
+    struct _FieldLocation
+    {
+        unsigned brick;         // of the grid
+        unsigned voxel[3];      // in the brick
+        double fraction[3];     // in the voxel: from 0 to 1
+    };
+
+    // returns false for points out of the field (or for the empty one)
+    inline bool _locate(const DistanceFieldView &field, const Point &point, /*out*/ _FieldLocation &location)
+    {
+        if( field.bricks[0] == 0 )
+        {
+            return false;
+        }
+        const double coordinates[3] = { (point.x - field.origin.x)/field.voxel_size, (point.y - field.origin.y)/field.voxel_size,
+                                        (point.z - field.origin.z)/field.voxel_size };
+        unsigned brick[3];
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            const double voxels = static_cast<double>( field.bricks[i] )*DistanceField::BRICK_SIZE;
+            if( !( coordinates[i] >= 0 && coordinates[i] <= voxels ) )
+            {
+                return false;
+            }
+            // the far side of the last voxel is still in it
+            const unsigned voxel = std::min( static_cast<unsigned>( coordinates[i] ), static_cast<unsigned>( voxels ) - 1 );
+            brick[i] = voxel/DistanceField::BRICK_SIZE;
+            location.voxel[i] = voxel % DistanceField::BRICK_SIZE;
+            location.fraction[i] = coordinates[i] - voxel;
+        }
+        location.brick = brick[0] + field.bricks[0]*( brick[1] + field.bricks[1]*brick[2] );
+        return true;
+    }
+
+    // center of the brick of the grid
+    inline Point _brick_center(const DistanceFieldView &field, unsigned brick)
+    {
+        const unsigned x = brick % field.bricks[0];
+        const unsigned y = brick/field.bricks[0] % field.bricks[1];
+        const unsigned z = brick/field.bricks[0]/field.bricks[1];
+        return field.origin + (DistanceField::BRICK_SIZE*field.voxel_size)*Vector( x + 0.5, y + 0.5, z + 0.5 );
+    }
+
+    // distance to the field box plus the band: out of the field every point is farther from the mesh
+    inline double _outside_distance(const DistanceFieldView &field, const Point &point)
+    {
+        if( field.bricks[0] == 0 )
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        const Vector size = (DistanceField::BRICK_SIZE*field.voxel_size)*Vector( field.bricks[0], field.bricks[1], field.bricks[2] );
+        return std::sqrt( BoundingBox( field.origin, field.origin + size ).squared_distance( point ) ) + field.band;
+    }
+
+    // samples at corners of the voxel
+    inline void _voxel_samples(const DistanceFieldView &field, const _FieldLocation &location, unsigned index, /*out*/ double (&corners)[8])
+    {
+        const unsigned SIDE = DistanceField::BRICK_SIZE + 1;
+        const float *first = field.samples + static_cast<size_t>( index )*DistanceField::BRICK_SAMPLES +
+                             location.voxel[0] + SIDE*( location.voxel[1] + SIDE*location.voxel[2] );
+        for( unsigned i = 0; i < 8; ++i )
+        {
+            corners[i] = first[ (i & 1) + SIDE*( (i >> 1 & 1) + SIDE*(i >> 2) ) ];
+        }
+    }
+
+    inline double _trilinear(const double (&corners)[8], const double (&fraction)[3])
+    {
+        double along_x[4];
+        for( unsigned i = 0; i < 4; ++i )
+        {
+            along_x[i] = corners[2*i] + fraction[0]*( corners[2*i + 1] - corners[2*i] );
+        }
+        const double low = along_x[0] + fraction[1]*( along_x[1] - along_x[0] );
+        const double high = along_x[2] + fraction[1]*( along_x[3] - along_x[2] );
+        return low + fraction[2]*( high - low );
+    }
+
+    // rounding of floats, which samples are stored in, relative to their values
+    const double _SAMPLE_ROUNDING = 1e-6;
+
+    double DistanceFieldView::distance(const Point &point) const
+    {
+        _FieldLocation location;
+        if( !_locate( *this, point, location ) )
+        {
+            return _outside_distance( *this, point );
+        }
+        const unsigned index = brick_indices[location.brick];
+        if( index == DistanceField::FAR_BRICK )
+        {
+            const double center_distance = center_distances[location.brick];
+            const double estimate = std::fabs( center_distance ) - Collisions::distance( point, _brick_center( *this, location.brick ) );
+            return center_distance < 0 ? -estimate : estimate;
+        }
+        double corners[8];
+        _voxel_samples( *this, location, index, corners );
+        return _trilinear( corners, location.fraction );
+    }
+
+    double DistanceFieldView::safe_distance(const Point &point) const
+    {
+        _FieldLocation location;
+        if( !_locate( *this, point, location ) )
+        {
+            return _outside_distance( *this, point );
+        }
+        const unsigned index = brick_indices[location.brick];
+        if( index == DistanceField::FAR_BRICK )
+        {
+            // distances change no faster than points move
+            const double center_distance = std::fabs( center_distances[location.brick] )*( 1 - _SAMPLE_ROUNDING );
+            return std::max( center_distance - Collisions::distance( point, _brick_center( *this, location.brick ) ), 0.0 );
+        }
+
+        double corners[8];
+        _voxel_samples( *this, location, index, corners );
+        double lowest = corners[0], highest = corners[0];
+        for( unsigned i = 1; i < 8; ++i )
+        {
+            lowest = std::min( lowest, corners[i] );
+            highest = std::max( highest, corners[i] );
+        }
+        if( lowest < 0 && highest > 0 )
+        {
+            return 0; // the surface passes through the voxel
+        }
+        for( unsigned i = 0; i < 8; ++i )
+        {
+            corners[i] = std::fabs( corners[i] );
+        }
+        // interpolation of distances errs by at most the weighted distance to the corners, which is not
+        // more than a half of the voxel diagonal
+        const double error = voxel_size*std::sqrt( 3.0 )/2 + _SAMPLE_ROUNDING*std::max( std::fabs( lowest ), std::fabs( highest ) );
+        return std::max( _trilinear( corners, location.fraction ) - error, 0.0 );
+    }
+
+    // -------------------------------------- Q u e r y ----------------------------------------
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const DistanceFieldView &field, const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::FieldSweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            // steps shorter than a voxel give way to exact sweeps over WINDOW voxels
+            const double WINDOW = 4;
+            const Vector way = segment_end - segment_start;
+            const double length = way.norm();
+            double time = 0;
+            while( time < 1 )
+            {
+                const Point center = segment_start + time*way;
+                const double step = field.safe_distance( center ) - sphere_radius;
+                if( step >= field.voxel_size )
+                {
+                    // the sphere touches nothing, while its center is nearer to this point than `step'
+                    COLLISIONS_COUNT( Counter::FieldSteps );
+                    time += step/length;
+                    continue;
+                }
+
+                COLLISIONS_COUNT( Counter::FieldWindows );
+                const double window_end = std::min( time + WINDOW*field.voxel_size/length, 1.0 );
+                SweepHit window_hit;
+                if( NoThrow::sweep_sphere( mesh, center, segment_start + window_end*way, sphere_radius, window_hit ) == CollisionStatus::Hit )
+                {
+                    hit = window_hit;
+                    hit.time = time + (window_end - time)*window_hit.time;
+                    return CollisionStatus::Hit;
+                }
+                // a window too short for a segment (DegenerateSegment) is at the very end of the way
+                time = window_end;
+            }
+            return CollisionStatus::Miss;
+        }
+
+        CollisionStatus sweep_sphere(const DistanceField &field, const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( field.view(), mesh.view(), segment_start, segment_end, sphere_radius, hit );
+        }
+    };
+
+    bool sweep_sphere(const DistanceField &field, const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( field, mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    bool sweep_sphere(const DistanceFieldView &field, const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( field, mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "mesh_bvh.h"
+
+namespace Collisions
+{
+    class CollisionBatch;
+
+    // Distance field as plain arrays, laid out as in a DistanceField blob: the buffer of a DistanceField,
+    // or a blob stored elsewhere (like a file, mapped into memory). Queries only read it, so any number
+    // of threads may use the same field without locks.
+    struct DistanceFieldView
+    {
+        Point origin;                   // the lowest corner of the field
+        double voxel_size;
+        double band;
+        unsigned bricks[3];             // along x, y and z
+        const unsigned *brick_indices;  // per brick of the grid (x fastest): index of its samples, or DistanceField::FAR_BRICK
+        const float *center_distances;  // per brick of the grid: signed distance from its center to the mesh
+        const float *samples;           // DistanceField::BRICK_SAMPLES per stored brick
+
+        // The signed distance to the mesh, interpolated trilinearly between samples near the surface. Elsewhere
+        // (in bricks beyond the band and out of the field) it is only known to be farther than `band', and
+        // a lower estimate is returned.
+        double distance(const Point &point) const;
+        // Lower bound of the (unsigned) distance from the point to the mesh: the interpolated one less the error
+        // of interpolation (at most a half of the voxel diagonal, since distances change no faster than points
+        // move). 0 in voxels, which the surface passes through.
+        double safe_distance(const Point &point) const;
+    };
+
+    // Sparse signed distance field of a static mesh on a uniform grid of voxels: for particles, cloth vertices
+    // and the like, which are tested against the mesh at very high rates. The grid is split into bricks of
+    // BRICK_SIZE^3 voxels; only bricks, which are within `band' from the mesh, store samples at the corners of
+    // their voxels (BRICK_SIZE + 1 per side, so that a lookup reads one brick). Every brick keeps the distance
+    // from its center, which bounds distances of the whole brick.
+    //
+    // The sign is positive on the side, where normals of the nearest triangle are aimed (see Triangle::normal):
+    // outside for closed meshes with normals aimed outside. For open or inconsistently oriented meshes it is only
+    // a hint; sweeps and safe_distance use unsigned distances.
+    //
+    // The field is a single blob (a header, the brick table and samples), which doesn't depend on its address:
+    // it may be written into a file, mapped or read back and viewed in place by view_distance_field.
+    class DistanceField
+    {
+    public:
+        static const unsigned VERSION = 1;
+        static const unsigned BRICK_SIZE = 8;  // voxels per side of a brick
+        static const unsigned BRICK_SAMPLES = (BRICK_SIZE + 1)*(BRICK_SIZE + 1)*(BRICK_SIZE + 1);
+        static const unsigned FAR_BRICK = ~0u; // brick without samples
+        static const unsigned SECTION_ALIGNMENT = 64;
+    private:
+        std::vector<unsigned long long> words; // the blob, in words for its alignment
+        size_t bytes;
+
+        void build(const BvhView &mesh, double voxel_size, double band, CollisionBatch *batch);
+    public:
+        // Samples the mesh: throws InvalidVoxelSizeError, if the voxel size is not positive or the band is negative.
+        // Every sample is found by closest_point over the mesh hierarchy, so building is an offline job; the field
+        // of an empty mesh is empty.
+        DistanceField(const MeshBVH &mesh, double voxel_size, double band);
+        DistanceField(const BvhView &mesh, double voxel_size, double band);
+        // the same, with bricks sampled by threads of the batch
+        DistanceField(const BvhView &mesh, double voxel_size, double band, CollisionBatch &batch);
+        // copies a blob (of DistanceField::data): throws InvalidDistanceFieldError, as view_distance_field does
+        DistanceField(const void *blob, size_t bytes);
+
+        const void * data() const { return words.data(); }
+        // bytes of the blob
+        size_t size() const { return bytes; }
+        DistanceFieldView view() const;
+
+        // bricks with samples
+        unsigned stored_bricks() const;
+
+        // writes the blob into a file (FileError, if it can't be written)
+        void write(const char *path) const;
+        // reads a file, written by write(): throws FileError or InvalidDistanceFieldError
+        static DistanceField read(const char *path);
+    };
+
+    // Views a blob in place (it must stay there, while the view is used, and be aligned to 8 bytes): throws
+    // InvalidDistanceFieldError, if it is not a field of this version and layout, or its tables are out of it.
+    DistanceFieldView view_distance_field(const void *blob, size_t bytes);
+
+    // Sweeps a sphere along the segment against the mesh, which the field is built of, and finds the earliest
+    // collision (see sweep_sphere in collisions.h). The sphere marches along the segment by safe distances,
+    // less its radius, and only where they are shorter than a voxel, the mesh is swept exactly (by its hierarchy)
+    // over a few voxels of the way ahead. So sweeps through free space read a few samples, and results are the same
+    // as of sweep_sphere for the mesh. Samples are exact within the band only, so spheres larger than it creep near
+    // the surface by exact sweeps: the band should exceed their radii. hit.triangle_index is the index in the original
+    // triangle array.
+    bool sweep_sphere(const DistanceField &field, const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+    bool sweep_sphere(const DistanceFieldView &field, const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const DistanceField &field, const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+        CollisionStatus sweep_sphere(const DistanceFieldView &field, const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+    };
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include <exception>
+#include <ostream>
+#include "stats.h"
 
 namespace Collisions
 {
@@ -26,10 +28,67 @@ namespace Collisions
     DECLARE_ERROR( DegeneratedTriangleError, "triangle is degenerated" );
     DECLARE_ERROR( ParallelLinesError, "lines are parallel" );
     DECLARE_ERROR( OutOfBoundsError, "array index out of bounds" );
+    DECLARE_ERROR( InvalidIndicesError, "indices don't make triangles of the vertex buffer" );
+    DECLARE_ERROR( EmptyBoxError, "bounding box is empty" );
+    DECLARE_ERROR( InvalidCellSizeError, "cell size cannot be negative" );
+    DECLARE_ERROR( FileError, "cannot open, read or write the file" );
+    DECLARE_ERROR( InvalidMeshFileError, "file is not a collision mesh of a supported version" );
+    DECLARE_ERROR( MeshFormatError, "mesh file is malformed or of unsupported format" );
+    DECLARE_ERROR( InvalidTransformError, "rotation axis cannot be zero vector and scale must be positive" );
+    DECLARE_ERROR( InvalidVoxelSizeError, "voxel size must be positive and band cannot be negative" );
+    DECLARE_ERROR( InvalidDistanceFieldError, "blob is not a distance field of a supported version" );
 
     template <class ErrType> inline void check( bool should_be_true, const ErrType &error )
     {
         if( ! should_be_true )
+        {
+            COLLISIONS_COUNT( Counter::ErrorsThrown );
             throw error;
+        }
+    }
+
+    // Result of exception-free collision finders (see NoThrow namespace): whether there is
+    // a collision, or what is wrong with the input, instead of throwing a corresponding error
+    enum class CollisionStatus
+    {
+        Hit,
+        Miss,
+        DegenerateSegment,  // DegeneratedSegmentError
+        DegenerateTriangle, // DegeneratedTriangleError
+        InvalidNormal,      // InvalidNormalError
+        InvalidLineVector,  // InvalidLineVectorError
+    };
+
+    inline CollisionStatus to_status( bool collision ) noexcept
+    {
+        return collision ? CollisionStatus::Hit : CollisionStatus::Miss;
+    }
+
+    // returns true for Hit, false for Miss, and throws corresponding error for invalid input
+    inline bool check_status( CollisionStatus status )
+    {
+        COLLISIONS_COUNT_IF( status != CollisionStatus::Hit && status != CollisionStatus::Miss, Counter::ErrorsThrown );
+        switch( status )
+        {
+        case CollisionStatus::Hit:
+            return true;
+        case CollisionStatus::Miss:
+            return false;
+        case CollisionStatus::DegenerateSegment:
+            throw DegeneratedSegmentError();
+        case CollisionStatus::DegenerateTriangle:
+            throw DegeneratedTriangleError();
+        case CollisionStatus::InvalidNormal:
+            throw InvalidNormalError();
+        case CollisionStatus::InvalidLineVector:
+            throw InvalidLineVectorError();
+        }
+        throw RuntimeError( "unknown collision status" );
+    }
+
+    inline std::ostream &operator<<(std::ostream &stream, CollisionStatus status)
+    {
+        const char * const names[] = { "Hit", "Miss", "DegenerateSegment", "DegenerateTriangle", "InvalidNormal", "InvalidLineVector" };
+        return stream << names[ static_cast<int>(status) ];
     }
 };
@@ -2,6 +2,7 @@
 #include <assert.h>
 #include "errors.h"
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 
 // Helpers for 'proper' comparing floating point numbers: assuming equal those ones,
@@ -10,71 +11,196 @@
 
 namespace Collisions
 {
-    union DoubleAndInt
+    constexpr long long DEFAULT_MAX_ULPS = 50;
+    constexpr double DEFAULT_EPSILON = 1e-12;
+
+    // Tolerance policy: a struct with compile-time `max_ulps' and `epsilon', given as a template
+    // parameter to comparisons below. Its values are validated when the comparison is instantiated.
+    template <long long MaxUlps>
+    struct UlpsTolerance
+    {
+        static constexpr long long max_ulps = MaxUlps;
+        static constexpr double epsilon = DEFAULT_EPSILON;
+    };
+    typedef UlpsTolerance<DEFAULT_MAX_ULPS> DefaultTolerance;
+
+    // defaults for floats: their ULP is 2^29 times bigger, and so is their rounding error near zero
+    constexpr long long DEFAULT_FLOAT_MAX_ULPS = 16;
+    constexpr double DEFAULT_FLOAT_EPSILON = 1e-5;
+
+    struct FloatTolerance
+    {
+        static constexpr long long max_ulps = DEFAULT_FLOAT_MAX_ULPS;
+        static constexpr double epsilon = DEFAULT_FLOAT_EPSILON;
+    };
+
+    // default tolerance for the scalar type: DefaultToleranceFor<T>::type
+    template <class T>
+    struct DefaultToleranceFor;
+
+    template <>
+    struct DefaultToleranceFor<double>
     {
-        double double_;
-        long long int_;
+        typedef DefaultTolerance type;
+    };
+
+    template <>
+    struct DefaultToleranceFor<float>
+    {
+        typedef FloatTolerance type;
+    };
+
+    template <class Tolerance>
+    struct _ValidTolerance
+    {
+        // Make sure max_ulps is non-negative and small enough that the
+        // default NAN won't compare as equal to anything.
+        static_assert( Tolerance::max_ulps > 0 && Tolerance::max_ulps < 4 * 1024 * 1024, "invalid value of max_ulps" );
+        static_assert( Tolerance::epsilon >= 0, "invalid value of epsilon" );
+        static const bool value = true;
     };
 
-    const long long DEFAULT_MAX_ULPS = 50;
-    const double DEFAULT_EPSILON = 1e-12;
+    // Returns the bits of the double, made lexicographically ordered as a twos-complement int
+    // (without branches: negative numbers are mirrored around zero)
+    inline long long _ordered_bits(double x)
+    {
+        long long bits;
+        memcpy( &bits, &x, sizeof(bits) );
+        const long long sign_mask = bits >> 63; // all ones for negative numbers
+        const long long magnitude = bits & 0x7FFFFFFFFFFFFFFFLL;
+        return (magnitude ^ sign_mask) - sign_mask;
+    }
 
-#ifdef _MSC_VER
-    inline long long llabs(long long x) { return _abs64(x); }
-#endif //#ifdef _MSC_VER
+    // the same for float: 32-bit ordered bits
+    inline long long _ordered_bits(float x)
+    {
+        int bits;
+        memcpy( &bits, &x, sizeof(bits) );
+        const int sign_mask = bits >> 31;
+        const int magnitude = bits & 0x7FFFFFFF;
+        return (magnitude ^ sign_mask) - sign_mask;
+    }
 
-    // TODO: tests for these functions
+    // Returns the distance between doubles (or floats) in ULPs. It is exact: ordered bits are within
+    // +-(2^63 - 1), so their distance is below 2^64, and it is taken by their order, not by the sign of the
+    // wrapped difference
+    template <class T>
+    inline unsigned long long _ulps_between(T a, T b)
+    {
+        const long long a_bits = _ordered_bits(a);
+        const long long b_bits = _ordered_bits(b);
+        const unsigned long long difference = static_cast<unsigned long long>( a_bits ) - static_cast<unsigned long long>( b_bits );
+        const unsigned long long sign_mask = 0 - static_cast<unsigned long long>( a_bits < b_bits );
+        return (difference ^ sign_mask) - sign_mask;
+    }
+
+    // Both comparisons are done for any scalar type and combined bitwise, without branches
+    template <class Tolerance, class T>
+    inline bool _equal(T a, T b)
+    {
+        static_assert( _ValidTolerance<Tolerance>::value, "" );
+        // epsilon-comparison: needed near zero
+        return ( fabs(a - b) <= Tolerance::epsilon ) | ( _ulps_between( a, b ) <= static_cast<unsigned long long>( Tolerance::max_ulps ) );
+    }
 
     //
     // the idea from
     // 'Comparing floating point numbers' by Bruce Dawson
     // http://www.cygnus-software.com/papers/comparingfloats/comparingfloats.htm
     //
-    inline bool equal(double a, double b, long long max_ulps = DEFAULT_MAX_ULPS, double epsilon = DEFAULT_EPSILON)
+    // Overloaded for double and float rather than templated over the scalar type, so that mixed
+    // arguments like equal( 0, x ) still work
+    template <class Tolerance>
+    inline bool equal(double a, double b)
+    {
+        return _equal<Tolerance>( a, b );
+    }
+    template <class Tolerance>
+    inline bool equal(float a, float b)
+    {
+        return _equal<Tolerance>( a, b );
+    }
+
+    inline bool equal(double a, double b)
+    {
+        return equal<DefaultTolerance>( a, b );
+    }
+    inline bool equal(float a, float b)
+    {
+        return equal<FloatTolerance>( a, b );
+    }
+
+    // the same with tolerance given at run time: max_ulps is checked on every call
+    inline bool equal(double a, double b, long long max_ulps, double epsilon = DEFAULT_EPSILON)
     {
-        assert( sizeof(long long) == sizeof(double) );
-        // Make sure max_ulps is non-negative and small enough that the
-        // default NAN won't compare as equal to anything.
         check( max_ulps > 0 && max_ulps < 4 * 1024 * 1024, RuntimeError("invalid value of max_ulps") ); // this is maximum ULPS for floats, for doubles it might be greater, but for what?
-        
-        // epsilon-comparison: needed near zero
-        if( fabs(a - b) <= epsilon )
-        {
-            return true;
-        }
-        
-        DoubleAndInt a_union = { a };
-        DoubleAndInt b_union = { b };
-        
-        long long a_int = a_union.int_;
-        long long b_int = b_union.int_;
-
-        DoubleAndInt minus_null_union = { -0.0 };
-        long long minus_null_int = minus_null_union.int_;
-        // Make a_int lexicographically ordered as a twos-complement int
-        if (a_int < 0)
-            a_int = minus_null_int - a_int;
-        // Make b_int lexicographically ordered as a twos-complement int
-        if (b_int < 0)
-            b_int = minus_null_int - b_int;
-       
-        long long int_diff = llabs(a_int - b_int);
-        if (int_diff <= max_ulps)
-            return true;
-
-        return false;
-    }
-
-    inline bool less_or_equal(double a, double b, long long max_ulps = DEFAULT_MAX_ULPS, double epsilon = DEFAULT_EPSILON)
+        return ( fabs(a - b) <= epsilon ) | ( _ulps_between( a, b ) <= static_cast<unsigned long long>( max_ulps ) );
+    }
+
+    // all three pairs are equal: compared without branches
+    template <class Tolerance>
+    inline bool equal3(double a0, double a1, double a2, double b0, double b1, double b2)
+    {
+        return equal<Tolerance>( a0, b0 ) & equal<Tolerance>( a1, b1 ) & equal<Tolerance>( a2, b2 );
+    }
+    template <class Tolerance>
+    inline bool equal3(float a0, float a1, float a2, float b0, float b1, float b2)
+    {
+        return equal<Tolerance>( a0, b0 ) & equal<Tolerance>( a1, b1 ) & equal<Tolerance>( a2, b2 );
+    }
+
+    template <class Tolerance>
+    inline bool less_or_equal(double a, double b)
+    {
+        return (a < b) | equal<Tolerance>( a, b );
+    }
+    template <class Tolerance>
+    inline bool less_or_equal(float a, float b)
+    {
+        return (a < b) | equal<Tolerance>( a, b );
+    }
+
+    inline bool less_or_equal(double a, double b)
+    {
+        return less_or_equal<DefaultTolerance>( a, b );
+    }
+    inline bool less_or_equal(float a, float b)
+    {
+        return less_or_equal<FloatTolerance>( a, b );
+    }
+
+    inline bool less_or_equal(double a, double b, long long max_ulps, double epsilon = DEFAULT_EPSILON)
     {
         return (a < b) || equal( a, b, max_ulps, epsilon );
     }
 
-    inline bool greater_or_equal(double a, double b, long long max_ulps = DEFAULT_MAX_ULPS, double epsilon = DEFAULT_EPSILON)
+    template <class Tolerance>
+    inline bool greater_or_equal(double a, double b)
+    {
+        return (a > b) | equal<Tolerance>( a, b );
+    }
+    template <class Tolerance>
+    inline bool greater_or_equal(float a, float b)
+    {
+        return (a > b) | equal<Tolerance>( a, b );
+    }
+
+    inline bool greater_or_equal(double a, double b)
+    {
+        return greater_or_equal<DefaultTolerance>( a, b );
+    }
+    inline bool greater_or_equal(float a, float b)
+    {
+        return greater_or_equal<FloatTolerance>( a, b );
+    }
+
+    inline bool greater_or_equal(double a, double b, long long max_ulps, double epsilon = DEFAULT_EPSILON)
     {
         return (a > b) || equal( a, b, max_ulps, epsilon );
     }
-    inline int sign(double x)
+
+    template <class T>
+    inline int sign(T x)
     {
         return (x > 0) - (x < 0);
     }
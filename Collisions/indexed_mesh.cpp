@@ -0,0 +1,349 @@
+#include "indexed_mesh.h"
+#include "kernels.h"
+#include "bounding_box.h"
+#include <algorithm>
+#include <new>
+
+namespace Collisions
+{
+    // ---------------------------------- B u i l d e r ----------------------------------------
+
+    const unsigned IndexedMesh::NO_TRIANGLE;
+
+    // adjacent faces of an edge, making an angle less than this (in radians) with a plane, are considered flat
+    const double _FLAT_EDGE_ANGLE = 1e-9;
+
+    // side of a triangle, as seen by the builder: sides with the same key are the same edge
+    struct _SideItem
+    {
+        unsigned key[2]; // indices of vertices, the lesser first
+        unsigned triangle;
+        unsigned side;
+
+        bool operator<(const _SideItem &another) const
+        {
+            return key[0] != another.key[0] ? key[0] < another.key[0] :
+                   key[1] != another.key[1] ? key[1] < another.key[1] : triangle < another.triangle;
+        }
+        bool same_edge(const _SideItem &another) const
+        {
+            return key[0] == another.key[0] && key[1] == another.key[1];
+        }
+    };
+
+    IndexedMesh::IndexedMesh(const std::vector<Point> &vertices, const std::vector<unsigned> &indices)
+        : vertices( vertices ), indices( indices )
+    {
+        build();
+    }
+
+    IndexedMesh::IndexedMesh(const double *coordinates, unsigned vertices_count, const unsigned *indices, unsigned indices_count)
+        : indices( indices, indices + indices_count )
+    {
+        vertices.reserve( vertices_count );
+        for( unsigned i = 0; i < vertices_count; ++i )
+        {
+            vertices.push_back( Point( coordinates[3*i], coordinates[3*i + 1], coordinates[3*i + 2] ) );
+        }
+        build();
+    }
+
+    IndexedMesh::IndexedMesh(const float *coordinates, unsigned vertices_count, const unsigned *indices, unsigned indices_count)
+        : indices( indices, indices + indices_count )
+    {
+        vertices.reserve( vertices_count );
+        for( unsigned i = 0; i < vertices_count; ++i )
+        {
+            vertices.push_back( Point( coordinates[3*i], coordinates[3*i + 1], coordinates[3*i + 2] ) );
+        }
+        build();
+    }
+
+    void IndexedMesh::build()
+    {
+        check( indices.size() % 3 == 0, InvalidIndicesError() );
+        for( unsigned i = 0; i < indices.size(); ++i )
+        {
+            check( indices[i] < vertices.size(), InvalidIndicesError() );
+        }
+        const unsigned count = static_cast<unsigned>( indices.size()/3 );
+        normals.reserve( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            const Triangle triangle( vertices[ indices[3*i] ], vertices[ indices[3*i + 1] ], vertices[ indices[3*i + 2] ] );
+            normals.push_back( triangle.normal() ); // throws DegeneratedTriangleError, if needed
+        }
+
+        // unique edges: equal sides are neighbours after sorting, and are paired in the order of triangles
+        std::vector<_SideItem> sides( 3*count );
+        for( unsigned i = 0; i < 3*count; ++i )
+        {
+            const unsigned from = indices[i];
+            const unsigned to = indices[ i - i%3 + (i + 1)%3 ];
+            sides[i].key[0] = std::min( from, to );
+            sides[i].key[1] = std::max( from, to );
+            sides[i].triangle = i/3;
+            sides[i].side = i%3;
+        }
+        std::sort( sides.begin(), sides.end() );
+
+        unsigned edges_count = 0;
+        for( unsigned i = 0; i < sides.size(); i += i + 1 < sides.size() && sides[i + 1].same_edge( sides[i] ) ? 2 : 1 )
+        {
+            ++edges_count;
+        }
+        edges.reserve( edges_count );
+        triangle_edges.resize( 3*count );
+        for( unsigned i = 0; i < sides.size(); )
+        {
+            const _SideItem &first = sides[i];
+            Edge edge;
+            edge.triangles[0] = first.triangle;
+            edge.vertices[0] = indices[ 3*first.triangle + first.side ];
+            edge.vertices[1] = indices[ 3*first.triangle + (first.side + 1)%3 ];
+            edge.triangles[1] = NO_TRIANGLE;
+            edge.skipped = false;
+            triangle_edges[ 3*first.triangle + first.side ] = static_cast<unsigned>( edges.size() );
+
+            const bool shared = i + 1 < sides.size() && sides[i + 1].same_edge( first );
+            if( shared )
+            {
+                const _SideItem &second = sides[i + 1];
+                edge.triangles[1] = second.triangle;
+                triangle_edges[ 3*second.triangle + second.side ] = static_cast<unsigned>( edges.size() );
+
+                // the second triangle should traverse the edge backwards; then the edge is skipped,
+                // if the opposite vertex of the second triangle is not behind the plane of the first one
+                const bool consistent = indices[ 3*second.triangle + second.side ] == edge.vertices[1];
+                const Point &opposite = vertices[ indices[ 3*second.triangle + (second.side + 2)%3 ] ];
+                const Vector to_opposite = opposite - vertices[ edge.vertices[0] ];
+                edge.skipped = consistent && to_opposite*normals[edge.triangles[0]] >= -_FLAT_EDGE_ANGLE*to_opposite.norm();
+            }
+            edges.push_back( edge );
+            i += shared ? 2 : 1;
+        }
+
+        // corners around vertices, counting sort by vertex
+        vertex_corners_offsets.assign( vertices.size() + 1, 0 );
+        for( unsigned i = 0; i < indices.size(); ++i )
+        {
+            ++vertex_corners_offsets[ indices[i] + 1 ];
+        }
+        for( unsigned i = 0; i < vertices.size(); ++i )
+        {
+            vertex_corners_offsets[i + 1] += vertex_corners_offsets[i];
+        }
+        vertex_corners.resize( indices.size() );
+        std::vector<unsigned> filled( vertex_corners_offsets.begin(), vertex_corners_offsets.end() - 1 );
+        for( unsigned i = 0; i < indices.size(); ++i )
+        {
+            vertex_corners[ filled[ indices[i] ]++ ] = i;
+        }
+
+        // a vertex is skipped, if both sides at each of its corners are skipped (and so are unused vertices)
+        skipped_vertices.assign( vertices.size(), true );
+        for( unsigned i = 0; i < indices.size(); ++i )
+        {
+            const unsigned triangle = i/3;
+            const unsigned corner = i%3;
+            if( !edges[ triangle_edges[3*triangle + corner] ].skipped || !edges[ triangle_edges[3*triangle + (corner + 2)%3] ].skipped )
+            {
+                skipped_vertices[ indices[i] ] = false;
+            }
+        }
+    }
+
+    size_t IndexedMesh::memory_size() const
+    {
+        return vertices.capacity()*sizeof(Point) + indices.capacity()*sizeof(unsigned) + normals.capacity()*sizeof(Vector) +
+               triangle_edges.capacity()*sizeof(unsigned) + edges.capacity()*sizeof(Edge) +
+               vertex_corners_offsets.capacity()*sizeof(unsigned) + vertex_corners.capacity()*sizeof(unsigned) +
+               skipped_vertices.capacity()/8;
+    }
+
+    // ---------------------------------- Q u e r y --------------------------------------------
+
+    // if the sphere moves inside the triangle with the normal through its side from `from' to `to'
+    // (see _sphere_and_triangle_collision_fused)
+    inline bool _is_moving_inside(const Vector &L, const Vector &normal, const Point &from, const Point &to)
+    {
+        return _is_vector_outside( L, cross_product( from - to, normal ) );
+    }
+
+    // the same for the edge, as a side of the triangle with given indices: the triangle traverses it either forward or backward
+    inline bool _is_moving_inside(const Vector &L, const Vector &normal, const unsigned *triangle_indices, const Point *vertices, const IndexedMesh::Edge &edge)
+    {
+        const unsigned first = triangle_indices[0] == edge.vertices[0] ? 0 : triangle_indices[1] == edge.vertices[0] ? 1 : 2;
+        const bool forward = triangle_indices[ (first + 1)%3 ] == edge.vertices[1];
+        const Point &from = vertices[ edge.vertices[0] ];
+        const Point &to = vertices[ edge.vertices[1] ];
+        return forward ? _is_moving_inside( L, normal, from, to ) : _is_moving_inside( L, normal, to, from );
+    }
+
+    // bits of the sides of the box, outside which the point is: a triangle or an edge misses
+    // the box, if all its vertices are outside the same side
+    inline unsigned char _outcode(const BoundingBox &box, const Point &point)
+    {
+        return static_cast<unsigned char>( (point.x < box.min.x) | (point.x > box.max.x) << 1 |
+                                           (point.y < box.min.y) << 2 | (point.y > box.max.y) << 3 |
+                                           (point.z < box.min.z) << 4 | (point.z > box.max.z) << 5 );
+    }
+
+    // returns false, if the buffer cannot grow to the number of vertices
+    inline bool _classify_vertices(const std::vector<Point> &vertices, const BoundingBox &box, /*out*/ std::vector<unsigned char> &outcodes) noexcept
+    {
+        try
+        {
+            outcodes.resize( vertices.size() );
+        }
+        catch( const std::bad_alloc & )
+        {
+            return false;
+        }
+        for( unsigned i = 0; i < vertices.size(); ++i )
+        {
+            outcodes[i] = _outcode( box, vertices[i] );
+        }
+        return true;
+    }
+
+    // the earliest collision found so far
+    struct _MeshHit
+    {
+        bool any;
+        double time;
+        Point point;
+        unsigned triangle;
+
+        bool is_earlier(double another_time) const
+        {
+            return !any || another_time < time;
+        }
+        void set(double new_time, const Point &new_point, unsigned new_triangle)
+        {
+            any = true;
+            time = new_time;
+            point = new_point;
+            triangle = new_triangle;
+        }
+    };
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const IndexedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::MeshSweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            const Point *vertices = mesh.vertices.data();
+            const unsigned *indices = mesh.indices.data();
+            const Vector L = segment_end - segment_start;
+            const double L_squared = L.sqared_norm();
+            _MeshHit best = { false, 1, Point(), 0 };
+
+            // vertices are classified against the box of the sweep, to cull all features by them. The buffer is kept
+            // per thread and grows to the largest mesh swept; if it cannot grow, nothing is culled (the result
+            // is the same, only slower), so that no std::bad_alloc escapes
+            static thread_local std::vector<unsigned char> outcodes;
+            const bool culling = _classify_vertices( mesh.vertices, bounding_box( segment_start, segment_end, sphere_radius ), outcodes );
+
+            // 1) faces
+            for( unsigned i = 0; i < mesh.normals.size(); ++i )
+            {
+                const unsigned *corners = indices + 3*i;
+                if( culling && ( outcodes[ corners[0] ] & outcodes[ corners[1] ] & outcodes[ corners[2] ] ) )
+                    continue;
+                COLLISIONS_COUNT( Counter::MeshFacesTested );
+                const Vector &normal = mesh.normals[i];
+                const double L_normal = L*normal;
+                if( equal( 0, L_normal ) )
+                    continue;
+                const double start_height = (segment_start - vertices[ corners[0] ])*normal;
+                const double shift = sign( L_normal )*sphere_radius;
+                const double time = -( start_height + shift )/L_normal;
+                if( greater_or_equal( time, 0 ) && less_or_equal( time, 1 ) && best.is_earlier( time ) )
+                {
+                    const Point point = segment_start + shift*normal + time*L;
+                    if( _is_point_inside_triangle( point, Triangle( vertices[ corners[0] ], vertices[ corners[1] ], vertices[ corners[2] ] ) ) )
+                    {
+                        best.set( time, point, i );
+                    }
+                }
+            }
+
+            // a face hit shortens the way: edges and vertices are culled by the box of its part before the hit
+            if( culling && best.any )
+            {
+                _classify_vertices( mesh.vertices, bounding_box( segment_start, segment_start + best.time*L, sphere_radius ), outcodes );
+            }
+
+            // 2) unique edges, through which the sphere moves inside at least one of adjacent triangles
+            for( unsigned i = 0; i < mesh.edges.size(); ++i )
+            {
+                const IndexedMesh::Edge &edge = mesh.edges[i];
+                if( edge.skipped || ( culling && ( outcodes[ edge.vertices[0] ] & outcodes[ edge.vertices[1] ] ) ) )
+                    continue;
+                COLLISIONS_COUNT( Counter::MeshEdgesTested );
+                unsigned triangle = IndexedMesh::NO_TRIANGLE;
+                for( unsigned j = 0; j < 2 && edge.triangles[j] != IndexedMesh::NO_TRIANGLE; ++j )
+                {
+                    if( _is_moving_inside( L, mesh.normals[ edge.triangles[j] ], indices + 3*edge.triangles[j], vertices, edge ) )
+                    {
+                        triangle = edge.triangles[j];
+                        break;
+                    }
+                }
+                const Point &from = vertices[ edge.vertices[0] ];
+                const Point &to = vertices[ edge.vertices[1] ];
+                double time, position;
+                if( triangle != IndexedMesh::NO_TRIANGLE &&
+                    _sphere_and_line_entry( L, segment_start - from, to - from, sphere_radius, time, position ) &&
+                    greater_or_equal( position, 0 ) && less_or_equal( position, 1 ) && best.is_earlier( time ) )
+                {
+                    best.set( time, from + position*(to - from), triangle );
+                }
+            }
+
+            // 3) unique vertices, if the sphere moves inside a triangle around through both sides at the vertex
+            for( unsigned i = 0; i < mesh.vertices.size(); ++i )
+            {
+                if( ( culling && outcodes[i] != 0 ) || mesh.skipped_vertices[i] )
+                    continue;
+                COLLISIONS_COUNT( Counter::MeshVerticesTested );
+                const Point &vertex = vertices[i];
+                double time;
+                if( !_sphere_and_point_entry( L, L_squared, segment_start - vertex, sphere_radius, time ) || !best.is_earlier( time ) )
+                    continue;
+                for( unsigned j = mesh.vertex_corners_offsets[i]; j < mesh.vertex_corners_offsets[i + 1]; ++j )
+                {
+                    const unsigned *corners = indices + mesh.vertex_corners[j] - mesh.vertex_corners[j]%3;
+                    const unsigned corner = mesh.vertex_corners[j]%3;
+                    const Vector &normal = mesh.normals[ mesh.vertex_corners[j]/3 ];
+                    if( _is_moving_inside( L, normal, vertex, vertices[ corners[ (corner + 1)%3 ] ] ) &&
+                        _is_moving_inside( L, normal, vertices[ corners[ (corner + 2)%3 ] ], vertex ) )
+                    {
+                        best.set( time, vertex, mesh.vertex_corners[j]/3 );
+                        break;
+                    }
+                }
+            }
+
+            if( !best.any )
+                return CollisionStatus::Miss;
+
+            hit.collision_point = best.point;
+            hit.time = best.time;
+            hit.sphere_center = segment_start + best.time*L;
+            hit.triangle_index = best.triangle;
+            return CollisionStatus::Hit;
+        }
+    };
+
+    bool sweep_sphere(const IndexedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+};
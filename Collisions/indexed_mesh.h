@@ -0,0 +1,133 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "collisions.h"
+
+namespace Collisions
+{
+    class IndexedMesh;
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const IndexedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+    };
+
+    // Triangle mesh with shared vertices: a vertex buffer and three indices per triangle. On construction
+    // unique edges are found together with triangles adjacent to them, and edges and vertices, which can't
+    // be touched before adjacent faces, are marked as skipped. Sweeps then test each face, each unique edge
+    // and each unique vertex at most once, instead of testing shared edges and vertices once per triangle.
+    //
+    // Normals of triangles (see Triangle::normal) are expected to be aimed outside, and triangles sharing
+    // an edge should traverse it in opposite directions. An edge is skipped, if it is concave or flat (seen
+    // from outside): a sphere coming from outside touches adjacent faces first. A vertex is skipped, if all
+    // its edges are. Edges of inconsistently oriented triangles and boundary edges are never skipped.
+    // An edge shared by more than two triangles is stored once per pair of them.
+    class IndexedMesh
+    {
+    public:
+        static const unsigned NO_TRIANGLE = ~0u;
+
+        struct Edge
+        {
+            unsigned vertices[2];  // in the order of traversing by triangles[0]
+            unsigned triangles[2]; // adjacent triangles: triangles[1] is NO_TRIANGLE for a boundary edge
+            bool skipped;          // concave or flat: not tested by sweeps
+        };
+    private:
+        std::vector<Point> vertices;
+        std::vector<unsigned> indices;        // three per triangle
+        std::vector<Vector> normals;          // one per triangle
+        std::vector<unsigned> triangle_edges; // three per triangle: edge of the side #i
+        std::vector<Edge> edges;
+        // corners (triangle*3 + vertex number in it) around vertex #i are
+        // vertex_corners[ vertex_corners_offsets[i] .. vertex_corners_offsets[i+1] )
+        std::vector<unsigned> vertex_corners_offsets;
+        std::vector<unsigned> vertex_corners;
+        std::vector<bool> skipped_vertices;
+
+        void build();
+
+        // reads the buffers directly: indices in them are valid by construction
+        friend CollisionStatus NoThrow::sweep_sphere(const IndexedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                                     /*out*/ SweepHit &hit) noexcept;
+    public:
+        // throws InvalidIndicesError, if there is a partial triangle or an index out of the vertex buffer,
+        // and DegeneratedTriangleError for degenerated triangle
+        IndexedMesh(const std::vector<Point> &vertices, const std::vector<unsigned> &indices);
+        // vertex buffer of `vertices_count' points, three coordinates each
+        IndexedMesh(const double *coordinates, unsigned vertices_count, const unsigned *indices, unsigned indices_count);
+        IndexedMesh(const float *coordinates, unsigned vertices_count, const unsigned *indices, unsigned indices_count);
+
+        unsigned vertices_count() const { return static_cast<unsigned>( vertices.size() ); }
+        unsigned triangles_count() const { return static_cast<unsigned>( normals.size() ); }
+        unsigned edges_count() const { return static_cast<unsigned>( edges.size() ); }
+        bool empty() const { return normals.empty(); }
+
+        Point const & vertex(unsigned index) const
+        {
+            check( index < vertices.size(), OutOfBoundsError() );
+            return vertices[index];
+        }
+        // index of the vertex #corner of the triangle
+        unsigned vertex_index(unsigned triangle, unsigned corner) const
+        {
+            check( triangle < normals.size() && corner <= 2, OutOfBoundsError() );
+            return indices[3*triangle + corner];
+        }
+        Triangle triangle(unsigned index) const
+        {
+            return Triangle( vertex( vertex_index( index, 0 ) ), vertex( vertex_index( index, 1 ) ), vertex( vertex_index( index, 2 ) ) );
+        }
+        Vector const & normal(unsigned triangle) const
+        {
+            check( triangle < normals.size(), OutOfBoundsError() );
+            return normals[triangle];
+        }
+
+        Edge const & edge(unsigned index) const
+        {
+            check( index < edges.size(), OutOfBoundsError() );
+            return edges[index];
+        }
+        // index of the edge, which is the side #side of the triangle
+        unsigned triangle_edge(unsigned triangle, unsigned side) const
+        {
+            check( triangle < normals.size() && side <= 2, OutOfBoundsError() );
+            return triangle_edges[3*triangle + side];
+        }
+        // triangle, sharing the side #side with the given one, or NO_TRIANGLE
+        unsigned neighbour(unsigned triangle, unsigned side) const
+        {
+            const Edge &shared = edge( triangle_edge( triangle, side ) );
+            return shared.triangles[0] == triangle ? shared.triangles[1] : shared.triangles[0];
+        }
+        // corners around the vertex: each is triangle*3 + number of the vertex in that triangle
+        unsigned vertex_corners_count(unsigned index) const
+        {
+            check( index < skipped_vertices.size(), OutOfBoundsError() );
+            return vertex_corners_offsets[index + 1] - vertex_corners_offsets[index];
+        }
+        unsigned vertex_corner(unsigned index, unsigned corner) const
+        {
+            check( corner < vertex_corners_count( index ), OutOfBoundsError() );
+            return vertex_corners[ vertex_corners_offsets[index] + corner ];
+        }
+        bool is_vertex_skipped(unsigned index) const
+        {
+            check( index < skipped_vertices.size(), OutOfBoundsError() );
+            return skipped_vertices[index];
+        }
+
+        // bytes, taken by the buffers of the mesh
+        size_t memory_size() const;
+    };
+
+    // Sweeps a sphere along the segment against the mesh and finds the earliest collision (see sweep_sphere
+    // in collisions.h): faces, unique edges and vertices, which are not skipped, are tested once. A side or a
+    // vertex is hit only if the sphere moves inside an adjacent triangle through it, as in sphere and triangle
+    // collision, so the result is the same as of sweeping triangles of the mesh, if the sphere starts outside.
+    // hit.triangle_index is the triangle hit (for an edge or a vertex - one of triangles around it).
+    bool sweep_sphere(const IndexedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+};
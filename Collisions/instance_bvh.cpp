@@ -0,0 +1,304 @@
+#include "instance_bvh.h"
+#include <cmath>
+#include <type_traits>
+
+namespace Collisions
+{
+    // -------------------------------- T r a n s f o r m --------------------------------------
+
+    Transform::Transform() : translation(0, 0, 0), scale_factor(1)
+    {
+        rows[0] = Vector( 1, 0, 0 );
+        rows[1] = Vector( 0, 1, 0 );
+        rows[2] = Vector( 0, 0, 1 );
+    }
+
+    Transform::Transform(const Vector &translation, const Vector &axis, double angle, double scale)
+        : translation(translation), scale_factor(scale)
+    {
+        check( scale > 0 && ( angle == 0 || axis.norm() != 0 ), InvalidTransformError() );
+        // Rodrigues' formula: cos*I + sin*[k]x + (1 - cos)*k*k^T for the unit axis k
+        const Vector k = angle == 0 ? Vector( 0, 0, 1 ) : axis/axis.norm();
+        const double c = std::cos( angle );
+        const double s = std::sin( angle );
+        const double t = 1 - c;
+        rows[0] = Vector( c + k.x*k.x*t, k.x*k.y*t - k.z*s, k.x*k.z*t + k.y*s );
+        rows[1] = Vector( k.y*k.x*t + k.z*s, c + k.y*k.y*t, k.y*k.z*t - k.x*s );
+        rows[2] = Vector( k.z*k.x*t - k.y*s, k.z*k.y*t + k.x*s, c + k.z*k.z*t );
+    }
+
+    Transform Transform::from_quaternion(const Vector &translation, double w, double x, double y, double z, double scale)
+    {
+        const double norm = std::sqrt( w*w + x*x + y*y + z*z );
+        check( scale > 0 && norm != 0, InvalidTransformError() );
+        w /= norm;
+        x /= norm;
+        y /= norm;
+        z /= norm;
+        Transform result( translation, Vector( 0, 0, 1 ), 0, scale );
+        result.rows[0] = Vector( 1 - 2*(y*y + z*z), 2*(x*y - w*z), 2*(x*z + w*y) );
+        result.rows[1] = Vector( 2*(x*y + w*z), 1 - 2*(x*x + z*z), 2*(y*z - w*x) );
+        result.rows[2] = Vector( 2*(x*z - w*y), 2*(y*z + w*x), 1 - 2*(x*x + y*y) );
+        return result;
+    }
+
+    BoundingBox Transform::apply(const BoundingBox &box) const
+    {
+        if( box.is_empty() )
+        {
+            return box;
+        }
+        // the center goes as a point, half sizes - by absolute values of the matrix
+        const Point center = apply( box.center() );
+        const Vector half = box.size()/2;
+        const Vector extent = scale_factor*Vector( std::abs( rows[0].x )*half.x + std::abs( rows[0].y )*half.y + std::abs( rows[0].z )*half.z,
+                                                   std::abs( rows[1].x )*half.x + std::abs( rows[1].y )*half.y + std::abs( rows[1].z )*half.z,
+                                                   std::abs( rows[2].x )*half.x + std::abs( rows[2].y )*half.y + std::abs( rows[2].z )*half.z );
+        return BoundingBox( center - extent, center + extent );
+    }
+
+    // ---------------------------------- B u i l d e r ----------------------------------------
+
+    const unsigned InstanceBVH::MAX_LEAF_SIZE;
+    const unsigned InstanceBVH::NO_NODE;
+
+    unsigned InstanceBVH::add_mesh(const BvhView &mesh)
+    {
+        meshes.push_back( mesh );
+        return meshes_count() - 1;
+    }
+
+    unsigned InstanceBVH::add_instance(unsigned mesh, const Transform &transform)
+    {
+        check( mesh < meshes.size(), OutOfBoundsError() );
+        Instance instance;
+        instance.mesh = mesh;
+        instance.transform = transform;
+        instance.box = meshes[mesh].nodes_count != 0 ? transform.apply( meshes[mesh].nodes[0].box ) : BoundingBox();
+        instances.push_back( instance );
+        leaves.push_back( NO_NODE );
+        return size() - 1;
+    }
+
+    void InstanceBVH::set_transform(unsigned index, const Transform &transform)
+    {
+        check( index < instances.size(), OutOfBoundsError() );
+        Instance &instance = instances[index];
+        const BvhView &mesh = meshes[instance.mesh];
+        instance.transform = transform;
+        instance.box = mesh.nodes_count != 0 ? transform.apply( mesh.nodes[0].box ) : BoundingBox();
+        if( leaves[index] != NO_NODE )
+        {
+            refit( leaves[index] );
+        }
+    }
+
+    // recomputes boxes of the leaf and nodes above it
+    void InstanceBVH::refit(unsigned node)
+    {
+        BoundingBox box;
+        for( unsigned i = nodes[node].first; i < nodes[node].first + nodes[node].count; ++i )
+        {
+            box.add( instances[ order[i] ].box );
+        }
+        nodes[node].box = box;
+        for( node = parents[node]; node != NO_NODE; node = parents[node] )
+        {
+            const unsigned left = nodes[node].first;
+            nodes[node].box = BoundingBox( nodes[left].box ).add( nodes[left + 1].box );
+        }
+    }
+
+    void InstanceBVH::rebuild()
+    {
+        std::vector<BoundingBox> boxes( size() );
+        for( unsigned i = 0; i < size(); ++i )
+        {
+            boxes[i] = instances[i].box;
+        }
+        build_bvh( boxes, MAX_LEAF_SIZE, nodes, order );
+        built_count = size();
+
+        parents.assign( nodes.size(), NO_NODE );
+        for( unsigned i = 0; i < nodes.size(); ++i )
+        {
+            const MeshBVH::Node &node = nodes[i];
+            if( node.is_leaf() )
+            {
+                for( unsigned j = node.first; j < node.first + node.count; ++j )
+                {
+                    leaves[ order[j] ] = i;
+                }
+            }
+            else
+            {
+                parents[node.first] = i;
+                parents[node.first + 1] = i;
+            }
+        }
+    }
+
+    // ---------------------------------- Q u e r y --------------------------------------------
+
+    // node, waiting for traversal, and the time the segment enters its box
+    struct _InstanceTraversalItem
+    {
+        unsigned node;
+        double entry_time;
+    };
+
+    // state of a sweep: the earliest hit so far, and the segment shortened to it
+    struct _InstanceSweep
+    {
+        Point segment_start, segment_end;
+        double sphere_radius;
+        bool any_result;
+        double best_time;
+        Point current_end;
+        SweepHit hit;
+        unsigned instance_index;
+    };
+
+    // Sweeps the rest of the segment against the instance in mesh space. With AnyHit the first hit ends the sweep,
+    // so the segment is never shortened.
+    template <class Mode>
+    void _sweep_instance(const InstanceBVH &instances, unsigned index, /*inout*/ _InstanceSweep &sweep)
+    {
+        COLLISIONS_COUNT( Counter::InstancesTested );
+        const InstanceBVH::Instance &instance = instances.instance( index );
+        const Transform &transform = instance.transform;
+        SweepHit local_hit;
+        if( NoThrow::sweep_sphere( instances.mesh( instance.mesh ), transform.apply_inverse( sweep.segment_start ), transform.apply_inverse( sweep.current_end ),
+                                   sweep.sphere_radius/transform.scale(), Mode(), local_hit ) != CollisionStatus::Hit ||
+            ( sweep.any_result && local_hit.time >= 1 ) )
+        {
+            return;
+        }
+        sweep.hit = local_hit;
+        sweep.hit.time = local_hit.time*sweep.best_time;
+        sweep.hit.collision_point = transform.apply( local_hit.collision_point );
+        sweep.instance_index = index;
+        sweep.any_result = true;
+        sweep.best_time = sweep.hit.time;
+        sweep.current_end = sweep.segment_start + sweep.best_time*(sweep.segment_end - sweep.segment_start);
+    }
+
+    // the sweep by the query mode: ClosestHit or AnyHit
+    template <class Mode>
+    CollisionStatus _sweep_instances(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit, unsigned &instance_index)
+    {
+        const bool closest = !std::is_same<Mode, AnyHit>::value;
+        COLLISIONS_COUNT( Counter::InstanceSweepCalls );
+        if( segment_start == segment_end )
+            return CollisionStatus::DegenerateSegment;
+
+        _InstanceSweep sweep;
+        sweep.segment_start = segment_start;
+        sweep.segment_end = segment_end;
+        sweep.sphere_radius = sphere_radius;
+        sweep.any_result = false;
+        sweep.best_time = 1;
+        sweep.current_end = segment_end;
+        const BoxRay ray( segment_start, segment_end );
+
+        // instances, added after the last rebuild
+        double entry_time;
+        for( unsigned i = instances.built_size(); i < instances.size() && sweep.current_end != segment_start && ( closest || !sweep.any_result ); ++i )
+        {
+            if( segment_and_box_collision( ray, instances.instance( i ).box.inflated( sphere_radius ), sweep.best_time, entry_time ) )
+            {
+                _sweep_instance<Mode>( instances, i, sweep );
+            }
+        }
+
+        // the hierarchy, as in sweep_sphere for MeshBVH
+        _InstanceTraversalItem stack[MeshBVH::MAX_DEPTH + 2];
+        unsigned stack_size = 0;
+        if( instances.nodes_count() != 0 &&
+            segment_and_box_collision( ray, instances.node( 0 ).box.inflated( sphere_radius ), sweep.best_time, entry_time ) )
+        {
+            stack[stack_size].node = 0;
+            stack[stack_size].entry_time = entry_time;
+            ++stack_size;
+        }
+        while( stack_size > 0 && sweep.current_end != segment_start && ( closest || !sweep.any_result ) )
+        {
+            const _InstanceTraversalItem item = stack[--stack_size];
+            if( sweep.any_result && item.entry_time >= sweep.best_time )
+            {
+                continue;
+            }
+
+            const MeshBVH::Node &node = instances.node( item.node );
+            if( node.is_leaf() )
+            {
+                for( unsigned i = node.first; i < node.first + node.count && ( closest || !sweep.any_result ); ++i )
+                {
+                    const unsigned index = instances.instance_order( i );
+                    if( segment_and_box_collision( ray, instances.instance( index ).box.inflated( sphere_radius ), sweep.best_time, entry_time ) )
+                    {
+                        _sweep_instance<Mode>( instances, index, sweep );
+                    }
+                }
+                continue;
+            }
+
+            // push the farther child first, so that the nearer one is visited first
+            _InstanceTraversalItem children[2];
+            unsigned children_count = 0;
+            for( unsigned i = 0; i < 2; ++i )
+            {
+                const unsigned child = node.first + i;
+                if( segment_and_box_collision( ray, instances.node( child ).box.inflated( sphere_radius ), sweep.best_time, entry_time ) )
+                {
+                    children[children_count].node = child;
+                    children[children_count].entry_time = entry_time;
+                    ++children_count;
+                }
+            }
+            if( children_count == 2 && children[0].entry_time < children[1].entry_time )
+            {
+                std::swap( children[0], children[1] );
+            }
+            for( unsigned i = 0; i < children_count; ++i )
+            {
+                stack[stack_size++] = children[i];
+            }
+        }
+        if( !sweep.any_result )
+            return CollisionStatus::Miss;
+
+        hit = sweep.hit;
+        hit.sphere_center = segment_start + hit.time*(segment_end - segment_start);
+        instance_index = sweep.instance_index;
+        return CollisionStatus::Hit;
+    }
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit, unsigned &instance_index) noexcept
+        {
+            return _sweep_instances<ClosestHit>( instances, segment_start, segment_end, sphere_radius, hit, instance_index );
+        }
+
+        CollisionStatus sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit, unsigned &instance_index) noexcept
+        {
+            return _sweep_instances<AnyHit>( instances, segment_start, segment_end, sphere_radius, hit, instance_index );
+        }
+    };
+
+    bool sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit, unsigned &instance_index)
+    {
+        return check_status( NoThrow::sweep_sphere( instances, segment_start, segment_end, sphere_radius, hit, instance_index ) );
+    }
+
+    bool sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit, unsigned &instance_index)
+    {
+        return check_status( NoThrow::sweep_sphere( instances, segment_start, segment_end, sphere_radius, AnyHit(), hit, instance_index ) );
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include "mesh_bvh.h"
+
+namespace Collisions
+{
+    // Placement of a mesh instance: rotation, uniform scale and translation. A point p of the mesh
+    // is at translation + scale*rotation(p) in the world. Spheres stay spheres under it, so a sphere
+    // of the world is swept against the mesh in its own space, with the radius divided by the scale.
+    class Transform
+    {
+        Vector rows[3];     // orthonormal rotation matrix
+        Vector translation;
+        double scale_factor;
+    public:
+        // identity
+        Transform();
+        // rotation by `angle' radians around `axis' (counterclockwise, looking from its end towards
+        // the origin), then scaling and translation; throws InvalidTransformError for zero axis
+        // (unless the angle is 0) or scale, which is not positive
+        Transform(const Vector &translation, const Vector &axis = Vector(0, 0, 1), double angle = 0, double scale = 1);
+        // the same with rotation by a quaternion w + xi + yj + zk, which is normalized (so any nonzero one will do)
+        static Transform from_quaternion(const Vector &translation, double w, double x, double y, double z, double scale = 1);
+
+        double scale() const { return scale_factor; }
+
+        // from mesh space to the world and back
+        Point apply(const Point &point) const
+        {
+            return translation + scale_factor*Vector( rows[0]*point, rows[1]*point, rows[2]*point );
+        }
+        Point apply_inverse(const Point &point) const
+        {
+            const Vector shifted = (point - translation)/scale_factor;
+            return shifted.x*rows[0] + shifted.y*rows[1] + shifted.z*rows[2];
+        }
+        // box of the transformed box
+        BoundingBox apply(const BoundingBox &box) const;
+    };
+
+    // Two-level hierarchy for many instances of a few meshes: a top-level hierarchy over world boxes of
+    // instances, each of which refers to a mesh hierarchy (the bottom level) and places it by a Transform.
+    // Mesh hierarchies are shared by their instances and never transformed: sweeps are transformed into
+    // mesh space instead, so memory grows with meshes, and an instance costs only its transform and box.
+    //
+    // Moving an instance refits boxes of top-level nodes above it. Moves make boxes of nodes larger than
+    // they could be, so after many of them rebuild() restores the quality of the hierarchy. Instances,
+    // added after the last rebuild(), are not in the hierarchy yet and are tested one by one.
+    class InstanceBVH
+    {
+    public:
+        static const unsigned MAX_LEAF_SIZE = 2;    // of the top level
+
+        struct Instance
+        {
+            unsigned mesh;
+            Transform transform;
+            BoundingBox box;    // in the world
+        };
+    private:
+        std::vector<BvhView> meshes;
+        std::vector<Instance> instances;
+        std::vector<MeshBVH::Node> nodes;
+        std::vector<unsigned> order;        // instances of the hierarchy in the order of leaves
+        std::vector<unsigned> parents;      // by node (the root has none)
+        std::vector<unsigned> leaves;       // by instance
+        unsigned built_count;               // instances in the hierarchy
+
+        void refit(unsigned node);
+    public:
+        static const unsigned NO_NODE = ~0u;
+
+        InstanceBVH() : built_count(0) {}
+
+        // Adds a mesh for instances and returns its index. Only the view is kept: the mesh (or a MappedMesh
+        // of the view) must outlive the hierarchy.
+        unsigned add_mesh(const MeshBVH &mesh) { return add_mesh( mesh.view() ); }
+        unsigned add_mesh(const BvhView &mesh);
+        // adds an instance of the mesh and returns its index; throws OutOfBoundsError for unknown mesh
+        unsigned add_instance(unsigned mesh, const Transform &transform);
+        // moves the instance
+        void set_transform(unsigned instance, const Transform &transform);
+        // builds the top level over all instances anew
+        void rebuild();
+
+        unsigned meshes_count() const { return static_cast<unsigned>( meshes.size() ); }
+        BvhView const & mesh(unsigned index) const
+        {
+            check( index < meshes.size(), OutOfBoundsError() );
+            return meshes[index];
+        }
+        unsigned size() const { return static_cast<unsigned>( instances.size() ); }
+        bool empty() const { return instances.empty(); }
+        Instance const & instance(unsigned index) const
+        {
+            check( index < instances.size(), OutOfBoundsError() );
+            return instances[index];
+        }
+
+        // top level: node 0 is the root (absent before the first rebuild), leaves refer to ranges of instance_order
+        unsigned nodes_count() const { return static_cast<unsigned>( nodes.size() ); }
+        MeshBVH::Node const & node(unsigned index) const
+        {
+            check( index < nodes.size(), OutOfBoundsError() );
+            return nodes[index];
+        }
+        unsigned instance_order(unsigned index) const
+        {
+            check( index < order.size(), OutOfBoundsError() );
+            return order[index];
+        }
+        unsigned built_size() const { return built_count; }
+    };
+
+    // Sweeps a sphere along the segment against all instances and finds the earliest collision (see sweep_sphere
+    // in collisions.h). Top-level nodes are visited front to back, as in the mesh hierarchy; the segment and
+    // the radius are transformed into the space of each instance, whose box is crossed before the earliest
+    // collision found so far, and the hit is transformed back. hit.triangle_index is the index in the original
+    // triangle array of the mesh of instance `instance_index'. Parts of the segment, which are degenerated in
+    // mesh space (shorter than the tolerance after division by the scale), can't hit the mesh.
+    bool sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit, unsigned &instance_index);
+    // the same, but stops at the first collision found in any instance (see AnyHit in collisions.h)
+    bool sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit, unsigned &instance_index);
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit, unsigned &instance_index) noexcept;
+        CollisionStatus sweep_sphere(const InstanceBVH &instances, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit, unsigned &instance_index) noexcept;
+    };
+};
@@ -0,0 +1,231 @@
+#pragma once
+#include "vector.h"
+#include "floating_point.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Unchecked kernels of collision finders, shared by sphere and triangle collision (collision.cpp),
+// sweeps over meshes, testing faces, edges and vertices separately (indexed_mesh.cpp), and closest
+// point queries (collision.cpp, mesh_bvh.cpp). They neither validate input nor throw.
+
+namespace Collisions
+{
+    // Tests the projection of the point onto the plane of the triangle: distance to the plane is not checked,
+    // as callers pass points in it. Returns false for degenerated triangle instead of throwing
+    template <class T>
+    inline bool _is_point_inside_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle)
+    {
+        const BasicVector<T> u = triangle[1] - triangle[0];
+        const BasicVector<T> v = triangle[2] - triangle[0];
+        const BasicVector<T> r = point - triangle[0];
+        
+        // find components of r along u and v
+        const T determinant = (u*u)*(v*v) - (u*v)*(u*v);
+        if( determinant == 0 )
+        {
+            return false;
+        }
+
+        const T ru = ( (r*u)*(v*v) - (u*v)*(r*v) ) / determinant;
+        const T rv = ( (u*u)*(r*v) - (r*u)*(u*v) ) / determinant;
+
+        return greater_or_equal( ru, 0 ) && greater_or_equal( rv, 0 ) && less_or_equal( ru + rv, 1 );
+    }
+
+    // the same, by the projection of the point; prepared triangle is never degenerated, so it is checked already
+    template <class T>
+    inline bool _is_point_inside_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle)
+    {
+        T ru, rv;
+        triangle.barycentric( point, ru, rv );
+
+        return greater_or_equal( ru, 0 ) && greater_or_equal( rv, 0 ) && less_or_equal( ru + rv, 1 );
+    }
+
+    // if vector pointing outside triangle, while crossing given side
+    template <class T>
+    inline bool _is_vector_outside(const BasicVector<T> &vector, const BasicVector<T> &side_outer_normal)
+    {
+        return vector*side_outer_normal < 0;
+    }
+
+    // Sphere center S + t*L touches the infinite cylinder of radius R around the line P + u*D, when
+    // |D x (S + t*L - P)|^2 == R^2 * |D|^2. This is a quadratic in t: its smaller root is the moment of
+    // entering the cylinder, and the touch point is the projection of the sphere center onto the line
+    // at that moment. No trigonometry and a single sqrt.
+    // Takes the sphere way L and w == S - P; writes the time and the position of the touch point on the line
+    // (in units of D), returns false if the sphere doesn't enter the cylinder within its way.
+    template <class T>
+    inline bool _sphere_and_line_entry(const BasicVector<T> &L, const BasicVector<T> &w, const BasicVector<T> &D, T sphere_radius,
+                                       /*out*/ T &time, T &position)
+    {
+        const BasicVector<T> D_cross_L = cross_product( D, L );
+        const BasicVector<T> D_cross_w = cross_product( D, w );
+        const T D_squared = D.sqared_norm();
+        const T R_squared = sphere_radius*sphere_radius;
+
+        // a*t^2 + 2*b*t + c == 0
+        const T a = D_cross_L.sqared_norm();
+        const T b = D_cross_w*D_cross_L;
+        const T c = D_cross_w.sqared_norm() - R_squared*D_squared;
+
+        const T epsilon = static_cast<T>( DefaultToleranceFor<T>::type::epsilon );
+        if( a <= epsilon*epsilon*D_squared*L.sqared_norm() )
+        {
+            // when the sphere is flying in parallel to the line, it's assumed to be no collision
+            return false;
+        }
+        T discriminant = b*b - a*c;
+        if( discriminant < 0 )
+        {
+            // squared distance between the lines is R^2 - discriminant/(a*|D|^2)
+            if( !less_or_equal( R_squared - discriminant/(a*D_squared), R_squared ) )
+            {
+                return false; // sphere flies too far
+            }
+            discriminant = 0; // touching within tolerance
+        }
+        const T t = ( -b - std::sqrt( discriminant ) )/a;
+        if( !greater_or_equal( t, 0 ) || !less_or_equal( t, 1 ) )
+        {
+            // entering the cylinder is outside the sphere way (it is also the case of starting inside it)
+            return false;
+        }
+        time = std::min( std::max( t, T(0) ), T(1) );
+        position = (w + t*L)*D/D_squared;
+        return true;
+    }
+
+    // sphere and point collision (the same as _sphere_and_point_collision in collision.cpp), for w == segment_start - point
+    template <class T>
+    inline bool _sphere_and_point_entry(const BasicVector<T> &L, T L_squared, const BasicVector<T> &w, T sphere_radius, /*out*/ T &time)
+    {
+        const T b = w*L;
+        const T nearest_time = std::min( std::max( -b/L_squared, T(0) ), T(1) );
+        if( !greater_or_equal( sphere_radius, (w + nearest_time*L).norm() ) )
+        {
+            return false;
+        }
+        const T c = w*w - sphere_radius*sphere_radius;
+        if( c <= 0 )
+        {
+            time = 0; // touching it from the very start
+        }
+        else
+        {
+            const T discriminant = std::max( b*b - L_squared*c, T(0) ); // may be a bit less than 0 within tolerance
+            time = std::min( std::max( ( -b - std::sqrt( discriminant ) )/L_squared, T(0) ), T(1) );
+        }
+        return true;
+    }
+
+    // nearest point of the segment a + t*ab, t in [0, 1] (`a' itself for a segment of zero length)
+    template <class T>
+    inline BasicPoint<T> _closest_point_on_segment(const BasicPoint<T> &point, const BasicPoint<T> &a, const BasicVector<T> &ab)
+    {
+        const T ab_squared = ab*ab;
+        if( !( ab_squared > 0 ) )
+        {
+            return a;
+        }
+        const T t = std::min( std::max( (point - a)*ab/ab_squared, T(0) ), T(1) );
+        return a + t*ab;
+    }
+
+    // Nearest point of the triangle a, a + ab, a + ac: finds the Voronoi region of the triangle (three vertices,
+    // three sides and the face), containing the point, by signs of dot products with the sides, and projects the
+    // point onto that feature. Exact for every point, not only for ones above the face. For a degenerated triangle
+    // (its face region is empty) the nearest of its sides is taken.
+    template <class T>
+    inline BasicPoint<T> _closest_point_on_triangle(const BasicPoint<T> &point, const BasicPoint<T> &a, const BasicVector<T> &ab, const BasicVector<T> &ac)
+    {
+        // vertex a
+        const BasicVector<T> ap = point - a;
+        const T d1 = ab*ap;
+        const T d2 = ac*ap;
+        if( d1 <= 0 && d2 <= 0 )
+        {
+            return a;
+        }
+
+        // vertex b
+        const BasicVector<T> bp = ap - ab;
+        const T d3 = ab*bp;
+        const T d4 = ac*bp;
+        if( d3 >= 0 && d4 <= d3 )
+        {
+            return a + ab;
+        }
+
+        // side ab (d1 - d3 == |ab|^2, sides of zero length are left to the others)
+        const T vc = d1*d4 - d3*d2;
+        if( vc <= 0 && d1 >= 0 && d3 <= 0 && d1 > d3 )
+        {
+            return a + ( d1/(d1 - d3) )*ab;
+        }
+
+        // vertex c
+        const BasicVector<T> cp = ap - ac;
+        const T d5 = ab*cp;
+        const T d6 = ac*cp;
+        if( d6 >= 0 && d5 <= d6 )
+        {
+            return a + ac;
+        }
+
+        // side ac
+        const T vb = d5*d2 - d1*d6;
+        if( vb <= 0 && d2 >= 0 && d6 <= 0 && d2 > d6 )
+        {
+            return a + ( d2/(d2 - d6) )*ac;
+        }
+
+        // side bc
+        const T va = d3*d6 - d5*d4;
+        if( va <= 0 && d4 >= d3 && d5 >= d6 && (d4 - d3) + (d5 - d6) > 0 )
+        {
+            return a + ab + ( (d4 - d3)/( (d4 - d3) + (d5 - d6) ) )*(ac - ab);
+        }
+
+        // face: va + vb + vc == |ab x ac|^2, which is lost in rounding for (nearly) degenerated triangles
+        const T area_squared = va + vb + vc;
+        if( !( area_squared > std::numeric_limits<T>::epsilon()*(ab*ab)*(ac*ac) ) )
+        {
+            const BasicPoint<T> candidates[3] = { _closest_point_on_segment( point, a, ab ),
+                                                  _closest_point_on_segment( point, a, ac ),
+                                                  _closest_point_on_segment( point, a + ab, ac - ab ) };
+            unsigned nearest = 0;
+            for( unsigned i = 1; i < 3; ++i )
+            {
+                if( (candidates[i] - point).sqared_norm() < (candidates[nearest] - point).sqared_norm() )
+                {
+                    nearest = i;
+                }
+            }
+            return candidates[nearest];
+        }
+        return a + (vb/area_squared)*ab + (vc/area_squared)*ac;
+    }
+
+    template <class T>
+    inline BasicPoint<T> _closest_point_on_triangle(const BasicPoint<T> &point, const BasicTriangle<T> &triangle)
+    {
+        return _closest_point_on_triangle( point, triangle[0], triangle[1] - triangle[0], triangle[2] - triangle[0] );
+    }
+
+    // prepared triangle has its sides precomputed
+    template <class T>
+    inline BasicPoint<T> _closest_point_on_triangle(const BasicPoint<T> &point, const BasicPreparedTriangle<T> &triangle)
+    {
+        return _closest_point_on_triangle( point, triangle[0], triangle.side(0), -triangle.side(2) );
+    }
+
+    // tolerance of rejecting the sphere, which never comes near the plane of triangle: it is looser than
+    // tolerances of the plane, side and vertex tests, so that nothing they would accept is rejected
+    struct _PlaneRejectTolerance
+    {
+        static constexpr long long max_ulps = 4096;
+        static constexpr double epsilon = 1e-10;
+    };
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include "simd.h"
+#include "collisions.h"
+#include <limits>
+
+// Branch-free kernels over packs of lanes (see simd.h), shared by TriangleSoup (a block of triangles
+// in lanes against one sweep or ray, triangle_soup.cpp) and SpherePacket (sweeps in lanes against one triangle,
+// sphere_packet.cpp). Whatever is the same for all lanes is broadcasted. Like simd.h, include it only
+// from translation units.
+
+namespace Collisions
+{
+    // tolerance of comparisons, the same as for floating point helpers near zero
+    const double KERNEL_EPSILON = DEFAULT_EPSILON;
+
+    template <class Pack> inline typename Pack::Mask _in_unit_range(Pack value)
+    {
+        return ( value >= Pack(-KERNEL_EPSILON) ) & ( value <= Pack(1 + KERNEL_EPSILON) );
+    }
+
+    // sweeps in lanes: either one broadcasted to all of them, or loaded from arrays of [coordinate][lane]
+    template <class Pack>
+    struct _SweepQuery
+    {
+        Simd::PackVector<Pack> start;
+        Simd::PackVector<Pack> vector; // from start to end
+        Pack radius;
+        Pack squared_radius;
+        Pack squared_length;
+
+        _SweepQuery() {}
+        _SweepQuery(const Point &segment_start, const Point &segment_end, double sphere_radius)
+            : start( segment_start ), vector( segment_end - segment_start ), radius( sphere_radius ),
+              squared_radius( sphere_radius*sphere_radius ), squared_length( (segment_end - segment_start).sqared_norm() )
+        {
+        }
+        template <unsigned N>
+        _SweepQuery(const double (&starts)[3][N], const double (&vectors)[3][N], const double (&radii)[N], unsigned lane)
+            : start( Simd::PackVector<Pack>::load( starts, lane ) ), vector( Simd::PackVector<Pack>::load( vectors, lane ) ),
+              radius( Pack::load( &radii[lane] ) ), squared_radius( radius*radius ), squared_length( dot( vector, vector ) )
+        {
+        }
+    };
+
+    // Mask of lanes, where the sphere comes near the plane (`normal', `offset') while moving from the start
+    // of the sweep to `reach' of its way, with the tolerance of _sweep_lanes, which takes times a bit over 1.
+    // The kernel finds no hit, if the sphere stays on one side of the plane farther than its radius.
+    template <class Pack>
+    typename Pack::Mask _near_plane(const Simd::PackVector<Pack> &normal, Pack offset, const _SweepQuery<Pack> &query, Pack reach)
+    {
+        const Pack L_normal = dot( query.vector, normal );
+        const Pack start_distance = dot( query.start, normal ) - offset;
+        const Pack end_distance = start_distance + L_normal*reach;
+        const Pack margin = query.radius + Pack(KERNEL_EPSILON)*( abs( L_normal ) + query.radius + Pack(1.0) );
+        return ( min( start_distance, end_distance ) <= margin ) & ( max( start_distance, end_distance ) >= -margin );
+    }
+
+    // Triangles in lanes are given by `Lanes', which provides PackVectors vertex(i), side(i) and side_normal(i)
+    // (see PreparedTriangle::side and side_outer_normal), normal(), dual_u() and dual_v() (dual basis for
+    // barycentric coordinates), and Pack offset() (plane offset).
+    //
+    // Returns mask of lanes, where the sphere hits the triangle, and writes time of impact and collision point for them.
+    // It is a branch-free version of sphere_and_triangle_collision: plane, side and vertex tests
+    // are done for all lanes, and results are chosen with masks instead of early returns.
+    template <class Pack, class Lanes>
+    typename Pack::Mask _sweep_lanes(const Lanes &triangle, const _SweepQuery<Pack> &query,
+                                     /*out*/ Pack &time, Simd::PackVector<Pack> &point)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const Pack zero(0.0);
+        const Pack infinity( std::numeric_limits<double>::infinity() );
+        const PackVector &S = query.start;
+        const PackVector &L = query.vector;
+
+        const PackVector vertices[3] = { triangle.vertex(0), triangle.vertex(1), triangle.vertex(2) };
+
+        // 1) is it touching a plane of triangle inside the triangle?
+        const PackVector normal = triangle.normal();
+        const Pack L_normal = dot( L, normal );
+        const Pack shift = select( L_normal > zero, query.radius, -query.radius ); // see sphere_and_plane_collision
+        const Pack face_time = ( triangle.offset() - dot( S, normal ) - shift )/L_normal;
+        const PackVector face_point = S + normal*shift + L*face_time;
+        const PackVector r = face_point - vertices[0];
+        const Pack ru = dot( r, triangle.dual_u() );
+        const Pack rv = dot( r, triangle.dual_v() );
+        const Mask face_hit = ( abs( L_normal ) > Pack(KERNEL_EPSILON) ) & _in_unit_range( face_time ) &
+                              ( ru >= Pack(-KERNEL_EPSILON) ) & ( rv >= Pack(-KERNEL_EPSILON) ) & ( ru + rv <= Pack(1 + KERNEL_EPSILON) );
+
+        // 2) is it touching any side, while moving inside?
+        Mask moving_inside[3] = { zero < zero, zero < zero, zero < zero };
+        Mask side_hit = zero < zero;
+        Pack side_time = infinity;
+        PackVector side_point = S;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            const PackVector side = triangle.side(i);
+            moving_inside[i] = dot( L, triangle.side_normal(i) ) < zero;
+
+            // sphere center S + t*L is at distance `radius' from the side's line: a*t^2 + 2*b*t + c == 0
+            const PackVector w = S - vertices[i];
+            const Pack squared_side = dot( side, side );
+            const Pack L_side = dot( L, side );
+            const Pack w_side = dot( w, side );
+            const Pack a = query.squared_length - L_side*L_side/squared_side;
+            const Pack b = dot( w, L ) - w_side*L_side/squared_side;
+            const Pack c = dot( w, w ) - w_side*w_side/squared_side - query.squared_radius;
+            const Pack discriminant = b*b - a*c;
+            const Pack t = ( -b - sqrt( max( discriminant, zero ) ) )/a; // earlier root
+            const Pack u = ( w_side + t*L_side )/squared_side;            // touch point along the side
+
+            const Mask hit = moving_inside[i] & ( a > Pack(KERNEL_EPSILON)*query.squared_length ) & ( discriminant >= zero ) &
+                             _in_unit_range( t ) & _in_unit_range( u ) & ( t < side_time );
+            side_time = select( hit, t, side_time );
+            side_point = select( hit, vertices[i] + side*u, side_point );
+            side_hit = side_hit | hit;
+        }
+
+        // 3) is it touching any vertex, while moving inside?
+        Mask vertex_hit = zero < zero;
+        Pack vertex_time = infinity;
+        PackVector vertex_point = S;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            // sphere center S + t*L is at distance `radius' from the vertex: |L|^2*t^2 + 2*b*t + c == 0
+            const PackVector w = S - vertices[i];
+            const Pack b = dot( w, L );
+            const Pack c = dot( w, w ) - query.squared_radius;
+            const Pack discriminant = b*b - query.squared_length*c;
+            const Mask inside_at_start = c <= zero;
+            const Pack t = select( inside_at_start, zero, ( -b - sqrt( max( discriminant, zero ) ) )/query.squared_length );
+
+            const Mask hit = moving_inside[i] & moving_inside[ (i+2)%3 ] &
+                             ( inside_at_start | ( ( discriminant >= zero ) & _in_unit_range( t ) ) ) & ( t < vertex_time );
+            vertex_time = select( hit, t, vertex_time );
+            vertex_point = select( hit, vertices[i], vertex_point );
+            vertex_hit = vertex_hit | hit;
+        }
+
+        time = select( face_hit, face_time, select( side_hit, side_time, vertex_time ) );
+        point = select( face_hit, face_point, select( side_hit, side_point, vertex_point ) );
+        return face_hit | side_hit | vertex_hit;
+    }
+
+    // Ray against triangles in lanes, of which only vertex(0), side(0) and side(2) are needed: a branch-free
+    // version of Moller-Trumbore test of segment_and_triangle_collision. Returns mask of lanes, where the ray
+    // hits the triangle not farther than `max_time', and writes time and barycentric coordinates for them.
+    template <class Pack, class Lanes>
+    typename Pack::Mask _raycast_lanes(const Lanes &triangle, const Simd::PackVector<Pack> &origin, const Simd::PackVector<Pack> &direction, Pack max_time,
+                                       /*out*/ Pack &time, Pack &u, Pack &v)
+    {
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const Pack epsilon( KERNEL_EPSILON );
+        const PackVector edge1 = triangle.side(0);
+        const PackVector side2 = triangle.side(2);
+        const PackVector edge2( -side2.x, -side2.y, -side2.z );
+
+        const PackVector p = cross_product( direction, edge2 );
+        const Pack determinant = dot( edge1, p );
+        const Pack inverse_determinant = Pack(1.0)/determinant;
+        const PackVector s = origin - triangle.vertex(0);
+        const PackVector q = cross_product( s, edge1 );
+        u = dot( s, p )*inverse_determinant;
+        v = dot( direction, q )*inverse_determinant;
+        time = dot( edge2, q )*inverse_determinant;
+
+        return ( determinant*determinant > epsilon*epsilon*dot( direction, direction )*dot( edge1, edge1 )*dot( edge2, edge2 ) ) &
+               ( u >= -epsilon ) & ( u <= Pack(1 + KERNEL_EPSILON) ) & ( v >= -epsilon ) & ( u + v <= Pack(1 + KERNEL_EPSILON) ) &
+               ( time >= -epsilon ) & ( time <= max_time + epsilon );
+    }
+};
@@ -0,0 +1,374 @@
+#include "mapped_mesh.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Collisions
+{
+    const unsigned MappedMesh::VERSION;
+    const unsigned MappedMesh::SECTION_ALIGNMENT;
+
+    // ------------------------------------ F o r m a t ----------------------------------------
+
+    const char _SIGNATURE[8] = { 'C', 'O', 'L', 'M', 'E', 'S', 'H', '\0' };
+    // written as a number: reads back the same only with the same byte order
+    const uint32_t _BYTE_ORDER_MARK = 0x01020304;
+
+    struct _FileHeader
+    {
+        char signature[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t vertices_count;
+        uint32_t triangles_count;
+        uint32_t nodes_count;
+        uint32_t max_depth;     // MeshBVH::MAX_DEPTH of the writer: no node of the hierarchy is deeper
+        // sizes of stored types: the layout of elements of sections
+        uint32_t point_size;
+        uint32_t triangle_size;
+        uint32_t node_size;
+        uint32_t padding;       // zero
+        uint64_t file_size;
+    };
+
+    // the header is followed by MappedMesh::SECTIONS_COUNT of these
+    struct _SectionEntry
+    {
+        uint64_t offset;    // from the start of the file; 0 for an empty section
+        uint64_t bytes;
+        uint64_t checksum;  // see _checksum
+    };
+
+    // Fletcher-like sums of 64-bit words (the tail is padded with zeros): fast enough to read
+    // gigabytes at memory speed, and catches truncated, zeroed or shifted parts of a file
+    uint64_t _checksum(const unsigned char *data, size_t bytes)
+    {
+        uint64_t sum = 0, sum_of_sums = 0;
+        size_t i = 0;
+        for( ; i + 8 <= bytes; i += 8 )
+        {
+            uint64_t word;
+            memcpy( &word, data + i, 8 );
+            sum += word;
+            sum_of_sums += sum;
+        }
+        if( i < bytes )
+        {
+            uint64_t word = 0;
+            memcpy( &word, data + i, bytes - i );
+            sum += word;
+            sum_of_sums += sum;
+        }
+        return sum_of_sums ^ ( sum << 32 | sum >> 32 ) ^ bytes;
+    }
+
+    inline uint64_t _aligned(uint64_t offset)
+    {
+        return ( offset + MappedMesh::SECTION_ALIGNMENT - 1 )/MappedMesh::SECTION_ALIGNMENT*MappedMesh::SECTION_ALIGNMENT;
+    }
+
+    // bytes of sections for the given header
+    void _section_sizes(const _FileHeader &header, /*out*/ uint64_t (&bytes)[MappedMesh::SECTIONS_COUNT])
+    {
+        const bool has_bvh = header.nodes_count != 0;
+        bytes[MappedMesh::VERTICES] = static_cast<uint64_t>( header.vertices_count )*sizeof(Point);
+        bytes[MappedMesh::INDICES] = static_cast<uint64_t>( header.triangles_count )*3*sizeof(unsigned);
+        bytes[MappedMesh::TRIANGLES] = static_cast<uint64_t>( header.triangles_count )*sizeof(PreparedTriangle);
+        bytes[MappedMesh::ORIGINAL_INDICES] = has_bvh ? static_cast<uint64_t>( header.triangles_count )*sizeof(unsigned) : 0;
+        bytes[MappedMesh::NODES] = static_cast<uint64_t>( header.nodes_count )*sizeof(MeshBVH::Node);
+    }
+
+    // ------------------------------------ W r i t e r ----------------------------------------
+
+    void _write(std::FILE *file, const void *data, size_t bytes)
+    {
+        check( bytes == 0 || fwrite( data, 1, bytes, file ) == bytes, FileError() );
+    }
+
+    void _write_file(const char *path, const _FileHeader &header, const _SectionEntry (&entries)[MappedMesh::SECTIONS_COUNT],
+                     const void * const (&sections)[MappedMesh::SECTIONS_COUNT])
+    {
+        std::FILE *file = fopen( path, "wb" );
+        check( file != NULL, FileError() );
+        try
+        {
+            const unsigned char padding[MappedMesh::SECTION_ALIGNMENT] = { 0 };
+            _write( file, &header, sizeof(header) );
+            _write( file, entries, sizeof(entries) );
+            uint64_t position = sizeof(header) + sizeof(entries);
+            for( unsigned i = 0; i < MappedMesh::SECTIONS_COUNT; ++i )
+            {
+                if( entries[i].bytes == 0 )
+                    continue;
+
+                _write( file, padding, static_cast<size_t>( entries[i].offset - position ) );
+                _write( file, sections[i], static_cast<size_t>( entries[i].bytes ) );
+                position = entries[i].offset + entries[i].bytes;
+            }
+            _write( file, padding, static_cast<size_t>( header.file_size - position ) );
+        }
+        catch( ... )
+        {
+            fclose( file );
+            throw;
+        }
+        check( fclose( file ) == 0, FileError() );
+    }
+
+    void MappedMesh::write(const char *path, const std::vector<Point> &vertices, const std::vector<unsigned> &indices, bool with_bvh)
+    {
+        check( indices.size() % 3 == 0, InvalidIndicesError() );
+        for( unsigned i = 0; i < indices.size(); ++i )
+        {
+            check( indices[i] < vertices.size(), InvalidIndicesError() );
+        }
+        const unsigned count = static_cast<unsigned>( indices.size()/3 );
+        std::vector<PreparedTriangle> triangles;
+        triangles.reserve( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            // throws DegeneratedTriangleError, if needed
+            triangles.push_back( PreparedTriangle( vertices[ indices[3*i] ], vertices[ indices[3*i + 1] ], vertices[ indices[3*i + 2] ] ) );
+        }
+
+        _FileHeader header;
+        memset( &header, 0, sizeof(header) );
+        memcpy( header.signature, _SIGNATURE, sizeof(_SIGNATURE) );
+        header.version = VERSION;
+        header.byte_order = _BYTE_ORDER_MARK;
+        header.vertices_count = static_cast<unsigned>( vertices.size() );
+        header.triangles_count = count;
+        header.point_size = sizeof(Point);
+        header.triangle_size = sizeof(PreparedTriangle);
+        header.node_size = sizeof(MeshBVH::Node);
+        header.max_depth = MeshBVH::MAX_DEPTH;
+
+        const void *sections[SECTIONS_COUNT] = { vertices.data(), indices.data(), triangles.data(), NULL, NULL };
+        const MeshBVH hierarchy( with_bvh ? triangles : std::vector<PreparedTriangle>() );
+        if( !hierarchy.empty() )
+        {
+            const BvhView bvh = hierarchy.view();
+            header.nodes_count = bvh.nodes_count;
+            sections[TRIANGLES] = bvh.triangles;
+            sections[ORIGINAL_INDICES] = bvh.original_indices;
+            sections[NODES] = bvh.nodes;
+        }
+
+        _SectionEntry entries[SECTIONS_COUNT];
+        uint64_t bytes[SECTIONS_COUNT];
+        _section_sizes( header, bytes );
+        uint64_t position = sizeof(header) + sizeof(entries);
+        for( unsigned i = 0; i < SECTIONS_COUNT; ++i )
+        {
+            entries[i].bytes = bytes[i];
+            entries[i].offset = bytes[i] == 0 ? 0 : _aligned( position );
+            entries[i].checksum = _checksum( static_cast<const unsigned char *>( sections[i] ), static_cast<size_t>( bytes[i] ) );
+            position = bytes[i] == 0 ? position : entries[i].offset + bytes[i];
+        }
+        header.file_size = _aligned( position );
+
+        _write_file( path, header, entries, sections );
+    }
+
+    // ------------------------------------ M a p p i n g --------------------------------------
+
+    MappedMesh::MappedMesh(const char *path)
+        : data(NULL), size(0), handle(NULL), count_vertices(0), count_triangles(0), count_nodes(0)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        check( file != INVALID_HANDLE_VALUE, FileError() );
+        LARGE_INTEGER file_size;
+        if( !GetFileSizeEx( file, &file_size ) )
+        {
+            CloseHandle( file );
+            throw FileError();
+        }
+        size = static_cast<size_t>( file_size.QuadPart );
+        if( size < sizeof(_FileHeader) + SECTIONS_COUNT*sizeof(_SectionEntry) )
+        {
+            CloseHandle( file );
+            throw InvalidMeshFileError();
+        }
+        // the mapping keeps the file open
+        HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        CloseHandle( file );
+        check( mapping != NULL, FileError() );
+        data = static_cast<const unsigned char *>( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+        if( data == NULL )
+        {
+            CloseHandle( mapping );
+            throw FileError();
+        }
+        handle = mapping;
+#else
+        const int file = open( path, O_RDONLY );
+        check( file >= 0, FileError() );
+        struct stat status;
+        if( fstat( file, &status ) != 0 )
+        {
+            close( file );
+            throw FileError();
+        }
+        size = static_cast<size_t>( status.st_size );
+        if( size < sizeof(_FileHeader) + SECTIONS_COUNT*sizeof(_SectionEntry) )
+        {
+            close( file );
+            throw InvalidMeshFileError();
+        }
+        // shared: pages of the file are shared by all processes mapping it
+        void *address = mmap( NULL, size, PROT_READ, MAP_SHARED, file, 0 );
+        close( file ); // the mapping keeps the file open
+        check( address != MAP_FAILED, FileError() );
+        data = static_cast<const unsigned char *>( address );
+#endif
+        try
+        {
+            validate();
+        }
+        catch( ... )
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    MappedMesh::~MappedMesh()
+    {
+        unmap();
+    }
+
+    void MappedMesh::unmap()
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( data );
+        CloseHandle( static_cast<HANDLE>( handle ) );
+#else
+        munmap( const_cast<unsigned char *>( data ), size );
+#endif
+    }
+
+    // checks the header and the table of sections only: contents of sections are not read
+    void MappedMesh::validate()
+    {
+        _FileHeader header;
+        memcpy( &header, data, sizeof(header) );
+        check( memcmp( header.signature, _SIGNATURE, sizeof(_SIGNATURE) ) == 0 && header.version == VERSION &&
+               header.byte_order == _BYTE_ORDER_MARK, InvalidMeshFileError() );
+        check( header.point_size == sizeof(Point) && header.triangle_size == sizeof(PreparedTriangle) &&
+               header.node_size == sizeof(MeshBVH::Node), InvalidMeshFileError() );
+        check( header.file_size == size, InvalidMeshFileError() );
+        // a hierarchy of n triangles has at most 2n - 1 nodes
+        check( header.nodes_count <= 2*static_cast<uint64_t>( header.triangles_count ), InvalidMeshFileError() );
+        // traversals keep a stack for the path from the root, sized by MeshBVH::MAX_DEPTH of this build
+        check( header.max_depth <= MeshBVH::MAX_DEPTH, InvalidMeshFileError() );
+
+        uint64_t bytes[SECTIONS_COUNT];
+        _section_sizes( header, bytes );
+        const _SectionEntry *entries = reinterpret_cast<const _SectionEntry *>( data + sizeof(header) );
+        for( unsigned i = 0; i < SECTIONS_COUNT; ++i )
+        {
+            _SectionEntry entry;
+            memcpy( &entry, entries + i, sizeof(entry) );
+            check( entry.bytes == bytes[i], InvalidMeshFileError() );
+            check( entry.offset % SECTION_ALIGNMENT == 0 && entry.offset <= size && entry.bytes <= size - entry.offset, InvalidMeshFileError() );
+            sections[i] = entry.bytes == 0 ? NULL : data + entry.offset;
+        }
+        count_vertices = header.vertices_count;
+        count_triangles = header.triangles_count;
+        count_nodes = header.nodes_count;
+    }
+
+    // Inner nodes refer to a pair of children after them, so one pass in the order of nodes finds the depth
+    // of every node before its children. Leaves refer to ranges of stored triangles.
+    bool _valid_nodes(const MeshBVH::Node *nodes, unsigned nodes_count, unsigned triangles_count)
+    {
+        std::vector<unsigned> depths( nodes_count, 0 );
+        for( unsigned i = 0; i < nodes_count; ++i )
+        {
+            const MeshBVH::Node &node = nodes[i];
+            if( node.is_leaf() )
+            {
+                if( static_cast<uint64_t>( node.first ) + node.count > triangles_count )
+                {
+                    return false;
+                }
+                continue;
+            }
+            if( node.first <= i || node.first >= nodes_count - 1 || depths[i] + 1 >= MeshBVH::MAX_DEPTH )
+            {
+                return false;
+            }
+            depths[node.first] = std::max( depths[node.first], depths[i] + 1 );
+            depths[node.first + 1] = std::max( depths[node.first + 1], depths[i] + 1 );
+        }
+        return true;
+    }
+
+    bool MappedMesh::verify() const
+    {
+        const _SectionEntry *entries = reinterpret_cast<const _SectionEntry *>( data + sizeof(_FileHeader) );
+        for( unsigned i = 0; i < SECTIONS_COUNT; ++i )
+        {
+            _SectionEntry entry;
+            memcpy( &entry, entries + i, sizeof(entry) );
+            if( _checksum( data + entry.offset, static_cast<size_t>( entry.bytes ) ) != entry.checksum )
+            {
+                return false;
+            }
+        }
+        // sections are trusted from here: check the indices and the hierarchy too, as IndexedMesh checks indices
+        const unsigned *indices = static_cast<const unsigned *>( sections[INDICES] );
+        for( unsigned i = 0; i < 3*count_triangles; ++i )
+        {
+            if( indices[i] >= count_vertices )
+            {
+                return false;
+            }
+        }
+        return _valid_nodes( static_cast<const MeshBVH::Node *>( sections[NODES] ), count_nodes, count_triangles );
+    }
+
+    BvhView MappedMesh::bvh() const
+    {
+        const BvhView result = { static_cast<const PreparedTriangle *>( sections[TRIANGLES] ), static_cast<const unsigned *>( sections[ORIGINAL_INDICES] ),
+                                 static_cast<const MeshBVH::Node *>( sections[NODES] ), has_bvh() ? count_triangles : 0, count_nodes };
+        return result;
+    }
+
+    // -------------------------------------- Q u e r y ----------------------------------------
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const MappedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            if( mesh.has_bvh() )
+            {
+                return NoThrow::sweep_sphere( mesh.bvh(), segment_start, segment_end, sphere_radius, hit );
+            }
+            if( mesh.empty() )
+            {
+                return segment_start == segment_end ? CollisionStatus::DegenerateSegment : CollisionStatus::Miss;
+            }
+            return NoThrow::sweep_sphere( &mesh.prepared_triangle( 0 ), mesh.triangles_count(), segment_start, segment_end, sphere_radius, hit );
+        }
+    };
+
+    bool sweep_sphere(const MappedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+};
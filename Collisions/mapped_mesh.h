@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "collisions.h"
+#include "mesh_bvh.h"
+
+namespace Collisions
+{
+    // Collision mesh in a binary file, mapped into memory and used in place: nothing is parsed or copied
+    // on opening, pages are read by the system when they are touched first, and processes mapping the same
+    // file share them. The file is written by MappedMesh::write from a vertex buffer and indices, and
+    // keeps them together with prepared triangles (plane and side data, see PreparedTriangle) and,
+    // optionally, a MeshBVH over them.
+    //
+    // Layout (version 1): a header, a table of sections and the sections themselves, each starting at a
+    // multiple of SECTION_ALIGNMENT. Numbers are written in the byte order of the writer, and a file of
+    // the other byte order is rejected on opening by a mark in its header. Elements of sections are stored
+    // exactly as in memory, so a file is readable by builds with the same layout of Point, PreparedTriangle
+    // and MeshBVH::Node (their sizes are recorded and checked on opening) and with MeshBVH::MAX_DEPTH not
+    // less than the writer's one (it is recorded too). Each section has a checksum, which is not checked
+    // on opening (it would read the whole file), but by verify().
+    class MappedMesh
+    {
+    public:
+        static const unsigned VERSION = 1;
+        static const unsigned SECTION_ALIGNMENT = 64;
+
+        enum Section
+        {
+            VERTICES,           // Point per vertex
+            INDICES,            // three unsigned per triangle
+            TRIANGLES,          // PreparedTriangle per triangle: in the order of the hierarchy, if there is one
+            ORIGINAL_INDICES,   // unsigned per triangle, see MeshBVH::original_index (only with the hierarchy)
+            NODES,              // MeshBVH::Node per node (only with the hierarchy)
+            SECTIONS_COUNT
+        };
+    private:
+        const unsigned char *data;  // the whole file
+        size_t size;
+        void *handle;               // of the mapping, if the system has one apart from the address
+
+        unsigned count_vertices;
+        unsigned count_triangles;
+        unsigned count_nodes;
+        const void *sections[SECTIONS_COUNT]; // in the file, found by validate()
+
+        void validate();
+        void unmap();
+
+        // not copyable
+        MappedMesh(const MappedMesh &);
+        MappedMesh & operator=(const MappedMesh &);
+    public:
+        // Writes a mesh file: throws InvalidIndicesError, if there is a partial triangle or an index out of
+        // the vertex buffer, DegeneratedTriangleError for degenerated triangle and FileError, if the file
+        // can't be written. The hierarchy is built, if `with_bvh'.
+        static void write(const char *path, const std::vector<Point> &vertices, const std::vector<unsigned> &indices,
+                          bool with_bvh = true);
+
+        // Maps the file: throws FileError, if it can't be opened or mapped, and InvalidMeshFileError, if its
+        // header or table of sections is wrong (bad signature, other version, byte order or layout, deeper
+        // hierarchy allowed, sections out of the file)
+        explicit MappedMesh(const char *path);
+        ~MappedMesh();
+
+        // Reads the whole file and compares checksums of its sections, then checks that indices refer to
+        // vertices, and nodes of the hierarchy to children after them and to stored triangles, with no node
+        // deeper than MeshBVH::MAX_DEPTH allows. A file, which is not verified, is trusted: contents of its
+        // sections (like indices of nodes) are used as they are.
+        bool verify() const;
+
+        unsigned vertices_count() const { return count_vertices; }
+        unsigned triangles_count() const { return count_triangles; }
+        bool empty() const { return count_triangles == 0; }
+        bool has_bvh() const { return count_nodes != 0; }
+        // bytes of the file
+        size_t file_size() const { return size; }
+
+        Point const & vertex(unsigned index) const
+        {
+            check( index < count_vertices, OutOfBoundsError() );
+            return static_cast<const Point *>( sections[VERTICES] )[index];
+        }
+        // index of the vertex #corner of the triangle
+        unsigned vertex_index(unsigned triangle, unsigned corner) const
+        {
+            check( triangle < count_triangles && corner <= 2, OutOfBoundsError() );
+            return static_cast<const unsigned *>( sections[INDICES] )[3*triangle + corner];
+        }
+        Triangle triangle(unsigned index) const
+        {
+            return Triangle( vertex( vertex_index( index, 0 ) ), vertex( vertex_index( index, 1 ) ), vertex( vertex_index( index, 2 ) ) );
+        }
+        // triangles in the stored order (of the hierarchy, if there is one)
+        PreparedTriangle const & prepared_triangle(unsigned index) const
+        {
+            check( index < count_triangles, OutOfBoundsError() );
+            return static_cast<const PreparedTriangle *>( sections[TRIANGLES] )[index];
+        }
+        // index in the original order of the triangle in the stored order
+        unsigned original_index(unsigned index) const
+        {
+            check( index < count_triangles, OutOfBoundsError() );
+            return has_bvh() ? static_cast<const unsigned *>( sections[ORIGINAL_INDICES] )[index] : index;
+        }
+        // the hierarchy in the file (empty without it)
+        BvhView bvh() const;
+    };
+
+    // Sweeps a sphere along the segment against the mesh and finds the earliest collision (see sweep_sphere
+    // in collisions.h): by its hierarchy, if there is one, or by all its triangles. hit.triangle_index is
+    // the index in the original order.
+    bool sweep_sphere(const MappedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const MappedMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+    };
+};
@@ -0,0 +1,892 @@
+#include "mesh_bvh.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Collisions
+{
+    // ---------------------------------- B u i l d e r ----------------------------------------
+
+    const unsigned MeshBVH::MAX_LEAF_SIZE;
+    const unsigned MeshBVH::BINS_COUNT;
+    const unsigned MeshBVH::MAX_DEPTH;
+
+    // triangle, as seen by the builder
+    struct _BuildItem
+    {
+        BoundingBox box;
+        Point centroid;
+        unsigned index;
+    };
+
+    // range of items to be placed into the node
+    struct _BuildTask
+    {
+        unsigned node;
+        unsigned first;
+        unsigned count;
+        unsigned depth;
+
+        _BuildTask(unsigned node, unsigned first, unsigned count, unsigned depth)
+            : node(node), first(first), count(count), depth(depth) {}
+    };
+
+    inline double _coordinate(const Point &point, unsigned axis)
+    {
+        return axis == 0 ? point.x : ( axis == 1 ? point.y : point.z );
+    }
+
+    inline unsigned _bin(const _BuildItem &item, unsigned axis, double lowest, double scale)
+    {
+        const unsigned bin = static_cast<unsigned>( ( _coordinate( item.centroid, axis ) - lowest )*scale );
+        return std::min( bin, MeshBVH::BINS_COUNT - 1 );
+    }
+
+    // Finds a plane, splitting centroids of items with the least SAH cost, and partitions items by it.
+    // Returns the index of the first item of the right part, or `first' if there is no such plane
+    // (all centroids coincide).
+    unsigned _split(std::vector<_BuildItem> &items, unsigned first, unsigned count, const BoundingBox &centroids)
+    {
+        const unsigned BINS_COUNT = MeshBVH::BINS_COUNT;
+
+        double best_cost = -1;
+        unsigned best_axis = 0;
+        unsigned best_bin = 0; // the last bin of the left part
+
+        for( unsigned axis = 0; axis < 3; ++axis )
+        {
+            const double lowest = _coordinate( centroids.min, axis );
+            const double extent = _coordinate( centroids.max, axis ) - lowest;
+            if( extent <= 0 )
+            {
+                continue;
+            }
+            const double scale = BINS_COUNT/extent;
+
+            BoundingBox boxes[BINS_COUNT];
+            unsigned counts[BINS_COUNT] = { 0 };
+            for( unsigned i = first; i < first + count; ++i )
+            {
+                const unsigned bin = _bin( items[i], axis, lowest, scale );
+                boxes[bin].add( items[i].box );
+                ++counts[bin];
+            }
+
+            // cost of the right part for every split, accumulated from the right
+            double right_costs[BINS_COUNT];
+            BoundingBox right_box;
+            unsigned right_count = 0;
+            for( unsigned bin = BINS_COUNT - 1; bin > 0; --bin )
+            {
+                right_box.add( boxes[bin] );
+                right_count += counts[bin];
+                right_costs[bin - 1] = right_count*right_box.surface_area();
+            }
+
+            BoundingBox left_box;
+            unsigned left_count = 0;
+            for( unsigned bin = 0; bin + 1 < BINS_COUNT; ++bin )
+            {
+                left_box.add( boxes[bin] );
+                left_count += counts[bin];
+                if( left_count == 0 || left_count == count )
+                {
+                    continue;
+                }
+                const double cost = left_count*left_box.surface_area() + right_costs[bin];
+                if( best_cost < 0 || cost < best_cost )
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = bin;
+                }
+            }
+        }
+
+        if( best_cost < 0 )
+        {
+            return first;
+        }
+
+        const double lowest = _coordinate( centroids.min, best_axis );
+        const double scale = BINS_COUNT/( _coordinate( centroids.max, best_axis ) - lowest );
+        std::vector<_BuildItem>::iterator begin = items.begin() + first;
+        std::vector<_BuildItem>::iterator middle =
+            std::partition( begin, begin + count,
+                            [=](const _BuildItem &item) { return _bin( item, best_axis, lowest, scale ) <= best_bin; } );
+        return first + static_cast<unsigned>( middle - begin );
+    }
+
+    MeshBVH::MeshBVH(const std::vector<Triangle> &source)
+    {
+        triangles.reserve( source.size() );
+        for( unsigned i = 0; i < source.size(); ++i )
+        {
+            triangles.push_back( PreparedTriangle( source[i] ) );
+        }
+        build();
+    }
+
+    MeshBVH::MeshBVH(const std::vector<PreparedTriangle> &source) : triangles(source)
+    {
+        build();
+    }
+
+    void build_bvh(const std::vector<BoundingBox> &boxes, unsigned max_leaf_size, /*out*/ std::vector<MeshBVH::Node> &nodes,
+                   std::vector<unsigned> &order)
+    {
+        const unsigned count = static_cast<unsigned>( boxes.size() );
+        nodes.clear();
+        order.clear();
+        if( count == 0 )
+        {
+            return;
+        }
+
+        std::vector<_BuildItem> items( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            items[i].box = boxes[i];
+            items[i].centroid = items[i].box.center();
+            items[i].index = i;
+        }
+
+        nodes.reserve( 2*count - 1 );
+        nodes.push_back( MeshBVH::Node() );
+        std::vector<_BuildTask> tasks( 1, _BuildTask( 0, 0, count, 0 ) );
+        while( !tasks.empty() )
+        {
+            const _BuildTask task = tasks.back();
+            tasks.pop_back();
+
+            BoundingBox box, centroids;
+            for( unsigned i = task.first; i < task.first + task.count; ++i )
+            {
+                box.add( items[i].box );
+                centroids.add( items[i].centroid );
+            }
+            nodes[task.node].box = box;
+
+            unsigned split = task.first;
+            if( task.count > max_leaf_size && task.depth + 1 < MeshBVH::MAX_DEPTH )
+            {
+                split = _split( items, task.first, task.count, centroids );
+                if( split == task.first )
+                {
+                    // centroids coincide: no plane separates them, so just halve the range
+                    split = task.first + task.count/2;
+                }
+            }
+
+            if( split == task.first )
+            {
+                nodes[task.node].first = task.first;
+                nodes[task.node].count = task.count;
+                continue;
+            }
+
+            const unsigned left = static_cast<unsigned>( nodes.size() );
+            nodes[task.node].first = left;
+            nodes[task.node].count = 0;
+            nodes.push_back( MeshBVH::Node() );
+            nodes.push_back( MeshBVH::Node() );
+            tasks.push_back( _BuildTask( left + 1, split, task.first + task.count - split, task.depth + 1 ) );
+            tasks.push_back( _BuildTask( left, task.first, split - task.first, task.depth + 1 ) );
+        }
+
+        order.resize( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            order[i] = items[i].index;
+        }
+    }
+
+    void MeshBVH::build()
+    {
+        std::vector<BoundingBox> boxes( size() );
+        for( unsigned i = 0; i < size(); ++i )
+        {
+            boxes[i] = bounding_box( triangles[i] );
+        }
+        build_bvh( boxes, MAX_LEAF_SIZE, nodes, original_indices );
+
+        // store triangles in the order of leaves
+        std::vector<PreparedTriangle> ordered;
+        ordered.reserve( size() );
+        for( unsigned i = 0; i < size(); ++i )
+        {
+            ordered.push_back( triangles[ original_indices[i] ] );
+        }
+        triangles.swap( ordered );
+    }
+
+    BvhView MeshBVH::view() const
+    {
+        const BvhView result = { triangles.data(), original_indices.data(), nodes.data(), size(), nodes_count() };
+        return result;
+    }
+
+    // ---------------------------------- Q u e r y --------------------------------------------
+
+    // node, waiting for traversal, and the time the segment enters its box
+    struct _TraversalItem
+    {
+        unsigned node;
+        double entry_time;
+    };
+
+    // Leaves and results of traversal by the query mode. A query tells the traversal how much of the segment
+    // is left (`max_time'), tests leaves and says when to stop.
+
+    // as in sweep_sphere for a triangle array, leaves are tested against the segment shortened
+    // to the earliest collision found so far
+    struct _ClosestQuery
+    {
+        SweepHit &hit;
+        bool any_result;
+        double best_time;
+        Point current_end;
+
+        _ClosestQuery(SweepHit &hit, const Point &segment_end) : hit(hit), any_result(false), best_time(1), current_end(segment_end) {}
+
+        double max_time() const { return best_time; }
+        bool skips(double entry_time) const { return any_result && entry_time >= best_time; }
+
+        // returns true, if nothing else is needed
+        bool leaf(const BvhView &mesh, const MeshBVH::Node &node, const Point &segment_start, const Point &segment_end, double sphere_radius)
+        {
+            SweepHit leaf_hit;
+            if( NoThrow::sweep_sphere( mesh.triangles + node.first, node.count, segment_start, current_end, sphere_radius, leaf_hit ) == CollisionStatus::Hit &&
+                ( !any_result || leaf_hit.time < 1 ) )
+            {
+                hit = leaf_hit;
+                hit.time = leaf_hit.time*best_time;
+                hit.triangle_index = mesh.original_indices[ node.first + leaf_hit.triangle_index ];
+                any_result = true;
+
+                best_time = hit.time;
+                current_end = segment_start + best_time*(segment_end - segment_start);
+                return current_end == segment_start; // nothing can be hit earlier
+            }
+            return false;
+        }
+    };
+
+    // the first hit ends the traversal
+    struct _AnyQuery
+    {
+        SweepHit &hit;
+        bool any_result;
+
+        explicit _AnyQuery(SweepHit &hit) : hit(hit), any_result(false) {}
+
+        double max_time() const { return 1; }
+        bool skips(double) const { return false; }
+
+        bool leaf(const BvhView &mesh, const MeshBVH::Node &node, const Point &segment_start, const Point &segment_end, double sphere_radius)
+        {
+            if( NoThrow::sweep_sphere( mesh.triangles + node.first, node.count, segment_start, segment_end, sphere_radius, AnyHit(), hit ) == CollisionStatus::Hit )
+            {
+                hit.triangle_index = mesh.original_indices[ node.first + hit.triangle_index ];
+                any_result = true;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // every leaf on the way is tested against the whole segment
+    struct _AllQuery
+    {
+        std::vector<SweepHit> &hits;
+        std::vector<SweepHit> leaf_hits;
+        bool any_result;
+
+        explicit _AllQuery(std::vector<SweepHit> &hits) : hits(hits), any_result(false) {}
+
+        double max_time() const { return 1; }
+        bool skips(double) const { return false; }
+
+        bool leaf(const BvhView &mesh, const MeshBVH::Node &node, const Point &segment_start, const Point &segment_end, double sphere_radius)
+        {
+            if( NoThrow::sweep_sphere( mesh.triangles + node.first, node.count, segment_start, segment_end, sphere_radius, AllHits(), leaf_hits ) == CollisionStatus::Hit )
+            {
+                for( unsigned i = 0; i < leaf_hits.size(); ++i )
+                {
+                    leaf_hits[i].triangle_index = mesh.original_indices[ node.first + leaf_hits[i].triangle_index ];
+                    hits.push_back( leaf_hits[i] );
+                }
+                any_result = true;
+            }
+            return false;
+        }
+    };
+
+    // Rays are traversed as segments from origin to origin + max_time*direction with zero radius; times
+    // of the traversal are fractions of `max_time'.
+
+    // leaves are cast up to the nearest hit found so far
+    struct _ClosestRayQuery
+    {
+        RayHit &hit;
+        const Point &origin;
+        const Vector &direction;
+        double ray_length;
+        bool any_result;
+        double best_time;
+
+        _ClosestRayQuery(RayHit &hit, const Point &origin, const Vector &direction, double max_time)
+            : hit(hit), origin(origin), direction(direction), ray_length(max_time), any_result(false), best_time(max_time) {}
+
+        double max_time() const { return best_time/ray_length; }
+        bool skips(double entry_time) const { return any_result && entry_time*ray_length >= best_time; }
+
+        bool leaf(const BvhView &mesh, const MeshBVH::Node &node, const Point &, const Point &, double)
+        {
+            RayHit leaf_hit;
+            if( NoThrow::raycast( mesh.triangles + node.first, node.count, origin, direction, best_time, leaf_hit ) == CollisionStatus::Hit &&
+                ( !any_result || leaf_hit.time < best_time ) )
+            {
+                hit = leaf_hit;
+                hit.triangle_index = mesh.original_indices[ node.first + leaf_hit.triangle_index ];
+                any_result = true;
+                best_time = hit.time;
+            }
+            return false;
+        }
+    };
+
+    // the first hit ends the traversal
+    struct _AnyRayQuery
+    {
+        RayHit &hit;
+        const Point &origin;
+        const Vector &direction;
+        double ray_length;
+        bool any_result;
+
+        _AnyRayQuery(RayHit &hit, const Point &origin, const Vector &direction, double max_time)
+            : hit(hit), origin(origin), direction(direction), ray_length(max_time), any_result(false) {}
+
+        double max_time() const { return 1; }
+        bool skips(double) const { return false; }
+
+        bool leaf(const BvhView &mesh, const MeshBVH::Node &node, const Point &, const Point &, double)
+        {
+            if( NoThrow::raycast( mesh.triangles + node.first, node.count, origin, direction, ray_length, AnyHit(), hit ) == CollisionStatus::Hit )
+            {
+                hit.triangle_index = mesh.original_indices[ node.first + hit.triangle_index ];
+                any_result = true;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // visits leaves, which the sphere can touch, front to back, until the query has all it needs
+    template <class Query>
+    void _traverse(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius, /*inout*/ Query &query)
+    {
+        COLLISIONS_COUNT( Counter::BvhSweepCalls );
+        if( mesh.nodes_count == 0 )
+            return;
+
+        const BoxRay ray( segment_start, segment_end );
+
+        // stack never holds more than one sibling per level, plus two children of the current node
+        _TraversalItem stack[MeshBVH::MAX_DEPTH + 2];
+        unsigned stack_size = 0;
+        double entry_time;
+        if( !segment_and_box_collision( ray, mesh.nodes[0].box.inflated( sphere_radius ), 1, entry_time ) )
+            return;
+        stack[stack_size].node = 0;
+        stack[stack_size].entry_time = entry_time;
+        ++stack_size;
+
+        while( stack_size > 0 )
+        {
+            const _TraversalItem item = stack[--stack_size];
+            if( query.skips( item.entry_time ) )
+            {
+                continue;
+            }
+
+            COLLISIONS_COUNT( Counter::BvhNodesVisited );
+            const MeshBVH::Node &node = mesh.nodes[item.node];
+            if( node.is_leaf() )
+            {
+                COLLISIONS_COUNT( Counter::BvhLeavesVisited );
+                if( query.leaf( mesh, node, segment_start, segment_end, sphere_radius ) )
+                {
+                    break;
+                }
+                continue;
+            }
+
+            // push the farther child first, so that the nearer one is visited first
+            _TraversalItem children[2];
+            unsigned children_count = 0;
+            for( unsigned i = 0; i < 2; ++i )
+            {
+                const unsigned child = node.first + i;
+                if( segment_and_box_collision( ray, mesh.nodes[child].box.inflated( sphere_radius ), query.max_time(), entry_time ) )
+                {
+                    children[children_count].node = child;
+                    children[children_count].entry_time = entry_time;
+                    ++children_count;
+                }
+            }
+            if( children_count == 2 && children[0].entry_time < children[1].entry_time )
+            {
+                std::swap( children[0], children[1] );
+            }
+            for( unsigned i = 0; i < children_count; ++i )
+            {
+                stack[stack_size++] = children[i];
+            }
+        }
+    }
+
+    // ---------------------------- C l o s e s t   p o i n t --------------------------------
+
+    // node, waiting for traversal, and the squared distance from the point to its box
+    struct _NearestItem
+    {
+        unsigned node;
+        double squared_distance;
+    };
+
+    // whether anything at the squared distance may be taken instead of the best point found so far:
+    // the first point found may be as far as max_distance, later ones must be strictly nearer
+    inline bool _may_improve(double squared_distance, double best_squared, bool any_result)
+    {
+        return squared_distance < best_squared || ( !any_result && squared_distance <= best_squared );
+    }
+
+    // Visits leaves, whose boxes may contain a nearer point than the best one found so far, nearest first;
+    // `best_squared' starts as squared max_distance. Returns true, if any point is found.
+    bool _closest_point(const BvhView &mesh, const Point &point, /*inout*/ double &best_squared, /*out*/ ClosestPoint &result)
+    {
+        COLLISIONS_COUNT( Counter::BvhClosestPointCalls );
+        bool any_result = false;
+        if( mesh.nodes_count == 0 )
+            return false;
+
+        _NearestItem stack[MeshBVH::MAX_DEPTH + 2];
+        unsigned stack_size = 0;
+        stack[stack_size].node = 0;
+        stack[stack_size].squared_distance = mesh.nodes[0].box.squared_distance( point );
+        ++stack_size;
+
+        while( stack_size > 0 )
+        {
+            const _NearestItem item = stack[--stack_size];
+            if( !_may_improve( item.squared_distance, best_squared, any_result ) )
+            {
+                continue;
+            }
+
+            COLLISIONS_COUNT( Counter::BvhNodesVisited );
+            const MeshBVH::Node &node = mesh.nodes[item.node];
+            if( node.is_leaf() )
+            {
+                COLLISIONS_COUNT( Counter::BvhLeavesVisited );
+                for( unsigned i = node.first; i < node.first + node.count; ++i )
+                {
+                    COLLISIONS_COUNT( Counter::ClosestPointTrianglesTested );
+                    const Point nearest = _closest_point_on_triangle( point, mesh.triangles[i] );
+                    const double squared = (nearest - point).sqared_norm();
+                    if( _may_improve( squared, best_squared, any_result ) )
+                    {
+                        result.point = nearest;
+                        result.triangle_index = mesh.original_indices[i];
+                        any_result = true;
+                        best_squared = squared;
+                    }
+                }
+                continue;
+            }
+
+            // push the farther child first, so that the nearer one is visited first
+            _NearestItem children[2];
+            unsigned children_count = 0;
+            for( unsigned i = 0; i < 2; ++i )
+            {
+                const unsigned child = node.first + i;
+                const double squared_distance = mesh.nodes[child].box.squared_distance( point );
+                if( _may_improve( squared_distance, best_squared, any_result ) )
+                {
+                    children[children_count].node = child;
+                    children[children_count].squared_distance = squared_distance;
+                    ++children_count;
+                }
+            }
+            if( children_count == 2 && children[0].squared_distance < children[1].squared_distance )
+            {
+                std::swap( children[0], children[1] );
+            }
+            for( unsigned i = 0; i < children_count; ++i )
+            {
+                stack[stack_size++] = children[i];
+            }
+        }
+        return any_result;
+    }
+
+    const unsigned _GROUP_SIZE = CLOSEST_POINT_GROUP_SIZE;
+
+    // points of a group as arrays of coordinates, so that distances to a box are found for all of them at once
+    struct _PointGroup
+    {
+        double x[_GROUP_SIZE], y[_GROUP_SIZE], z[_GROUP_SIZE];
+
+        // squared distances from every point to the box
+        void squared_distances(const BoundingBox &box, /*out*/ double (&result)[_GROUP_SIZE]) const
+        {
+            for( unsigned i = 0; i < _GROUP_SIZE; ++i )
+            {
+                const double dx = std::max( std::max( box.min.x - x[i], x[i] - box.max.x ), 0.0 );
+                const double dy = std::max( std::max( box.min.y - y[i], y[i] - box.max.y ), 0.0 );
+                const double dz = std::max( std::max( box.min.z - z[i], z[i] - box.max.z ), 0.0 );
+                result[i] = dx*dx + dy*dy + dz*dz;
+            }
+        }
+    };
+
+    // node, waiting for traversal of a group, with squared distances from every point of the group to its box
+    struct _GroupItem
+    {
+        unsigned node;
+        double squared_distances[_GROUP_SIZE];
+    };
+
+    // lanes, which may find a nearer point in the box: bit i is set for lane i
+    inline unsigned _active_lanes(const double (&squared_distances)[_GROUP_SIZE], const double (&best_squared)[_GROUP_SIZE], const bool (&any_result)[_GROUP_SIZE])
+    {
+        unsigned mask = 0;
+        for( unsigned i = 0; i < _GROUP_SIZE; ++i )
+        {
+            mask |= _may_improve( squared_distances[i], best_squared[i], any_result[i] ) ? 1u << i : 0u;
+        }
+        return mask;
+    }
+
+    // The same as _closest_point for up to _GROUP_SIZE points at once. Lanes after the last point have best_squared
+    // of -1, so that they never need anything.
+    void _closest_points(const BvhView &mesh, const Point *points, unsigned count,
+                         /*inout*/ double (&best_squared)[_GROUP_SIZE], /*out*/ bool (&any_result)[_GROUP_SIZE], ClosestPoint *results)
+    {
+        COLLISIONS_COUNT( Counter::BvhClosestPointCalls );
+        for( unsigned i = 0; i < _GROUP_SIZE; ++i )
+        {
+            any_result[i] = false;
+        }
+        if( mesh.nodes_count == 0 )
+            return;
+
+        _PointGroup group;
+        for( unsigned i = 0; i < _GROUP_SIZE; ++i )
+        {
+            const Point &point = points[ std::min( i, count - 1 ) ];
+            group.x[i] = point.x;
+            group.y[i] = point.y;
+            group.z[i] = point.z;
+        }
+
+        _GroupItem stack[MeshBVH::MAX_DEPTH + 2];
+        unsigned stack_size = 0;
+        stack[stack_size].node = 0;
+        group.squared_distances( mesh.nodes[0].box, stack[stack_size].squared_distances );
+        ++stack_size;
+
+        while( stack_size > 0 )
+        {
+            const _GroupItem &item = stack[--stack_size]; // not used after children are pushed into its place
+            const unsigned mask = _active_lanes( item.squared_distances, best_squared, any_result );
+            if( mask == 0 )
+            {
+                continue;
+            }
+
+            COLLISIONS_COUNT( Counter::BvhNodesVisited );
+            const MeshBVH::Node &node = mesh.nodes[item.node];
+            if( node.is_leaf() )
+            {
+                COLLISIONS_COUNT( Counter::BvhLeavesVisited );
+                for( unsigned i = node.first; i < node.first + node.count; ++i )
+                {
+                    const PreparedTriangle &triangle = mesh.triangles[i];
+                    for( unsigned lane = 0; lane < count; ++lane )
+                    {
+                        if( ( mask & (1u << lane) ) == 0 )
+                        {
+                            continue;
+                        }
+                        COLLISIONS_COUNT( Counter::ClosestPointTrianglesTested );
+                        const Point nearest = _closest_point_on_triangle( points[lane], triangle );
+                        const double squared = (nearest - points[lane]).sqared_norm();
+                        if( _may_improve( squared, best_squared[lane], any_result[lane] ) )
+                        {
+                            results[lane].point = nearest;
+                            results[lane].triangle_index = mesh.original_indices[i];
+                            any_result[lane] = true;
+                            best_squared[lane] = squared;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            // children are ordered by the nearest of their active lanes
+            _GroupItem children[2];
+            double nearest[2];
+            unsigned children_count = 0;
+            for( unsigned i = 0; i < 2; ++i )
+            {
+                _GroupItem &child = children[children_count];
+                child.node = node.first + i;
+                group.squared_distances( mesh.nodes[child.node].box, child.squared_distances );
+                const unsigned child_mask = _active_lanes( child.squared_distances, best_squared, any_result );
+                if( child_mask != 0 )
+                {
+                    nearest[children_count] = std::numeric_limits<double>::infinity();
+                    for( unsigned lane = 0; lane < count; ++lane )
+                    {
+                        if( ( child_mask & (1u << lane) ) != 0 )
+                        {
+                            nearest[children_count] = std::min( nearest[children_count], child.squared_distances[lane] );
+                        }
+                    }
+                    ++children_count;
+                }
+            }
+            if( children_count == 2 && nearest[0] < nearest[1] )
+            {
+                stack[stack_size++] = children[1];
+                stack[stack_size++] = children[0];
+            }
+            else
+            {
+                for( unsigned i = 0; i < children_count; ++i )
+                {
+                    stack[stack_size++] = children[i];
+                }
+            }
+        }
+    }
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            _ClosestQuery query( hit, segment_end );
+            _traverse( mesh, segment_start, segment_end, sphere_radius, query );
+            if( !query.any_result )
+                return CollisionStatus::Miss;
+
+            hit.sphere_center = segment_start + hit.time*(segment_end - segment_start);
+            return CollisionStatus::Hit;
+        }
+
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit) noexcept
+        {
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            _AnyQuery query( hit );
+            _traverse( mesh, segment_start, segment_end, sphere_radius, query );
+            return query.any_result ? CollisionStatus::Hit : CollisionStatus::Miss;
+        }
+
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AllHits, /*out*/ std::vector<SweepHit> &hits)
+        {
+            hits.clear();
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            _AllQuery query( hits );
+            _traverse( mesh, segment_start, segment_end, sphere_radius, query );
+            return query.any_result ? CollisionStatus::Hit : CollisionStatus::Miss;
+        }
+
+        CollisionStatus raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept
+        {
+            if( direction.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+            if( !( max_time > 0 ) )
+                return CollisionStatus::Miss;
+
+            _ClosestRayQuery query( hit, origin, direction, max_time );
+            _traverse( mesh, origin, origin + max_time*direction, 0, query );
+            return query.any_result ? CollisionStatus::Hit : CollisionStatus::Miss;
+        }
+
+        CollisionStatus raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                                AnyHit, /*out*/ RayHit &hit) noexcept
+        {
+            if( direction.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+            if( !( max_time > 0 ) )
+                return CollisionStatus::Miss;
+
+            _AnyRayQuery query( hit, origin, direction, max_time );
+            _traverse( mesh, origin, origin + max_time*direction, 0, query );
+            return query.any_result ? CollisionStatus::Hit : CollisionStatus::Miss;
+        }
+
+        CollisionStatus closest_point(const BvhView &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result) noexcept
+        {
+            if( !( max_distance >= 0 ) )
+                return CollisionStatus::Miss;
+
+            double best_squared = max_distance*max_distance;
+            if( !_closest_point( mesh, point, best_squared, result ) )
+                return CollisionStatus::Miss;
+
+            result.distance = std::sqrt( best_squared );
+            return CollisionStatus::Hit;
+        }
+
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( mesh.view(), segment_start, segment_end, sphere_radius, hit );
+        }
+
+        CollisionStatus closest_point(const MeshBVH &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result) noexcept
+        {
+            return NoThrow::closest_point( mesh.view(), point, max_distance, result );
+        }
+
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( mesh.view(), segment_start, segment_end, sphere_radius, AnyHit(), hit );
+        }
+
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AllHits, /*out*/ std::vector<SweepHit> &hits)
+        {
+            return NoThrow::sweep_sphere( mesh.view(), segment_start, segment_end, sphere_radius, AllHits(), hits );
+        }
+
+        CollisionStatus raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept
+        {
+            return NoThrow::raycast( mesh.view(), origin, direction, max_time, hit );
+        }
+
+        CollisionStatus raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                                AnyHit, /*out*/ RayHit &hit) noexcept
+        {
+            return NoThrow::raycast( mesh.view(), origin, direction, max_time, AnyHit(), hit );
+        }
+    };
+
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, AnyHit(), hit ) );
+    }
+
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, AnyHit(), hit ) );
+    }
+
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AllHits, /*out*/ std::vector<SweepHit> &hits)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, AllHits(), hits ) );
+    }
+
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AllHits, /*out*/ std::vector<SweepHit> &hits)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, AllHits(), hits ) );
+    }
+
+    bool raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit)
+    {
+        return check_status( NoThrow::raycast( mesh, origin, direction, max_time, hit ) );
+    }
+
+    bool raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit)
+    {
+        return check_status( NoThrow::raycast( mesh, origin, direction, max_time, hit ) );
+    }
+
+    bool raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                 AnyHit, /*out*/ RayHit &hit)
+    {
+        return check_status( NoThrow::raycast( mesh, origin, direction, max_time, AnyHit(), hit ) );
+    }
+
+    bool raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                 AnyHit, /*out*/ RayHit &hit)
+    {
+        return check_status( NoThrow::raycast( mesh, origin, direction, max_time, AnyHit(), hit ) );
+    }
+
+    bool closest_point(const MeshBVH &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result)
+    {
+        return check_status( NoThrow::closest_point( mesh, point, max_distance, result ) );
+    }
+
+    bool closest_point(const BvhView &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result)
+    {
+        return check_status( NoThrow::closest_point( mesh, point, max_distance, result ) );
+    }
+
+    void closest_point(const MeshBVH &mesh, const Point *points, unsigned count, double max_distance,
+                       /*out*/ ClosestPoint *results, CollisionStatus *statuses)
+    {
+        closest_point( mesh.view(), points, count, max_distance, results, statuses );
+    }
+
+    void closest_point(const BvhView &mesh, const Point *points, unsigned count, double max_distance,
+                       /*out*/ ClosestPoint *results, CollisionStatus *statuses)
+    {
+        for( unsigned first = 0; first < count; first += _GROUP_SIZE )
+        {
+            const unsigned group_size = std::min( count - first, _GROUP_SIZE );
+            double best_squared[_GROUP_SIZE];
+            bool any_result[_GROUP_SIZE];
+            for( unsigned i = 0; i < _GROUP_SIZE; ++i )
+            {
+                best_squared[i] = i < group_size && max_distance >= 0 ? max_distance*max_distance : -1;
+            }
+            _closest_points( mesh, points + first, group_size, best_squared, any_result, results + first );
+            for( unsigned i = 0; i < group_size; ++i )
+            {
+                statuses[first + i] = any_result[i] ? CollisionStatus::Hit : CollisionStatus::Miss;
+                if( any_result[i] )
+                {
+                    results[first + i].distance = std::sqrt( best_squared[i] );
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+#include <vector>
+#include "collisions.h"
+#include "bounding_box.h"
+
+namespace Collisions
+{
+    struct BvhView;
+
+    // Bounding volume hierarchy over a static triangle mesh, built with binned surface area heuristic (SAH).
+    // Triangles are reordered so that every leaf refers to a contiguous range of them;
+    // original_index() maps them back to the order they were given in.
+    class MeshBVH
+    {
+    public:
+        static const unsigned MAX_LEAF_SIZE = 4;  // bigger nodes are split
+        static const unsigned BINS_COUNT = 16;    // candidate split planes per axis
+        static const unsigned MAX_DEPTH = 64;     // deeper nodes become leaves regardless of their size
+
+        struct Node
+        {
+            BoundingBox box;
+            unsigned first; // leaf: index of the first triangle; inner node: index of the left child (right one follows it)
+            unsigned count; // leaf: number of triangles; inner node: 0
+
+            bool is_leaf() const { return count != 0; }
+        };
+    private:
+        std::vector<PreparedTriangle> triangles;
+        std::vector<unsigned> original_indices;
+        std::vector<Node> nodes;
+
+        void build();
+    public:
+        // throws DegeneratedTriangleError for degenerated triangle
+        explicit MeshBVH(const std::vector<Triangle> &triangles);
+        explicit MeshBVH(const std::vector<PreparedTriangle> &triangles);
+
+        unsigned size() const { return static_cast<unsigned>( triangles.size() ); }
+        bool empty() const { return triangles.empty(); }
+
+        // triangles in the order of the hierarchy
+        PreparedTriangle const & triangle(unsigned index) const
+        {
+            check( index < triangles.size(), OutOfBoundsError() );
+            return triangles[index];
+        }
+        unsigned original_index(unsigned index) const
+        {
+            check( index < original_indices.size(), OutOfBoundsError() );
+            return original_indices[index];
+        }
+
+        // node 0 is the root (absent for empty mesh)
+        unsigned nodes_count() const { return static_cast<unsigned>( nodes.size() ); }
+        Node const & node(unsigned index) const
+        {
+            check( index < nodes.size(), OutOfBoundsError() );
+            return nodes[index];
+        }
+
+        BvhView view() const;
+    };
+
+    // Builds nodes of a hierarchy over the boxes as MeshBVH does for boxes of triangles: leaves refer to ranges
+    // of `order', which lists indices of the boxes. For hierarchies over other objects (see InstanceBVH).
+    void build_bvh(const std::vector<BoundingBox> &boxes, unsigned max_leaf_size, /*out*/ std::vector<MeshBVH::Node> &nodes,
+                   std::vector<unsigned> &order);
+
+    // Hierarchy as plain arrays, laid out as in MeshBVH: buffers of a MeshBVH, or a hierarchy stored elsewhere
+    // (see MappedMesh). Sweeps read the arrays as they are, so node and triangle indices in them must be valid.
+    struct BvhView
+    {
+        const PreparedTriangle *triangles;
+        const unsigned *original_indices;
+        const MeshBVH::Node *nodes;
+        unsigned triangles_count;
+        unsigned nodes_count;
+    };
+
+    // Sweeps a sphere along the segment against the mesh and finds the earliest collision (see sweep_sphere
+    // in collisions.h). Nodes are visited front to back and skipped when the segment misses their box, inflated
+    // by the sphere radius, before the earliest collision found so far. hit.triangle_index is the index in the
+    // original triangle array.
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+
+    // the same with a query mode (see AnyHit in collisions.h): AnyHit stops at the first leaf with a hit,
+    // AllHits visits every leaf on the whole way
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit);
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AnyHit, /*out*/ SweepHit &hit);
+    bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AllHits, /*out*/ std::vector<SweepHit> &hits);
+    bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      AllHits, /*out*/ std::vector<SweepHit> &hits);
+    inline bool sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                             ClosestHit, /*out*/ SweepHit &hit)
+    {
+        return sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit );
+    }
+    inline bool sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                             ClosestHit, /*out*/ SweepHit &hit)
+    {
+        return sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit );
+    }
+
+    // Casts a ray from `origin' along `direction' as far as origin + max_time*direction against the mesh
+    // (see raycast in collisions.h): nodes are visited front to back, as for a sphere of zero radius, and
+    // triangles of leaves are tested by Moller-Trumbore kernel. max_time must be finite. hit.triangle_index
+    // is the index in the original triangle array.
+    bool raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit);
+    bool raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit);
+    // the first hit found ends the cast
+    bool raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                 AnyHit, /*out*/ RayHit &hit);
+    bool raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                 AnyHit, /*out*/ RayHit &hit);
+
+    // Finds the point of the mesh, nearest to the given one, no farther than max_distance from it (see closest_point
+    // in collisions.h; max_distance may be infinite). Branch and bound: nodes are visited nearest first and skipped,
+    // when their boxes are farther than the nearest point found so far. result.triangle_index is the index in the
+    // original triangle array.
+    bool closest_point(const MeshBVH &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result);
+    bool closest_point(const BvhView &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result);
+
+    // points of a group of closest_point queries, traversing the hierarchy together
+    const unsigned CLOSEST_POINT_GROUP_SIZE = 8;
+
+    // The same for `count' points: results[i] and statuses[i] (Hit or Miss) are for points[i]. Consecutive points
+    // are taken by groups of CLOSEST_POINT_GROUP_SIZE, and each group traverses the hierarchy once: a node is
+    // visited, while its box is nearer than the nearest point found so far for any point of the group, and its
+    // triangles are read once for all of them. So the points should be given in an order, where neighbours are
+    // near each other (like probes along a path or points of a grid, row by row); scattered points gain nothing.
+    void closest_point(const MeshBVH &mesh, const Point *points, unsigned count, double max_distance,
+                       /*out*/ ClosestPoint *results, CollisionStatus *statuses);
+    void closest_point(const BvhView &mesh, const Point *points, unsigned count, double max_distance,
+                       /*out*/ ClosestPoint *results, CollisionStatus *statuses);
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit) noexcept;
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AnyHit, /*out*/ SweepHit &hit) noexcept;
+        // growing `hits' may throw std::bad_alloc
+        CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AllHits, /*out*/ std::vector<SweepHit> &hits);
+        CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     AllHits, /*out*/ std::vector<SweepHit> &hits);
+        CollisionStatus raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept;
+        CollisionStatus raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept;
+        CollisionStatus raycast(const MeshBVH &mesh, const Point &origin, const Vector &direction, double max_time,
+                                AnyHit, /*out*/ RayHit &hit) noexcept;
+        CollisionStatus raycast(const BvhView &mesh, const Point &origin, const Vector &direction, double max_time,
+                                AnyHit, /*out*/ RayHit &hit) noexcept;
+        CollisionStatus closest_point(const MeshBVH &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result) noexcept;
+        CollisionStatus closest_point(const BvhView &mesh, const Point &point, double max_distance, /*out*/ ClosestPoint &result) noexcept;
+        inline CollisionStatus sweep_sphere(const MeshBVH &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                            ClosestHit, /*out*/ SweepHit &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit );
+        }
+        inline CollisionStatus sweep_sphere(const BvhView &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                            ClosestHit, /*out*/ SweepHit &hit) noexcept
+        {
+            return NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit );
+        }
+    };
+};
@@ -0,0 +1,1033 @@
+#include "mesh_import.h"
+#include "collision_batch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace Collisions
+{
+    // ------------------------------------ N u m b e r s --------------------------------------
+
+    // powers of ten, which are exact doubles
+    const double _POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const int _MAX_EXACT_POWER = 22;
+    const uint64_t _MAX_EXACT_MANTISSA = 1ull << 53;
+    const int _MAX_MANTISSA_DIGITS = 19; // fit into 64 bits
+
+    inline bool _is_digit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char * parse_double(const char *begin, const char *end, /*out*/ double &value)
+    {
+        const char *position = begin;
+        bool negative = false;
+        if( position < end && ( *position == '-' || *position == '+' ) )
+        {
+            negative = *position == '-';
+            ++position;
+        }
+
+        // significant digits go to the mantissa, the rest only shift the exponent
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any_digits = false;
+        for( ; position < end && _is_digit( *position ); ++position )
+        {
+            any_digits = true;
+            if( digits < _MAX_MANTISSA_DIGITS )
+            {
+                mantissa = mantissa*10 + ( *position - '0' );
+                digits += mantissa != 0 ? 1 : 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+        if( position < end && *position == '.' )
+        {
+            for( ++position; position < end && _is_digit( *position ); ++position )
+            {
+                any_digits = true;
+                if( digits < _MAX_MANTISSA_DIGITS )
+                {
+                    mantissa = mantissa*10 + ( *position - '0' );
+                    digits += mantissa != 0 ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+        if( !any_digits )
+        {
+            return NULL;
+        }
+        if( position < end && ( *position == 'e' || *position == 'E' ) )
+        {
+            const char *exponent_position = position + 1;
+            bool negative_exponent = false;
+            if( exponent_position < end && ( *exponent_position == '-' || *exponent_position == '+' ) )
+            {
+                negative_exponent = *exponent_position == '-';
+                ++exponent_position;
+            }
+            // without digits `e' is not a part of the number
+            if( exponent_position < end && _is_digit( *exponent_position ) )
+            {
+                int written_exponent = 0;
+                for( ; exponent_position < end && _is_digit( *exponent_position ); ++exponent_position )
+                {
+                    written_exponent = std::min( written_exponent*10 + ( *exponent_position - '0' ), 100000 );
+                }
+                exponent += negative_exponent ? -written_exponent : written_exponent;
+                position = exponent_position;
+            }
+        }
+
+        if( mantissa == 0 )
+        {
+            value = negative ? -0.0 : 0.0;
+        }
+        else if( mantissa <= _MAX_EXACT_MANTISSA && exponent >= -_MAX_EXACT_POWER && exponent <= _MAX_EXACT_POWER )
+        {
+            // both are exact, so the only rounding is that of the operation: the result is correctly rounded
+            value = exponent < 0 ? mantissa/_POWERS_OF_TEN[-exponent] : mantissa*_POWERS_OF_TEN[exponent];
+            value = negative ? -value : value;
+        }
+        else
+        {
+            // strtod needs a terminated string
+            char buffer[64];
+            const size_t length = position - begin;
+            if( length < sizeof(buffer) )
+            {
+                memcpy( buffer, begin, length );
+                buffer[length] = 0;
+                value = strtod( buffer, NULL );
+            }
+            else
+            {
+                value = strtod( std::string( begin, position ).c_str(), NULL );
+            }
+        }
+        return position;
+    }
+
+    // parses an integer, returns the position after it or NULL
+    inline const char * _parse_integer(const char *position, const char *end, /*out*/ long long &value)
+    {
+        bool negative = false;
+        if( position < end && ( *position == '-' || *position == '+' ) )
+        {
+            negative = *position == '-';
+            ++position;
+        }
+        if( position == end || !_is_digit( *position ) )
+        {
+            return NULL;
+        }
+        value = 0;
+        for( ; position < end && _is_digit( *position ); ++position )
+        {
+            value = std::min( value*10 + ( *position - '0' ), 1ll << 40 ); // far beyond any index, but no overflow
+        }
+        value = negative ? -value : value;
+        return position;
+    }
+
+    inline bool _is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline const char * _skip_spaces(const char *position, const char *end)
+    {
+        while( position < end && _is_space( *position ) )
+        {
+            ++position;
+        }
+        return position;
+    }
+
+    inline const char * _skip_token(const char *position, const char *end)
+    {
+        while( position < end && !_is_space( *position ) && *position != '\n' )
+        {
+            ++position;
+        }
+        return position;
+    }
+
+    inline const char * _line_end(const char *position, const char *end)
+    {
+        const char *found = static_cast<const char *>( memchr( position, '\n', end - position ) );
+        return found != NULL ? found : end;
+    }
+
+    // true if the line starts with the keyword, followed by a space; moves the position after the keyword
+    inline bool _keyword(const char *&position, const char *end, const char *keyword)
+    {
+        const size_t length = strlen( keyword );
+        if( static_cast<size_t>( end - position ) > length && memcmp( position, keyword, length ) == 0 && _is_space( position[length] ) )
+        {
+            position += length;
+            return true;
+        }
+        return false;
+    }
+
+    // ------------------------------------- R e a d e r ---------------------------------------
+
+    // size of chunks of a file, parsed at once
+    const size_t _CHUNK_SIZE = 16 << 20;
+    // parts of a chunk per thread of a batch (a few, so that threads, finishing earlier, take more)
+    const unsigned _PARTS_PER_THREAD = 4;
+
+    // reads a file into a buffer by chunks, keeping the data, which is not consumed yet
+    class _Reader
+    {
+        std::FILE *file;
+        std::vector<char> buffer;
+        size_t begin, end;  // data in the buffer
+        bool eof;
+
+        // moves the data to the start of the buffer and reads more after it; returns false at the end of the file
+        bool refill()
+        {
+            if( eof )
+            {
+                return false;
+            }
+            memmove( &buffer[0], &buffer[begin], end - begin );
+            end -= begin;
+            begin = 0;
+            if( end == buffer.size() )
+            {
+                buffer.resize( 2*buffer.size() );
+            }
+            const size_t read = fread( &buffer[end], 1, buffer.size() - end, file );
+            check( read != 0 || !ferror( file ), FileError() );
+            end += read;
+            eof = read == 0;
+            return !eof;
+        }
+    public:
+        explicit _Reader(const char *path) : buffer(_CHUNK_SIZE), begin(0), end(0), eof(false)
+        {
+            file = fopen( path, "rb" );
+            check( file != NULL, FileError() );
+        }
+        ~_Reader()
+        {
+            fclose( file );
+        }
+
+        // Gives data up to the end of a line: at most about _CHUNK_SIZE, unless a line is longer.
+        // Returns false at the end of the file.
+        bool chunk(/*out*/ const char *&chunk_begin, const char *&chunk_end)
+        {
+            for(;;)
+            {
+                const char *data = &buffer[0] + begin;
+                const size_t size = end - begin;
+                const char *last = size == 0 ? NULL : data + size - 1;
+                while( last != NULL && *last != '\n' )
+                {
+                    last = last == data ? NULL : last - 1;
+                }
+                if( last != NULL || ( eof && size != 0 ) )
+                {
+                    chunk_begin = data;
+                    chunk_end = last != NULL ? last + 1 : data + size;
+                    begin += chunk_end - chunk_begin;
+                    return true;
+                }
+                if( !refill() && end == begin )
+                {
+                    return false;
+                }
+            }
+        }
+
+        // a line without the ending "\n", false at the end of the file
+        bool line(/*out*/ const char *&line_begin, const char *&line_end)
+        {
+            for(;;)
+            {
+                const char *data = &buffer[0] + begin;
+                const char *found = static_cast<const char *>( memchr( data, '\n', end - begin ) );
+                if( found != NULL || ( eof && end != begin ) )
+                {
+                    line_begin = data;
+                    line_end = found != NULL ? found : &buffer[0] + end;
+                    begin = found != NULL ? found + 1 - &buffer[0] : end;
+                    return true;
+                }
+                if( !refill() && end == begin )
+                {
+                    return false;
+                }
+            }
+        }
+
+        // exactly `size' bytes, throws MeshFormatError at the end of the file
+        void read(/*out*/ void *destination, size_t size)
+        {
+            while( end - begin < size )
+            {
+                check( refill() || end - begin >= size, MeshFormatError() );
+            }
+            memcpy( destination, &buffer[begin], size );
+            begin += size;
+        }
+
+        // reads up to `size' bytes, returns the number of read ones
+        size_t read_some(/*out*/ void *destination, size_t size)
+        {
+            while( end - begin < size && refill() )
+            {
+            }
+            const size_t result = std::min( size, end - begin );
+            memcpy( destination, &buffer[begin], result );
+            begin += result;
+            return result;
+        }
+    };
+
+    // splits [begin, end) into parts ending at ends of lines
+    void _split_lines(const char *begin, const char *end, unsigned parts_count, /*out*/ std::vector<const char *> &bounds)
+    {
+        bounds.clear();
+        bounds.push_back( begin );
+        for( unsigned i = 1; i < parts_count; ++i )
+        {
+            const char *bound = std::max( bounds.back(), begin + (end - begin)*i/parts_count );
+            bound = bound == end ? end : std::min( end, _line_end( bound, end ) + 1 );
+            bounds.push_back( bound );
+        }
+        bounds.push_back( end );
+    }
+
+    // calls `job' for parts [0, count) on threads of the batch, if there is one
+    void _run(CollisionBatch *batch, unsigned count, const std::function<void (unsigned begin, unsigned end)> &job)
+    {
+        if( batch != NULL )
+        {
+            batch->run( count, job );
+        }
+        else
+        {
+            job( 0, count );
+        }
+    }
+
+    unsigned _parts_count(CollisionBatch *batch)
+    {
+        return batch != NULL ? batch->threads_count()*_PARTS_PER_THREAD : 1;
+    }
+
+    // ----------------------------------- T r i a n g l e s -----------------------------------
+
+    // checks indices and drops degenerated triangles
+    void _finish(CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        const unsigned count = mesh.triangles_count();
+        std::vector<unsigned char> degenerated( count );
+        std::vector<unsigned char> part_failed( _parts_count( batch ) );
+        const unsigned parts = static_cast<unsigned>( part_failed.size() );
+        _run( batch, parts, [&](unsigned begin, unsigned end)
+        {
+            for( unsigned part = begin; part < end; ++part )
+            {
+                for( unsigned i = static_cast<unsigned>( static_cast<unsigned long long>( count )*part/parts );
+                     i < static_cast<unsigned>( static_cast<unsigned long long>( count )*(part + 1)/parts ); ++i )
+                {
+                    const unsigned *corners = &mesh.indices[3*i];
+                    if( corners[0] >= mesh.vertices.size() || corners[1] >= mesh.vertices.size() || corners[2] >= mesh.vertices.size() )
+                    {
+                        part_failed[part] = 1;
+                        continue;
+                    }
+                    degenerated[i] = Triangle( mesh.vertices[ corners[0] ], mesh.vertices[ corners[1] ], mesh.vertices[ corners[2] ] ).is_degenerated() ? 1 : 0;
+                }
+            }
+        } );
+        check( std::find( part_failed.begin(), part_failed.end(), 1 ) == part_failed.end(), MeshFormatError() );
+
+        unsigned kept = 0;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            if( degenerated[i] )
+            {
+                mesh.dropped_triangles.push_back( i );
+                continue;
+            }
+            // std::copy is undefined for a destination inside the source, so triangles in place are not copied
+            if( kept != i )
+            {
+                std::copy( &mesh.indices[3*i], &mesh.indices[3*i] + 3, &mesh.indices[3*kept] );
+            }
+            ++kept;
+        }
+        mesh.indices.resize( 3*kept );
+    }
+
+    // adds a polygon as a fan of triangles
+    inline void _add_polygon(const unsigned *corners, unsigned count, /*out*/ std::vector<unsigned> &indices)
+    {
+        for( unsigned i = 1; i + 1 < count; ++i )
+        {
+            indices.push_back( corners[0] );
+            indices.push_back( corners[i] );
+            indices.push_back( corners[i + 1] );
+        }
+    }
+
+    // ------------------------------------------ O B J ----------------------------------------
+
+    // corner of a face, as written in the file
+    struct _ObjCorner
+    {
+        long long index;    // from 0: in the file (absolute) or in the part (relative, may be negative)
+        bool relative;
+    };
+
+    // what is found in a part of a chunk
+    struct _ObjPart
+    {
+        std::vector<Point> vertices;
+        std::vector<_ObjCorner> corners;
+        std::vector<unsigned> polygon_sizes;
+        bool failed;
+    };
+
+    void _parse_obj(const char *begin, const char *end, /*out*/ _ObjPart &part)
+    {
+        part.vertices.clear();
+        part.corners.clear();
+        part.polygon_sizes.clear();
+        part.failed = false;
+        for( const char *line = begin; line < end; )
+        {
+            const char *line_end = _line_end( line, end );
+            const char *position = _skip_spaces( line, line_end );
+            if( _keyword( position, line_end, "v" ) )
+            {
+                double coordinates[3];
+                for( unsigned i = 0; i < 3 && position != NULL; ++i )
+                {
+                    position = parse_double( _skip_spaces( position, line_end ), line_end, coordinates[i] );
+                }
+                if( position == NULL )
+                {
+                    part.failed = true;
+                    return;
+                }
+                part.vertices.push_back( Point( coordinates[0], coordinates[1], coordinates[2] ) );
+            }
+            else if( _keyword( position, line_end, "f" ) )
+            {
+                unsigned count = 0;
+                for( position = _skip_spaces( position, line_end ); position < line_end; position = _skip_spaces( position, line_end ) )
+                {
+                    long long index;
+                    // vertex index, then texture and normal ones after slashes
+                    const char *after = _parse_integer( position, line_end, index );
+                    if( after == NULL || index == 0 )
+                    {
+                        part.failed = true;
+                        return;
+                    }
+                    const _ObjCorner corner = { index > 0 ? index - 1 : static_cast<long long>( part.vertices.size() ) + index, index < 0 };
+                    part.corners.push_back( corner );
+                    ++count;
+                    position = _skip_token( after, line_end );
+                }
+                if( count < 3 )
+                {
+                    part.failed = true;
+                    return;
+                }
+                part.polygon_sizes.push_back( count );
+            }
+            line = line_end + 1;
+        }
+    }
+
+    void _import_obj(const char *path, CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        mesh.clear();
+        _Reader reader( path );
+        std::vector<_ObjPart> parts( _parts_count( batch ) );
+        std::vector<const char *> bounds;
+        std::vector<unsigned> polygon;
+        const char *begin, *end;
+        while( reader.chunk( begin, end ) )
+        {
+            _split_lines( begin, end, static_cast<unsigned>( parts.size() ), bounds );
+            _run( batch, static_cast<unsigned>( parts.size() ), [&](unsigned first, unsigned last)
+            {
+                for( unsigned i = first; i < last; ++i )
+                {
+                    _parse_obj( bounds[i], bounds[i + 1], parts[i] );
+                }
+            } );
+
+            // relative indices are resolved by vertices before the part
+            for( unsigned i = 0; i < parts.size(); ++i )
+            {
+                const _ObjPart &part = parts[i];
+                check( !part.failed, MeshFormatError() );
+                const long long base = static_cast<long long>( mesh.vertices.size() );
+                mesh.vertices.insert( mesh.vertices.end(), part.vertices.begin(), part.vertices.end() );
+                unsigned corner = 0;
+                for( unsigned j = 0; j < part.polygon_sizes.size(); ++j )
+                {
+                    polygon.clear();
+                    for( unsigned k = 0; k < part.polygon_sizes[j]; ++k, ++corner )
+                    {
+                        const long long index = part.corners[corner].index + ( part.corners[corner].relative ? base : 0 );
+                        // indices after the last vertex are found by _finish
+                        check( index >= 0 && index <= 0xFFFFFFFFll, MeshFormatError() );
+                        polygon.push_back( static_cast<unsigned>( index ) );
+                    }
+                    _add_polygon( &polygon[0], part.polygon_sizes[j], mesh.indices );
+                }
+            }
+        }
+        _finish( batch, mesh );
+    }
+
+    void import_obj(const char *path, /*out*/ ImportedMesh &mesh)
+    {
+        _import_obj( path, NULL, mesh );
+    }
+
+    void import_obj(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch)
+    {
+        _import_obj( path, &batch, mesh );
+    }
+
+    // ------------------------------------------ S T L ----------------------------------------
+
+    const size_t _STL_HEADER_SIZE = 80;
+    const size_t _STL_RECORD_SIZE = 50; // normal and three vertices by three floats, and two bytes of attributes
+    const size_t _STL_RECORDS_PER_CHUNK = _CHUNK_SIZE/_STL_RECORD_SIZE;
+
+    inline bool _is_little_endian()
+    {
+        const uint32_t one = 1;
+        unsigned char first;
+        memcpy( &first, &one, 1 );
+        return first == 1;
+    }
+
+    // reverses bytes of a value, if the byte order of the file is not that of the machine
+    inline void _to_host_order(/*inout*/ unsigned char *value, size_t size, bool little_endian)
+    {
+        if( little_endian != _is_little_endian() )
+        {
+            std::reverse( value, value + size );
+        }
+    }
+
+    inline float _little_endian_float(const unsigned char *data)
+    {
+        unsigned char bytes[4];
+        memcpy( bytes, data, 4 );
+        _to_host_order( bytes, 4, true );
+        float value;
+        memcpy( &value, bytes, 4 );
+        return value;
+    }
+
+    // hash of a vertex by the bits of its coordinates (-0 and 0 are equal, so they are made the same)
+    struct _PointHash
+    {
+        size_t operator()(const Point &point) const
+        {
+            const double coordinates[3] = { point.x + 0.0, point.y + 0.0, point.z + 0.0 };
+            uint64_t bits[3];
+            memcpy( bits, coordinates, sizeof(bits) );
+            const uint64_t hash = ( bits[0]*0x9E3779B97F4A7C15ull ) ^ ( bits[1]*0xC2B2AE3D27D4EB4Full ) ^ ( bits[2]*0x165667B19E3779F9ull );
+            return static_cast<size_t>( hash ^ ( hash >> 29 ) );
+        }
+    };
+
+    // exact equality of vertices (Point::operator== compares with a tolerance)
+    struct _PointEqual
+    {
+        bool operator()(const Point &a, const Point &b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    typedef std::unordered_map<Point, unsigned, _PointHash, _PointEqual> _VertexIndices;
+
+    // merges equal vertices of triangles, given by three corners each
+    void _add_triangles(const std::vector<Point> &corners, _VertexIndices &indices, /*out*/ ImportedMesh &mesh)
+    {
+        for( unsigned i = 0; i < corners.size(); ++i )
+        {
+            const std::pair<_VertexIndices::iterator, bool> found =
+                indices.insert( std::make_pair( corners[i], static_cast<unsigned>( mesh.vertices.size() ) ) );
+            if( found.second )
+            {
+                mesh.vertices.push_back( corners[i] );
+            }
+            mesh.indices.push_back( found.first->second );
+        }
+    }
+
+    // true if the line starts with a word of the structure of ASCII STL (except `vertex')
+    bool _is_stl_structure(const char *position, const char *line_end)
+    {
+        static const char * const WORDS[] = { "solid", "facet", "outer", "endloop", "endfacet", "endsolid" };
+        const std::string word( position, _skip_token( position, line_end ) );
+        return std::find( WORDS, WORDS + sizeof(WORDS)/sizeof(WORDS[0]), word ) != WORDS + sizeof(WORDS)/sizeof(WORDS[0]);
+    }
+
+    void _parse_ascii_stl(const char *begin, const char *end, /*out*/ std::vector<Point> &corners, /*out*/ bool &failed)
+    {
+        corners.clear();
+        failed = false;
+        for( const char *line = begin; line < end; )
+        {
+            const char *line_end = _line_end( line, end );
+            const char *position = _skip_spaces( line, line_end );
+            // other lines only make the structure
+            if( _keyword( position, line_end, "vertex" ) )
+            {
+                double coordinates[3];
+                for( unsigned i = 0; i < 3 && position != NULL; ++i )
+                {
+                    position = parse_double( _skip_spaces( position, line_end ), line_end, coordinates[i] );
+                }
+                if( position == NULL )
+                {
+                    failed = true;
+                    return;
+                }
+                corners.push_back( Point( coordinates[0], coordinates[1], coordinates[2] ) );
+            }
+            else if( position != line_end && !_is_stl_structure( position, line_end ) )
+            {
+                // a binary file of a wrong size, starting with "solid", gets here
+                failed = true;
+                return;
+            }
+            line = line_end + 1;
+        }
+    }
+
+    void _import_ascii_stl(_Reader &reader, CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        const unsigned parts_count = _parts_count( batch );
+        std::vector< std::vector<Point> > parts( parts_count );
+        std::vector<unsigned char> failed( parts_count );
+        std::vector<const char *> bounds;
+        std::vector<Point> corners;
+        _VertexIndices indices;
+        const char *begin, *end;
+        while( reader.chunk( begin, end ) )
+        {
+            _split_lines( begin, end, parts_count, bounds );
+            _run( batch, parts_count, [&](unsigned first, unsigned last)
+            {
+                for( unsigned i = first; i < last; ++i )
+                {
+                    bool part_failed;
+                    _parse_ascii_stl( bounds[i], bounds[i + 1], parts[i], part_failed );
+                    failed[i] = part_failed ? 1 : 0;
+                }
+            } );
+            for( unsigned i = 0; i < parts_count; ++i )
+            {
+                check( !failed[i], MeshFormatError() );
+                corners.insert( corners.end(), parts[i].begin(), parts[i].end() );
+            }
+            // triangles may go across chunks: only whole ones are added
+            const size_t whole = corners.size()/3*3;
+            const std::vector<Point> rest( corners.begin() + whole, corners.end() );
+            corners.resize( whole );
+            _add_triangles( corners, indices, mesh );
+            corners = rest;
+        }
+        check( corners.empty(), MeshFormatError() );
+    }
+
+    void _import_binary_stl(_Reader &reader, unsigned count, CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        const unsigned parts_count = _parts_count( batch );
+        std::vector<unsigned char> records;
+        std::vector<Point> corners;
+        _VertexIndices indices;
+        indices.reserve( count/2 + 1 ); // closed meshes have about half as many vertices as triangles
+        for( unsigned first = 0; first < count; first += static_cast<unsigned>( _STL_RECORDS_PER_CHUNK ) )
+        {
+            const unsigned chunk = static_cast<unsigned>( std::min<size_t>( count - first, _STL_RECORDS_PER_CHUNK ) );
+            records.resize( chunk*_STL_RECORD_SIZE );
+            reader.read( &records[0], records.size() );
+            corners.resize( 3*chunk );
+            _run( batch, parts_count, [&](unsigned begin, unsigned end)
+            {
+                for( unsigned i = static_cast<unsigned>( static_cast<unsigned long long>( chunk )*begin/parts_count );
+                     i < static_cast<unsigned>( static_cast<unsigned long long>( chunk )*end/parts_count ); ++i )
+                {
+                    const unsigned char *record = &records[i*_STL_RECORD_SIZE];
+                    for( unsigned j = 0; j < 3; ++j )
+                    {
+                        const unsigned char *vertex = record + 12*(j + 1); // after the normal
+                        corners[3*i + j] = Point( _little_endian_float( vertex ), _little_endian_float( vertex + 4 ), _little_endian_float( vertex + 8 ) );
+                    }
+                }
+            } );
+            _add_triangles( corners, indices, mesh );
+        }
+    }
+
+    void _import_stl(const char *path, CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        mesh.clear();
+        // binary files start with a header and the number of triangles, and may start with "solid" too:
+        // the size tells them apart
+        std::FILE *file = fopen( path, "rb" );
+        check( file != NULL, FileError() );
+        const bool seek_ok = fseek( file, 0, SEEK_END ) == 0;
+        const long long size = seek_ok ? ftell( file ) : -1;
+        fclose( file );
+        check( size >= 0, FileError() );
+
+        _Reader reader( path );
+        unsigned char header[_STL_HEADER_SIZE + 4];
+        const size_t header_size = reader.read_some( header, sizeof(header) );
+        unsigned count = 0;
+        if( header_size == sizeof(header) )
+        {
+            memcpy( &count, header + _STL_HEADER_SIZE, 4 );
+            _to_host_order( reinterpret_cast<unsigned char *>( &count ), 4, true );
+        }
+        if( header_size == sizeof(header) && static_cast<unsigned long long>( size ) == sizeof(header) + count*static_cast<unsigned long long>( _STL_RECORD_SIZE ) )
+        {
+            _import_binary_stl( reader, count, batch, mesh );
+        }
+        else
+        {
+            // binary headers starting with "solid" are told by zero bytes of the count
+            check( header_size >= 5 && memcmp( header, "solid", 5 ) == 0 && memchr( header, 0, header_size ) == NULL, MeshFormatError() );
+            // the header was a part of the text
+            _Reader text_reader( path );
+            _import_ascii_stl( text_reader, batch, mesh );
+        }
+        _finish( batch, mesh );
+    }
+
+    void import_stl(const char *path, /*out*/ ImportedMesh &mesh)
+    {
+        _import_stl( path, NULL, mesh );
+    }
+
+    void import_stl(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch)
+    {
+        _import_stl( path, &batch, mesh );
+    }
+
+    // ------------------------------------------ P L Y ----------------------------------------
+
+    enum _PlyFormat { _PLY_ASCII, _PLY_LITTLE_ENDIAN, _PLY_BIG_ENDIAN };
+
+    struct _PlyProperty
+    {
+        std::string name;
+        unsigned size;          // bytes of the value (of an item for a list)
+        bool is_float;
+        bool is_signed;
+        unsigned count_size;    // bytes of the count of a list, 0 for a single value
+    };
+
+    struct _PlyElement
+    {
+        std::string name;
+        unsigned long long count;
+        std::vector<_PlyProperty> properties;
+    };
+
+    // sets size and kind by the name of a type, false for unknown
+    bool _ply_type(const std::string &name, /*out*/ unsigned &size, bool &is_float, bool &is_signed)
+    {
+        static const char * const NAMES[] = { "char", "int8", "uchar", "uint8", "short", "int16", "ushort", "uint16",
+                                              "int", "int32", "uint", "uint32", "float", "float32", "double", "float64" };
+        static const unsigned SIZES[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+        for( unsigned i = 0; i < 16; ++i )
+        {
+            if( name == NAMES[i] )
+            {
+                size = SIZES[i/2];
+                is_float = i >= 12;
+                is_signed = i >= 12 || (i/2) % 2 == 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // space separated words of a line
+    void _words(const char *begin, const char *end, /*out*/ std::vector<std::string> &words)
+    {
+        words.clear();
+        for( const char *position = _skip_spaces( begin, end ); position < end; position = _skip_spaces( position, end ) )
+        {
+            const char *word_end = _skip_token( position, end );
+            words.push_back( std::string( position, word_end ) );
+            position = word_end;
+        }
+    }
+
+    _PlyFormat _read_ply_header(_Reader &reader, /*out*/ std::vector<_PlyElement> &elements)
+    {
+        const char *begin, *end;
+        std::vector<std::string> words;
+        check( reader.line( begin, end ), MeshFormatError() );
+        _words( begin, end, words );
+        check( words.size() == 1 && words[0] == "ply", MeshFormatError() );
+
+        bool has_format = false;
+        _PlyFormat format = _PLY_ASCII;
+        for(;;)
+        {
+            check( reader.line( begin, end ), MeshFormatError() );
+            _words( begin, end, words );
+            if( words.empty() || words[0] == "comment" || words[0] == "obj_info" )
+                continue;
+
+            if( words[0] == "end_header" )
+                break;
+
+            if( words[0] == "format" )
+            {
+                check( words.size() == 3 && words[2] == "1.0", MeshFormatError() );
+                check( words[1] == "ascii" || words[1] == "binary_little_endian" || words[1] == "binary_big_endian", MeshFormatError() );
+                format = words[1] == "ascii" ? _PLY_ASCII : ( words[1] == "binary_little_endian" ? _PLY_LITTLE_ENDIAN : _PLY_BIG_ENDIAN );
+                has_format = true;
+            }
+            else if( words[0] == "element" )
+            {
+                check( words.size() == 3, MeshFormatError() );
+                _PlyElement element;
+                element.name = words[1];
+                long long count;
+                check( _parse_integer( words[2].data(), words[2].data() + words[2].size(), count ) != NULL && count >= 0, MeshFormatError() );
+                element.count = static_cast<unsigned long long>( count );
+                elements.push_back( element );
+            }
+            else if( words[0] == "property" )
+            {
+                check( !elements.empty(), MeshFormatError() );
+                _PlyProperty property;
+                property.count_size = 0;
+                if( words.size() == 5 && words[1] == "list" )
+                {
+                    bool count_is_float, count_is_signed;
+                    check( _ply_type( words[2], property.count_size, count_is_float, count_is_signed ) && !count_is_float, MeshFormatError() );
+                    check( _ply_type( words[3], property.size, property.is_float, property.is_signed ), MeshFormatError() );
+                    property.name = words[4];
+                }
+                else
+                {
+                    check( words.size() == 3 && _ply_type( words[1], property.size, property.is_float, property.is_signed ), MeshFormatError() );
+                    property.name = words[2];
+                }
+                elements.back().properties.push_back( property );
+            }
+            else
+            {
+                throw MeshFormatError();
+            }
+        }
+        check( has_format, MeshFormatError() );
+        return format;
+    }
+
+    // reads values of an element by one
+    class _PlyValues
+    {
+        _Reader &reader;
+        _PlyFormat format;
+        std::vector<std::string> words;
+        unsigned next_word;
+    public:
+        _PlyValues(_Reader &reader, _PlyFormat format) : reader(reader), format(format), next_word(0) {}
+
+        // starts the next element (a line in ASCII)
+        void next_element()
+        {
+            if( format == _PLY_ASCII )
+            {
+                const char *begin, *end;
+                check( reader.line( begin, end ), MeshFormatError() );
+                _words( begin, end, words );
+                next_word = 0;
+            }
+        }
+
+        double value(unsigned size, bool is_float, bool is_signed)
+        {
+            if( format == _PLY_ASCII )
+            {
+                check( next_word < words.size(), MeshFormatError() );
+                const std::string &word = words[next_word++];
+                double result;
+                check( parse_double( word.data(), word.data() + word.size(), result ) == word.data() + word.size(), MeshFormatError() );
+                return result;
+            }
+            unsigned char bytes[8];
+            reader.read( bytes, size );
+            _to_host_order( bytes, size, format == _PLY_LITTLE_ENDIAN );
+            if( is_float )
+            {
+                if( size == 4 )
+                {
+                    float result;
+                    memcpy( &result, bytes, 4 );
+                    return result;
+                }
+                double result;
+                memcpy( &result, bytes, 8 );
+                return result;
+            }
+            // integers of the host order: the value is in the low `size' bytes on little endian machines, in the high ones otherwise
+            uint64_t bits = 0;
+            memcpy( reinterpret_cast<unsigned char *>( &bits ) + ( _is_little_endian() ? 0 : 8 - size ), bytes, size );
+            if( is_signed && size < 8 && ( bits >> (8*size - 1) ) != 0 )
+            {
+                bits |= ~0ull << 8*size; // sign extension
+            }
+            return is_signed ? static_cast<double>( static_cast<long long>( bits ) ) : static_cast<double>( bits );
+        }
+    };
+
+    void import_ply(const char *path, /*out*/ ImportedMesh &mesh)
+    {
+        mesh.clear();
+        _Reader reader( path );
+        std::vector<_PlyElement> elements;
+        const _PlyFormat format = _read_ply_header( reader, elements );
+        _PlyValues values( reader, format );
+
+        std::vector<unsigned> polygon;
+        for( unsigned e = 0; e < elements.size(); ++e )
+        {
+            const _PlyElement &element = elements[e];
+            const bool is_vertex = element.name == "vertex";
+            const bool is_face = element.name == "face";
+            // coordinates of vertices and indices of faces
+            int coordinate_properties[3] = { -1, -1, -1 };
+            int indices_property = -1;
+            for( unsigned p = 0; p < element.properties.size(); ++p )
+            {
+                const _PlyProperty &property = element.properties[p];
+                for( unsigned axis = 0; axis < 3 && is_vertex && property.count_size == 0; ++axis )
+                {
+                    coordinate_properties[axis] = property.name == std::string( 1, static_cast<char>( 'x' + axis ) ) ? static_cast<int>( p ) : coordinate_properties[axis];
+                }
+                if( is_face && property.count_size != 0 && !property.is_float && ( property.name == "vertex_indices" || property.name == "vertex_index" ) )
+                {
+                    indices_property = static_cast<int>( p );
+                }
+            }
+            check( !is_vertex || ( coordinate_properties[0] >= 0 && coordinate_properties[1] >= 0 && coordinate_properties[2] >= 0 ), MeshFormatError() );
+            check( !is_face || indices_property >= 0, MeshFormatError() );
+
+            for( unsigned long long i = 0; i < element.count; ++i )
+            {
+                values.next_element();
+                double coordinates[3] = { 0, 0, 0 };
+                polygon.clear();
+                for( unsigned p = 0; p < element.properties.size(); ++p )
+                {
+                    const _PlyProperty &property = element.properties[p];
+                    if( property.count_size == 0 )
+                    {
+                        const double value = values.value( property.size, property.is_float, property.is_signed );
+                        for( unsigned axis = 0; axis < 3; ++axis )
+                        {
+                            coordinates[axis] = coordinate_properties[axis] == static_cast<int>( p ) ? value : coordinates[axis];
+                        }
+                        continue;
+                    }
+                    const double items = values.value( property.count_size, false, false );
+                    check( items >= 0 && items <= 0xFFFFFFFFu, MeshFormatError() );
+                    for( unsigned k = 0; k < static_cast<unsigned>( items ); ++k )
+                    {
+                        const double item = values.value( property.size, property.is_float, property.is_signed );
+                        if( indices_property == static_cast<int>( p ) )
+                        {
+                            check( item >= 0 && item <= 0xFFFFFFFFu, MeshFormatError() );
+                            polygon.push_back( static_cast<unsigned>( item ) );
+                        }
+                    }
+                }
+                if( is_vertex )
+                {
+                    mesh.vertices.push_back( Point( coordinates[0], coordinates[1], coordinates[2] ) );
+                }
+                else if( is_face )
+                {
+                    check( polygon.size() >= 3, MeshFormatError() );
+                    _add_polygon( &polygon[0], static_cast<unsigned>( polygon.size() ), mesh.indices );
+                }
+            }
+        }
+        _finish( NULL, mesh );
+    }
+
+    // -------------------------------------- B y   n a m e ------------------------------------
+
+    // lowercase extension of the path, without the dot
+    std::string _extension(const char *path)
+    {
+        const char *dot = strrchr( path, '.' );
+        std::string result( dot != NULL ? dot + 1 : "" );
+        for( unsigned i = 0; i < result.size(); ++i )
+        {
+            result[i] = result[i] >= 'A' && result[i] <= 'Z' ? static_cast<char>( result[i] - 'A' + 'a' ) : result[i];
+        }
+        return result;
+    }
+
+    void _import_mesh(const char *path, CollisionBatch *batch, /*out*/ ImportedMesh &mesh)
+    {
+        const std::string extension = _extension( path );
+        if( extension == "obj" )
+        {
+            _import_obj( path, batch, mesh );
+        }
+        else if( extension == "stl" )
+        {
+            _import_stl( path, batch, mesh );
+        }
+        else
+        {
+            check( extension == "ply", MeshFormatError() );
+            import_ply( path, mesh );
+        }
+    }
+
+    void import_mesh(const char *path, /*out*/ ImportedMesh &mesh)
+    {
+        _import_mesh( path, NULL, mesh );
+    }
+
+    void import_mesh(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch)
+    {
+        _import_mesh( path, &batch, mesh );
+    }
+};
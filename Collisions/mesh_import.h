@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include "collisions.h"
+
+namespace Collisions
+{
+    class CollisionBatch;
+
+    // Mesh read from a file: a vertex buffer and three indices per triangle, as taken by IndexedMesh
+    // and MappedMesh::write. Polygons are split into fans of triangles.
+    struct ImportedMesh
+    {
+        std::vector<Point> vertices;
+        std::vector<unsigned> indices;
+        // Degenerated triangles (see Triangle::is_degenerated) are not put into indices: these are their
+        // numbers among all triangles of the file, in its order (a polygon of n vertices counts as n - 2).
+        std::vector<unsigned> dropped_triangles;
+
+        unsigned triangles_count() const { return static_cast<unsigned>( indices.size()/3 ); }
+        void clear()
+        {
+            vertices.clear();
+            indices.clear();
+            dropped_triangles.clear();
+        }
+    };
+
+    // Importers read the file by chunks, so it is never in memory as a whole, and throw FileError if the file
+    // can't be read, MeshFormatError if it is malformed (including indices out of the vertex buffer).
+    // Versions with a batch parse parts of each chunk on its threads.
+
+    // Wavefront OBJ: `v' and `f' lines, with absolute or relative (negative) indices; texture and normal
+    // indices and other lines are ignored
+    void import_obj(const char *path, /*out*/ ImportedMesh &mesh);
+    void import_obj(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch);
+    // binary or ASCII STL: equal vertices of triangles are merged into one
+    void import_stl(const char *path, /*out*/ ImportedMesh &mesh);
+    void import_stl(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch);
+    // PLY (ASCII, binary little or big endian): x, y, z of `vertex' elements and `vertex_indices' (or `vertex_index')
+    // lists of `face' elements; other elements and properties are skipped. Its elements can't be found without reading
+    // the preceding ones, so it is parsed by one thread.
+    void import_ply(const char *path, /*out*/ ImportedMesh &mesh);
+    // by the extension of the path: .obj, .stl or .ply in any case (MeshFormatError for others)
+    void import_mesh(const char *path, /*out*/ ImportedMesh &mesh);
+    void import_mesh(const char *path, /*out*/ ImportedMesh &mesh, CollisionBatch &batch);
+
+    // Parses a decimal floating point number (as strtod in "C" locale, without hexadecimal, infinity and NaN)
+    // at the start of [begin, end) and returns the position after it, or NULL if there is no number. Numbers of up
+    // to 15 significant digits and with decimal exponents up to 22 are converted exactly by one multiplication
+    // or division, others go to strtod.
+    const char * parse_double(const char *begin, const char *end, /*out*/ double &value);
+};
@@ -0,0 +1,371 @@
+#include "meshlets.h"
+#include "bounding_box.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace Collisions
+{
+    // ---------------------------------- B u i l d e r ----------------------------------------
+
+    const unsigned MeshletMesh::MAX_TRIANGLES;
+
+    // triangle, as seen by the builder
+    struct _ClusterItem
+    {
+        Point centroid;
+        Vector normal;
+        unsigned index;
+    };
+
+    // keys to split clusters by: coordinates of centroids (0 to 2) and of normals (3 to 5)
+    const unsigned _CLUSTER_KEYS = 6;
+
+    inline double _cluster_key(const _ClusterItem &item, unsigned key)
+    {
+        const Vector &vector = key < 3 ? item.centroid : item.normal;
+        const unsigned axis = key % 3;
+        return axis == 0 ? vector.x : ( axis == 1 ? vector.y : vector.z );
+    }
+
+    // Unit axis of the cone of normals (their mean) and the cosine of its half angle. Opposite normals give
+    // no axis: the cosine is -1 then.
+    void _normal_cone(const _ClusterItem *items, unsigned count, /*out*/ Vector &axis, double &cone_cos)
+    {
+        Vector sum( 0, 0, 0 );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            sum += items[i].normal;
+        }
+        if( sum.is_zero() )
+        {
+            axis = Vector( 0, 0, 1 );
+            cone_cos = -1;
+            return;
+        }
+        axis = sum.normalized();
+        cone_cos = 1;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            cone_cos = std::min( cone_cos, items[i].normal*axis );
+        }
+    }
+
+    // how loose the cluster is: the size of its centroids (relative to `scale') and the spread of its normals
+    double _looseness(const _ClusterItem *items, unsigned count, double scale)
+    {
+        BoundingBox centroids;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            centroids.add( items[i].centroid );
+        }
+        Vector axis;
+        double cone_cos;
+        _normal_cone( items, count, axis, cone_cos );
+        return distance( centroids.min, centroids.max )/scale + (1 - cone_cos);
+    }
+
+    MeshletMesh::MeshletMesh(const std::vector<Triangle> &source)
+    {
+        triangles.reserve( source.size() );
+        for( unsigned i = 0; i < source.size(); ++i )
+        {
+            triangles.push_back( PreparedTriangle( source[i] ) );
+        }
+        build();
+    }
+
+    MeshletMesh::MeshletMesh(const std::vector<PreparedTriangle> &source) : triangles(source)
+    {
+        build();
+    }
+
+    void MeshletMesh::build()
+    {
+        const unsigned count = static_cast<unsigned>( triangles.size() );
+        std::vector<_ClusterItem> items( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            items[i].centroid = (triangles[i][0] + triangles[i][1] + triangles[i][2])/3;
+            items[i].normal = triangles[i].normal();
+            items[i].index = i;
+        }
+
+        // Clusters are split at the median by the key, which gives the least loose halves. Ranges are taken
+        // depth first, left to right, so that neighbouring meshlets are near each other.
+        std::vector<std::pair<unsigned, unsigned> > stack; // first item and count
+        if( count != 0 )
+        {
+            stack.push_back( std::make_pair( 0u, count ) );
+        }
+        std::vector<_ClusterItem> candidate, best;
+        std::vector<std::pair<unsigned, unsigned> > ranges;
+        while( !stack.empty() )
+        {
+            const unsigned first = stack.back().first;
+            const unsigned size = stack.back().second;
+            stack.pop_back();
+            if( size <= MAX_TRIANGLES )
+            {
+                ranges.push_back( std::make_pair( first, size ) );
+                continue;
+            }
+
+            BoundingBox centroids;
+            for( unsigned i = first; i < first + size; ++i )
+            {
+                centroids.add( items[i].centroid );
+            }
+            const double scale = std::max( distance( centroids.min, centroids.max ), std::numeric_limits<double>::min() );
+            const unsigned half = size/2;
+            double best_looseness = -1;
+            for( unsigned key = 0; key < _CLUSTER_KEYS; ++key )
+            {
+                candidate.assign( items.begin() + first, items.begin() + first + size );
+                std::nth_element( candidate.begin(), candidate.begin() + half, candidate.end(),
+                                  [=](const _ClusterItem &a, const _ClusterItem &b) { return _cluster_key( a, key ) < _cluster_key( b, key ); } );
+                const double looseness = _looseness( &candidate[0], half, scale ) + _looseness( &candidate[half], size - half, scale );
+                if( best_looseness < 0 || looseness < best_looseness )
+                {
+                    best_looseness = looseness;
+                    best.swap( candidate );
+                }
+            }
+            std::copy( best.begin(), best.end(), items.begin() + first );
+            stack.push_back( std::make_pair( first + half, size - half ) );
+            stack.push_back( std::make_pair( first, half ) );
+        }
+
+        std::vector<PreparedTriangle> ordered;
+        ordered.reserve( count );
+        original_indices.resize( count );
+        for( unsigned i = 0; i < count; ++i )
+        {
+            ordered.push_back( triangles[ items[i].index ] );
+            original_indices[i] = items[i].index;
+        }
+        triangles.swap( ordered );
+
+        meshlets.resize( ranges.size() );
+        for( unsigned i = 0; i < ranges.size(); ++i )
+        {
+            Meshlet &meshlet = meshlets[i];
+            meshlet.first = ranges[i].first;
+            meshlet.count = ranges[i].second;
+
+            BoundingBox box;
+            for( unsigned j = meshlet.first; j < meshlet.first + meshlet.count; ++j )
+            {
+                box.add( triangles[j][0] ).add( triangles[j][1] ).add( triangles[j][2] );
+            }
+            meshlet.center = box.center();
+            meshlet.radius = 0;
+            for( unsigned j = meshlet.first; j < meshlet.first + meshlet.count; ++j )
+            {
+                for( unsigned k = 0; k < 3; ++k )
+                {
+                    meshlet.radius = std::max( meshlet.radius, distance( meshlet.center, triangles[j][k] ) );
+                }
+            }
+
+            _normal_cone( &items[meshlet.first], meshlet.count, meshlet.axis, meshlet.cone_cos );
+            meshlet.cone_sin = std::sqrt( std::max( 1 - meshlet.cone_cos*meshlet.cone_cos, 0.0 ) );
+            meshlet.center_heights[0] = std::numeric_limits<double>::infinity();
+            meshlet.center_heights[1] = -std::numeric_limits<double>::infinity();
+            for( unsigned j = meshlet.first; j < meshlet.first + meshlet.count; ++j )
+            {
+                const double height = (meshlet.center - triangles[j][0])*triangles[j].normal();
+                meshlet.center_heights[0] = std::min( meshlet.center_heights[0], height );
+                meshlet.center_heights[1] = std::max( meshlet.center_heights[1], height );
+            }
+        }
+    }
+
+    // -------------------------------------- Q u e r y ----------------------------------------
+
+    // relative margin of culling tests, so that touches within tolerances of the triangle kernel are kept
+    const double _CULL_MARGIN = 1e-9;
+
+    // Returns false, if the segment misses the sphere, or enters it after max_time; otherwise writes the time
+    // of entering it (0, if it starts inside).
+    inline bool _segment_and_sphere_entry(const Point &segment_start, const Vector &segment_vector, const Point &center, double radius, double max_time,
+                                          /*out*/ double &entry_time)
+    {
+        const Vector w = segment_start - center;
+        const double c = w*w - radius*radius;
+        if( c <= 0 )
+        {
+            entry_time = 0;
+            return true;
+        }
+        const double a = segment_vector*segment_vector;
+        const double b = w*segment_vector;
+        const double discriminant = b*b - a*c;
+        if( b >= 0 || discriminant < 0 )
+        {
+            return false; // outside and moving away, or passing by
+        }
+        entry_time = (-b - std::sqrt( discriminant ))/a;
+        return entry_time <= max_time;
+    }
+
+    // Lower bound of (vector*normal) for normals of the cone: |vector|*cos(angle to the axis + the cone angle),
+    // or -|vector|, if that sum is over pi (the opposite of the vector is inside the cone then). It is only
+    // positive, if the vector is inside the cone, widened to a hemisphere. `sign' turns the axis over.
+    inline double _cone_lower_bound(const MeshletMesh::Meshlet &meshlet, const Vector &vector, double sign)
+    {
+        const double along = sign*(vector*meshlet.axis);
+        const double length = vector.norm();
+        if( along <= -length*meshlet.cone_cos )
+            return -length;
+
+        return along*meshlet.cone_cos - cross_product( vector, meshlet.axis ).norm()*meshlet.cone_sin;
+    }
+
+    // true, if the point is farther than `margin' in front of planes of all triangles of the meshlet (or behind them for
+    // negative `sign'): its height over a plane is the height of the meshlet center plus (point - center)*normal
+    inline bool _beyond_planes(const MeshletMesh::Meshlet &meshlet, const Point &point, double margin, double sign)
+    {
+        const double center_height = sign > 0 ? meshlet.center_heights[0] : -meshlet.center_heights[1];
+        return _cone_lower_bound( meshlet, point - meshlet.center, sign ) + center_height > margin;
+    }
+
+    // true, if the sphere stays on one side of every triangle plane of the meshlet
+    inline bool _is_culled_by_cone(const MeshletMesh::Meshlet &meshlet, const Point &segment_start, const Point &segment_end, double margin)
+    {
+        if( meshlet.cone_cos <= 0 )
+            return false;
+
+        for( double sign = -1; sign <= 1; sign += 2 )
+        {
+            if( _beyond_planes( meshlet, segment_start, margin, sign ) &&
+                ( _cone_lower_bound( meshlet, segment_end - segment_start, sign ) >= 0 || _beyond_planes( meshlet, segment_end, margin, sign ) ) )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // meshlets, which the sphere way enters, are gathered by up to _SORTED_MESHLETS and tested front to back
+    const unsigned _SORTED_MESHLETS = 64;
+
+    struct _MeshletEntry
+    {
+        double time;
+        unsigned index;
+    };
+
+    inline bool _is_entered_earlier(const _MeshletEntry &a, const _MeshletEntry &b)
+    {
+        return a.time < b.time;
+    }
+
+    // as for leaves of MeshBVH, meshlets are tested against the segment, shortened to the earliest collision found so far
+    struct _MeshletSweep
+    {
+        const MeshletMesh &mesh;
+        const Point &segment_start;
+        const Vector segment_vector;
+        const double sphere_radius;
+        SweepHit &hit;
+        bool any_result;
+        double best_time;
+        Point current_end;
+
+        _MeshletSweep(const MeshletMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius, SweepHit &hit)
+            : mesh(mesh), segment_start(segment_start), segment_vector(segment_end - segment_start), sphere_radius(sphere_radius), hit(hit),
+              any_result(false), best_time(1), current_end(segment_end) {}
+
+        // returns true, if nothing can be hit earlier
+        bool test(const _MeshletEntry *entries, unsigned count)
+        {
+            for( unsigned i = 0; i < count; ++i )
+            {
+                if( any_result && entries[i].time >= best_time )
+                {
+                    COLLISIONS_COUNT_N( Counter::MeshletsCulledByBounds, count - i );
+                    return false; // the rest are entered later
+                }
+
+                COLLISIONS_COUNT( Counter::MeshletsTested );
+                const MeshletMesh::Meshlet &meshlet = mesh.meshlet( entries[i].index );
+                SweepHit meshlet_hit;
+                if( NoThrow::sweep_sphere( &mesh.triangle( meshlet.first ), meshlet.count, segment_start, current_end, sphere_radius, meshlet_hit ) == CollisionStatus::Hit &&
+                    ( !any_result || meshlet_hit.time < 1 ) )
+                {
+                    hit = meshlet_hit;
+                    hit.time = meshlet_hit.time*best_time;
+                    hit.triangle_index = mesh.original_index( meshlet.first + meshlet_hit.triangle_index );
+                    any_result = true;
+
+                    best_time = hit.time;
+                    current_end = segment_start + best_time*segment_vector;
+                    if( current_end == segment_start )
+                        return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const MeshletMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::MeshletSweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            _MeshletSweep sweep( mesh, segment_start, segment_end, sphere_radius, hit );
+            _MeshletEntry entries[_SORTED_MESHLETS];
+            unsigned entries_count = 0;
+            for( unsigned i = 0; i < mesh.meshlets_count(); ++i )
+            {
+                const MeshletMesh::Meshlet &meshlet = mesh.meshlet( i );
+                const double margin = _CULL_MARGIN*( meshlet.radius + sphere_radius );
+                double entry_time;
+                if( !_segment_and_sphere_entry( segment_start, sweep.segment_vector, meshlet.center, meshlet.radius + sphere_radius + margin, sweep.best_time, entry_time ) ||
+                    ( sweep.any_result && entry_time >= sweep.best_time ) )
+                {
+                    COLLISIONS_COUNT( Counter::MeshletsCulledByBounds );
+                    continue;
+                }
+                if( _is_culled_by_cone( meshlet, segment_start, sweep.current_end, sphere_radius + margin ) )
+                {
+                    COLLISIONS_COUNT( Counter::MeshletsCulledByCone );
+                    continue;
+                }
+
+                entries[entries_count].time = entry_time;
+                entries[entries_count].index = i;
+                if( ++entries_count == _SORTED_MESHLETS )
+                {
+                    std::sort( entries, entries + entries_count, _is_entered_earlier );
+                    const bool done = sweep.test( entries, entries_count );
+                    entries_count = 0;
+                    if( done )
+                        break;
+                }
+            }
+            if( entries_count != 0 )
+            {
+                std::sort( entries, entries + entries_count, _is_entered_earlier );
+                sweep.test( entries, entries_count );
+            }
+            if( !sweep.any_result )
+                return CollisionStatus::Miss;
+
+            hit.sphere_center = segment_start + hit.time*sweep.segment_vector;
+            return CollisionStatus::Hit;
+        }
+    };
+
+    bool sweep_sphere(const MeshletMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( mesh, segment_start, segment_end, sphere_radius, hit ) );
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include "collisions.h"
+
+namespace Collisions
+{
+    // Static triangle mesh, split into meshlets: clusters of neighbouring triangles with similar normals. Every
+    // meshlet keeps a bounding sphere and a cone, which holds normals of its triangles, so that a sweep rejects
+    // the whole meshlet without reading its triangles, when the sphere way misses the bounding sphere, or stays
+    // on one side of the plane of every triangle in it (like moving away from faces, which the sphere is in front of).
+    // Clusters are split in halves by position or by normal, whichever gives tighter halves, until they are not
+    // bigger than MAX_TRIANGLES: meshlets have from MAX_TRIANGLES/2 + 1 to MAX_TRIANGLES triangles (a smaller mesh
+    // is a single meshlet). For props, which are swept against as a whole, with no hierarchy over their triangles.
+    class MeshletMesh
+    {
+    public:
+        static const unsigned MAX_TRIANGLES = 64;
+
+        struct Meshlet
+        {
+            Point center;    // bounding sphere of vertices
+            double radius;
+            Vector axis;     // unit axis of the normal cone
+            double cone_cos; // cosine and sine of the cone half angle: normal*axis >= cone_cos for all triangles;
+            double cone_sin; // the cone is not used, if cone_cos is not positive (normals are wider than a hemisphere)
+            double center_heights[2]; // the lowest and the highest signed height of the center over planes of triangles
+            unsigned first;  // index of the first triangle
+            unsigned count;
+        };
+    private:
+        std::vector<PreparedTriangle> triangles;
+        std::vector<unsigned> original_indices;
+        std::vector<Meshlet> meshlets;
+
+        void build();
+    public:
+        // throws DegeneratedTriangleError for degenerated triangle
+        explicit MeshletMesh(const std::vector<Triangle> &triangles);
+        explicit MeshletMesh(const std::vector<PreparedTriangle> &triangles);
+
+        unsigned size() const { return static_cast<unsigned>( triangles.size() ); }
+        bool empty() const { return triangles.empty(); }
+
+        // triangles in the order of meshlets
+        PreparedTriangle const & triangle(unsigned index) const
+        {
+            check( index < triangles.size(), OutOfBoundsError() );
+            return triangles[index];
+        }
+        unsigned original_index(unsigned index) const
+        {
+            check( index < original_indices.size(), OutOfBoundsError() );
+            return original_indices[index];
+        }
+
+        unsigned meshlets_count() const { return static_cast<unsigned>( meshlets.size() ); }
+        Meshlet const & meshlet(unsigned index) const
+        {
+            check( index < meshlets.size(), OutOfBoundsError() );
+            return meshlets[index];
+        }
+    };
+
+    // Sweeps a sphere along the segment against the mesh and finds the earliest collision (see sweep_sphere in
+    // collisions.h). A meshlet is skipped, if the sphere way misses its bounding sphere, inflated by the sphere
+    // radius, or if the sphere stays farther than its radius in front of (or behind) the planes of all its triangles:
+    // at both ends of the segment, or at the start, moving away from them. The rest are tested in the order the way
+    // enters their bounding spheres, until they are entered after the earliest collision found so far. Triangles collide on both sides (as in sphere_and_triangle_collision), so a way, which is
+    // only aimed along normals, is not enough: the sphere may come to the back of triangles. hit.triangle_index
+    // is the index in the original triangle array.
+    bool sweep_sphere(const MeshletMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const MeshletMesh &mesh, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+    };
+};
@@ -0,0 +1,246 @@
+#include "moving_spheres.h"
+#include "simd.h"
+
+namespace Collisions
+{
+    // ------------------------- M o v i n g   s p h e r e s ------------------------------
+
+    inline void _store(double (&destination)[3][MovingSpheres::BLOCK_SIZE], unsigned lane, const Vector &vector)
+    {
+        destination[0][lane] = vector.x;
+        destination[1][lane] = vector.y;
+        destination[2][lane] = vector.z;
+    }
+
+    inline Vector _load(const double (&source)[3][MovingSpheres::BLOCK_SIZE], unsigned lane)
+    {
+        return Vector( source[0][lane], source[1][lane], source[2][lane] );
+    }
+
+    void MovingSpheres::add(const Point &segment_start, const Point &segment_end, double sphere_radius)
+    {
+        const unsigned first_lane = count % BLOCK_SIZE;
+        if( first_lane == 0 )
+        {
+            blocks.push_back( Block() );
+        }
+        Block &block = blocks.back();
+        // fill the rest of the block too: padding lanes are copies of the last sphere
+        for( unsigned lane = first_lane; lane < BLOCK_SIZE; ++lane )
+        {
+            _store( block.start, lane, segment_start );
+            _store( block.way, lane, segment_end - segment_start );
+            block.radius[lane] = sphere_radius;
+        }
+        ++count;
+    }
+
+    void MovingSpheres::clear()
+    {
+        blocks.clear();
+        count = 0;
+    }
+
+    Point MovingSpheres::segment_start(unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        return _load( blocks[index/BLOCK_SIZE].start, index % BLOCK_SIZE );
+    }
+
+    Point MovingSpheres::segment_end(unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        const Block &block = blocks[index/BLOCK_SIZE];
+        return _load( block.start, index % BLOCK_SIZE ) + _load( block.way, index % BLOCK_SIZE );
+    }
+
+    double MovingSpheres::radius(unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        return blocks[index/BLOCK_SIZE].radius[index % BLOCK_SIZE];
+    }
+
+    // ----------------------------- P a i r   k e r n e l -------------------------------
+
+    // Tests Pack::WIDTH pairs of spheres. Returns mask of colliding pairs and writes time of impact for them.
+    // It is a branch-free version of sphere_and_sphere_collision: the nearest approach in relative motion
+    // and the entry time are computed for all lanes, and the case of no relative motion is chosen by masks.
+    template <class Pack>
+    inline typename Pack::Mask _sphere_pairs(const Simd::PackVector<Pack> &start1, const Simd::PackVector<Pack> &way1, Pack radius1,
+                                             const Simd::PackVector<Pack> &start2, const Simd::PackVector<Pack> &way2, Pack radius2,
+                                             /*out*/ Pack &time)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const Pack zero(0.0);
+        const Pack one(1.0);
+        const PackVector L = way1 - way2;
+        const PackVector w = start1 - start2;
+        const Pack radii_sum = radius1 + radius2;
+        const Pack a = dot( L, L );
+        const Pack b = dot( w, L );
+        const Pack c = dot( w, w ) - radii_sum*radii_sum;
+        const Mask moving = a > zero;
+
+        const Pack nearest_time = select( moving, min( max( -b/a, zero ), one ), zero );
+        const PackVector nearest = w + L*nearest_time;
+        const Pack nearest_distance = sqrt( dot( nearest, nearest ) );
+        const Mask hit = ( nearest_distance <= radii_sum ) | Simd::equal<DefaultTolerance>( nearest_distance, radii_sum );
+
+        const Pack entry_time = ( -b - sqrt( max( b*b - a*c, zero ) ) )/a; // earlier root
+        time = select( moving & ( c > zero ), min( max( entry_time, zero ), one ), zero );
+        return hit;
+    }
+
+    // the sphere broadcasted to all lanes
+    template <class Pack>
+    struct _PackSphere
+    {
+        Simd::PackVector<Pack> start;
+        Simd::PackVector<Pack> way;
+        Pack radius;
+
+        _PackSphere(const MovingSpheres::Block &block, unsigned lane)
+            : start( _load( block.start, lane ) ), way( _load( block.way, lane ) ), radius( block.radius[lane] )
+        {
+        }
+    };
+
+    template <class Pack>
+    inline Pack _lane_offsets()
+    {
+        double lane_offsets[Pack::WIDTH];
+        for( unsigned i = 0; i < Pack::WIDTH; ++i )
+        {
+            lane_offsets[i] = i;
+        }
+        return Pack::load( lane_offsets );
+    }
+
+    template <class Pack>
+    void _sphere_and_sphere_collisions(const MovingSpheres &spheres,
+                                       /*out*/ std::vector<SpherePairHit> &hits)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const Pack lane_offset = _lane_offsets<Pack>();
+        const Pack count( spheres.size() );
+        const unsigned BLOCK_SIZE = MovingSpheres::BLOCK_SIZE;
+
+        for( unsigned first = 0; first < spheres.size(); ++first )
+        {
+            const _PackSphere<Pack> sphere( spheres.block( first/BLOCK_SIZE ), first % BLOCK_SIZE );
+            const Pack first_index( first );
+            // from the block of the first sphere: lanes up to it are masked out by index
+            for( unsigned block_index = first/BLOCK_SIZE; block_index < spheres.blocks_count(); ++block_index )
+            {
+                const MovingSpheres::Block &block = spheres.block( block_index );
+                for( unsigned lane = 0; lane < BLOCK_SIZE; lane += Pack::WIDTH )
+                {
+                    COLLISIONS_COUNT_N( Counter::SpherePairsTested, Pack::WIDTH );
+                    const Pack second_index = Pack( block_index*BLOCK_SIZE + lane ) + lane_offset;
+                    Pack time;
+                    const Mask hit = _sphere_pairs( sphere.start, sphere.way, sphere.radius,
+                                                    PackVector::load( block.start, lane ), PackVector::load( block.way, lane ), Pack::load( &block.radius[lane] ),
+                                                    time ) &
+                                     ( second_index > first_index ) & ( second_index < count );
+                    if( !any( hit ) )
+                        continue;
+
+                    double times[Pack::WIDTH];
+                    time.store( times );
+                    const unsigned hit_bits = bits( hit );
+                    for( unsigned i = 0; i < Pack::WIDTH; ++i )
+                    {
+                        if( hit_bits & (1u << i) )
+                        {
+                            COLLISIONS_COUNT( Counter::SpherePairHits );
+                            const SpherePairHit pair_hit = { first, block_index*BLOCK_SIZE + lane + i, times[i] };
+                            hits.push_back( pair_hit );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    template <class Pack>
+    void _sphere_and_sphere_collisions(const MovingSpheres &spheres, const std::vector<SpherePair> &pairs,
+                                       /*out*/ std::vector<SpherePairHit> &hits)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const Pack lane_offset = _lane_offsets<Pack>();
+        const Pack count( static_cast<double>( pairs.size() ) );
+        const unsigned BLOCK_SIZE = MovingSpheres::BLOCK_SIZE;
+
+        // pairs are gathered by blocks: the last one is padded with copies of the last pair
+        MovingSpheres::Block firsts, seconds;
+        for( unsigned chunk = 0; chunk < pairs.size(); chunk += BLOCK_SIZE )
+        {
+            for( unsigned lane = 0; lane < BLOCK_SIZE; ++lane )
+            {
+                const SpherePair &pair = pairs[ std::min( chunk + lane, static_cast<unsigned>( pairs.size() ) - 1 ) ];
+                check( pair.first < spheres.size() && pair.second < spheres.size(), OutOfBoundsError() );
+                const MovingSpheres::Block &first = spheres.block( pair.first/BLOCK_SIZE );
+                const MovingSpheres::Block &second = spheres.block( pair.second/BLOCK_SIZE );
+                const unsigned first_lane = pair.first % BLOCK_SIZE;
+                const unsigned second_lane = pair.second % BLOCK_SIZE;
+                for( unsigned i = 0; i < 3; ++i )
+                {
+                    firsts.start[i][lane] = first.start[i][first_lane];
+                    firsts.way[i][lane] = first.way[i][first_lane];
+                    seconds.start[i][lane] = second.start[i][second_lane];
+                    seconds.way[i][lane] = second.way[i][second_lane];
+                }
+                firsts.radius[lane] = first.radius[first_lane];
+                seconds.radius[lane] = second.radius[second_lane];
+            }
+
+            for( unsigned lane = 0; lane < BLOCK_SIZE; lane += Pack::WIDTH )
+            {
+                COLLISIONS_COUNT_N( Counter::SpherePairsTested, Pack::WIDTH );
+                Pack time;
+                const Mask hit = _sphere_pairs( PackVector::load( firsts.start, lane ), PackVector::load( firsts.way, lane ), Pack::load( &firsts.radius[lane] ),
+                                                PackVector::load( seconds.start, lane ), PackVector::load( seconds.way, lane ), Pack::load( &seconds.radius[lane] ),
+                                                time ) &
+                                 ( Pack( chunk + lane ) + lane_offset < count );
+                if( !any( hit ) )
+                    continue;
+
+                double times[Pack::WIDTH];
+                time.store( times );
+                const unsigned hit_bits = bits( hit );
+                for( unsigned i = 0; i < Pack::WIDTH; ++i )
+                {
+                    if( hit_bits & (1u << i) )
+                    {
+                        COLLISIONS_COUNT( Counter::SpherePairHits );
+                        const SpherePair &pair = pairs[chunk + lane + i];
+                        const SpherePairHit pair_hit = { pair.first, pair.second, times[i] };
+                        hits.push_back( pair_hit );
+                    }
+                }
+            }
+        }
+    }
+
+    void sphere_and_sphere_collisions(const MovingSpheres &spheres,
+                                      /*out*/ std::vector<SpherePairHit> &hits)
+    {
+        COLLISIONS_COUNT( Counter::SpherePairBatchCalls );
+        hits.clear();
+        _sphere_and_sphere_collisions<Simd::DefaultPack>( spheres, hits );
+    }
+
+    void sphere_and_sphere_collisions(const MovingSpheres &spheres, const std::vector<SpherePair> &pairs,
+                                      /*out*/ std::vector<SpherePairHit> &hits)
+    {
+        COLLISIONS_COUNT( Counter::SpherePairBatchCalls );
+        hits.clear();
+        _sphere_and_sphere_collisions<Simd::DefaultPack>( spheres, pairs, hits );
+    }
+};
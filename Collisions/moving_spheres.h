@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include "collisions.h"
+
+namespace Collisions
+{
+    // Set of spheres moving along their segments at the same time, optimized for testing many pairs of
+    // them (see sphere_and_sphere_collision): like TriangleSoup, spheres are stored by blocks of BLOCK_SIZE,
+    // with every value of a block being an array with one element per sphere.
+    class MovingSpheres
+    {
+    public:
+        static const unsigned BLOCK_SIZE = 8;
+
+        struct Block
+        {
+            double start[3][BLOCK_SIZE]; // [coordinate][sphere]
+            double way[3][BLOCK_SIZE];   // from segment start to end
+            double radius[BLOCK_SIZE];
+        };
+    private:
+        // the last block is padded with copies of the last sphere
+        std::vector<Block> blocks;
+        unsigned count;
+    public:
+        MovingSpheres() : count(0) {}
+
+        // a sphere may stay in place: segment_start == segment_end
+        void add(const Point &segment_start, const Point &segment_end, double sphere_radius);
+        void clear();
+
+        unsigned size() const { return count; }
+        bool empty() const { return count == 0; }
+        Point segment_start(unsigned index) const;
+        Point segment_end(unsigned index) const;
+        double radius(unsigned index) const;
+
+        unsigned blocks_count() const { return static_cast<unsigned>( blocks.size() ); }
+        Block const & block(unsigned index) const
+        {
+            check( index < blocks.size(), OutOfBoundsError() );
+            return blocks[index];
+        }
+    };
+
+    // indices of two spheres of a MovingSpheres
+    struct SpherePair
+    {
+        unsigned first;
+        unsigned second;
+
+        SpherePair() : first(0), second(0) {}
+        SpherePair(unsigned first, unsigned second) : first(first), second(second) {}
+
+        bool operator==(const SpherePair &another) const
+        {
+            return first == another.first && second == another.second;
+        }
+        // by first, then by second sphere
+        bool operator<(const SpherePair &another) const
+        {
+            return first < another.first || ( first == another.first && second < another.second );
+        }
+    };
+
+    struct SpherePairHit
+    {
+        unsigned first;
+        unsigned second;
+        double time_of_impact; // the collision point is given by sphere_and_sphere_collision for the pair
+    };
+
+    // Tests all pairs of spheres (first < second) and writes those colliding, ordered by first, then by second
+    // sphere. The result is the same as of sphere_and_sphere_collision for every pair (within tolerance), but
+    // one sphere is tested against a whole block of others at once, with SIMD instructions. Unlike that function,
+    // two spheres both staying in place are not an error: they collide, if they intersect.
+    void sphere_and_sphere_collisions(const MovingSpheres &spheres,
+                                      /*out*/ std::vector<SpherePairHit> &hits);
+    // the same for the given pairs only: hits are in the order of pairs. Throws OutOfBoundsError for a wrong index
+    void sphere_and_sphere_collisions(const MovingSpheres &spheres, const std::vector<SpherePair> &pairs,
+                                      /*out*/ std::vector<SpherePairHit> &hits);
+};
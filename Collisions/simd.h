@@ -0,0 +1,298 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "floating_point.h"
+#include "vector.h"
+
+// Thin wrappers around SIMD registers of doubles, used by batch kernels.
+// Every pack type provides the same set of operations, so a kernel is written once
+// as a template and compiled for the widest instruction set available.
+// Include it only from translation units: pack layout depends on compiler flags.
+
+#if defined(__AVX2__)
+#define COLLISIONS_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define COLLISIONS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Collisions
+{
+    namespace Simd
+    {
+        // ------------------------- S c a l a r ---------------------------------------------
+        // a pack of one double: fallback for platforms without SIMD and a reference for the others
+
+        struct ScalarMask
+        {
+            bool value;
+            ScalarMask(bool value) : value(value) {}
+        };
+        inline ScalarMask operator&(ScalarMask a, ScalarMask b) { return a.value && b.value; }
+        inline ScalarMask operator|(ScalarMask a, ScalarMask b) { return a.value || b.value; }
+        inline ScalarMask operator!(ScalarMask a) { return !a.value; }
+        inline bool any(ScalarMask mask) { return mask.value; }
+        inline unsigned bits(ScalarMask mask) { return mask.value ? 1 : 0; }
+
+        struct ScalarPack
+        {
+            typedef ScalarMask Mask;
+            static const unsigned WIDTH = 1;
+
+            double value;
+
+            ScalarPack() {}
+            ScalarPack(double value) : value(value) {}
+            static ScalarPack load(const double *source) { return *source; }
+            void store(double *destination) const { *destination = value; }
+        };
+        inline ScalarPack operator+(ScalarPack a, ScalarPack b) { return a.value + b.value; }
+        inline ScalarPack operator-(ScalarPack a, ScalarPack b) { return a.value - b.value; }
+        inline ScalarPack operator*(ScalarPack a, ScalarPack b) { return a.value * b.value; }
+        inline ScalarPack operator/(ScalarPack a, ScalarPack b) { return a.value / b.value; }
+        inline ScalarPack operator-(ScalarPack a) { return -a.value; }
+        inline ScalarMask operator<(ScalarPack a, ScalarPack b) { return a.value < b.value; }
+        inline ScalarMask operator<=(ScalarPack a, ScalarPack b) { return a.value <= b.value; }
+        inline ScalarMask operator>(ScalarPack a, ScalarPack b) { return a.value > b.value; }
+        inline ScalarMask operator>=(ScalarPack a, ScalarPack b) { return a.value >= b.value; }
+        inline ScalarPack sqrt(ScalarPack a) { return std::sqrt( a.value ); }
+        inline ScalarPack abs(ScalarPack a) { return std::fabs( a.value ); }
+        inline ScalarPack min(ScalarPack a, ScalarPack b) { return std::min( a.value, b.value ); }
+        inline ScalarPack max(ScalarPack a, ScalarPack b) { return std::max( a.value, b.value ); }
+        // returns `if_true' where mask is set, `if_false' elsewhere
+        inline ScalarPack select(ScalarMask mask, ScalarPack if_true, ScalarPack if_false) { return mask.value ? if_true : if_false; }
+        // the same as Collisions::equal, lane by lane
+        template <class Tolerance>
+        inline ScalarMask equal(ScalarPack a, ScalarPack b) { return Collisions::equal<Tolerance>( a.value, b.value ); }
+
+#ifdef COLLISIONS_SIMD_SSE2
+        // --------------------------- S S E 2 -----------------------------------------------
+
+        struct Sse2Mask
+        {
+            __m128d value;
+            Sse2Mask(__m128d value) : value(value) {}
+        };
+        inline Sse2Mask operator&(Sse2Mask a, Sse2Mask b) { return _mm_and_pd( a.value, b.value ); }
+        inline Sse2Mask operator|(Sse2Mask a, Sse2Mask b) { return _mm_or_pd( a.value, b.value ); }
+        inline Sse2Mask operator!(Sse2Mask a) { return _mm_xor_pd( a.value, _mm_castsi128_pd( _mm_set1_epi32(-1) ) ); }
+        inline bool any(Sse2Mask mask) { return _mm_movemask_pd( mask.value ) != 0; }
+        inline unsigned bits(Sse2Mask mask) { return _mm_movemask_pd( mask.value ); }
+
+        struct Sse2Pack
+        {
+            typedef Sse2Mask Mask;
+            static const unsigned WIDTH = 2;
+
+            __m128d value;
+
+            Sse2Pack() {}
+            Sse2Pack(__m128d value) : value(value) {}
+            Sse2Pack(double value) : value( _mm_set1_pd(value) ) {}
+            static Sse2Pack load(const double *source) { return _mm_loadu_pd( source ); }
+            void store(double *destination) const { _mm_storeu_pd( destination, value ); }
+        };
+        inline Sse2Pack operator+(Sse2Pack a, Sse2Pack b) { return _mm_add_pd( a.value, b.value ); }
+        inline Sse2Pack operator-(Sse2Pack a, Sse2Pack b) { return _mm_sub_pd( a.value, b.value ); }
+        inline Sse2Pack operator*(Sse2Pack a, Sse2Pack b) { return _mm_mul_pd( a.value, b.value ); }
+        inline Sse2Pack operator/(Sse2Pack a, Sse2Pack b) { return _mm_div_pd( a.value, b.value ); }
+        inline Sse2Pack operator-(Sse2Pack a) { return _mm_xor_pd( a.value, _mm_set1_pd(-0.0) ); }
+        inline Sse2Mask operator<(Sse2Pack a, Sse2Pack b) { return _mm_cmplt_pd( a.value, b.value ); }
+        inline Sse2Mask operator<=(Sse2Pack a, Sse2Pack b) { return _mm_cmple_pd( a.value, b.value ); }
+        inline Sse2Mask operator>(Sse2Pack a, Sse2Pack b) { return _mm_cmpgt_pd( a.value, b.value ); }
+        inline Sse2Mask operator>=(Sse2Pack a, Sse2Pack b) { return _mm_cmpge_pd( a.value, b.value ); }
+        inline Sse2Pack sqrt(Sse2Pack a) { return _mm_sqrt_pd( a.value ); }
+        inline Sse2Pack abs(Sse2Pack a) { return _mm_andnot_pd( _mm_set1_pd(-0.0), a.value ); }
+        inline Sse2Pack min(Sse2Pack a, Sse2Pack b) { return _mm_min_pd( a.value, b.value ); }
+        inline Sse2Pack max(Sse2Pack a, Sse2Pack b) { return _mm_max_pd( a.value, b.value ); }
+        inline Sse2Pack select(Sse2Mask mask, Sse2Pack if_true, Sse2Pack if_false)
+        {
+            return _mm_or_pd( _mm_and_pd( mask.value, if_true.value ), _mm_andnot_pd( mask.value, if_false.value ) );
+        }
+
+        // SSE2 has no 64-bit shifts and compares: they are made of 32-bit ones
+
+        // sign of every 64-bit lane, spread over the lane
+        inline __m128i _sse2_sign_mask(__m128i value)
+        {
+            return _mm_shuffle_epi32( _mm_srai_epi32( value, 31 ), _MM_SHUFFLE(3,3,1,1) );
+        }
+
+        // see _ordered_bits in floating_point.h
+        inline __m128i _sse2_ordered_bits(__m128d value)
+        {
+            const __m128i bits = _mm_castpd_si128( value );
+            const __m128i sign_mask = _sse2_sign_mask( bits );
+            const __m128i magnitude = _mm_and_si128( bits, _mm_set1_epi64x( 0x7FFFFFFFFFFFFFFFLL ) );
+            return _mm_sub_epi64( _mm_xor_si128( magnitude, sign_mask ), sign_mask );
+        }
+
+        // mask of 64-bit lanes, which are not greater than `limit' as unsigned numbers (limit < 2^31 - 1)
+        inline __m128i _sse2_not_greater(__m128i value, int limit)
+        {
+            const __m128i low_fits = _mm_and_si128( _mm_cmpgt_epi32( _mm_set1_epi32( limit + 1 ), value ),
+                                                    _mm_cmpgt_epi32( value, _mm_set1_epi32( -1 ) ) );
+            const __m128i high_zero = _mm_cmpeq_epi32( value, _mm_setzero_si128() );
+            const __m128i halves = _mm_or_si128( _mm_and_si128( low_fits, _mm_set_epi32( 0, -1, 0, -1 ) ),
+                                                 _mm_and_si128( high_zero, _mm_set_epi32( -1, 0, -1, 0 ) ) );
+            return _mm_and_si128( halves, _mm_shuffle_epi32( halves, _MM_SHUFFLE(2,3,0,1) ) );
+        }
+
+        template <class Tolerance>
+        inline Sse2Mask equal(Sse2Pack a, Sse2Pack b)
+        {
+            static_assert( _ValidTolerance<Tolerance>::value, "" );
+            const __m128i difference = _mm_sub_epi64( _sse2_ordered_bits( a.value ), _sse2_ordered_bits( b.value ) );
+            const __m128i sign_mask = _sse2_sign_mask( difference );
+            const __m128i ulps = _mm_sub_epi64( _mm_xor_si128( difference, sign_mask ), sign_mask );
+            const __m128d near_in_ulps = _mm_castsi128_pd( _sse2_not_greater( ulps, static_cast<int>( Tolerance::max_ulps ) ) );
+            const __m128d near_in_epsilon = _mm_cmple_pd( abs( a - b ).value, _mm_set1_pd( Tolerance::epsilon ) );
+            return _mm_or_pd( near_in_epsilon, near_in_ulps );
+        }
+#endif //#ifdef COLLISIONS_SIMD_SSE2
+
+#ifdef COLLISIONS_SIMD_AVX2
+        // --------------------------- A V X 2 -----------------------------------------------
+
+        struct Avx2Mask
+        {
+            __m256d value;
+            Avx2Mask(__m256d value) : value(value) {}
+        };
+        inline Avx2Mask operator&(Avx2Mask a, Avx2Mask b) { return _mm256_and_pd( a.value, b.value ); }
+        inline Avx2Mask operator|(Avx2Mask a, Avx2Mask b) { return _mm256_or_pd( a.value, b.value ); }
+        inline Avx2Mask operator!(Avx2Mask a) { return _mm256_xor_pd( a.value, _mm256_castsi256_pd( _mm256_set1_epi32(-1) ) ); }
+        inline bool any(Avx2Mask mask) { return _mm256_movemask_pd( mask.value ) != 0; }
+        inline unsigned bits(Avx2Mask mask) { return _mm256_movemask_pd( mask.value ); }
+
+        struct Avx2Pack
+        {
+            typedef Avx2Mask Mask;
+            static const unsigned WIDTH = 4;
+
+            __m256d value;
+
+            Avx2Pack() {}
+            Avx2Pack(__m256d value) : value(value) {}
+            Avx2Pack(double value) : value( _mm256_set1_pd(value) ) {}
+            static Avx2Pack load(const double *source) { return _mm256_loadu_pd( source ); }
+            void store(double *destination) const { _mm256_storeu_pd( destination, value ); }
+        };
+        inline Avx2Pack operator+(Avx2Pack a, Avx2Pack b) { return _mm256_add_pd( a.value, b.value ); }
+        inline Avx2Pack operator-(Avx2Pack a, Avx2Pack b) { return _mm256_sub_pd( a.value, b.value ); }
+        inline Avx2Pack operator*(Avx2Pack a, Avx2Pack b) { return _mm256_mul_pd( a.value, b.value ); }
+        inline Avx2Pack operator/(Avx2Pack a, Avx2Pack b) { return _mm256_div_pd( a.value, b.value ); }
+        inline Avx2Pack operator-(Avx2Pack a) { return _mm256_xor_pd( a.value, _mm256_set1_pd(-0.0) ); }
+        inline Avx2Mask operator<(Avx2Pack a, Avx2Pack b) { return _mm256_cmp_pd( a.value, b.value, _CMP_LT_OQ ); }
+        inline Avx2Mask operator<=(Avx2Pack a, Avx2Pack b) { return _mm256_cmp_pd( a.value, b.value, _CMP_LE_OQ ); }
+        inline Avx2Mask operator>(Avx2Pack a, Avx2Pack b) { return _mm256_cmp_pd( a.value, b.value, _CMP_GT_OQ ); }
+        inline Avx2Mask operator>=(Avx2Pack a, Avx2Pack b) { return _mm256_cmp_pd( a.value, b.value, _CMP_GE_OQ ); }
+        inline Avx2Pack sqrt(Avx2Pack a) { return _mm256_sqrt_pd( a.value ); }
+        inline Avx2Pack abs(Avx2Pack a) { return _mm256_andnot_pd( _mm256_set1_pd(-0.0), a.value ); }
+        inline Avx2Pack min(Avx2Pack a, Avx2Pack b) { return _mm256_min_pd( a.value, b.value ); }
+        inline Avx2Pack max(Avx2Pack a, Avx2Pack b) { return _mm256_max_pd( a.value, b.value ); }
+        inline Avx2Pack select(Avx2Mask mask, Avx2Pack if_true, Avx2Pack if_false)
+        {
+            return _mm256_blendv_pd( if_false.value, if_true.value, mask.value );
+        }
+
+        // see _ordered_bits in floating_point.h
+        inline __m256i _avx2_ordered_bits(__m256d value)
+        {
+            const __m256i bits = _mm256_castpd_si256( value );
+            const __m256i sign_mask = _mm256_cmpgt_epi64( _mm256_setzero_si256(), bits );
+            const __m256i magnitude = _mm256_and_si256( bits, _mm256_set1_epi64x( 0x7FFFFFFFFFFFFFFFLL ) );
+            return _mm256_sub_epi64( _mm256_xor_si256( magnitude, sign_mask ), sign_mask );
+        }
+
+        template <class Tolerance>
+        inline Avx2Mask equal(Avx2Pack a, Avx2Pack b)
+        {
+            static_assert( _ValidTolerance<Tolerance>::value, "" );
+            const __m256i difference = _mm256_sub_epi64( _avx2_ordered_bits( a.value ), _avx2_ordered_bits( b.value ) );
+            const __m256i sign_mask = _mm256_cmpgt_epi64( _mm256_setzero_si256(), difference );
+            const __m256i ulps = _mm256_sub_epi64( _mm256_xor_si256( difference, sign_mask ), sign_mask );
+            // unsigned comparison: made signed by flipping the sign bits
+            const __m256i flip = _mm256_set1_epi64x( static_cast<long long>( 0x8000000000000000ULL ) );
+            const __m256i too_far = _mm256_cmpgt_epi64( _mm256_xor_si256( ulps, flip ), _mm256_xor_si256( _mm256_set1_epi64x( Tolerance::max_ulps ), flip ) );
+            const __m256d near_in_ulps = _mm256_castsi256_pd( _mm256_xor_si256( too_far, _mm256_set1_epi64x( -1 ) ) );
+            const __m256d near_in_epsilon = _mm256_cmp_pd( abs( a - b ).value, _mm256_set1_pd( Tolerance::epsilon ), _CMP_LE_OQ );
+            return _mm256_or_pd( near_in_epsilon, near_in_ulps );
+        }
+#endif //#ifdef COLLISIONS_SIMD_AVX2
+
+        // ------------------------- V e c t o r s -------------------------------------------
+        // three coordinates of Pack::WIDTH vectors
+
+        template <class Pack>
+        struct PackVector
+        {
+            Pack x, y, z;
+
+            PackVector() {}
+            PackVector(Pack x, Pack y, Pack z) : x(x), y(y), z(z) {}
+            explicit PackVector(const Vector &vector) : x(vector.x), y(vector.y), z(vector.z) {}
+
+            // from structure of arrays: [coordinate][lane]
+            template <unsigned N>
+            static PackVector load(const double (&source)[3][N], unsigned lane)
+            {
+                return PackVector( Pack::load( &source[0][lane] ), Pack::load( &source[1][lane] ), Pack::load( &source[2][lane] ) );
+            }
+        };
+
+        template <class Pack> inline PackVector<Pack> operator+(const PackVector<Pack> &a, const PackVector<Pack> &b)
+        {
+            return PackVector<Pack>( a.x + b.x, a.y + b.y, a.z + b.z );
+        }
+        template <class Pack> inline PackVector<Pack> operator-(const PackVector<Pack> &a, const PackVector<Pack> &b)
+        {
+            return PackVector<Pack>( a.x - b.x, a.y - b.y, a.z - b.z );
+        }
+        template <class Pack> inline PackVector<Pack> operator*(const PackVector<Pack> &a, Pack scalar)
+        {
+            return PackVector<Pack>( a.x*scalar, a.y*scalar, a.z*scalar );
+        }
+        template <class Pack> inline Pack dot(const PackVector<Pack> &a, const PackVector<Pack> &b)
+        {
+            return a.x*b.x + a.y*b.y + a.z*b.z;
+        }
+        template <class Pack> inline PackVector<Pack> cross_product(const PackVector<Pack> &a, const PackVector<Pack> &b)
+        {
+            return PackVector<Pack>( a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x );
+        }
+        template <class Pack> inline PackVector<Pack> select(typename Pack::Mask mask, const PackVector<Pack> &if_true, const PackVector<Pack> &if_false)
+        {
+            return PackVector<Pack>( select( mask, if_true.x, if_false.x ), select( mask, if_true.y, if_false.y ), select( mask, if_true.z, if_false.z ) );
+        }
+
+        // the widest pack available with current compiler flags
+#if defined(COLLISIONS_SIMD_AVX2)
+        typedef Avx2Pack DefaultPack;
+#elif defined(COLLISIONS_SIMD_SSE2)
+        typedef Sse2Pack DefaultPack;
+#else
+        typedef ScalarPack DefaultPack;
+#endif
+
+        // all three coordinates of vectors are equal (the same as Vector::equals): with AVX2 they are
+        // compared by one pack comparison, with SSE2 - by two
+        template <class Tolerance>
+        inline bool equal3(const Vector &a, const Vector &b)
+        {
+#if defined(COLLISIONS_SIMD_AVX2)
+            const Avx2Mask mask = equal<Tolerance>( Avx2Pack( _mm256_set_pd( 0, a.z, a.y, a.x ) ), Avx2Pack( _mm256_set_pd( 0, b.z, b.y, b.x ) ) );
+            return bits( mask ) == 0xF;
+#elif defined(COLLISIONS_SIMD_SSE2)
+            const Sse2Mask mask = equal<Tolerance>( Sse2Pack( _mm_set_pd( a.y, a.x ) ), Sse2Pack( _mm_set_pd( b.y, b.x ) ) ) &
+                                  equal<Tolerance>( Sse2Pack( _mm_set_pd( 0, a.z ) ), Sse2Pack( _mm_set_pd( 0, b.z ) ) );
+            return bits( mask ) == 0x3;
+#else
+            return Collisions::equal3<Tolerance>( a.x, a.y, a.z, b.x, b.y, b.z );
+#endif
+        }
+    };
+};
@@ -0,0 +1,595 @@
+#include "spatial_hash_grid.h"
+#include "collision_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Collisions
+{
+    const unsigned SpatialHashGrid::NO_CELL;
+    const double SpatialHashGrid::AUTO_CELL_PERCENTILE = 0.99;
+
+    // at most so many spheres are looked at to choose the cell size
+    const unsigned _CELL_SIZE_SAMPLES = 1024;
+    // boxes must be a bit smaller than cells, so that rounding of cell coordinates can't put
+    // spheres with intersecting boxes into cells, which are not neighbours
+    const double _CELL_MARGIN = 1.001;
+    // cell coordinates are clamped, so that far away spheres don't overflow them; until the layout of keys
+    // is chosen, they are biased to be positive and packed by 21 bits: any layout fits into 63 bits then
+    const int _CELL_COORDINATE_BIAS = 1 << 20;
+    const double _MAX_CELL_COORDINATE = _CELL_COORDINATE_BIAS - 2;
+    const unsigned _BIASED_COORDINATE_BITS = 21;
+    const unsigned long long _BIASED_COORDINATE_MASK = ( 1ull << _BIASED_COORDINATE_BITS ) - 1;
+    const unsigned long long _BIASED_LARGE_KEY = 1ull << 63;
+    // keys are sorted by digits of so many bits: a histogram of a part fits into the L1 cache
+    const unsigned _RADIX_BITS = 11;
+    const unsigned _RADIX_SIZE = 1 << _RADIX_BITS;
+    // parts of cells per thread for finding pairs by threads
+    const unsigned _PARTS_PER_THREAD = 8;
+
+    inline int _cell_coordinate(double value, double cell_size)
+    {
+        return static_cast<int>( std::max( -_MAX_CELL_COORDINATE, std::min( _MAX_CELL_COORDINATE, std::floor( value/cell_size ) ) ) );
+    }
+
+    inline double _extent(const BoundingBox &box)
+    {
+        const Vector size = box.size();
+        return std::max( size.x, std::max( size.y, size.z ) );
+    }
+
+    inline bool _less_min_x(const SpatialHashGrid::Item &a, const SpatialHashGrid::Item &b)
+    {
+        return a.box.min.x < b.box.min.x;
+    }
+
+    // the first element of the part, if `count' elements are divided into `parts_count' parts
+    inline unsigned _part_begin(unsigned count, unsigned part, unsigned parts_count)
+    {
+        return static_cast<unsigned>( static_cast<unsigned long long>( count )*part/parts_count );
+    }
+
+    // calls job(part) for all parts: on threads of the batch, if there is one
+    template <class Job>
+    void _run_parts(CollisionBatch *batch, unsigned parts_count, const Job &job)
+    {
+        if( batch == NULL )
+        {
+            for( unsigned part = 0; part < parts_count; ++part )
+            {
+                job( part );
+            }
+            return;
+        }
+        batch->run( parts_count, [&](unsigned begin, unsigned end)
+        {
+            for( unsigned part = begin; part < end; ++part )
+            {
+                job( part );
+            }
+        } );
+    }
+
+    // --------------------------------- R e b u i l d ------------------------------------
+
+    SpatialHashGrid::SpatialHashGrid(double cell_size)
+        : requested_cell_size(cell_size), current_cell_size(cell_size)
+    {
+        check( cell_size >= 0, InvalidCellSizeError() );
+        for( unsigned k = 0; k < 3; ++k )
+        {
+            origin[k] = 0;
+        }
+        for( unsigned k = 0; k < 4; ++k )
+        {
+            shifts[k] = 0;
+        }
+        cell_firsts.push_back( 0 );
+    }
+
+    void SpatialHashGrid::choose_cell_size(const MovingSpheres &spheres)
+    {
+        if( requested_cell_size != 0 )
+        {
+            current_cell_size = requested_cell_size;
+            return;
+        }
+        const unsigned count = spheres.size();
+        const unsigned samples_count = std::min( count, _CELL_SIZE_SAMPLES );
+        samples.clear();
+        for( unsigned i = 0; i < samples_count; ++i )
+        {
+            const unsigned index = static_cast<unsigned>( static_cast<unsigned long long>( count )*i/samples_count );
+            samples.push_back( _extent( bounding_box( spheres.segment_start( index ), spheres.segment_end( index ), spheres.radius( index ) ) ) );
+        }
+        double extent = 0;
+        if( !samples.empty() )
+        {
+            std::vector<double>::iterator percentile = samples.begin() + static_cast<unsigned>( AUTO_CELL_PERCENTILE*( samples.size() - 1 ) );
+            std::nth_element( samples.begin(), percentile, samples.end() );
+            extent = *percentile;
+        }
+        // spheres of zero size, staying in place: any size will do
+        current_cell_size = extent > 0 ? extent*_CELL_MARGIN : 1;
+    }
+
+    void SpatialHashGrid::compute_keys(const MovingSpheres &spheres, unsigned part)
+    {
+        const unsigned count = spheres.size();
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        Part &bounds = parts[part];
+        for( unsigned k = 0; k < 3; ++k )
+        {
+            bounds.min[k] = std::numeric_limits<int>::max();
+            bounds.max[k] = std::numeric_limits<int>::min();
+        }
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ); ++i )
+        {
+            // as segment_start and segment_end give them, without checking the index
+            const MovingSpheres::Block &block = spheres.block( i/MovingSpheres::BLOCK_SIZE );
+            const unsigned lane = i % MovingSpheres::BLOCK_SIZE;
+            const Point start( block.start[0][lane], block.start[1][lane], block.start[2][lane] );
+            const Point end = start + Vector( block.way[0][lane], block.way[1][lane], block.way[2][lane] );
+            Item &item = sphere_items[i];
+            item.box = bounding_box( start, end, block.radius[lane] );
+            item.index = i;
+
+            // biased coordinates, until the layout of keys is chosen
+            SortEntry &entry = entries[i];
+            entry.index = i;
+            if( _extent( item.box )*_CELL_MARGIN > current_cell_size )
+            {
+                entry.key = _BIASED_LARGE_KEY;
+                continue;
+            }
+            const Point center = item.box.center();
+            const int coordinates[3] = { _cell_coordinate( center.x, current_cell_size ), _cell_coordinate( center.y, current_cell_size ),
+                                         _cell_coordinate( center.z, current_cell_size ) };
+            entry.key = 0;
+            for( unsigned k = 0; k < 3; ++k )
+            {
+                bounds.min[k] = std::min( bounds.min[k], coordinates[k] );
+                bounds.max[k] = std::max( bounds.max[k], coordinates[k] );
+                entry.key |= static_cast<unsigned long long>( coordinates[k] + _CELL_COORDINATE_BIAS ) << ( k*_BIASED_COORDINATE_BITS );
+            }
+        }
+    }
+
+    void SpatialHashGrid::choose_key_layout()
+    {
+        unsigned shift = 0;
+        for( unsigned k = 0; k < 3; ++k )
+        {
+            int min = std::numeric_limits<int>::max(), max = std::numeric_limits<int>::min();
+            for( unsigned part = 0; part < parts.size(); ++part )
+            {
+                min = std::min( min, parts[part].min[k] );
+                max = std::max( max, parts[part].max[k] );
+            }
+            if( min > max )
+            {
+                // no cells
+                min = max = 0;
+            }
+            // coordinates in keys are from 1 to range + 1, and neighbours of cells on the border are within
+            // the same bits too: a neighbour of a cell never wraps around to another row
+            const long long range = static_cast<long long>( max ) - min;
+            unsigned bits = 1;
+            while( ( 1ll << bits ) <= range + 2 )
+            {
+                ++bits;
+            }
+            origin[k] = min - 1;
+            shifts[k] = shift;
+            shift += bits;
+        }
+        shifts[3] = shift;
+    }
+
+    unsigned long long SpatialHashGrid::key(int x, int y, int z) const
+    {
+        return static_cast<unsigned long long>( x - origin[0] ) << shifts[0] |
+               static_cast<unsigned long long>( y - origin[1] ) << shifts[1] |
+               static_cast<unsigned long long>( z - origin[2] ) << shifts[2];
+    }
+
+    void SpatialHashGrid::pack_keys(unsigned part)
+    {
+        // keys of the layout from biased coordinates; the histogram of the lowest digit is counted at once
+        const unsigned count = static_cast<unsigned>( entries.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        const unsigned long long large_key = 1ull << shifts[3];
+        unsigned *histogram = &histograms[part*_RADIX_SIZE];
+        std::fill( histogram, histogram + _RADIX_SIZE, 0u );
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ); ++i )
+        {
+            SortEntry &entry = entries[i];
+            if( entry.key == _BIASED_LARGE_KEY )
+            {
+                entry.key = large_key;
+            }
+            else
+            {
+                unsigned long long cell_key = 0;
+                for( unsigned k = 0; k < 3; ++k )
+                {
+                    const unsigned long long coordinate = ( entry.key >> ( k*_BIASED_COORDINATE_BITS ) ) & _BIASED_COORDINATE_MASK;
+                    cell_key |= ( coordinate - ( origin[k] + _CELL_COORDINATE_BIAS ) ) << shifts[k];
+                }
+                entry.key = cell_key;
+            }
+            ++histogram[ entry.key & (_RADIX_SIZE - 1) ];
+        }
+    }
+
+    void SpatialHashGrid::count_digits(const std::vector<SortEntry> &source, unsigned shift, unsigned part)
+    {
+        const unsigned count = static_cast<unsigned>( source.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        unsigned *histogram = &histograms[part*_RADIX_SIZE];
+        std::fill( histogram, histogram + _RADIX_SIZE, 0u );
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ); ++i )
+        {
+            ++histogram[ ( source[i].key >> shift ) & (_RADIX_SIZE - 1) ];
+        }
+    }
+
+    bool SpatialHashGrid::compute_offsets(unsigned count)
+    {
+        // entries with a digit go after those with lower digits, and, within the digit, in the order of parts,
+        // so that the sort is stable; if all entries have the same digit, the pass changes nothing
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        unsigned total = 0;
+        for( unsigned digit = 0; digit < _RADIX_SIZE; ++digit )
+        {
+            const unsigned digit_start = total;
+            for( unsigned part = 0; part < parts_count; ++part )
+            {
+                unsigned &counter = histograms[part*_RADIX_SIZE + digit];
+                const unsigned digit_count = counter;
+                counter = total;
+                total += digit_count;
+            }
+            if( total - digit_start == count )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SpatialHashGrid::scatter_digits(const std::vector<SortEntry> &source, unsigned shift, unsigned part, /*out*/ std::vector<SortEntry> &destination)
+    {
+        const unsigned count = static_cast<unsigned>( source.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        unsigned *offsets = &histograms[part*_RADIX_SIZE];
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ); ++i )
+        {
+            destination[ offsets[ ( source[i].key >> shift ) & (_RADIX_SIZE - 1) ]++ ] = source[i];
+        }
+    }
+
+    void SpatialHashGrid::sort_entries(CollisionBatch *batch)
+    {
+        // LSD radix sort: histograms of the lowest digit are already counted by pack_keys
+        const unsigned count = static_cast<unsigned>( entries.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        sorted_entries.resize( count );
+        for( unsigned shift = 0; shift <= shifts[3]; shift += _RADIX_BITS )
+        {
+            if( shift != 0 )
+            {
+                _run_parts( batch, parts_count, [&](unsigned part) { count_digits( entries, shift, part ); } );
+            }
+            if( compute_offsets( count ) )
+            {
+                _run_parts( batch, parts_count, [&](unsigned part) { scatter_digits( entries, shift, part, sorted_entries ); } );
+                entries.swap( sorted_entries );
+            }
+        }
+    }
+
+    void SpatialHashGrid::count_cells(unsigned part)
+    {
+        const unsigned count = static_cast<unsigned>( entries.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        const unsigned long long large_key = 1ull << shifts[3];
+        unsigned cells = 0;
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ); ++i )
+        {
+            if( entries[i].key != large_key && ( i == 0 || entries[i].key != entries[i - 1].key ) )
+            {
+                ++cells;
+            }
+        }
+        parts[part].cells_count = cells;
+    }
+
+    void SpatialHashGrid::collect_cells(unsigned part)
+    {
+        // cells_count of the part is the index of its first cell here
+        const unsigned count = static_cast<unsigned>( entries.size() );
+        const unsigned parts_count = static_cast<unsigned>( parts.size() );
+        const unsigned long long large_key = 1ull << shifts[3];
+        unsigned cell = parts[part].cells_count;
+        for( unsigned i = _part_begin( count, part, parts_count ); i < _part_begin( count, part + 1, parts_count ) && entries[i].key != large_key; ++i )
+        {
+            if( i == 0 || entries[i].key != entries[i - 1].key )
+            {
+                cell_keys[cell] = entries[i].key;
+                cell_firsts[cell] = i;
+                ++cell;
+            }
+            items[i] = sphere_items[ entries[i].index ];
+        }
+    }
+
+    void SpatialHashGrid::rebuild(const MovingSpheres &spheres, CollisionBatch *batch)
+    {
+        COLLISIONS_COUNT( Counter::HashGridRebuilds );
+        const unsigned count = spheres.size();
+        const unsigned parts_count = std::max( 1u, std::min( count, batch != NULL ? batch->threads_count() : 1u ) );
+        parts.resize( parts_count );
+        histograms.resize( parts_count*_RADIX_SIZE );
+        sphere_items.resize( count );
+        entries.resize( count );
+
+        choose_cell_size( spheres );
+        _run_parts( batch, parts_count, [&](unsigned part) { compute_keys( spheres, part ); } );
+        choose_key_layout();
+        _run_parts( batch, parts_count, [&](unsigned part) { pack_keys( part ); } );
+        sort_entries( batch );
+
+        // large spheres are sorted after all cells
+        unsigned items_count = count;
+        while( items_count > 0 && entries[items_count - 1].key == 1ull << shifts[3] )
+        {
+            --items_count;
+        }
+        _run_parts( batch, parts_count, [&](unsigned part) { count_cells( part ); } );
+        unsigned cells = 0;
+        for( unsigned part = 0; part < parts_count; ++part )
+        {
+            const unsigned part_cells = parts[part].cells_count;
+            parts[part].cells_count = cells;
+            cells += part_cells;
+        }
+        cell_keys.resize( cells );
+        cell_firsts.resize( cells + 1 );
+        cell_firsts[cells] = items_count;
+        items.resize( items_count );
+        _run_parts( batch, parts_count, [&](unsigned part) { collect_cells( part ); } );
+
+        large_items.clear();
+        for( unsigned i = items_count; i < count; ++i )
+        {
+            large_items.push_back( sphere_items[ entries[i].index ] );
+        }
+        std::sort( large_items.begin(), large_items.end(), _less_min_x );
+    }
+
+    void SpatialHashGrid::rebuild(const MovingSpheres &spheres)
+    {
+        rebuild( spheres, NULL );
+    }
+
+    void SpatialHashGrid::rebuild(const MovingSpheres &spheres, CollisionBatch &batch)
+    {
+        rebuild( spheres, &batch );
+    }
+
+    unsigned SpatialHashGrid::find_cell(int x, int y, int z) const
+    {
+        const int coordinates[3] = { x, y, z };
+        unsigned long long cell_key = 0;
+        for( unsigned k = 0; k < 3; ++k )
+        {
+            const long long relative = static_cast<long long>( coordinates[k] ) - origin[k];
+            if( relative < 0 || relative >= 1ll << ( shifts[k + 1] - shifts[k] ) )
+            {
+                return NO_CELL;
+            }
+            cell_key |= static_cast<unsigned long long>( relative ) << shifts[k];
+        }
+        const std::vector<unsigned long long>::const_iterator found = std::lower_bound( cell_keys.begin(), cell_keys.end(), cell_key );
+        return found != cell_keys.end() && *found == cell_key ? static_cast<unsigned>( found - cell_keys.begin() ) : NO_CELL;
+    }
+
+    SpatialHashGrid::Cell SpatialHashGrid::cell(unsigned index) const
+    {
+        check( index < cell_keys.size(), OutOfBoundsError() );
+        const unsigned long long cell_key = cell_keys[index];
+        int coordinates[3];
+        for( unsigned k = 0; k < 3; ++k )
+        {
+            coordinates[k] = static_cast<int>( ( cell_key >> shifts[k] ) & ( ( 1ull << ( shifts[k + 1] - shifts[k] ) ) - 1 ) ) + origin[k];
+        }
+        const Cell result = { coordinates[0], coordinates[1], coordinates[2], cell_firsts[index], cell_firsts[index + 1] - cell_firsts[index] };
+        return result;
+    }
+
+    // ---------------------------------- P a i r s ---------------------------------------
+
+    inline void _test_pair(const SpatialHashGrid::Item &a, const SpatialHashGrid::Item &b, /*out*/ std::vector<SpherePair> &pairs)
+    {
+        COLLISIONS_COUNT( Counter::HashGridPairsTested );
+        // as BoundingBox::intersects, but without branches: most tests fail on one of the axes, which is hard to predict
+        const bool intersects = ( a.box.min.x <= b.box.max.x ) & ( b.box.min.x <= a.box.max.x ) &
+                                ( a.box.min.y <= b.box.max.y ) & ( b.box.min.y <= a.box.max.y ) &
+                                ( a.box.min.z <= b.box.max.z ) & ( b.box.min.z <= a.box.max.z );
+        if( intersects )
+        {
+            pairs.push_back( a.index < b.index ? SpherePair( a.index, b.index ) : SpherePair( b.index, a.index ) );
+        }
+    }
+
+    // the first of sorted keys, which is not less than `key', searching from `from': the step doubles, so
+    // that a key close after `from' (like the next row of cells) is found in a few steps
+    inline unsigned _lower_bound_from(const std::vector<unsigned long long> &keys, unsigned from, unsigned long long key)
+    {
+        const unsigned size = static_cast<unsigned>( keys.size() );
+        unsigned low = from, high = from;
+        for( unsigned step = 1; high < size && keys[high] < key; step *= 2 )
+        {
+            low = high + 1;
+            high = std::min( size, low + step );
+        }
+        return static_cast<unsigned>( std::lower_bound( keys.begin() + low, keys.begin() + high, key ) - keys.begin() );
+    }
+
+    // tests items [a_begin, a_end) against items [b_begin, b_end)
+    inline void _test_items(const std::vector<SpatialHashGrid::Item> &items, unsigned a_begin, unsigned a_end, unsigned b_begin, unsigned b_end,
+                            /*out*/ std::vector<SpherePair> &pairs)
+    {
+        for( unsigned a = a_begin; a < a_end; ++a )
+        {
+            for( unsigned b = b_begin; b < b_end; ++b )
+            {
+                _test_pair( items[a], items[b], pairs );
+            }
+        }
+    }
+
+    void SpatialHashGrid::find_cell_pairs(unsigned begin, unsigned end, /*out*/ std::vector<SpherePair> &pairs) const
+    {
+        // half of the 26 neighbours of a cell, so that each pair of neighbours is looked at from one of them only:
+        // the next cell in the row, and cells from x - 1 to x + 1 in the rows (y + 1, z) and (y - 1 .. y + 1, z + 1).
+        // Cells of such a window are contiguous, and so are their spheres. As cells are sorted by keys, the first
+        // cells of windows only go forward: they are kept by cursors.
+        if( begin >= end )
+        {
+            return;
+        }
+        const unsigned cells = static_cast<unsigned>( cell_keys.size() );
+        const unsigned long long row = 1ull << shifts[1], layer = 1ull << shifts[2];
+        const unsigned long long window_offsets[4] = { row - 1, layer - row - 1, layer - 1, layer + row - 1 };
+        unsigned window_begins[4];
+        for( unsigned w = 0; w < 4; ++w )
+        {
+            window_begins[w] = static_cast<unsigned>( std::lower_bound( cell_keys.begin(), cell_keys.end(), cell_keys[begin] + window_offsets[w] ) - cell_keys.begin() );
+        }
+
+        for( unsigned i = begin; i < end; ++i )
+        {
+            const unsigned long long cell_key = cell_keys[i];
+            const unsigned first = cell_firsts[i], cell_end = cell_firsts[i + 1];
+            for( unsigned a = first; a < cell_end; ++a )
+            {
+                for( unsigned b = a + 1; b < cell_end; ++b )
+                {
+                    _test_pair( items[a], items[b], pairs );
+                }
+            }
+            if( i + 1 < cells && cell_keys[i + 1] == cell_key + 1 )
+            {
+                _test_items( items, first, cell_end, cell_end, cell_firsts[i + 2], pairs );
+            }
+            for( unsigned w = 0; w < 4; ++w )
+            {
+                const unsigned long long lowest = cell_key + window_offsets[w];
+                while( window_begins[w] < cells && cell_keys[ window_begins[w] ] < lowest )
+                {
+                    ++window_begins[w];
+                }
+                // a window has at most 3 cells: they are counted with no loop, which is hard to predict
+                unsigned window_end = window_begins[w];
+                for( unsigned k = 0; k < 3; ++k )
+                {
+                    window_end += window_end < cells && cell_keys[window_end] <= lowest + 2 ? 1 : 0;
+                }
+                _test_items( items, first, cell_end, cell_firsts[ window_begins[w] ], cell_firsts[window_end], pairs );
+            }
+        }
+    }
+
+    void SpatialHashGrid::find_large_pairs(/*out*/ std::vector<SpherePair> &pairs) const
+    {
+        // boxes of spheres in cells are at most cell/2 from their centers
+        const double reach = current_cell_size/2;
+        for( unsigned i = 0; i < large_items.size(); ++i )
+        {
+            const Item &large = large_items[i];
+            // large spheres are sorted by the min x of boxes: only those starting within this box may intersect it
+            for( unsigned j = i + 1; j < large_items.size() && large_items[j].box.min.x <= large.box.max.x; ++j )
+            {
+                _test_pair( large, large_items[j], pairs );
+            }
+            if( cell_keys.empty() )
+                continue;
+
+            // cells in reach of the box, within coordinates of cells with spheres
+            const BoundingBox range = large.box.inflated( reach );
+            const double range_min[3] = { range.min.x, range.min.y, range.min.z };
+            const double range_max[3] = { range.max.x, range.max.y, range.max.z };
+            int min[3], max[3];
+            bool is_outside = false;
+            for( unsigned k = 0; k < 3; ++k )
+            {
+                min[k] = std::max( _cell_coordinate( range_min[k], current_cell_size ), origin[k] + 1 );
+                max[k] = std::min( _cell_coordinate( range_max[k], current_cell_size ), origin[k] + ( 1 << ( shifts[k + 1] - shifts[k] ) ) - 2 );
+                is_outside = is_outside || min[k] > max[k];
+            }
+            if( is_outside )
+                continue;
+
+            const double rows_in_range = ( static_cast<double>( max[1] ) - min[1] + 1 )*( static_cast<double>( max[2] ) - min[2] + 1 );
+            if( rows_in_range > items.size() )
+            {
+                // looking up so many rows is slower than testing all spheres
+                for( unsigned j = 0; j < items.size(); ++j )
+                {
+                    _test_pair( large, items[j], pairs );
+                }
+                continue;
+            }
+            // rows of cells are in the order of keys: each is searched after the previous one
+            unsigned j = static_cast<unsigned>( std::lower_bound( cell_keys.begin(), cell_keys.end(), key( min[0], min[1], min[2] ) ) - cell_keys.begin() );
+            for( int z = min[2]; z <= max[2]; ++z )
+            {
+                for( int y = min[1]; y <= max[1]; ++y )
+                {
+                    // cells of the row from min x to max x are contiguous
+                    const unsigned long long last = key( max[0], y, z );
+                    for( j = _lower_bound_from( cell_keys, j, key( min[0], y, z ) ); j < cell_keys.size() && cell_keys[j] <= last; ++j )
+                    {
+                        for( unsigned k = cell_firsts[j]; k < cell_firsts[j + 1]; ++k )
+                        {
+                            _test_pair( large, items[k], pairs );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void SpatialHashGrid::find_pairs(/*out*/ std::vector<SpherePair> &pairs) const
+    {
+        pairs.clear();
+        find_cell_pairs( 0, static_cast<unsigned>( cell_keys.size() ), pairs );
+        find_large_pairs( pairs );
+    }
+
+    void SpatialHashGrid::find_pairs(/*out*/ std::vector<SpherePair> &pairs, CollisionBatch &batch) const
+    {
+        // cells are divided into parts with own outputs, which are joined then
+        const unsigned cells = static_cast<unsigned>( cell_keys.size() );
+        const unsigned parts = std::max( 1u, std::min( cells, batch.threads_count()*_PARTS_PER_THREAD ) );
+        part_pairs.resize( parts );
+        batch.run( parts, [&](unsigned begin, unsigned end)
+        {
+            for( unsigned part = begin; part < end; ++part )
+            {
+                part_pairs[part].clear();
+                find_cell_pairs( static_cast<unsigned>( static_cast<unsigned long long>( cells )*part/parts ),
+                                 static_cast<unsigned>( static_cast<unsigned long long>( cells )*(part + 1)/parts ), part_pairs[part] );
+            }
+        } );
+
+        pairs.clear();
+        find_large_pairs( pairs );
+        for( unsigned part = 0; part < parts; ++part )
+        {
+            pairs.insert( pairs.end(), part_pairs[part].begin(), part_pairs[part].end() );
+        }
+    }
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <vector>
+#include "bounding_box.h"
+#include "moving_spheres.h"
+
+namespace Collisions
+{
+    class CollisionBatch;
+
+    // Broadphase for many moving spheres of similar size: a uniform grid of cells, with each sphere kept
+    // in the cell of the center of its box (the box covers its whole way, see bounding_box). If the cell
+    // is not smaller than boxes, spheres with intersecting boxes are in the same or neighbouring cells.
+    // Only cells with spheres are stored: coordinates of a cell, relative to the lowest ones, are packed
+    // into a key with as many bits as they need (x in the lowest ones), and cells are sorted by keys. So cells
+    // of a row along x are contiguous, and neighbours of cells in the next rows are found by walking the keys
+    // forward, without lookups.
+    //
+    // Despite the name, this is a sorted-cell grid: cells are not hashed and there is no hash table. Sorted
+    // keys take its place (a single cell is found by binary search, see find_cell), so finding pairs is
+    // a linear walk over memory, and there is no table to size or clear on rebuilds.
+    //
+    // The grid is rebuilt from scratch every frame: spheres are radix sorted by keys of their cells, so that
+    // spheres of a cell are contiguous. The array is divided into parts, each with its own histograms,
+    // so that every pass of the sort (as well as computing keys and collecting cells) runs on threads of
+    // a batch. Buffers are kept between rebuilds, so there are no allocations once they have grown to the
+    // number of spheres.
+    class SpatialHashGrid
+    {
+    public:
+        static const unsigned NO_CELL = ~0u;
+        // Automatic cell size is the size of box (along its longest side), which is not exceeded by that
+        // part of spheres. The rest of them are tested against the cells around them one by one.
+        static const double AUTO_CELL_PERCENTILE;
+
+        struct Cell
+        {
+            int x, y, z;        // cell coordinates: floor of coordinates of a point / cell_size
+            unsigned first;     // spheres of the cell are item(first) .. item(first + count - 1)
+            unsigned count;
+        };
+
+        // sphere as stored in the grid
+        struct Item
+        {
+            BoundingBox box;    // of its whole way
+            unsigned index;     // in MovingSpheres
+        };
+    private:
+        // sphere with the key of its cell, as it is sorted
+        struct SortEntry
+        {
+            unsigned long long key;
+            unsigned index;
+        };
+
+        // a part of spheres (or of sorted entries) of rebuilding by threads
+        struct Part
+        {
+            int min[3];         // bounds of cell coordinates of spheres, which are not large
+            int max[3];
+            unsigned cells_count;
+        };
+
+        double requested_cell_size; // 0 for automatic
+        double current_cell_size;
+        int origin[3];              // cell coordinates of key 0
+        unsigned shifts[4];         // of coordinates in keys, and of the bit after them: the key of large spheres
+        std::vector<unsigned long long> cell_keys;  // of cells with spheres, sorted
+        std::vector<unsigned> cell_firsts;          // the first item of each cell, and the number of items
+        std::vector<Item> items;                    // spheres, sorted by cells
+        std::vector<Item> large_items;              // spheres with boxes bigger than a cell
+
+        // buffers of rebuilding
+        std::vector<Item> sphere_items;     // by sphere index
+        std::vector<SortEntry> entries;
+        std::vector<SortEntry> sorted_entries;
+        std::vector<Part> parts;
+        std::vector<unsigned> histograms;   // of digits of keys, one per part
+        std::vector<double> samples;
+        // buffers of finding pairs by threads
+        mutable std::vector< std::vector<SpherePair> > part_pairs;
+
+        void rebuild(const MovingSpheres &spheres, CollisionBatch *batch);
+        void choose_cell_size(const MovingSpheres &spheres);
+        void compute_keys(const MovingSpheres &spheres, unsigned part);
+        void choose_key_layout();
+        void pack_keys(unsigned part);
+        void count_digits(const std::vector<SortEntry> &source, unsigned shift, unsigned part);
+        bool compute_offsets(unsigned count);
+        void scatter_digits(const std::vector<SortEntry> &source, unsigned shift, unsigned part, /*out*/ std::vector<SortEntry> &destination);
+        void sort_entries(CollisionBatch *batch);
+        void count_cells(unsigned part);
+        void collect_cells(unsigned part);
+        unsigned long long key(int x, int y, int z) const;
+        void find_cell_pairs(unsigned begin, unsigned end, /*out*/ std::vector<SpherePair> &pairs) const;
+        void find_large_pairs(/*out*/ std::vector<SpherePair> &pairs) const;
+    public:
+        // cell_size == 0 means choosing it on every rebuild (see AUTO_CELL_PERCENTILE)
+        explicit SpatialHashGrid(double cell_size = 0);
+
+        void rebuild(const MovingSpheres &spheres);
+        // the same, with boxes and cells of spheres computed by threads of the batch
+        void rebuild(const MovingSpheres &spheres, CollisionBatch &batch);
+
+        // Finds pairs of spheres with intersecting boxes: candidates for sphere_and_sphere_collision (or,
+        // as they are, for sphere_and_sphere_collisions). Each pair is given once, with first < second,
+        // in no particular order.
+        void find_pairs(/*out*/ std::vector<SpherePair> &pairs) const;
+        void find_pairs(/*out*/ std::vector<SpherePair> &pairs, CollisionBatch &batch) const;
+
+        double cell_size() const { return current_cell_size; }
+        unsigned size() const { return static_cast<unsigned>( items.size() + large_items.size() ); }
+        unsigned cells_count() const { return static_cast<unsigned>( cell_keys.size() ); }
+        unsigned large_count() const { return static_cast<unsigned>( large_items.size() ); }
+
+        // index of the given cell (in the order of keys), or NO_CELL: a binary search over keys of cells
+        unsigned find_cell(int x, int y, int z) const;
+        Cell cell(unsigned index) const;
+        Item const & item(unsigned index) const
+        {
+            check( index < items.size(), OutOfBoundsError() );
+            return items[index];
+        }
+    };
+};
@@ -0,0 +1,317 @@
+#include "sphere_packet.h"
+#include "lane_kernels.h"
+#include "bounding_box.h"
+
+namespace Collisions
+{
+    // ------------------------- S p h e r e   p a c k e t --------------------------------
+
+    const unsigned SpherePacket::MAX_SIZE;
+
+    void SpherePacket::add(const Point &segment_start, const Point &segment_end, double sphere_radius)
+    {
+        check( count < MAX_SIZE, OutOfBoundsError() );
+        const Vector segment_way = segment_end - segment_start;
+        // fill the rest of the packet too: padding lanes are copies of the last sphere
+        for( unsigned lane = count; lane < MAX_SIZE; ++lane )
+        {
+            start[0][lane] = segment_start.x;
+            start[1][lane] = segment_start.y;
+            start[2][lane] = segment_start.z;
+            way[0][lane] = segment_way.x;
+            way[1][lane] = segment_way.y;
+            way[2][lane] = segment_way.z;
+            radius[lane] = sphere_radius;
+        }
+        ++count;
+    }
+
+    Point SpherePacket::segment_start(unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        return Point( start[0][index], start[1][index], start[2][index] );
+    }
+
+    Point SpherePacket::segment_end(unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        return segment_start( index ) + Vector( way[0][index], way[1][index], way[2][index] );
+    }
+
+    // ----------------------------- T r a v e r s a l -----------------------------------
+
+    // a triangle, broadcasted to all lanes (see _sweep_lanes in lane_kernels.h)
+    template <class Pack>
+    struct _TriangleLanes
+    {
+        typedef Simd::PackVector<Pack> PackVector;
+
+        PackVector vertices[3];
+        PackVector sides[3];
+        PackVector side_normals[3];
+        PackVector plane_normal;
+        PackVector basis_u;
+        PackVector basis_v;
+        Pack plane_offset;
+
+        explicit _TriangleLanes(const PreparedTriangle &triangle)
+            : plane_normal( triangle.normal() ), basis_u( triangle.barycentric_basis(0) ), basis_v( triangle.barycentric_basis(1) ),
+              plane_offset( triangle.plane_offset() )
+        {
+            for( unsigned i = 0; i < 3; ++i )
+            {
+                vertices[i] = PackVector( triangle[i] );
+                sides[i] = PackVector( triangle.side(i) );
+                side_normals[i] = PackVector( triangle.side_outer_normal(i) );
+            }
+        }
+
+        PackVector const & vertex(unsigned i) const { return vertices[i]; }
+        PackVector const & side(unsigned i) const { return sides[i]; }
+        PackVector const & side_normal(unsigned i) const { return side_normals[i]; }
+        PackVector const & normal() const { return plane_normal; }
+        PackVector const & dual_u() const { return basis_u; }
+        PackVector const & dual_v() const { return basis_v; }
+        Pack offset() const { return plane_offset; }
+    };
+
+    // Sweeps of the packet by chunks of Pack::WIDTH lanes and the earliest collisions found so far.
+    // Lanes, which take no part in the sweep (beyond the size of the packet, or with degenerated segments),
+    // have the best time of minus infinity: their boxes are always missed and no collision is earlier.
+    template <class Pack>
+    struct _PacketSweep
+    {
+        static const unsigned CHUNKS_COUNT = SpherePacket::MAX_SIZE/Pack::WIDTH;
+
+        const SpherePacket &packet;
+        unsigned chunks_count;          // chunks with any lanes of the packet
+        unsigned active_lanes;          // bit per lane
+        _SweepQuery<Pack> queries[CHUNKS_COUNT];
+        // segments against boxes (see BoxRay), by coordinate: a box is touched, when the segment enters the slab
+        // between box.min - radius and box.max + radius, so that the radius is added to starts once per sweep
+        Pack min_starts[CHUNKS_COUNT][3];       // start + radius
+        Pack max_starts[CHUNKS_COUNT][3];       // start - radius
+        Pack inverse_ways[CHUNKS_COUNT][3];     // 1/way (infinite for zero coordinates)
+        bool parallel[CHUNKS_COUNT];            // any lane of the chunk has a zero coordinate of its way
+        Pack best_times[CHUNKS_COUNT];
+        Pack best_indices[CHUNKS_COUNT];                   // in the hierarchy, -1 before the first hit
+        Simd::PackVector<Pack> best_points[CHUNKS_COUNT];
+
+        explicit _PacketSweep(const SpherePacket &packet) : packet(packet), active_lanes(0)
+        {
+            static_assert( SpherePacket::MAX_SIZE % Pack::WIDTH == 0, "a packet is made of whole packs" );
+
+            double times[SpherePacket::MAX_SIZE];
+            for( unsigned i = 0; i < SpherePacket::MAX_SIZE; ++i )
+            {
+                const bool active = i < packet.size() && packet.segment_start( i ) != packet.segment_end( i );
+                times[i] = active ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+                active_lanes |= active ? 1u << i : 0;
+            }
+            chunks_count = ( packet.size() + Pack::WIDTH - 1 )/Pack::WIDTH;
+            const Pack zero(0.0);
+            const Pack one(1.0);
+            for( unsigned chunk = 0; chunk < chunks_count; ++chunk )
+            {
+                const unsigned lane = chunk*Pack::WIDTH;
+                queries[chunk] = _SweepQuery<Pack>( packet.start, packet.way, packet.radius, lane );
+                const _SweepQuery<Pack> &query = queries[chunk];
+                const Pack starts[3] = { query.start.x, query.start.y, query.start.z };
+                const Pack ways[3] = { query.vector.x, query.vector.y, query.vector.z };
+                parallel[chunk] = false;
+                for( unsigned i = 0; i < 3; ++i )
+                {
+                    min_starts[chunk][i] = starts[i] + query.radius;
+                    max_starts[chunk][i] = starts[i] - query.radius;
+                    inverse_ways[chunk][i] = one/ways[i];
+                    parallel[chunk] = parallel[chunk] || any( !( ( ways[i] < zero ) | ( ways[i] > zero ) ) );
+                }
+                best_times[chunk] = Pack::load( &times[lane] );
+                best_indices[chunk] = Pack(-1.0);
+                best_points[chunk] = queries[chunk].start;
+            }
+        }
+
+        // Returns lanes of `lanes', whose spheres touch the box before their earliest collision found so far:
+        // segment_and_box_collision with the box inflated by radius of each lane.
+        unsigned box_lanes(const BoundingBox &box, unsigned lanes) const
+        {
+            const double mins[3] = { box.min.x, box.min.y, box.min.z };
+            const double maxs[3] = { box.max.x, box.max.y, box.max.z };
+            unsigned result = 0;
+            for( unsigned chunk = 0; chunk < chunks_count; ++chunk )
+            {
+                const unsigned lane = chunk*Pack::WIDTH;
+                if( ( ( lanes >> lane ) & ( ( 1u << Pack::WIDTH ) - 1 ) ) == 0 )
+                    continue;
+
+                Pack enter(0.0);
+                Pack leave = min( best_times[chunk], Pack(1.0) );
+                for( unsigned i = 0; i < 3; ++i )
+                {
+                    const Pack box_min( mins[i] );
+                    const Pack box_max( maxs[i] );
+                    const Pack t1 = ( box_min - min_starts[chunk][i] )*inverse_ways[chunk][i];
+                    const Pack t2 = ( box_max - max_starts[chunk][i] )*inverse_ways[chunk][i];
+                    if( !parallel[chunk] )
+                    {
+                        enter = max( enter, min( t1, t2 ) );
+                        leave = min( leave, max( t1, t2 ) );
+                        continue;
+                    }
+                    // parallel to the slab: either always inside it, or never (and the times may be not numbers)
+                    const Pack zero(0.0);
+                    const Pack infinity( std::numeric_limits<double>::infinity() );
+                    const Pack way = i == 0 ? queries[chunk].vector.x : i == 1 ? queries[chunk].vector.y : queries[chunk].vector.z;
+                    const typename Pack::Mask parallel_lanes = !( ( way < zero ) | ( way > zero ) );
+                    const typename Pack::Mask inside = ( min_starts[chunk][i] >= box_min ) & ( max_starts[chunk][i] <= box_max );
+                    enter = max( enter, select( parallel_lanes, -infinity, min( t1, t2 ) ) );
+                    leave = min( leave, select( parallel_lanes, select( inside, infinity, -infinity ), max( t1, t2 ) ) );
+                }
+                result |= bits( enter <= leave ) << lane;
+            }
+            return result & lanes;
+        }
+
+        // tests the triangle (number `index' in the hierarchy) against chunks with any of `lanes'
+        void triangle(const PreparedTriangle &triangle, unsigned index, unsigned lanes)
+        {
+            COLLISIONS_COUNT( Counter::PacketTrianglesTested );
+
+            // Most triangles of a leaf are missed: the kernel is skipped for chunks, whose spheres never come near
+            // the plane of the triangle
+            const Simd::PackVector<Pack> normal( triangle.normal() );
+            const Pack offset( triangle.plane_offset() );
+            unsigned near_chunks = 0;
+            for( unsigned chunk = 0; chunk < chunks_count; ++chunk )
+            {
+                if( ( ( lanes >> chunk*Pack::WIDTH ) & ( ( 1u << Pack::WIDTH ) - 1 ) ) == 0 )
+                    continue;
+
+                if( any( _near_plane( normal, offset, queries[chunk], Pack(1.0) ) ) )
+                {
+                    near_chunks |= 1u << chunk;
+                }
+            }
+            if( near_chunks == 0 )
+                return;
+
+            const _TriangleLanes<Pack> triangle_lanes( triangle );
+            for( unsigned chunk = 0; chunk < chunks_count; ++chunk )
+            {
+                if( ( near_chunks & ( 1u << chunk ) ) == 0 )
+                    continue;
+
+                Pack time;
+                Simd::PackVector<Pack> point;
+                const typename Pack::Mask hit = _sweep_lanes( triangle_lanes, queries[chunk], time, point );
+                const typename Pack::Mask better = hit & ( time < best_times[chunk] );
+                best_times[chunk] = select( better, time, best_times[chunk] );
+                best_indices[chunk] = select( better, Pack( index ), best_indices[chunk] );
+                best_points[chunk] = select( better, point, best_points[chunk] );
+            }
+        }
+    };
+
+    // node, waiting for traversal, and lanes, which touched its parent
+    struct _PacketItem
+    {
+        unsigned node;
+        unsigned lanes;
+    };
+
+    template <class Pack>
+    void _sweep_packet(const BvhView &mesh, const SpherePacket &packet, /*out*/ BatchResult *results)
+    {
+        _PacketSweep<Pack> sweep( packet );
+
+        // the stack holds both children of every node on the path, as boxes are tested when popped,
+        // against the earliest collisions found by then
+        _PacketItem stack[MeshBVH::MAX_DEPTH + 2];
+        unsigned stack_size = 0;
+        if( mesh.nodes_count != 0 && sweep.active_lanes != 0 )
+        {
+            stack[stack_size].node = 0;
+            stack[stack_size].lanes = sweep.active_lanes;
+            ++stack_size;
+        }
+        while( stack_size > 0 )
+        {
+            const _PacketItem item = stack[--stack_size];
+            const MeshBVH::Node &node = mesh.nodes[item.node];
+            const unsigned lanes = sweep.box_lanes( node.box, item.lanes );
+            if( lanes == 0 )
+            {
+                continue;
+            }
+
+            COLLISIONS_COUNT( Counter::BvhNodesVisited );
+            if( node.is_leaf() )
+            {
+                COLLISIONS_COUNT( Counter::BvhLeavesVisited );
+                for( unsigned i = node.first; i < node.first + node.count; ++i )
+                {
+                    sweep.triangle( mesh.triangles[i], i, lanes );
+                }
+                continue;
+            }
+
+            // push the farther child first along the way of the first lane, so that the nearer one is visited first
+            unsigned first_lane = 0;
+            while( ( lanes & ( 1u << first_lane ) ) == 0 )
+            {
+                ++first_lane;
+            }
+            const Vector way( packet.way[0][first_lane], packet.way[1][first_lane], packet.way[2][first_lane] );
+            const bool left_first = ( mesh.nodes[node.first + 1].box.center() - mesh.nodes[node.first].box.center() )*way >= 0;
+            stack[stack_size].node = left_first ? node.first + 1 : node.first;
+            stack[stack_size].lanes = lanes;
+            ++stack_size;
+            stack[stack_size].node = left_first ? node.first : node.first + 1;
+            stack[stack_size].lanes = lanes;
+            ++stack_size;
+        }
+
+        double times[SpherePacket::MAX_SIZE], indices[SpherePacket::MAX_SIZE];
+        double xs[SpherePacket::MAX_SIZE], ys[SpherePacket::MAX_SIZE], zs[SpherePacket::MAX_SIZE];
+        for( unsigned chunk = 0; chunk < sweep.chunks_count; ++chunk )
+        {
+            const unsigned lane = chunk*Pack::WIDTH;
+            sweep.best_times[chunk].store( &times[lane] );
+            sweep.best_indices[chunk].store( &indices[lane] );
+            sweep.best_points[chunk].x.store( &xs[lane] );
+            sweep.best_points[chunk].y.store( &ys[lane] );
+            sweep.best_points[chunk].z.store( &zs[lane] );
+        }
+        for( unsigned i = 0; i < packet.size(); ++i )
+        {
+            if( ( sweep.active_lanes & ( 1u << i ) ) == 0 )
+            {
+                results[i].status = CollisionStatus::DegenerateSegment;
+                continue;
+            }
+            if( indices[i] < 0 )
+            {
+                results[i].status = CollisionStatus::Miss;
+                continue;
+            }
+            SweepHit &hit = results[i].hit;
+            hit.time = times[i];
+            hit.triangle_index = mesh.original_indices[ static_cast<unsigned>( indices[i] ) ];
+            hit.collision_point = Point( xs[i], ys[i], zs[i] );
+            hit.sphere_center = packet.segment_start( i ) + hit.time*Vector( packet.way[0][i], packet.way[1][i], packet.way[2][i] );
+            results[i].status = CollisionStatus::Hit;
+        }
+    }
+
+    void sweep_sphere(const MeshBVH &mesh, const SpherePacket &packet, /*out*/ BatchResult *results)
+    {
+        sweep_sphere( mesh.view(), packet, results );
+    }
+
+    void sweep_sphere(const BvhView &mesh, const SpherePacket &packet, /*out*/ BatchResult *results)
+    {
+        COLLISIONS_COUNT( Counter::PacketSweepCalls );
+        _sweep_packet<Simd::DefaultPack>( mesh, packet, results );
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "mesh_bvh.h"
+#include "collision_batch.h"
+
+namespace Collisions
+{
+    // Bundle of sweeps, which go close to each other (like a spread of projectiles or probes from the same
+    // origin), for sweeping through a mesh hierarchy together. Like MovingSpheres, every value is an array
+    // with one element per sweep (a lane), so that SIMD instructions process several sweeps at once.
+    class SpherePacket
+    {
+    public:
+        static const unsigned MAX_SIZE = 8;
+
+        // lanes after the last sphere are padded with copies of it
+        double start[3][MAX_SIZE];  // [coordinate][sweep]
+        double way[3][MAX_SIZE];    // from segment start to end
+        double radius[MAX_SIZE];
+    private:
+        unsigned count;
+    public:
+        SpherePacket() : count(0) {}
+
+        // throws OutOfBoundsError, when the packet is full
+        void add(const Point &segment_start, const Point &segment_end, double sphere_radius);
+        void clear() { count = 0; }
+
+        unsigned size() const { return count; }
+        bool empty() const { return count == 0; }
+        Point segment_start(unsigned index) const;
+        Point segment_end(unsigned index) const;
+    };
+
+    // Sweeps every sphere of the packet against the mesh and finds its earliest collision, as sweep_sphere for
+    // MeshBVH does for one sphere; results[i] (at least packet.size() of them) is for sphere i. Status of a sphere
+    // with degenerated segment is DegenerateSegment, and it takes no part in the sweep.
+    //
+    // The hierarchy is traversed once for the whole packet: a node is tested against all spheres, which still
+    // may hit anything in it (active lanes), and skipped only when none of them does. Every triangle of a visited
+    // leaf is read once and tested against all active spheres by a lane-parallel version of the sphere and triangle
+    // test (the same as that of TriangleSoup). Nodes are visited front to back along the way of the first active
+    // sphere, so the packet pays off when its spheres go the same way: the more they diverge, the more nodes
+    // are visited for a few of them only.
+    void sweep_sphere(const MeshBVH &mesh, const SpherePacket &packet, /*out*/ BatchResult *results);
+    void sweep_sphere(const BvhView &mesh, const SpherePacket &packet, /*out*/ BatchResult *results);
+};
@@ -0,0 +1,140 @@
+#include "stats.h"
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace Collisions
+{
+    // counters of living threads, and the sums of finished ones
+    struct _StatsRegistry
+    {
+        std::mutex mutex;
+        std::vector<_ThreadCounters *> threads;
+        Stats finished;
+        Stats baseline; // totals at the last reset_stats()
+
+        _StatsRegistry()
+        {
+            std::fill( finished.counters, finished.counters + COUNTERS_COUNT, 0 );
+            std::fill( baseline.counters, baseline.counters + COUNTERS_COUNT, 0 );
+        }
+
+        // requires the mutex locked
+        Stats totals() const
+        {
+            Stats result = finished;
+            for( unsigned i = 0; i < threads.size(); ++i )
+            {
+                for( unsigned j = 0; j < COUNTERS_COUNT; ++j )
+                {
+                    result.counters[j] += threads[i]->values[j].load( std::memory_order_relaxed );
+                }
+            }
+            return result;
+        }
+    };
+
+    // never destroyed: threads may finish after static destructors are run
+    _StatsRegistry & _registry()
+    {
+        static _StatsRegistry *registry = new _StatsRegistry();
+        return *registry;
+    }
+
+    _ThreadCounters::_ThreadCounters()
+    {
+        for( unsigned i = 0; i < COUNTERS_COUNT; ++i )
+        {
+            values[i].store( 0, std::memory_order_relaxed );
+        }
+        _StatsRegistry &registry = _registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        registry.threads.push_back( this );
+    }
+
+    _ThreadCounters::~_ThreadCounters()
+    {
+        _StatsRegistry &registry = _registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        for( unsigned i = 0; i < COUNTERS_COUNT; ++i )
+        {
+            registry.finished.counters[i] += values[i].load( std::memory_order_relaxed );
+        }
+        registry.threads.erase( std::find( registry.threads.begin(), registry.threads.end(), this ) );
+    }
+
+    bool stats_enabled()
+    {
+#ifdef COLLISIONS_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Stats stats()
+    {
+        _StatsRegistry &registry = _registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        Stats result = registry.totals();
+        for( unsigned i = 0; i < COUNTERS_COUNT; ++i )
+        {
+            result.counters[i] -= registry.baseline.counters[i];
+        }
+        return result;
+    }
+
+    void reset_stats()
+    {
+        _StatsRegistry &registry = _registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        registry.baseline = registry.totals();
+    }
+
+    const char * counter_name(Counter counter)
+    {
+        static const char * const names[] =
+        {
+            "LineAndPlaneCalls", "LineAndPlaneHits",
+            "SegmentAndPlaneCalls", "SegmentAndPlaneHits",
+            "SegmentAndTriangleCalls", "SegmentAndTriangleHits",
+            "SphereAndPlaneCalls", "SphereAndPlaneHits",
+            "SphereAndPointCalls", "SphereAndPointHits",
+            "SphereAndSegmentCalls", "SphereAndSegmentHits",
+            "SphereAndTriangleCalls", "SphereAndTriangleHits",
+            "SphereAndSphereCalls", "SphereAndSphereHits",
+            "TriangleKernelCalls", "TrianglePlaneRejects", "TrianglePlaneHits", "TrianglePlaneOutside",
+            "TriangleEdgeTests", "TriangleEdgesMovingOutside", "TriangleEdgeHits",
+            "TriangleVertexTests", "TriangleVertexHits", "TriangleMisses",
+            "SweepCalls", "SweepTrianglesTested",
+            "RaycastCalls", "RayTrianglesTested",
+            "ClosestPointCalls", "ClosestPointTrianglesTested",
+            "SoupSweepCalls", "SoupBlocksTested", "SoupLanesSwept",
+            "BvhSweepCalls", "BvhClosestPointCalls", "BvhNodesVisited", "BvhLeavesVisited",
+            "MeshSweepCalls", "MeshFacesTested", "MeshEdgesTested", "MeshVerticesTested",
+            "InstanceSweepCalls", "InstancesTested",
+            "PacketSweepCalls", "PacketTrianglesTested",
+            "FieldSweepCalls", "FieldSteps", "FieldWindows",
+            "MeshletSweepCalls", "MeshletsCulledByBounds", "MeshletsCulledByCone", "MeshletsTested",
+            "SpherePairBatchCalls", "SpherePairsTested", "SpherePairHits",
+            "SweepAndPruneUpdates", "SweepAndPruneSwaps",
+            "HashGridRebuilds", "HashGridPairsTested",
+            "ErrorsThrown",
+        };
+        static_assert( sizeof(names)/sizeof(names[0]) == COUNTERS_COUNT, "a name is needed for every counter" );
+        const unsigned index = static_cast<unsigned>( counter );
+        return index < COUNTERS_COUNT ? names[index] : "Unknown";
+    }
+
+    std::ostream &operator<<(std::ostream &stream, const Stats &stats)
+    {
+        for( unsigned i = 0; i < COUNTERS_COUNT; ++i )
+        {
+            if( stats.counters[i] != 0 )
+            {
+                stream << counter_name( static_cast<Counter>( i ) ) << ": " << stats.counters[i] << std::endl;
+            }
+        }
+        return stream;
+    }
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+
+// Hot-path counters: calls and outcomes of collision finders, stages of the sphere and triangle
+// kernel, work done by sweeps and thrown errors. They are compiled in only if COLLISIONS_STATS
+// is defined (see COLLISIONS_STATS option in CMakeLists.txt); otherwise COLLISIONS_COUNT macros
+// expand to nothing and stats() returns zeros.
+//
+// Every thread increments its own counters without synchronization; stats() sums them over
+// all threads, including finished ones.
+
+namespace Collisions
+{
+    enum class Counter
+    {
+        // collision finders (including NoThrow ones): calls and hits
+        LineAndPlaneCalls,
+        LineAndPlaneHits,
+        SegmentAndPlaneCalls,
+        SegmentAndPlaneHits,
+        SegmentAndTriangleCalls,
+        SegmentAndTriangleHits,
+        SphereAndPlaneCalls,
+        SphereAndPlaneHits,
+        SphereAndPointCalls,
+        SphereAndPointHits,
+        SphereAndSegmentCalls,
+        SphereAndSegmentHits,
+        SphereAndTriangleCalls,
+        SphereAndTriangleHits,
+        SphereAndSphereCalls,
+        SphereAndSphereHits,
+
+        // stages of sphere and triangle kernel, called by finders and sweeps
+        TriangleKernelCalls,
+        TrianglePlaneRejects,       // the sphere never comes near the plane (fused kernel only)
+        TrianglePlaneHits,          // resolved by the plane (step 1)
+        TrianglePlaneOutside,       // plane is touched outside the triangle
+        TriangleEdgeTests,          // sphere and segment tests (step 2): three per fall-through, or only sides the sphere moves inside through
+        TriangleEdgesMovingOutside, // side is touched, but the sphere is moving outside through it (decomposed kernel only)
+        TriangleEdgeHits,           // resolved by sides
+        TriangleVertexTests,        // sphere and point tests (step 3): three per fall-through, or only vertices between such sides
+        TriangleVertexHits,         // resolved by vertices
+        TriangleMisses,
+
+        // sweeps
+        SweepCalls,            // sweeps over triangle arrays (BVH leaves included)
+        SweepTrianglesTested,
+        RaycastCalls,          // casts over triangle arrays and soups (BVH leaves included)
+        RayTrianglesTested,    // triangles of arrays, or lanes of soup blocks
+        ClosestPointCalls,     // closest point queries over triangle arrays
+        ClosestPointTrianglesTested, // triangles of arrays and BVH leaves
+        SoupSweepCalls,
+        SoupBlocksTested,
+        SoupLanesSwept,        // lanes of soup blocks near the sphere way, run through the sweep kernel
+        BvhSweepCalls,
+        BvhClosestPointCalls,  // traversals for one point or a group of points
+        BvhNodesVisited,
+        BvhLeavesVisited,
+        MeshSweepCalls,        // sweeps over indexed meshes
+        MeshFacesTested,       // faces, edges and vertices near the sphere way
+        MeshEdgesTested,
+        MeshVerticesTested,
+        InstanceSweepCalls,    // sweeps over instanced meshes
+        InstancesTested,       // instances, whose meshes are swept
+        PacketSweepCalls,      // sweeps of sphere packets (nodes and leaves are counted as BvhNodesVisited and BvhLeavesVisited)
+        PacketTrianglesTested, // triangles, each tested against all lanes of a packet, which still need it
+        FieldSweepCalls,       // sweeps through distance fields
+        FieldSteps,            // steps by safe distances
+        FieldWindows,          // exact sweeps over the mesh near its surface
+        MeshletSweepCalls,
+        MeshletsCulledByBounds, // the way misses the bounding sphere, or enters it after the earliest hit
+        MeshletsCulledByCone,  // the sphere stays on one side of all triangle planes
+        MeshletsTested,
+
+        // batches of moving spheres
+        SpherePairBatchCalls,
+        SpherePairsTested,     // pairs in tested packs, including masked out lanes
+        SpherePairHits,
+
+        // broadphase
+        SweepAndPruneUpdates,
+        SweepAndPruneSwaps,    // swaps of box ends by insertion sort
+        HashGridRebuilds,
+        HashGridPairsTested,   // pairs of boxes tested by SpatialHashGrid
+
+        ErrorsThrown,
+
+        Count
+    };
+
+    const unsigned COUNTERS_COUNT = static_cast<unsigned>( Counter::Count );
+
+    // snapshot of counters
+    struct Stats
+    {
+        unsigned long long counters[COUNTERS_COUNT];
+
+        unsigned long long operator[](Counter counter) const
+        {
+            return counters[ static_cast<unsigned>( counter ) ];
+        }
+    };
+
+    // returns true if the library is compiled with COLLISIONS_STATS
+    bool stats_enabled();
+
+    // sums counters of all threads since the last reset_stats()
+    Stats stats();
+    void reset_stats();
+
+    const char * counter_name(Counter counter);
+
+    // prints non-zero counters, one per line
+    std::ostream &operator<<(std::ostream &stream, const Stats &stats);
+
+    // counters of one thread: registered on creation, added to the totals of finished threads on destruction
+    class _ThreadCounters
+    {
+    public:
+        std::atomic<unsigned long long> values[COUNTERS_COUNT]; // written by the owner thread only
+
+        _ThreadCounters();
+        ~_ThreadCounters();
+    };
+
+    inline void _count(Counter counter, unsigned long long amount)
+    {
+        static thread_local _ThreadCounters counters;
+        std::atomic<unsigned long long> &value = counters.values[ static_cast<unsigned>( counter ) ];
+        value.store( value.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+    }
+};
+
+#ifdef COLLISIONS_STATS
+#define COLLISIONS_COUNT(counter) ::Collisions::_count( (counter), 1 )
+#define COLLISIONS_COUNT_N(counter, amount) ::Collisions::_count( (counter), (amount) )
+#define COLLISIONS_COUNT_IF(condition, counter) do { if( condition ) ::Collisions::_count( (counter), 1 ); } while( false )
+#else
+#define COLLISIONS_COUNT(counter) ((void)0)
+#define COLLISIONS_COUNT_N(counter, amount) ((void)0)
+#define COLLISIONS_COUNT_IF(condition, counter) ((void)0)
+#endif
@@ -0,0 +1,248 @@
+#include "sweep_and_prune.h"
+#include <algorithm>
+#include <functional>
+
+namespace Collisions
+{
+    // ----------------------------- O b j e c t s ---------------------------------------
+
+    enum _Flags
+    {
+        _ALIVE  = 1,
+        _STATIC = 2,
+    };
+
+    inline unsigned long long _pair_key(unsigned first, unsigned second)
+    {
+        if( first > second )
+        {
+            std::swap( first, second );
+        }
+        return ( static_cast<unsigned long long>( first ) << 32 ) | second;
+    }
+
+    inline SpherePair _pair(unsigned long long key)
+    {
+        return SpherePair( static_cast<unsigned>( key >> 32 ), static_cast<unsigned>( key & 0xFFFFFFFFu ) );
+    }
+
+    inline double _coordinate(const Point &point, unsigned axis)
+    {
+        return axis == 0 ? point.x : ( axis == 1 ? point.y : point.z );
+    }
+
+    unsigned SweepAndPrune::add(const BoundingBox &box, bool is_static)
+    {
+        check( !box.is_empty(), EmptyBoxError() );
+        unsigned id;
+        if( free_ids.empty() )
+        {
+            id = static_cast<unsigned>( boxes.size() );
+            boxes.push_back( box );
+            flags.push_back( 0 );
+        }
+        else
+        {
+            // the least one: pop_heap moves it to the back
+            std::pop_heap( free_ids.begin(), free_ids.end(), std::greater<unsigned>() );
+            id = free_ids.back();
+            free_ids.pop_back();
+            boxes[id] = box;
+        }
+        flags[id] = _ALIVE | ( is_static ? _STATIC : 0 );
+
+        // the ends are placed after all others, as if the box were beyond all boxes and intersected nothing:
+        // they are moved to their places (and the pairs are found) by the next update_pairs()
+        for( unsigned axis = 0; axis < 3; ++axis )
+        {
+            const Endpoint min = { _coordinate( box.min, axis ), id*2 };
+            const Endpoint max = { _coordinate( box.max, axis ), id*2 + 1 };
+            endpoints[axis].push_back( min );
+            endpoints[axis].push_back( max );
+        }
+        ++count;
+        return id;
+    }
+
+    unsigned SweepAndPrune::add(const Point &segment_start, const Point &segment_end, double sphere_radius)
+    {
+        return add( bounding_box( segment_start, segment_end, sphere_radius ) );
+    }
+
+    void SweepAndPrune::remove(unsigned id)
+    {
+        check( contains( id ), OutOfBoundsError() );
+        for( unsigned axis = 0; axis < 3; ++axis )
+        {
+            std::vector<Endpoint> &list = endpoints[axis];
+            unsigned kept = 0;
+            for( unsigned i = 0; i < list.size(); ++i )
+            {
+                if( list[i].object() != id )
+                {
+                    list[kept++] = list[i];
+                }
+            }
+            list.resize( kept );
+        }
+        // pairs of the object are not indexed by it: removing is expected to be much rarer than updates
+        for( std::unordered_set<unsigned long long>::iterator i = pairs.begin(); i != pairs.end(); )
+        {
+            const SpherePair pair = _pair( *i );
+            if( pair.first == id || pair.second == id )
+            {
+                removed.push_back( *i );
+                i = pairs.erase( i );
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        flags[id] = 0;
+        released_ids.push_back( id );
+        --count;
+    }
+
+    void SweepAndPrune::update_box(unsigned id, const BoundingBox &box)
+    {
+        check( contains( id ), OutOfBoundsError() );
+        check( !box.is_empty(), EmptyBoxError() );
+        boxes[id] = box;
+    }
+
+    void SweepAndPrune::update_box(unsigned id, const Point &segment_start, const Point &segment_end, double sphere_radius)
+    {
+        update_box( id, bounding_box( segment_start, segment_end, sphere_radius ) );
+    }
+
+    bool SweepAndPrune::contains(unsigned id) const
+    {
+        return id < flags.size() && ( flags[id] & _ALIVE ) != 0;
+    }
+
+    // ------------------------------- P a i r s -----------------------------------------
+
+    void SweepAndPrune::add_pair(unsigned first, unsigned second)
+    {
+        if( ( flags[first] & flags[second] & _STATIC ) != 0 || !boxes[first].intersects( boxes[second] ) )
+        {
+            return;
+        }
+        const unsigned long long key = _pair_key( first, second );
+        if( pairs.insert( key ).second )
+        {
+            added.push_back( key );
+        }
+    }
+
+    void SweepAndPrune::remove_pair(unsigned first, unsigned second)
+    {
+        const unsigned long long key = _pair_key( first, second );
+        if( pairs.erase( key ) != 0 )
+        {
+            removed.push_back( key );
+        }
+    }
+
+    // a min end goes before a max one of the same value, so that touching boxes intersect (see BoundingBox::intersects)
+    inline bool _less(const SweepAndPrune::Endpoint &a, const SweepAndPrune::Endpoint &b)
+    {
+        return a.value < b.value || ( a.value == b.value && !a.is_max() && b.is_max() );
+    }
+
+    void SweepAndPrune::sort_axis(unsigned axis)
+    {
+        std::vector<Endpoint> &list = endpoints[axis];
+        for( unsigned i = 0; i < list.size(); ++i )
+        {
+            const BoundingBox &box = boxes[ list[i].object() ];
+            list[i].value = _coordinate( list[i].is_max() ? box.max : box.min, axis );
+        }
+
+        // insertion sort: every swap of a min and a max end changes overlapping of two boxes along the axis
+        for( unsigned i = 1; i < list.size(); ++i )
+        {
+            const Endpoint moving = list[i];
+            unsigned j = i;
+            for( ; j > 0 && _less( moving, list[j - 1] ); --j )
+            {
+                COLLISIONS_COUNT( Counter::SweepAndPruneSwaps );
+                const Endpoint &passed = list[j - 1];
+                if( !moving.is_max() && passed.is_max() )
+                {
+                    add_pair( moving.object(), passed.object() );    // the min passes a max to the left: they start overlapping
+                }
+                else if( moving.is_max() && !passed.is_max() )
+                {
+                    remove_pair( moving.object(), passed.object() ); // the max passes a min to the left: they stop overlapping
+                }
+                list[j] = passed;
+            }
+            list[j] = moving;
+        }
+    }
+
+    void SweepAndPrune::update_pairs()
+    {
+        COLLISIONS_COUNT( Counter::SweepAndPruneUpdates );
+        for( unsigned axis = 0; axis < 3; ++axis )
+        {
+            sort_axis( axis );
+        }
+
+        // a pair could be added and removed several times since the previous update: only the net change is reported
+        std::sort( added.begin(), added.end() );
+        std::sort( removed.begin(), removed.end() );
+        added_result.clear();
+        removed_result.clear();
+        unsigned i = 0, j = 0;
+        while( i < added.size() || j < removed.size() )
+        {
+            const unsigned long long key = j == removed.size() || ( i < added.size() && added[i] < removed[j] ) ? added[i] : removed[j];
+            int balance = 0;
+            for( ; i < added.size() && added[i] == key; ++i )
+            {
+                ++balance;
+            }
+            for( ; j < removed.size() && removed[j] == key; ++j )
+            {
+                --balance;
+            }
+            if( balance > 0 )
+            {
+                added_result.push_back( _pair( key ) );
+            }
+            else if( balance < 0 )
+            {
+                removed_result.push_back( _pair( key ) );
+            }
+        }
+        added.clear();
+        removed.clear();
+
+        for( unsigned k = 0; k < released_ids.size(); ++k )
+        {
+            free_ids.push_back( released_ids[k] );
+            std::push_heap( free_ids.begin(), free_ids.end(), std::greater<unsigned>() );
+        }
+        released_ids.clear();
+    }
+
+    void SweepAndPrune::get_pairs(/*out*/ std::vector<SpherePair> &result) const
+    {
+        std::vector<unsigned long long> keys( pairs.begin(), pairs.end() );
+        std::sort( keys.begin(), keys.end() );
+        result.clear();
+        result.reserve( keys.size() );
+        for( unsigned i = 0; i < keys.size(); ++i )
+        {
+            result.push_back( _pair( keys[i] ) );
+        }
+    }
+
+    bool SweepAndPrune::has_pair(unsigned first, unsigned second) const
+    {
+        return pairs.count( _pair_key( first, second ) ) != 0;
+    }
+};
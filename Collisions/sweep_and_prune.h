@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <unordered_set>
+#include "bounding_box.h"
+#include "moving_spheres.h"
+
+namespace Collisions
+{
+    // Broadphase for many moving objects: finds pairs of objects with intersecting bounding boxes, so
+    // that only they are passed to the exact finders. For a moving sphere the box covers its whole way
+    // (see bounding_box), and pairs of spheres go to sphere_and_sphere_collision (or, as they are, to
+    // sphere_and_sphere_collisions, if object ids are indices of a MovingSpheres), pairs of a sphere
+    // and a triangle - to sphere_and_triangle_collision.
+    //
+    // Ends of boxes are kept sorted along each axis. Every frame boxes are changed and update_pairs()
+    // re-sorts the ends by insertion sort: objects move little between frames, so the lists are nearly
+    // sorted and it takes about linear time. Each swap of the ends of two boxes is where they start or stop
+    // overlapping along the axis, and the set of intersecting pairs is updated only there.
+    class SweepAndPrune
+    {
+    public:
+        struct Endpoint
+        {
+            double value;
+            unsigned data; // object*2 + 1 for the max end, object*2 for the min one
+
+            unsigned object() const { return data >> 1; }
+            bool is_max() const { return (data & 1) != 0; }
+        };
+    private:
+        std::vector<BoundingBox> boxes;      // by object id
+        std::vector<unsigned char> flags;    // by object id, see _Flags in sweep_and_prune.cpp
+        std::vector<Endpoint> endpoints[3];  // sorted by value, a min end before a max one of the same value
+        std::unordered_set<unsigned long long> pairs;
+        std::vector<unsigned long long> added, removed; // changes since the previous update_pairs()
+        std::vector<SpherePair> added_result, removed_result;
+        std::vector<unsigned> free_ids;      // ids of removed objects, reused after update_pairs()
+        std::vector<unsigned> released_ids;  // ids removed since the previous update_pairs()
+        unsigned count;
+
+        void add_pair(unsigned first, unsigned second);
+        void remove_pair(unsigned first, unsigned second);
+        void sort_axis(unsigned axis);
+    public:
+        SweepAndPrune() : count(0) {}
+
+        // Adds an object and returns its id: the least of ids of removed objects, or the next one.
+        // Pairs of two static objects (like triangles of level geometry) are never reported.
+        // The object takes part in pairs after the next update_pairs().
+        unsigned add(const BoundingBox &box, bool is_static = false);
+        unsigned add(const Point &segment_start, const Point &segment_end, double sphere_radius);
+        // the id is free for add() after the next update_pairs(), and its pairs are reported as removed by it
+        void remove(unsigned id);
+
+        // the new box is taken into account by the next update_pairs()
+        void update_box(unsigned id, const BoundingBox &box);
+        void update_box(unsigned id, const Point &segment_start, const Point &segment_end, double sphere_radius);
+
+        // Re-sorts the ends of boxes and updates the pairs. Pairs, which have appeared or disappeared
+        // since the previous call, are given by added_pairs() and removed_pairs() then.
+        void update_pairs();
+        std::vector<SpherePair> const & added_pairs() const { return added_result; }
+        std::vector<SpherePair> const & removed_pairs() const { return removed_result; }
+
+        // all intersecting pairs (first < second) as of the last update_pairs(), sorted
+        void get_pairs(/*out*/ std::vector<SpherePair> &result) const;
+        unsigned pairs_count() const { return static_cast<unsigned>( pairs.size() ); }
+        bool has_pair(unsigned first, unsigned second) const;
+
+        unsigned size() const { return count; }
+        bool empty() const { return count == 0; }
+        bool contains(unsigned id) const;
+        BoundingBox const & box(unsigned id) const
+        {
+            check( contains( id ), OutOfBoundsError() );
+            return boxes[id];
+        }
+        Endpoint const & endpoint(unsigned axis, unsigned index) const
+        {
+            check( axis < 3 && index < endpoints[0].size(), OutOfBoundsError() );
+            return endpoints[axis][index];
+        }
+    };
+};
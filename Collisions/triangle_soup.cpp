@@ -0,0 +1,322 @@
+#include "triangle_soup.h"
+#include "bounding_box.h"
+#include "lane_kernels.h"
+#include <algorithm>
+#include <limits>
+
+namespace Collisions
+{
+    // ------------------------- T r i a n g l e   s o u p --------------------------------
+
+    TriangleSoup::TriangleSoup(const std::vector<Triangle> &triangles) : count(0)
+    {
+        blocks.reserve( (triangles.size() + BLOCK_SIZE - 1)/BLOCK_SIZE );
+        bounds.reserve( blocks.capacity() );
+        for( unsigned i = 0; i < triangles.size(); ++i )
+        {
+            add( triangles[i] );
+        }
+    }
+
+    void TriangleSoup::add(const Triangle &triangle)
+    {
+        add( PreparedTriangle( triangle ) );
+    }
+
+    inline void _store(double (&destination)[3][TriangleSoup::BLOCK_SIZE], unsigned lane, const Vector &vector)
+    {
+        destination[0][lane] = vector.x;
+        destination[1][lane] = vector.y;
+        destination[2][lane] = vector.z;
+    }
+
+    inline Vector _load(const double (&source)[3][TriangleSoup::BLOCK_SIZE], unsigned lane)
+    {
+        return Vector( source[0][lane], source[1][lane], source[2][lane] );
+    }
+
+    void TriangleSoup::add(const PreparedTriangle &triangle)
+    {
+        const unsigned first_lane = count % BLOCK_SIZE;
+        if( first_lane == 0 )
+        {
+            blocks.push_back( Block() );
+            bounds.push_back( BlockBounds() );
+        }
+        Block &block = blocks.back();
+        BlockBounds &block_bounds = bounds.back();
+        BoundingBox box;
+        box.add( triangle[0] ).add( triangle[1] ).add( triangle[2] );
+        // fill the rest of the block too: padding lanes are copies of the last triangle
+        for( unsigned lane = first_lane; lane < BLOCK_SIZE; ++lane )
+        {
+            for( unsigned i = 0; i < 3; ++i )
+            {
+                _store( block.vertices[i], lane, triangle[i] );
+                _store( block.sides[i], lane, triangle.side(i) );
+                _store( block.side_normals[i], lane, triangle.side_outer_normal(i) );
+            }
+            _store( block_bounds.box_min, lane, box.min );
+            _store( block_bounds.box_max, lane, box.max );
+            _store( block_bounds.normal, lane, triangle.normal() );
+            block_bounds.offset[lane] = triangle.plane_offset();
+            _store( block.dual_u, lane, triangle.barycentric_basis(0) );
+            _store( block.dual_v, lane, triangle.barycentric_basis(1) );
+        }
+        ++count;
+    }
+
+    void TriangleSoup::clear()
+    {
+        blocks.clear();
+        bounds.clear();
+        count = 0;
+    }
+
+    Triangle TriangleSoup::operator[](unsigned index) const
+    {
+        check( index < count, OutOfBoundsError() );
+        const Block &block = blocks[index/BLOCK_SIZE];
+        const unsigned lane = index % BLOCK_SIZE;
+        return Triangle( _load( block.vertices[0], lane ), _load( block.vertices[1], lane ), _load( block.vertices[2], lane ) );
+    }
+
+    // ----------------------------- S w e e p   k e r n e l -------------------------------
+
+    // lanes of a block, loaded when the kernel needs them (see _sweep_lanes in lane_kernels.h)
+    template <class Pack>
+    struct _BlockLanes
+    {
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const TriangleSoup::Block &block;
+        const TriangleSoup::BlockBounds &bounds;
+        unsigned lane;
+
+        _BlockLanes(const TriangleSoup::Block &block, const TriangleSoup::BlockBounds &bounds, unsigned lane)
+            : block(block), bounds(bounds), lane(lane) {}
+
+        PackVector vertex(unsigned i) const { return PackVector::load( block.vertices[i], lane ); }
+        PackVector side(unsigned i) const { return PackVector::load( block.sides[i], lane ); }
+        PackVector side_normal(unsigned i) const { return PackVector::load( block.side_normals[i], lane ); }
+        PackVector normal() const { return PackVector::load( bounds.normal, lane ); }
+        PackVector dual_u() const { return PackVector::load( block.dual_u, lane ); }
+        PackVector dual_v() const { return PackVector::load( block.dual_v, lane ); }
+        Pack offset() const { return Pack::load( &bounds.offset[lane] ); }
+    };
+
+    // box of the sphere way from the start to `reach' of it, widened by the tolerance of _sweep_lanes
+    template <class Pack>
+    void _way_box(const Point &segment_start, const Point &segment_end, double sphere_radius, double reach,
+                  /*out*/ Simd::PackVector<Pack> &min, Simd::PackVector<Pack> &max)
+    {
+        const Vector way = segment_end - segment_start;
+        const Point end = segment_start + std::max( reach, 0.0 )*way;
+        const double margin = sphere_radius + KERNEL_EPSILON*( way.norm() + sphere_radius + 1 );
+        min = Simd::PackVector<Pack>( Point( std::min( segment_start.x, end.x ), std::min( segment_start.y, end.y ), std::min( segment_start.z, end.z ) ) -
+                                      Vector( margin, margin, margin ) );
+        max = Simd::PackVector<Pack>( Point( std::max( segment_start.x, end.x ), std::max( segment_start.y, end.y ), std::max( segment_start.z, end.z ) ) +
+                                      Vector( margin, margin, margin ) );
+    }
+
+    template <class Pack>
+    bool _sweep_sphere(const TriangleSoup &soup, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                       /*out*/ SweepHit &hit)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const _SweepQuery<Pack> query( segment_start, segment_end, sphere_radius );
+
+        double lane_offsets[Pack::WIDTH];
+        for( unsigned i = 0; i < Pack::WIDTH; ++i )
+        {
+            lane_offsets[i] = i;
+        }
+        const Pack lane_offset = Pack::load( lane_offsets );
+
+        Pack best_time( std::numeric_limits<double>::infinity() );
+        Pack best_index( -1.0 );
+        PackVector best_point( segment_start );
+
+        // Most triangles are missed: the kernel is skipped for lanes, where the sphere never comes near the box or
+        // the plane of the triangle before `reach' (of the way), the earliest collision found so far. Later collisions
+        // can't be chosen, and equal times are chosen by the least index, which is in an earlier block.
+        double reach = 1;
+        PackVector way_min, way_max;
+        _way_box( segment_start, segment_end, sphere_radius, reach, way_min, way_max );
+        for( unsigned block_index = 0; block_index < soup.blocks_count(); ++block_index )
+        {
+            COLLISIONS_COUNT( Counter::SoupBlocksTested );
+            const TriangleSoup::Block &block = soup.block( block_index );
+            const TriangleSoup::BlockBounds &bounds = soup.block_bounds( block_index );
+            for( unsigned lane = 0; lane < TriangleSoup::BLOCK_SIZE; lane += Pack::WIDTH )
+            {
+                const PackVector box_min = PackVector::load( bounds.box_min, lane );
+                const PackVector box_max = PackVector::load( bounds.box_max, lane );
+                const Mask near_box = ( box_min.x <= way_max.x ) & ( box_min.y <= way_max.y ) & ( box_min.z <= way_max.z ) &
+                                      ( box_max.x >= way_min.x ) & ( box_max.y >= way_min.y ) & ( box_max.z >= way_min.z );
+                if( !any( near_box ) )
+                    continue;
+
+                const _BlockLanes<Pack> lanes( block, bounds, lane );
+                if( !any( near_box & _near_plane( lanes.normal(), lanes.offset(), query, Pack(reach) ) ) )
+                    continue;
+
+                COLLISIONS_COUNT_N( Counter::SoupLanesSwept, Pack::WIDTH );
+                Pack time;
+                PackVector point;
+                const Mask hit = _sweep_lanes( lanes, query, time, point );
+                const Mask better = hit & ( time < best_time );
+                if( !any( better ) )
+                    continue;
+
+                best_time = select( better, time, best_time );
+                best_index = select( better, Pack( block_index*TriangleSoup::BLOCK_SIZE + lane ) + lane_offset, best_index );
+                best_point = select( better, point, best_point );
+
+                double times[Pack::WIDTH];
+                best_time.store( times );
+                reach = *std::min_element( times, times + Pack::WIDTH );
+                _way_box( segment_start, segment_end, sphere_radius, reach, way_min, way_max );
+            }
+        }
+
+        // reduce lanes: the earliest collision, or the one with the least index for equal times
+        // (so that padding copies of a triangle never win over the original)
+        double times[Pack::WIDTH], indices[Pack::WIDTH], xs[Pack::WIDTH], ys[Pack::WIDTH], zs[Pack::WIDTH];
+        best_time.store( times );
+        best_index.store( indices );
+        best_point.x.store( xs );
+        best_point.y.store( ys );
+        best_point.z.store( zs );
+
+        int best_lane = -1;
+        for( unsigned i = 0; i < Pack::WIDTH; ++i )
+        {
+            if( indices[i] >= 0 &&
+                ( best_lane < 0 || times[i] < times[best_lane] || ( times[i] == times[best_lane] && indices[i] < indices[best_lane] ) ) )
+            {
+                best_lane = i;
+            }
+        }
+        if( best_lane < 0 )
+        {
+            return false;
+        }
+        assert( indices[best_lane] < soup.size() );
+
+        hit.time = times[best_lane];
+        hit.triangle_index = static_cast<unsigned>( indices[best_lane] );
+        hit.collision_point = Point( xs[best_lane], ys[best_lane], zs[best_lane] );
+        hit.sphere_center = segment_start + hit.time*(segment_end - segment_start);
+        return true;
+    }
+
+    template <class Pack>
+    bool _raycast(const TriangleSoup &soup, const Point &origin, const Vector &direction, double max_time,
+                  /*out*/ RayHit &hit)
+    {
+        typedef typename Pack::Mask Mask;
+        typedef Simd::PackVector<Pack> PackVector;
+
+        const PackVector ray_origin( origin );
+        const PackVector ray_direction( direction );
+        const Pack ray_length( max_time );
+
+        double lane_offsets[Pack::WIDTH];
+        for( unsigned i = 0; i < Pack::WIDTH; ++i )
+        {
+            lane_offsets[i] = i;
+        }
+        const Pack lane_offset = Pack::load( lane_offsets );
+
+        Pack best_time( std::numeric_limits<double>::infinity() );
+        Pack best_index( -1.0 );
+        Pack best_u( 0.0 );
+        Pack best_v( 0.0 );
+
+        for( unsigned block_index = 0; block_index < soup.blocks_count(); ++block_index )
+        {
+            COLLISIONS_COUNT( Counter::SoupBlocksTested );
+            COLLISIONS_COUNT_N( Counter::RayTrianglesTested, TriangleSoup::BLOCK_SIZE );
+            const TriangleSoup::Block &block = soup.block( block_index );
+            const TriangleSoup::BlockBounds &bounds = soup.block_bounds( block_index );
+            for( unsigned lane = 0; lane < TriangleSoup::BLOCK_SIZE; lane += Pack::WIDTH )
+            {
+                Pack time, u, v;
+                const Mask hit = _raycast_lanes( _BlockLanes<Pack>( block, bounds, lane ), ray_origin, ray_direction, ray_length, time, u, v );
+                const Mask better = hit & ( time < best_time );
+
+                best_time = select( better, time, best_time );
+                best_index = select( better, Pack( block_index*TriangleSoup::BLOCK_SIZE + lane ) + lane_offset, best_index );
+                best_u = select( better, u, best_u );
+                best_v = select( better, v, best_v );
+            }
+        }
+
+        // reduce lanes, as _sweep_sphere does
+        double times[Pack::WIDTH], indices[Pack::WIDTH], us[Pack::WIDTH], vs[Pack::WIDTH];
+        best_time.store( times );
+        best_index.store( indices );
+        best_u.store( us );
+        best_v.store( vs );
+
+        int best_lane = -1;
+        for( unsigned i = 0; i < Pack::WIDTH; ++i )
+        {
+            if( indices[i] >= 0 &&
+                ( best_lane < 0 || times[i] < times[best_lane] || ( times[i] == times[best_lane] && indices[i] < indices[best_lane] ) ) )
+            {
+                best_lane = i;
+            }
+        }
+        if( best_lane < 0 )
+        {
+            return false;
+        }
+        assert( indices[best_lane] < soup.size() );
+
+        hit.time = times[best_lane];
+        hit.u = us[best_lane];
+        hit.v = vs[best_lane];
+        hit.triangle_index = static_cast<unsigned>( indices[best_lane] );
+        hit.collision_point = origin + hit.time*direction;
+        return true;
+    }
+
+    namespace NoThrow
+    {
+        CollisionStatus sweep_sphere(const TriangleSoup &soup, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::SoupSweepCalls );
+            if( segment_start == segment_end )
+                return CollisionStatus::DegenerateSegment;
+
+            return to_status( _sweep_sphere<Simd::DefaultPack>( soup, segment_start, segment_end, sphere_radius, hit ) );
+        }
+
+        CollisionStatus raycast(const TriangleSoup &soup, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept
+        {
+            COLLISIONS_COUNT( Counter::RaycastCalls );
+            if( direction.is_zero() )
+                return CollisionStatus::InvalidLineVector;
+
+            return to_status( _raycast<Simd::DefaultPack>( soup, origin, direction, max_time, hit ) );
+        }
+    };
+
+    bool sweep_sphere(const TriangleSoup &soup, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit)
+    {
+        return check_status( NoThrow::sweep_sphere( soup, segment_start, segment_end, sphere_radius, hit ) );
+    }
+
+    bool raycast(const TriangleSoup &soup, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit)
+    {
+        return check_status( NoThrow::raycast( soup, origin, direction, max_time, hit ) );
+    }
+};
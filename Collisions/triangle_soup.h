@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include "collisions.h"
+
+namespace Collisions
+{
+    // Set of triangles, optimized for sweeping a sphere against all of them: triangles with their
+    // precomputed plane and side data are stored by blocks of BLOCK_SIZE. Inside a block every value
+    // is an array with one element per triangle (structure of arrays), so that the whole block is
+    // processed by a few SIMD instructions. Bounding boxes and planes of a block are stored apart
+    // from the rest of it (see BlockBounds).
+    class TriangleSoup
+    {
+    public:
+        static const unsigned BLOCK_SIZE = 4;
+
+        struct Block
+        {
+            double vertices[3][3][BLOCK_SIZE];     // [vertex][coordinate][triangle]
+            double sides[3][3][BLOCK_SIZE];        // [side][coordinate][triangle], see PreparedTriangle::side
+            double side_normals[3][3][BLOCK_SIZE]; // [side][coordinate][triangle]
+            double dual_u[3][BLOCK_SIZE];          // dual basis for barycentric coordinates
+            double dual_v[3][BLOCK_SIZE];
+        };
+        // bounding boxes and planes of triangles of a block, kept apart from the rest of it: sweeps reject
+        // most lanes by them, and read only these for such lanes
+        struct BlockBounds
+        {
+            double box_min[3][BLOCK_SIZE];         // [coordinate][triangle]
+            double box_max[3][BLOCK_SIZE];
+            double normal[3][BLOCK_SIZE];
+            double offset[BLOCK_SIZE];             // plane offset
+        };
+    private:
+        // the last block is padded with copies of the last triangle
+        std::vector<Block> blocks;
+        std::vector<BlockBounds> bounds;
+        unsigned count;
+    public:
+        TriangleSoup() : count(0) {}
+        explicit TriangleSoup(const std::vector<Triangle> &triangles);
+
+        // throws DegeneratedTriangleError for degenerated triangle
+        void add(const Triangle &triangle);
+        void add(const PreparedTriangle &triangle);
+        void clear();
+
+        unsigned size() const { return count; }
+        bool empty() const { return count == 0; }
+        Triangle operator[](unsigned index) const;
+
+        unsigned blocks_count() const { return static_cast<unsigned>( blocks.size() ); }
+        Block const & block(unsigned index) const
+        {
+            check( index < blocks.size(), OutOfBoundsError() );
+            return blocks[index];
+        }
+        BlockBounds const & block_bounds(unsigned index) const
+        {
+            check( index < bounds.size(), OutOfBoundsError() );
+            return bounds[index];
+        }
+    };
+
+    // Sweeps a sphere along the segment against all triangles of the soup and finds the earliest collision
+    // (with the same rules as sphere_and_triangle_collision for each triangle). Returns true if there is any.
+    // Lanes are tested against bounding boxes and planes of their triangles first, by Pack::WIDTH lanes at once
+    // (see simd.h): the kernel runs only for packs of lanes with a triangle, whose box and plane the sphere comes
+    // near before the earliest collision found so far.
+    bool sweep_sphere(const TriangleSoup &soup, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                      /*out*/ SweepHit &hit);
+
+    // Casts a ray against all triangles of the soup (see raycast in collisions.h): a block is tested against
+    // the ray at once, and the nearest hit is chosen among lanes at the end.
+    bool raycast(const TriangleSoup &soup, const Point &origin, const Vector &direction, double max_time,
+                 /*out*/ RayHit &hit);
+
+    namespace NoThrow
+    {
+        // exception-free version of the above (see NoThrow in collisions.h): triangles of the soup
+        // are validated when added, so only the segment is checked once per sweep
+        CollisionStatus sweep_sphere(const TriangleSoup &soup, const Point &segment_start, const Point &segment_end, double sphere_radius,
+                                     /*out*/ SweepHit &hit) noexcept;
+        CollisionStatus raycast(const TriangleSoup &soup, const Point &origin, const Vector &direction, double max_time,
+                                /*out*/ RayHit &hit) noexcept;
+    };
+};
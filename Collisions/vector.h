@@ -6,33 +6,41 @@
 
 namespace Collisions
 {
-    class Vector
+    // BasicVector (or point) of three coordinates of the scalar type T: float or double
+    template <class T>
+    class BasicVector
     {
     public:
-        double x, y, z;
+        typedef T Scalar;
+        typedef typename DefaultToleranceFor<T>::type Tolerance;
 
-        Vector() : x(0), y(0), z(0) {}
-        Vector(double x, double y, double z) : x(x), y(y), z(z) {}
+        T x, y, z;
+
+        BasicVector() : x(0), y(0), z(0) {}
+        BasicVector(T x, T y, T z) : x(x), y(y), z(z) {}
+        // conversion between precisions
+        template <class U>
+        explicit BasicVector(const BasicVector<U> &another) : x( static_cast<T>( another.x ) ), y( static_cast<T>( another.y ) ), z( static_cast<T>( another.z ) ) {}
 
         // unary operators
-        Vector operator-() const
+        BasicVector operator-() const
         {
-            return Vector( -x, -y, -z );
+            return BasicVector( -x, -y, -z );
         }
-        Vector operator+() const
+        BasicVector operator+() const
         {
             return *this;
         }
 
         // assignment operators
-        Vector & operator+=(const Vector &another)
+        BasicVector & operator+=(const BasicVector &another)
         {
             x += another.x;
             y += another.y;
             z += another.z;
             return *this;
         }
-        Vector & operator-=(const Vector &another)
+        BasicVector & operator-=(const BasicVector &another)
         {
             x -= another.x;
             y -= another.y;
@@ -40,14 +48,14 @@ namespace Collisions
             return *this;
         }
 
-        Vector & operator*=(const double &scalar)
+        BasicVector & operator*=(const T &scalar)
         {
             x *= scalar;
             y *= scalar;
             z *= scalar;
             return *this;
         }
-        Vector & operator/=(const double &scalar)
+        BasicVector & operator/=(const T &scalar)
         {
             x /= scalar;
             y /= scalar;
@@ -56,53 +64,59 @@ namespace Collisions
         }
 
         // binary operators
-        Vector operator+(const Vector &another) const
+        BasicVector operator+(const BasicVector &another) const
         {
-            Vector result = *this;
+            BasicVector result = *this;
             return result += another;
         }
-        Vector operator-(const Vector &another) const
+        BasicVector operator-(const BasicVector &another) const
         {
-            Vector result = *this;
+            BasicVector result = *this;
             return result -= another;
         }
 
-        Vector operator*(const double &scalar) const
+        BasicVector operator*(const T &scalar) const
         {
-            Vector result = *this;
+            BasicVector result = *this;
             return result *= scalar;
         }
-        Vector operator/(const double &scalar) const
+        BasicVector operator/(const T &scalar) const
         {
-            Vector result = *this;
+            BasicVector result = *this;
             return result /= scalar;
         }
 
-        bool operator==(const Vector &another) const
+        // all three coordinates are compared at once, without branches
+        template <class ComparisonTolerance>
+        bool equals(const BasicVector &another) const
+        {
+            return equal3<ComparisonTolerance>( x, y, z, another.x, another.y, another.z );
+        }
+        bool operator==(const BasicVector &another) const
         {
-            return equal( x, another.x ) && equal( y, another.y ) && equal( z, another.z );
+            return equals<Tolerance>( another );
         }
-        bool operator!=(const Vector &another) const
+        bool operator!=(const BasicVector &another) const
         {
             return !( *this == another );
         }
         
         // scalar multiplication
-        double operator*(const Vector &another) const
+        T operator*(const BasicVector &another) const
         {
             return x*another.x + y*another.y + z*another.z;
         }
         
         // methods
-        double sqared_norm() const
+        T sqared_norm() const
         {
             return (*this)*(*this);
         }
-        double norm() const
+        T norm() const
         {
-            return sqrt( sqared_norm() );
+            return std::sqrt( sqared_norm() );
         }
-        Vector & normalize() // normalizes given point/vector in place (!), returns itself
+        BasicVector & normalize() // normalizes given point/vector in place (!), returns itself
         {
             if( norm() != 0 )
             {
@@ -110,67 +124,92 @@ namespace Collisions
             }
             return *this;
         }
-        Vector normalized() const  // returns normalized point/vector
+        BasicVector normalized() const  // returns normalized point/vector
         {
-            Vector result = *this;
+            BasicVector result = *this;
             return result.normalize();
         }
 
+        template <class ComparisonTolerance>
         bool is_zero() const
         {
-            return equal( 0, x ) && equal( 0, y ) && equal( 0, z );
+            return equal3<ComparisonTolerance>( 0, 0, 0, x, y, z );
         }
-        bool is_collinear_to(const Vector &another) const;
-        bool is_orthogonal_to(const Vector &another) const
+        bool is_zero() const
+        {
+            return is_zero<Tolerance>();
+        }
+        bool is_collinear_to(const BasicVector &another) const;
+        bool is_orthogonal_to(const BasicVector &another) const
         {
             return equal( 0, (*this)*another );
         }
     };
 
+    template <class T>
+    using BasicPoint = BasicVector<T>;
+    // the scalar type T itself, but not deduced from arguments of function templates: so that
+    // f( point, 1 ) works for f(const BasicPoint<T> &, Scalar<T>) and any T
+    template <class T>
+    using Scalar = typename BasicVector<T>::Scalar;
+
+    typedef BasicVector<double> Vector;
     typedef Vector Point; // define an alias
+    typedef BasicVector<float> VectorF;
+    typedef VectorF PointF;
 
-    // more operators
-    inline Vector operator*(const double &scalar, const Vector &vector)
+    // more operators (the scalar type is taken from the vector, so that 2*vector works for any of them)
+    template <class T>
+    inline BasicVector<T> operator*(const typename BasicVector<T>::Scalar &scalar, const BasicVector<T> &vector)
     {
         return vector * scalar;
     }
-    inline std::ostream &operator<<(std::ostream &stream, const Vector &vector)
+    template <class T>
+    inline std::ostream &operator<<(std::ostream &stream, const BasicVector<T> &vector)
     {
         return stream << "(" << vector.x << ", " << vector.y << ", " << vector.z << ")";
     }
 
     // functions
-    inline double distance(const Point &A, const Point &B)
+    template <class T>
+    inline T distance(const BasicVector<T> &A, const BasicVector<T> &B)
     {
         return (A - B).norm();
     }
-    inline Vector cross_product(const Vector &a, const Vector &b)
+    template <class T>
+    inline BasicVector<T> cross_product(const BasicVector<T> &a, const BasicVector<T> &b)
     {
-        return Vector( a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x );
+        return BasicVector<T>( a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x );
     }
 
-    inline bool Vector::is_collinear_to(const Vector &another) const
+    template <class T>
+    inline bool BasicVector<T>::is_collinear_to(const BasicVector<T> &another) const
     {
         return cross_product( *this, another ).is_zero();
     }
 
     // error checking functions
-    template <class ErrType> inline void check_nonzero_vector( const Vector &vector, const ErrType &error )
+    template <class T, class ErrType> inline void check_nonzero_vector( const BasicVector<T> &vector, const ErrType &error )
     {
         check( !vector.is_zero(), error );
     }
-    inline void check_segment( const Point &segment_start, const Point &segment_end )
+    template <class T> inline void check_segment( const BasicVector<T> &segment_start, const BasicVector<T> &segment_end )
     {
         check( segment_start != segment_end, DegeneratedSegmentError() );
     }
 
     // triangle class
-    class Triangle
+    template <class T>
+    class BasicTriangle
     {
+    public:
+        typedef T Scalar;
+        typedef BasicVector<T> Vector;
+        typedef BasicPoint<T> Point;
     private:
         Point vertices[3];
     public:
-        Triangle(const Point &vertex0, const Point &vertex1, const Point &vertex2)
+        BasicTriangle(const Point &vertex0, const Point &vertex1, const Point &vertex2)
         {
             vertices[0] = vertex0;
             vertices[1] = vertex1;
@@ -192,6 +231,11 @@ namespace Collisions
             check( !normal.is_zero(), DegeneratedTriangleError() );
             return normal;
         }
+        // returns true if normal() would throw DegeneratedTriangleError
+        bool is_degenerated() const
+        {
+            return cross_product( vertices[2] - vertices[0], vertices[1] - vertices[0] ).normalized().is_zero();
+        }
         // returns outer normal for the side, containing vertices #index and #index+1
         Vector side_outer_normal(unsigned index) const
         {
@@ -200,4 +244,104 @@ namespace Collisions
             return cross_product( side, normal() ).normalized();
         }
     };
+
+    // triangle with precomputed normal, plane offset, sides and their outer normals,
+    // for static geometry which is tested against many times
+    template <class T>
+    class BasicPreparedTriangle
+    {
+    public:
+        typedef T Scalar;
+        typedef BasicVector<T> Vector;
+        typedef BasicPoint<T> Point;
+        typedef BasicTriangle<T> Triangle;
+    private:
+        Point vertices[3];
+        Vector sides[3];        // sides[i] == vertices[i+1] - vertices[i]
+        Vector side_normals[3]; // outer normals of sides, the same as Triangle::side_outer_normal
+        Vector plane_normal;
+        T offset;               // plane equation is plane_normal*point == offset
+        // dual basis for u = vertices[1] - vertices[0] and v = vertices[2] - vertices[0]:
+        // components of r along u and v are r*dual_basis[0] and r*dual_basis[1] (inverse determinant is folded in)
+        Vector dual_basis[2];
+
+        void prepare(const Triangle &triangle)
+        {
+            plane_normal = triangle.normal(); // throws DegeneratedTriangleError, if needed
+            for( unsigned i = 0; i < 3; ++i )
+            {
+                vertices[i] = triangle[i];
+            }
+            for( unsigned i = 0; i < 3; ++i )
+            {
+                sides[i] = vertices[ (i+1)%3 ] - vertices[i];
+                side_normals[i] = cross_product( -sides[i], plane_normal ).normalized();
+            }
+            offset = plane_normal*vertices[0];
+
+            const Vector u = sides[0];
+            const Vector v = -sides[2];
+            const T determinant = (u*u)*(v*v) - (u*v)*(u*v);
+            check( determinant != 0, DegeneratedTriangleError() );
+            dual_basis[0] = ( (v*v)*u - (u*v)*v )/determinant;
+            dual_basis[1] = ( (u*u)*v - (u*v)*u )/determinant;
+        }
+    public:
+        explicit BasicPreparedTriangle(const Triangle &triangle)
+        {
+            prepare( triangle );
+        }
+        BasicPreparedTriangle(const Point &vertex0, const Point &vertex1, const Point &vertex2)
+        {
+            prepare( Triangle( vertex0, vertex1, vertex2 ) );
+        }
+        Point const & operator[](unsigned index) const
+        {
+            check( index <= 2, OutOfBoundsError() );
+            return vertices[index];
+        }
+        Vector const & normal() const
+        {
+            return plane_normal;
+        }
+        T plane_offset() const
+        {
+            return offset;
+        }
+        // returns vector from vertex #index to vertex #index+1
+        Vector const & side(unsigned index) const
+        {
+            check( index <= 2, OutOfBoundsError() );
+            return sides[index];
+        }
+        // returns outer normal for the side, containing vertices #index and #index+1
+        Vector const & side_outer_normal(unsigned index) const
+        {
+            check( index <= 2, OutOfBoundsError() );
+            return side_normals[index];
+        }
+        // finds components of (point - vertex #0) along sides #0 and #2 (reversed), i.e. barycentric coordinates
+        // of the point's projection, corresponding to vertices #1 and #2
+        void barycentric(const Point &point, /*out*/ T &ru, T &rv) const
+        {
+            const Vector r = point - vertices[0];
+            ru = r*dual_basis[0];
+            rv = r*dual_basis[1];
+        }
+        // returns vector, giving barycentric coordinate #index+1 by scalar multiplication (see above)
+        Vector const & barycentric_basis(unsigned index) const
+        {
+            check( index <= 1, OutOfBoundsError() );
+            return dual_basis[index];
+        }
+        Triangle triangle() const
+        {
+            return Triangle( vertices[0], vertices[1], vertices[2] );
+        }
+    };
+
+    typedef BasicTriangle<double> Triangle;
+    typedef BasicPreparedTriangle<double> PreparedTriangle;
+    typedef BasicTriangle<float> TriangleF;
+    typedef BasicPreparedTriangle<float> PreparedTriangleF;
 };
@@ -0,0 +1,127 @@
+#include "../Collisions/collision_batch.h"
+#include "../Collisions/mesh_bvh.h"
+#include "../Collisions/triangle_soup.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+using namespace Collisions;
+
+namespace
+{
+    std::vector<SweepQuery> random_queries(unsigned count, double size)
+    {
+        std::vector<SweepQuery> queries;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            const Point start = random_point(size);
+            queries.push_back( SweepQuery( start, start + random_point(size/2), random_double(0.1, 1) ) );
+        }
+        return queries;
+    }
+}
+
+// Collision batch tests
+
+TEST(CollisionBatchTest, Creation)
+{
+    EXPECT_EQ( 3u, CollisionBatch(3).threads_count() );
+    EXPECT_GE( CollisionBatch().threads_count(), 1u );
+    EXPECT_EQ( 0u, sizeof(BatchResult) % CACHE_LINE_SIZE );
+}
+
+TEST(CollisionBatchTest, SameAsSequential)
+{
+    srand(4242);
+    const std::vector<Triangle> triangles = random_mesh( 200, 10 );
+    const MeshBVH mesh( triangles );
+    const TriangleSoup soup( triangles );
+    const std::vector<SweepQuery> queries = random_queries( 1000, 10 );
+
+    for( unsigned threads = 1; threads <= 4; ++threads )
+    {
+        CollisionBatch batch( threads );
+        std::vector<BatchResult> mesh_results, soup_results;
+        batch.sweep_sphere( mesh, queries, mesh_results );
+        batch.sweep_sphere( soup, queries, soup_results );
+        ASSERT_EQ( queries.size(), mesh_results.size() );
+        ASSERT_EQ( queries.size(), soup_results.size() );
+
+        for( unsigned i = 0; i < queries.size(); ++i )
+        {
+            SweepHit expected;
+            const CollisionStatus status = NoThrow::sweep_sphere( mesh, queries[i].segment_start, queries[i].segment_end, queries[i].sphere_radius, expected );
+            ASSERT_EQ( status, mesh_results[i].status ) << "query #" << i << ", threads: " << threads;
+            EXPECT_EQ( status, soup_results[i].status ) << "query #" << i << ", threads: " << threads;
+            if( status == CollisionStatus::Hit )
+            {
+                EXPECT_EQ( expected.triangle_index, mesh_results[i].hit.triangle_index );
+                EXPECT_EQ( expected.time, mesh_results[i].hit.time );
+                EXPECT_NEAR( expected.time, soup_results[i].hit.time, 1e-9 );
+            }
+        }
+    }
+}
+
+TEST(CollisionBatchTest, Arrays)
+{
+    std::vector<Triangle> triangles;
+    triangles.push_back( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    const MeshBVH mesh( triangles );
+    const Point A(2, 2, 1);
+    const Point starts[3] = { A, A, A };
+    const Point ends[3] = { -A, 2*A, A };
+    const double radii[3] = { 0.5, 0.5, 0.5 };
+    BatchResult results[3];
+
+    CollisionBatch batch( 2 );
+    batch.sweep_sphere( mesh, starts, ends, radii, 3, results );
+
+    EXPECT_EQ( CollisionStatus::Hit, results[0].status );
+    EXPECT_EQ( Point(1,1,0), results[0].hit.collision_point );
+    EXPECT_EQ( CollisionStatus::Miss, results[1].status );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, results[2].status );
+}
+
+TEST(CollisionBatchTest, Empty)
+{
+    std::vector<Triangle> triangles;
+    triangles.push_back( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    const MeshBVH mesh( triangles );
+    std::vector<BatchResult> results( 5 );
+
+    CollisionBatch batch( 2 );
+    batch.sweep_sphere( mesh, std::vector<SweepQuery>(), results );
+    EXPECT_TRUE( results.empty() );
+}
+
+TEST(CollisionBatchTest, ThrowingJob)
+{
+    // the first exception comes out of run, on whichever thread it was thrown, after all threads are done
+    for( unsigned threads = 1; threads <= 4; ++threads )
+    {
+        CollisionBatch batch( threads );
+        std::atomic<unsigned> running( 0 );
+        EXPECT_THROW( batch.run( 10000, [&](unsigned begin, unsigned end)
+        {
+            ++running;
+            if( begin <= 5000 && 5000 < end )
+            {
+                --running;
+                throw std::runtime_error( "job" );
+            }
+            --running;
+        } ), std::runtime_error ) << threads;
+        EXPECT_EQ( 0u, running.load() );
+
+        EXPECT_THROW( batch.run( 1000, [](unsigned, unsigned) { throw std::bad_alloc(); } ), std::bad_alloc ) << threads;
+
+        // the batch is usable after that
+        std::atomic<unsigned> done( 0 );
+        batch.run( 1000, [&](unsigned begin, unsigned end) { done += end - begin; } );
+        EXPECT_EQ( 1000u, done.load() );
+    }
+}
@@ -0,0 +1,378 @@
+#include "../Collisions/mesh_bvh.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+using namespace Collisions;
+
+// Bounding box tests
+
+TEST(BoundingBoxTest, Creation)
+{
+    BoundingBox box;
+    EXPECT_TRUE( box.is_empty() );
+    EXPECT_EQ( 0, box.surface_area() );
+
+    box.add( Point(1,2,3) ).add( Point(-1,0,5) );
+    EXPECT_FALSE( box.is_empty() );
+    EXPECT_EQ( Point(-1,0,3), box.min );
+    EXPECT_EQ( Point(1,2,5), box.max );
+    EXPECT_EQ( Point(0,1,4), box.center() );
+    EXPECT_DOUBLE_EQ( 24, box.surface_area() );
+    EXPECT_TRUE( box.contains( Point(0,1,4) ) );
+    EXPECT_FALSE( box.contains( Point(0,1,6) ) );
+
+    const BoundingBox inflated = box.inflated( 1 );
+    EXPECT_EQ( Point(-2,-1,2), inflated.min );
+    EXPECT_EQ( Point(2,3,6), inflated.max );
+    EXPECT_TRUE( inflated.intersects( box ) );
+    EXPECT_FALSE( BoundingBox( Point(3,3,3), Point(4,4,4) ).intersects( box ) );
+}
+
+TEST(BoundingBoxTest, Segment)
+{
+    const BoundingBox box( Point(0,0,0), Point(1,1,1) );
+    double time;
+
+    EXPECT_TRUE( segment_and_box_collision( BoxRay( Point(-1,0.5,0.5), Point(3,0.5,0.5) ), box, 1, time ) );
+    EXPECT_DOUBLE_EQ( 0.25, time );
+    EXPECT_FALSE( segment_and_box_collision( BoxRay( Point(-1,0.5,0.5), Point(3,0.5,0.5) ), box, 0.2, time ) );
+    EXPECT_TRUE( segment_and_box_collision( BoxRay( Point(0.5,0.5,0.5), Point(3,3,3) ), box, 1, time ) ); // starts inside
+    EXPECT_DOUBLE_EQ( 0, time );
+    EXPECT_FALSE( segment_and_box_collision( BoxRay( Point(-1,2,0.5), Point(3,2,0.5) ), box, 1, time ) ); // parallel
+    EXPECT_FALSE( segment_and_box_collision( BoxRay( Point(-1,-1,0.5), Point(1,5,0.5) ), box, 1, time ) ); // passes by the corner
+}
+
+TEST(BoundingBoxTest, SquaredDistance)
+{
+    const BoundingBox box( Point(0,0,0), Point(1,2,3) );
+
+    EXPECT_EQ( 0, box.squared_distance( Point(0.5,1,1) ) );
+    EXPECT_EQ( 0, box.squared_distance( Point(1,2,3) ) );
+    EXPECT_DOUBLE_EQ( 4, box.squared_distance( Point(0.5,4,1) ) );
+    EXPECT_DOUBLE_EQ( 1 + 4 + 9, box.squared_distance( Point(-1,4,6) ) );
+    EXPECT_EQ( std::numeric_limits<double>::infinity(), BoundingBox().squared_distance( Point(0,0,0) ) );
+}
+
+// Mesh BVH tests
+
+TEST(MeshBVHTest, Creation)
+{
+    srand(2718);
+    const std::vector<Triangle> triangles = random_mesh( 500, 20 );
+    const MeshBVH mesh( triangles );
+
+    ASSERT_EQ( triangles.size(), mesh.size() );
+    ASSERT_GT( mesh.nodes_count(), 1u );
+
+    // triangles are a permutation of the original ones
+    std::vector<bool> used( triangles.size(), false );
+    for( unsigned i = 0; i < mesh.size(); ++i )
+    {
+        const unsigned index = mesh.original_index(i);
+        ASSERT_LT( index, triangles.size() );
+        EXPECT_FALSE( used[index] );
+        used[index] = true;
+        for( unsigned j = 0; j < 3; ++j )
+        {
+            EXPECT_EQ( triangles[index][j], mesh.triangle(i)[j] );
+        }
+    }
+
+    // every node contains its children, leaves cover all triangles
+    unsigned leaf_triangles = 0;
+    for( unsigned i = 0; i < mesh.nodes_count(); ++i )
+    {
+        const MeshBVH::Node &node = mesh.node(i);
+        if( node.is_leaf() )
+        {
+            EXPECT_LE( node.count, MeshBVH::MAX_LEAF_SIZE );
+            leaf_triangles += node.count;
+            for( unsigned j = node.first; j < node.first + node.count; ++j )
+            {
+                for( unsigned k = 0; k < 3; ++k )
+                {
+                    EXPECT_TRUE( node.box.contains( mesh.triangle(j)[k] ) );
+                }
+            }
+        }
+        else
+        {
+            ASSERT_LT( node.first + 1, mesh.nodes_count() );
+            for( unsigned j = 0; j < 2; ++j )
+            {
+                const BoundingBox &child = mesh.node( node.first + j ).box;
+                EXPECT_TRUE( node.box.contains( child.min ) );
+                EXPECT_TRUE( node.box.contains( child.max ) );
+            }
+        }
+    }
+    EXPECT_EQ( mesh.size(), leaf_triangles );
+}
+
+TEST(MeshBVHTest, Empty)
+{
+    const std::vector<Triangle> triangles;
+    const MeshBVH mesh( triangles );
+    SweepHit hit;
+
+    EXPECT_TRUE( mesh.empty() );
+    EXPECT_EQ( 0u, mesh.nodes_count() );
+    EXPECT_FALSE( sweep_sphere( mesh, Point(0,0,0), Point(1,1,1), 1, hit ) );
+}
+
+TEST(MeshBVHTest, Earliest)
+{
+    // a stack of horizontal triangles: z = 0..19, sphere is falling from above
+    std::vector<Triangle> triangles;
+    for( unsigned i = 0; i < 20; ++i )
+    {
+        triangles.push_back( Triangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    const MeshBVH mesh( triangles );
+    SweepHit hit;
+
+    EXPECT_TRUE( sweep_sphere( mesh, Point(2,2,30), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_EQ( 19u, hit.triangle_index );
+    EXPECT_EQ( Point(2,2,19), hit.collision_point );
+    EXPECT_EQ( Point(2,2,19.5), hit.sphere_center );
+    EXPECT_DOUBLE_EQ( 10.5/40, hit.time );
+
+    EXPECT_TRUE( sweep_sphere( mesh, Point(2,2,-10), Point(2,2,30), 0.5, hit ) );
+    EXPECT_EQ( 0u, hit.triangle_index );
+
+    EXPECT_TRUE( sweep_sphere( mesh, Point(2,2,7.7), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_EQ( 7u, hit.triangle_index );
+
+    EXPECT_FALSE( sweep_sphere( mesh, Point(10,2,7.7), Point(10,2,-10), 0.5, hit ) );
+}
+
+TEST(MeshBVHTest, Random)
+{
+    srand(31415);
+    const std::vector<Triangle> triangles = random_mesh( 300, 10 );
+    const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+    const MeshBVH mesh( triangles );
+
+    for( unsigned test = 0; test < 500; ++test )
+    {
+        const Point start = random_point(15);
+        const Point end = random_point(15);
+        const double R = random_double(0.1, 2);
+
+        SweepHit expected, hit;
+        const bool any_hit = sweep_sphere( prepared, start, end, R, expected );
+        ASSERT_EQ( any_hit, sweep_sphere( mesh, start, end, R, hit ) ) << "test #" << test;
+        if( any_hit )
+        {
+            ASSERT_LT( hit.triangle_index, triangles.size() );
+            EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+            EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 ) << "test #" << test;
+            // the same triangle, unless two triangles are touched at once
+            if( expected.triangle_index == hit.triangle_index )
+            {
+                EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "test #" << test;
+            }
+        }
+    }
+}
+
+TEST(MeshBVHTest, QueryModes)
+{
+    srand(1618);
+    const std::vector<Triangle> triangles = random_mesh( 300, 10 );
+    const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+    const MeshBVH mesh( triangles );
+
+    unsigned multiple_hits = 0;
+    for( unsigned test = 0; test < 500; ++test )
+    {
+        const Point start = random_point(15);
+        const Point end = random_point(15);
+        const double R = random_double(0.1, 2);
+
+        SweepHit closest, any;
+        std::vector<SweepHit> expected_all, all;
+        const bool any_hit = sweep_sphere( mesh, start, end, R, closest );
+        ASSERT_EQ( any_hit, sweep_sphere( mesh, start, end, R, AnyHit(), any ) ) << "test #" << test;
+        ASSERT_EQ( any_hit, sweep_sphere( mesh.view(), start, end, R, AllHits(), all ) ) << "test #" << test;
+        ASSERT_EQ( any_hit, sweep_sphere( prepared, start, end, R, AllHits(), expected_all ) ) << "test #" << test;
+        if( !any_hit )
+            continue;
+
+        // AnyHit finds one of the triangles touched, at some moment of touching it (not necessarily the first one)
+        ASSERT_EQ( expected_all.size(), all.size() ) << "test #" << test;
+        std::vector<int> expected_by_triangle( triangles.size(), -1 );
+        for( unsigned i = 0; i < expected_all.size(); ++i )
+        {
+            expected_by_triangle[expected_all[i].triangle_index] = i;
+        }
+        ASSERT_NE( -1, expected_by_triangle[any.triangle_index] ) << "test #" << test;
+        EXPECT_GE( any.time, expected_all[expected_by_triangle[any.triangle_index]].time - 1e-9 ) << "test #" << test;
+        EXPECT_LE( distance( any.sphere_center, any.collision_point ), R + 1e-9 ) << "test #" << test;   // less when starting inside
+        EXPECT_NEAR( 0, distance( start + any.time*(end - start), any.sphere_center ), 1e-9 ) << "test #" << test;
+
+        // all hits are the same, though in other order, and the closest one is the earliest of them
+        double earliest_time = 1;
+        for( unsigned i = 0; i < all.size(); ++i )
+        {
+            ASSERT_LT( all[i].triangle_index, triangles.size() );
+            const int expected = expected_by_triangle[all[i].triangle_index];
+            ASSERT_NE( -1, expected ) << "test #" << test;
+            EXPECT_NEAR( expected_all[expected].time, all[i].time, 1e-9 ) << "test #" << test;
+            EXPECT_NEAR( 0, distance( expected_all[expected].collision_point, all[i].collision_point ), 1e-9 ) << "test #" << test;
+            earliest_time = std::min( earliest_time, all[i].time );
+        }
+        EXPECT_NEAR( closest.time, earliest_time, 1e-9 ) << "test #" << test;
+        if( all.size() > 1 )
+        {
+            ++multiple_hits;
+        }
+    }
+    EXPECT_LT( 50u, multiple_hits );
+}
+
+TEST(MeshBVHTest, Raycast)
+{
+    srand(2024);
+    const std::vector<Triangle> triangles = random_mesh( 300, 10 );
+    const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+    const MeshBVH mesh( triangles );
+
+    unsigned hits = 0;
+    for( unsigned test = 0; test < 500; ++test )
+    {
+        const Point origin = random_point(15);
+        const Vector direction = random_point(5) - origin;
+        const double max_time = random_double(0.5, 2);
+
+        RayHit expected, hit, any;
+        const bool any_hit = raycast( prepared, origin, direction, max_time, expected );
+        ASSERT_EQ( any_hit, raycast( mesh, origin, direction, max_time, hit ) ) << "test #" << test;
+        ASSERT_EQ( any_hit, raycast( mesh.view(), origin, direction, max_time, AnyHit(), any ) ) << "test #" << test;
+        if( !any_hit )
+            continue;
+
+        ++hits;
+        ASSERT_LT( hit.triangle_index, triangles.size() );
+        EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+        EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "test #" << test;
+        if( expected.triangle_index == hit.triangle_index )
+        {
+            EXPECT_NEAR( expected.u, hit.u, 1e-9 ) << "test #" << test;
+            EXPECT_NEAR( expected.v, hit.v, 1e-9 ) << "test #" << test;
+        }
+
+        // any hit is a hit of that triangle, not farther than the ray goes
+        ASSERT_LT( any.triangle_index, triangles.size() );
+        EXPECT_GE( any.time, expected.time - 1e-9 ) << "test #" << test;
+        EXPECT_LE( any.time, max_time + 1e-9 ) << "test #" << test;
+        Point point;
+        EXPECT_TRUE( segment_and_triangle_collision( origin, origin + 2*max_time*direction, triangles[any.triangle_index], point ) ) << "test #" << test;
+    }
+    EXPECT_LT( 50u, hits );
+
+    RayHit hit;
+    EXPECT_THROW( raycast( mesh, Point(0,0,0), Vector(0,0,0), 1, hit ), InvalidLineVectorError );
+    EXPECT_FALSE( raycast( MeshBVH( std::vector<Triangle>() ), Point(0,0,0), Vector(0,0,1), 1, hit ) );
+}
+
+TEST(MeshBVHTest, ClosestPoint)
+{
+    srand(2025);
+    const std::vector<Triangle> triangles = random_mesh( 300, 10 );
+    const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+    const MeshBVH mesh( triangles );
+
+    // points along random paths, so that groups of them are near each other, with some left unlimited
+    std::vector<Point> points;
+    std::vector<double> max_distances;
+    for( unsigned path = 0; path < 40; ++path )
+    {
+        const Point start = random_point(15);
+        const Vector step = random_point(0.5);
+        const double max_distance = path % 4 == 0 ? std::numeric_limits<double>::infinity() : random_double(0.5, 4);
+        for( unsigned i = 0; i < 13; ++i )
+        {
+            points.push_back( start + i*step );
+            max_distances.push_back( max_distance );
+        }
+    }
+
+    unsigned hits = 0;
+    for( unsigned i = 0; i < points.size(); ++i )
+    {
+        ClosestPoint expected, result;
+        const bool any_hit = closest_point( prepared, points[i], max_distances[i], expected );
+        ASSERT_EQ( any_hit, closest_point( mesh, points[i], max_distances[i], result ) ) << "point #" << i;
+        if( !any_hit )
+            continue;
+
+        ++hits;
+        ASSERT_LT( result.triangle_index, triangles.size() );
+        EXPECT_DOUBLE_EQ( expected.distance, result.distance ) << "point #" << i;
+        EXPECT_DOUBLE_EQ( expected.distance, distance( points[i], result.point ) ) << "point #" << i;
+        EXPECT_DOUBLE_EQ( expected.distance, distance_between_point_and_triangle( points[i], triangles[result.triangle_index] ) ) << "point #" << i;
+    }
+    EXPECT_LT( 100u, hits );
+
+    // groups find the same, as single queries do: a full group and a partial one per path
+    for( unsigned path = 0; path < 40; ++path )
+    {
+        const unsigned first = path*13;
+        std::vector<ClosestPoint> results( 13 );
+        std::vector<CollisionStatus> statuses( 13 );
+        closest_point( mesh.view(), &points[first], 13, max_distances[first], &results[0], &statuses[0] );
+        for( unsigned i = 0; i < 13; ++i )
+        {
+            ClosestPoint expected;
+            const CollisionStatus status = NoThrow::closest_point( mesh, points[first + i], max_distances[first], expected );
+            ASSERT_EQ( status, statuses[i] ) << "point #" << first + i;
+            if( status == CollisionStatus::Hit )
+            {
+                EXPECT_DOUBLE_EQ( expected.distance, results[i].distance ) << "point #" << first + i;
+                EXPECT_DOUBLE_EQ( expected.distance, distance( points[first + i], results[i].point ) ) << "point #" << first + i;
+            }
+        }
+    }
+
+    ClosestPoint result;
+    EXPECT_FALSE( closest_point( MeshBVH( std::vector<Triangle>() ), Point(0,0,0), 1, result ) );
+    EXPECT_FALSE( closest_point( mesh, Point(0,0,0), -1, result ) );
+    CollisionStatus status = CollisionStatus::Hit;
+    closest_point( MeshBVH( std::vector<Triangle>() ), &points[0], 1, 1, &result, &status );
+    EXPECT_EQ( CollisionStatus::Miss, status );
+}
+
+TEST(MeshBVHTest, BlackTest)
+{
+    std::vector<Triangle> triangles;
+    triangles.push_back( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    const MeshBVH mesh( triangles );
+    const Point A(1, 1, 1);
+    SweepHit hit;
+
+    EXPECT_THROW( sweep_sphere( mesh, A, A, 0.5, hit ), DegeneratedSegmentError );
+    EXPECT_THROW( sweep_sphere( mesh, A, A, 0.5, AnyHit(), hit ), DegeneratedSegmentError );
+    std::vector<SweepHit> hits;
+    EXPECT_THROW( sweep_sphere( mesh, A, A, 0.5, AllHits(), hits ), DegeneratedSegmentError );
+    EXPECT_THROW( mesh.node(1), OutOfBoundsError );
+    EXPECT_THROW( mesh.triangle(1), OutOfBoundsError );
+
+    triangles.push_back( Triangle( Point(1,2,3), Point(2,3,4), Point(3,4,5) ) );
+    EXPECT_THROW( MeshBVH mesh2( triangles ), DegeneratedTriangleError );
+}
+
+TEST(MeshBVHTest, NoThrow)
+{
+    const MeshBVH mesh( std::vector<Triangle>( 1, Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) ) );
+    const Point A(2, 2, 1);
+    SweepHit hit;
+
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sweep_sphere( mesh, A, -A, 0.5, hit ) );
+    EXPECT_EQ( 0u, hit.triangle_index );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::sweep_sphere( mesh, A, 2*A, 0.5, hit ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sweep_sphere( mesh, A, A, 0.5, hit ) );
+}
@@ -1,5 +1,7 @@
 #include "../Collisions/collisions.h"
+#include "test_helpers.h"
 #include <gtest/gtest.h>
+#include <cstdlib>
 
 using namespace Collisions;
 
@@ -145,6 +147,100 @@ TEST(SegmentAndPlaneTest, BlackTest)
     EXPECT_THROW( segment_and_plane_collision( A, B, A, ZERO, result ), InvalidNormalError );
 }
 
+// Segment and triangle tests
+
+TEST(SegmentAndTriangleTest, Trivial)
+{
+    const Triangle triangle( Point(0,0,0), Point(4,0,0), Point(0,4,0) );
+    const PreparedTriangle prepared( triangle );
+    Point result;
+    double time;
+
+    // through the inside, from both faces
+    EXPECT_TRUE( segment_and_triangle_collision( Point(1,1,2), Point(1,1,-2), triangle, result, time ) );
+    EXPECT_EQ( Point(1,1,0), result );
+    EXPECT_DOUBLE_EQ( 0.5, time );
+    EXPECT_TRUE( segment_and_triangle_collision( Point(1,1,-1), Point(1,1,3), prepared, result, time ) );
+    EXPECT_EQ( Point(1,1,0), result );
+    EXPECT_DOUBLE_EQ( 0.25, time );
+
+    // through a side and a vertex
+    EXPECT_TRUE( segment_and_triangle_collision( Point(2,2,1), Point(2,2,-1), prepared, result ) );
+    EXPECT_EQ( Point(2,2,0), result );
+    EXPECT_TRUE( segment_and_triangle_collision( Point(4,0,1), Point(4,0,-1), triangle, result ) );
+    EXPECT_EQ( Point(4,0,0), result );
+
+    // ending on the triangle, short of it, outside of it, and in its plane
+    EXPECT_TRUE( segment_and_triangle_collision( Point(1,1,1), Point(1,1,0), prepared, result, time ) );
+    EXPECT_DOUBLE_EQ( 1, time );
+    EXPECT_FALSE( segment_and_triangle_collision( Point(1,1,2), Point(1,1,0.5), prepared, result ) );
+    EXPECT_FALSE( segment_and_triangle_collision( Point(3,3,1), Point(3,3,-1), triangle, result ) );
+    EXPECT_FALSE( segment_and_triangle_collision( Point(-1,1,0), Point(5,1,0), prepared, result ) );
+}
+
+TEST(SegmentAndTriangleTest, SameAsPlaneAndInside)
+{
+    srand(2718);
+    unsigned hits = 0;
+    for( unsigned i = 0; i < 1000; ++i )
+    {
+        const Triangle triangle( random_point(5), random_point(5), random_point(5) );
+        const PreparedTriangle prepared( triangle );
+        // segments through the triangle's neighbourhood
+        const Point start = random_point(10);
+        const Point end = start + 2*( triangle[0] + ( (triangle[1] - triangle[0]) + (triangle[2] - triangle[0]) )/3 + random_point(2) - start );
+
+        // the composition of plane and inside tests, far enough from the boundaries
+        Point plane_point;
+        const bool crosses_plane = segment_and_plane_collision( start, end, triangle[0], triangle.normal(), plane_point );
+        double u = 0, v = 0;
+        if( crosses_plane )
+        {
+            prepared.barycentric( plane_point, u, v );
+        }
+        const double margin = 1e-6;
+        const bool inside = crosses_plane && u > margin && v > margin && u + v < 1 - margin;
+        const bool outside = !crosses_plane || u < -margin || v < -margin || u + v > 1 + margin;
+        if( !inside && !outside )
+            continue;
+
+        Point result;
+        double time;
+        ASSERT_EQ( inside, segment_and_triangle_collision( start, end, prepared, result, time ) ) << "test #" << i;
+        EXPECT_EQ( inside, segment_and_triangle_collision( start, end, triangle, result ) ) << "test #" << i;
+        if( inside )
+        {
+            ++hits;
+            EXPECT_EQ( plane_point, result );
+            EXPECT_EQ( start + time*(end - start), result );
+        }
+    }
+    EXPECT_LT( 50u, hits );
+}
+
+TEST(SegmentAndTriangleTest, Float)
+{
+    const TriangleF triangle( PointF(0,0,0), PointF(4,0,0), PointF(0,4,0) );
+    PointF result;
+    float time;
+
+    EXPECT_TRUE( segment_and_triangle_collision( PointF(1,1,2), PointF(1,1,-2), PreparedTriangleF( triangle ), result, time ) );
+    EXPECT_FLOAT_EQ( 0.5f, time );
+    EXPECT_FALSE( segment_and_triangle_collision( PointF(3,3,1), PointF(3,3,-1), triangle, result ) );
+}
+
+TEST(SegmentAndTriangleTest, BlackTest)
+{
+    const Point A(1,2,3), B(2,3,4), C(3,4,5);
+    const Triangle triangle( Point(0,0,0), Point(4,0,0), Point(0,4,0) );
+    Point result;
+
+    EXPECT_THROW( segment_and_triangle_collision( A, A, triangle, result ), DegeneratedSegmentError );
+    EXPECT_THROW( segment_and_triangle_collision( A, A, PreparedTriangle( triangle ), result ), DegeneratedSegmentError );
+    EXPECT_THROW( segment_and_triangle_collision( A, B, Triangle( A, B, C ), result ), DegeneratedTriangleError );
+    EXPECT_EQ( CollisionStatus::DegenerateTriangle, NoThrow::segment_and_triangle_collision( A, B, Triangle( A, B, C ), result ) );
+}
+
 // Sphere and plane tests
 
 TEST(SphereAndPlaneTest, Parallel)
@@ -313,6 +409,88 @@ TEST(SphereAndPointTest, BlackTest)
     EXPECT_THROW( sphere_and_point_collision( A, A, 0.5, A ), DegeneratedSegmentError );
 }
 
+// Sphere and sphere tests
+
+TEST(SphereAndSphereTest, HeadOn)
+{
+    const Point A1(-3, 0, 0), B1(1, 0, 0);
+    const Point A2( 3, 0, 0), B2(-1, 0, 0);
+    Point point;
+    double time = -1;
+
+    // they approach by 8 in total and touch, when the distance 6 is reduced to 2 + 1
+    EXPECT_TRUE( sphere_and_sphere_collision( A1, B1, 2.0, A2, B2, 1.0, point, time ) );
+    EXPECT_DOUBLE_EQ( 3.0/8, time );
+    EXPECT_EQ( Point(0.5, 0, 0), point );
+    // the same from the other side
+    EXPECT_TRUE( sphere_and_sphere_collision( A2, B2, 1.0, A1, B1, 2.0, point, time ) );
+    EXPECT_DOUBLE_EQ( 3.0/8, time );
+    EXPECT_EQ( Point(0.5, 0, 0), point );
+    // they don't meet in time
+    EXPECT_FALSE( sphere_and_sphere_collision( A1, A1 + 0.3*(B1 - A1), 2.0, A2, A2 + 0.3*(B2 - A2), 1.0, point ) );
+}
+
+TEST(SphereAndSphereTest, Passing)
+{
+    const Point A1(-2, 0, 0), B1(2, 0, 0);
+    const Point A2( 2, 1, 0), B2(-2, 1, 0); // nearest at time 0.5: distance 1
+    Point point;
+    double time = -1;
+
+    EXPECT_TRUE(  sphere_and_sphere_collision( A1, B1, 0.6, A2, B2, 0.5, point, time ) );
+    EXPECT_LT( time, 0.5 );
+    EXPECT_TRUE(  sphere_and_sphere_collision( A1, B1, 0.5, A2, B2, 0.5, point, time ) ); // touching
+    EXPECT_DOUBLE_EQ( 0.5, time );
+    EXPECT_EQ( Point(0, 0.5, 0), point );
+    EXPECT_FALSE( sphere_and_sphere_collision( A1, B1, 0.4, A2, B2, 0.5, point, time ) );
+}
+
+TEST(SphereAndSphereTest, StaticAndParallel)
+{
+    const Point A(0, 0, 0), B(4, 0, 0);
+    const Point P(2, 1, 0);
+    Point point;
+    double time = -1;
+
+    // one of spheres stays in place: the same as the sphere and point test with sum of radii
+    EXPECT_TRUE( sphere_and_sphere_collision( A, B, 0.7, P, P, 0.5, point, time ) );
+    Point center;
+    double point_time = -1;
+    EXPECT_TRUE( sphere_and_point_collision( A, B, 1.2, P, center, point_time ) );
+    EXPECT_DOUBLE_EQ( point_time, time );
+    EXPECT_FALSE( sphere_and_sphere_collision( P, P, 0.5, A, B, 0.4, point ) );
+
+    // moving the same way: only intersecting from the start
+    const Point Q(0, 1, 0);
+    EXPECT_TRUE( sphere_and_sphere_collision( A, B, 0.7, Q, Q + (B - A), 0.5, point, time ) );
+    EXPECT_EQ( 0, time );
+    EXPECT_FALSE( sphere_and_sphere_collision( A, B, 0.5, Q, Q + (B - A), 0.4, point, time ) );
+    // intersecting from the start
+    EXPECT_TRUE( sphere_and_sphere_collision( A, B, 1, Point(0.5, 0, 0), Point(0.5, 3, 0), 1, point, time ) );
+    EXPECT_EQ( 0, time );
+}
+
+TEST(SphereAndSphereTest, BlackTest)
+{
+    const Point A(1, 1, 1);
+    Point point;
+
+    EXPECT_THROW( sphere_and_sphere_collision( A, A, 0.5, A, A, 0.5, point ), DegeneratedSegmentError );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_sphere_collision( A, A, 0.5, -A, -A, 0.5, point ) );
+}
+
+TEST(SphereAndSphereTest, Float)
+{
+    const PointF A1(-3, 0, 0), B1(1, 0, 0);
+    const PointF A2( 3, 0, 0), B2(-1, 0, 0);
+    PointF point;
+    float time = -1;
+
+    EXPECT_TRUE( sphere_and_sphere_collision( A1, B1, 2.0f, A2, B2, 1.0f, point, time ) );
+    EXPECT_FLOAT_EQ( 3.0f/8, time );
+    EXPECT_EQ( PointF(0.5f, 0, 0), point );
+}
+
 // Sphere and point tests
 
 TEST( SphereAndSegmentTest, Parallel )
@@ -453,6 +631,63 @@ TEST(SphereAndSegmentTest, BlackTest)
     EXPECT_THROW( sphere_and_segment_collision( A, B, 0.5, A, A, temp ), DegeneratedSegmentError );
 }
 
+TEST(SphereAndSegmentTest, ContactNormal)
+{
+    const Point P1(0,0,0), P2(2,0,0); // segment
+    const double R = 0.5;
+    const double height = 0.3;
+    const double d = sqrt( R*R - height*height );
+    const Point A(1, d+1, height);
+    const Point C(1, -d-1, height);
+
+    Point result, center;
+    Vector normal;
+    double time;
+
+    EXPECT_TRUE( sphere_and_segment_collision( A, C, R, P1, P2, result, center, normal, time ) );
+    EXPECT_EQ( Point(1, 0, 0), result );
+    EXPECT_EQ( Point(1, d, height), center );
+    EXPECT_EQ( Vector(0, d, height)/R, normal );
+    EXPECT_DOUBLE_EQ( 1/(2*d + 2), time );
+}
+
+TEST(SphereAndSegmentTest, Random)
+{
+    // a hit must be the first touch of the segment: the sphere center is at distance R from the touch point,
+    // the touch point is nearest to it on the segment, and the sphere was not nearer before
+    const unsigned COUNT = 2000;
+    const unsigned SAMPLES = 200;
+    unsigned hits = 0;
+    srand(10);
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        const Point P1 = random_point(1), P2 = random_point(1);
+        const Point A = random_point(3), B = random_point(3);
+        const double R = random_double(0.1, 1);
+
+        Point result, center;
+        Vector normal;
+        double time;
+        if( !sphere_and_segment_collision( A, B, R, P1, P2, result, center, normal, time ) )
+            continue;
+        ++hits;
+
+        EXPECT_LE( 0, time );
+        EXPECT_GE( 1, time );
+        EXPECT_EQ( A + time*(B - A), center );
+        EXPECT_TRUE( is_point_between( result, P1, P2 ) );
+        EXPECT_NEAR( R, distance( center, result ), 1e-9 );
+        EXPECT_NEAR( R, distance_between_point_and_segment( center, P1, P2 ), 1e-9 );
+        EXPECT_NEAR( 1, normal.norm(), 1e-9 );
+        for( unsigned j = 0; j < SAMPLES; ++j )
+        {
+            const double earlier = time*j/SAMPLES;
+            EXPECT_LT( R - 1e-9, distance_between_point_and_segment( A + earlier*(B - A), P1, P2 ) );
+        }
+    }
+    EXPECT_LT( COUNT/20, hits );
+}
+
 TEST(SphereAndTriangleTest, TouchingPlane)
 {
     const double R = 0.32;
@@ -536,3 +771,464 @@ TEST(SphereAndTriangleTest, OutsideOnly)
     EXPECT_TRUE(  sphere_and_triangle_collision( D, C, R, triangle, result ) );
     EXPECT_FALSE( sphere_and_triangle_collision( C, D, R, triangle, result ) );
 }
+
+TEST(SphereAndTriangleTest, Prepared)
+{
+    const double R = 0.32;
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    const PreparedTriangle prepared( triangle );
+    const Point inner(2,2,0);
+    const Vector L( 0, 0, 2*R );
+    const Point A = triangle[1] + Point(0,0,R);
+    const Point B = triangle[0] - Point(R,R,0);
+
+    Point result;
+
+    EXPECT_TRUE(  sphere_and_triangle_collision( inner-L, inner+L, R, prepared, result ) );
+    EXPECT_EQ( inner, result );
+    EXPECT_TRUE(  sphere_and_triangle_collision( Point(4,-2*R,0), Point(4,6+R,0), R, prepared, result ) ); // side
+    EXPECT_EQ( Point(4,0,0), result );
+    EXPECT_TRUE(  sphere_and_triangle_collision( Point(7,-1,0), Point(3,+1,0), R, prepared, result ) ); // vertex
+    EXPECT_EQ( triangle[2], result );
+    EXPECT_TRUE(  sphere_and_triangle_collision( A, B, R, prepared, result ) );
+    EXPECT_EQ( triangle[1], result );
+    EXPECT_TRUE(  sphere_and_triangle_collision( B, A, R, prepared, result ) );
+    EXPECT_EQ( triangle[0], result );
+    EXPECT_FALSE( sphere_and_triangle_collision( Point(2,2*R,0), Point(2,-3*R,0), R, prepared, result ) );
+    EXPECT_THROW( sphere_and_triangle_collision( A, A, R, prepared, result ), DegeneratedSegmentError );
+}
+
+namespace
+{
+    enum ReferenceStage { PLANE, SIDE, VERTEX, MISS };
+
+    // sphere and triangle collision, decomposed into public finders: a plane, three sides and three vertices
+    ReferenceStage reference_sphere_and_triangle(const Point &start, const Point &end, double R, const PreparedTriangle &triangle,
+                                                 /*out*/ Point &collision_point, double &time)
+    {
+        Point point, center;
+        double t;
+        if( sphere_and_plane_collision( start, end, R, triangle[0], triangle.normal(), point, center, t ) &&
+            is_point_inside_triangle( point, triangle ) )
+        {
+            collision_point = point;
+            time = t;
+            return PLANE;
+        }
+        bool moving_inside[3];
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            moving_inside[i] = (end - start)*triangle.side_outer_normal(i) < 0;
+        }
+        bool any = false;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( moving_inside[i] && sphere_and_segment_collision( start, end, R, triangle[i], triangle[(i+1)%3], point, center, t ) &&
+                ( !any || time > t ) )
+            {
+                collision_point = point;
+                time = t;
+                any = true;
+            }
+        }
+        if( any )
+            return SIDE;
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            if( moving_inside[i] && moving_inside[(i+2)%3] && sphere_and_point_collision( start, end, R, triangle[i], center, t ) &&
+                ( !any || time > t ) )
+            {
+                collision_point = triangle[i];
+                time = t;
+                any = true;
+            }
+        }
+        return any ? VERTEX : MISS;
+    }
+}
+
+TEST(SphereAndTriangleTest, SameAsDecomposition)
+{
+    const unsigned COUNT = 1000000;
+    unsigned stages[4] = { 0, 0, 0, 0 };
+    unsigned mismatches = 0;
+    srand(11);
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        const Triangle triangle( random_point(1), random_point(1), random_point(1) );
+        if( triangle.is_degenerated() )
+            continue;
+        const PreparedTriangle prepared( triangle );
+        const double R = random_double(0.05, 1);
+        Point A = random_point(3);
+        Point B = random_point(3);
+        if( i % 4 == 0 )
+        {
+            // moving in the plane of triangle: sides and vertices are hit more often
+            A = A - ((A - triangle[0])*prepared.normal())*prepared.normal();
+            B = B - ((B - triangle[0])*prepared.normal())*prepared.normal();
+        }
+
+        Point expected_point, point, center;
+        double expected_time = 0, time = 0;
+        const ReferenceStage stage = reference_sphere_and_triangle( A, B, R, prepared, expected_point, expected_time );
+        ++stages[stage];
+
+        const bool result = sphere_and_triangle_collision( A, B, R, prepared, point, center, time );
+        Point triangle_point, triangle_center;
+        double triangle_time = 0;
+        const bool triangle_result = sphere_and_triangle_collision( A, B, R, triangle, triangle_point, triangle_center, triangle_time );
+        const bool expected = stage != MISS;
+        const bool any_result = sphere_and_triangle_collision( A, B, R, prepared, AnyHit() );
+        const bool triangle_any_result = sphere_and_triangle_collision( A, B, R, triangle, AnyHit() );
+        if( result != expected || triangle_result != expected || any_result != expected || triangle_any_result != expected ||
+            ( expected && ( distance( point, expected_point ) > 1e-9 || fabs( time - expected_time ) > 1e-9 ||
+                            distance( triangle_point, expected_point ) > 1e-9 || fabs( triangle_time - expected_time ) > 1e-9 ) ) )
+        {
+            ++mismatches;
+            ADD_FAILURE() << "case " << i << ": expected " << expected << " at " << expected_time << ", got " << result << " at " << time;
+            if( mismatches > 10 )
+                return;
+        }
+    }
+    EXPECT_EQ( 0u, mismatches );
+    // all regions are covered
+    EXPECT_LT( COUNT/100, stages[PLANE] );
+    EXPECT_LT( COUNT/100, stages[SIDE] );
+    EXPECT_LT( COUNT/1000, stages[VERTEX] );
+    EXPECT_LT( COUNT/100, stages[MISS] );
+}
+
+TEST(SphereAndTriangleTest, FloatSameAsDouble)
+{
+    // single precision kernels agree with double ones, except for cases near borders of regions
+    const unsigned COUNT = 100000;
+    unsigned mismatches = 0;
+    unsigned hits = 0;
+    srand(13);
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        const Triangle triangle( random_point(1), random_point(1), random_point(1) );
+        if( triangle.is_degenerated() )
+            continue;
+        const double R = random_double(0.05, 1);
+        const Point A = random_point(3);
+        const Point B = random_point(3);
+        const PointF vertices[3] = { PointF( triangle[0] ), PointF( triangle[1] ), PointF( triangle[2] ) };
+        const TriangleF triangle_float( vertices[0], vertices[1], vertices[2] );
+        const PreparedTriangleF prepared_float( triangle_float );
+
+        Point point, center;
+        double time = 0;
+        const bool result = sphere_and_triangle_collision( A, B, R, triangle, point, center, time );
+        PointF point_float, center_float;
+        float time_float = 0;
+        const bool result_float = sphere_and_triangle_collision( PointF( A ), PointF( B ), static_cast<float>( R ), triangle_float,
+                                                                 point_float, center_float, time_float );
+        PointF prepared_point;
+        const bool prepared_result = sphere_and_triangle_collision( PointF( A ), PointF( B ), R, prepared_float, prepared_point );
+        EXPECT_EQ( result_float, prepared_result );
+
+        if( result != result_float )
+        {
+            ++mismatches;
+        }
+        else if( result )
+        {
+            ++hits;
+            EXPECT_NEAR( time, time_float, 1e-3 );
+            EXPECT_LT( distance( point, Point( point_float ) ), 1e-3 );
+        }
+    }
+    EXPECT_LT( COUNT/10, hits );
+    EXPECT_GT( COUNT/1000, mismatches );
+}
+
+TEST(SphereAndSegmentTest, Float)
+{
+    const PointF A( 0, 0, 0 );
+    const PointF B( 0, 10, 0 );
+    PointF point, center;
+    VectorF normal;
+    float time;
+    EXPECT_TRUE( sphere_and_segment_collision( PointF( -5, 5, 0 ), PointF( 5, 5, 0 ), 1, A, B, point, center, normal, time ) );
+    EXPECT_EQ( PointF( 0, 5, 0 ), point );
+    EXPECT_EQ( PointF( -1, 5, 0 ), center );
+    EXPECT_EQ( VectorF( -1, 0, 0 ), normal );
+    EXPECT_NEAR( 0.4f, time, 1e-6f );
+    EXPECT_THROW( sphere_and_segment_collision( A, A, 1, A, B, point ), DegeneratedSegmentError );
+}
+
+// Exception-free finders tests
+
+TEST(NoThrowTest, Statuses)
+{
+    const double R = 0.32;
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    const PreparedTriangle prepared( triangle );
+    const Triangle degenerated( Point(1,2,3), Point(2,3,4), Point(3,4,5) );
+    const Point inner(2,2,0);
+    const Vector L( 0, 0, 2*R );
+    const Vector N( 0, 0, 1 );
+    const Vector ZERO( 0, 0, 0 );
+
+    Point result;
+
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sphere_and_triangle_collision( inner-L, inner+L, R, triangle, result ) );
+    EXPECT_EQ( inner, result );
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sphere_and_triangle_collision( inner-L, inner+L, R, prepared, result ) );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::sphere_and_triangle_collision( inner+L, inner+2*L, R, triangle, result ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_triangle_collision( inner, inner, R, triangle, result ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_triangle_collision( inner, inner, R, prepared, result ) );
+    EXPECT_EQ( CollisionStatus::DegenerateTriangle, NoThrow::sphere_and_triangle_collision( inner-L, inner+L, R, degenerated, result ) );
+
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::line_and_plane_collision( inner+L, L, inner, N, result ) );
+    EXPECT_EQ( CollisionStatus::InvalidLineVector, NoThrow::line_and_plane_collision( inner, ZERO, inner, N, result ) );
+    EXPECT_EQ( CollisionStatus::InvalidNormal, NoThrow::line_and_plane_collision( inner, L, inner, ZERO, result ) );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::segment_and_plane_collision( inner+L, inner+2*L, inner, N, result ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::segment_and_plane_collision( inner, inner, inner, N, result ) );
+    EXPECT_EQ( CollisionStatus::InvalidNormal, NoThrow::sphere_and_plane_collision( inner-L, inner+L, R, inner, ZERO, result ) );
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sphere_and_point_collision( inner-L, inner+L, R, inner ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_point_collision( inner, inner, R, inner ) );
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sphere_and_segment_collision( Point(1,1,0), Point(1,-1,0), R, Point(0,0,0), Point(2,0,0), result ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_segment_collision( inner-L, inner+L, R, inner, inner, result ) );
+}
+
+TEST(NoThrowTest, CheckStatus)
+{
+    EXPECT_TRUE( check_status( CollisionStatus::Hit ) );
+    EXPECT_FALSE( check_status( CollisionStatus::Miss ) );
+    EXPECT_THROW( check_status( CollisionStatus::DegenerateSegment ), DegeneratedSegmentError );
+    EXPECT_THROW( check_status( CollisionStatus::DegenerateTriangle ), DegeneratedTriangleError );
+    EXPECT_THROW( check_status( CollisionStatus::InvalidNormal ), InvalidNormalError );
+    EXPECT_THROW( check_status( CollisionStatus::InvalidLineVector ), InvalidLineVectorError );
+}
+
+// Time of impact tests
+
+TEST(TimeOfImpactTest, Planes)
+{
+    const Point A(1, 1, 1);
+    const Point B(1, 1, -1);
+    const Point D(1, 1, -2);
+    const Point P0(0, 0, 0);
+    const Vector N(0, 0, 1);
+    const double R = 0.25;
+
+    Point result, center;
+    double time;
+
+    EXPECT_TRUE( line_and_plane_collision( A, D - A, P0, N, result, time ) );
+    EXPECT_DOUBLE_EQ( 1.0/3, time );
+    EXPECT_TRUE( segment_and_plane_collision( A, B, P0, N, result, time ) );
+    EXPECT_DOUBLE_EQ( 0.5, time );
+    EXPECT_TRUE( sphere_and_plane_collision( A, D, R, P0, N, result, center, time ) );
+    EXPECT_DOUBLE_EQ( 0.25, time );
+    EXPECT_EQ( Point(1, 1, R), center );
+    EXPECT_TRUE( sphere_and_plane_collision( D, A, R, P0, N, result, center, time ) );
+    EXPECT_DOUBLE_EQ( 1.75/3, time );
+    EXPECT_EQ( Point(1, 1, -R), center );
+}
+
+TEST(TimeOfImpactTest, Point)
+{
+    const Point P(2.5, 0, 0);
+    const Point A(0, 0, 1.1);
+    const Point B(0, 0, -1.2);
+    const double R = 2.6;
+    const double touch_z = sqrt( R*R - 2.5*2.5 );
+
+    Point center;
+    double time;
+
+    EXPECT_TRUE( sphere_and_point_collision( A, B, R, P, center, time ) );
+    EXPECT_DOUBLE_EQ( (1.1 - touch_z)/2.3, time );
+    EXPECT_EQ( Point(0, 0, touch_z), center );
+    EXPECT_EQ( R, distance( P, center ) );
+
+    EXPECT_TRUE( sphere_and_point_collision( Point(0, 0, 0), B, R, P, center, time ) ); // touching from the start
+    EXPECT_EQ( 0, time );
+    EXPECT_FALSE( sphere_and_point_collision( A, B, 2.4, P, center, time ) );
+}
+
+TEST(TimeOfImpactTest, Segment)
+{
+    const Point P1(0,0,0), P2(2,0,0); // segment
+    const double R = 0.25;
+    const Point A(1,  R+1, 0);
+    const Point C(1, -R-1, 0);
+
+    Point result, center;
+    double time;
+
+    EXPECT_TRUE( sphere_and_segment_collision( A, C, R, P1, P2, result, center, time ) );
+    EXPECT_EQ( Point(1, 0, 0), result );
+    EXPECT_DOUBLE_EQ( 1/(2*R + 2), time );
+    EXPECT_EQ( Point(1, R, 0), center );
+}
+
+TEST(TimeOfImpactTest, Triangle)
+{
+    const double R = 0.32;
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    const PreparedTriangle prepared( triangle );
+    const Point inner(2,2,0);
+    const Vector L( 0, 0, 2*R );
+    const Point A(7,-1,0);
+    const Point B(3,+1,0);
+
+    Point result, center;
+    double time;
+
+    EXPECT_TRUE( sphere_and_triangle_collision( inner-L, inner+L, R, triangle, result, center, time ) ); // plane
+    EXPECT_DOUBLE_EQ( 0.25, time );
+    EXPECT_EQ( inner - Vector(0,0,R), center );
+    EXPECT_TRUE( sphere_and_triangle_collision( inner-L, inner+L, R, prepared, result, center, time ) );
+    EXPECT_DOUBLE_EQ( 0.25, time );
+
+    EXPECT_TRUE( sphere_and_triangle_collision( Point(4,-2*R,0), Point(4,6+R,0), R, prepared, result, center, time ) ); // side
+    EXPECT_DOUBLE_EQ( R/(6 + 3*R), time );
+    EXPECT_EQ( Point(4,-R,0), center );
+
+    EXPECT_TRUE( sphere_and_triangle_collision( A, B, R, triangle, result, center, time ) ); // vertex
+    EXPECT_EQ( triangle[2], result );
+    EXPECT_DOUBLE_EQ( R, distance( center, triangle[2] ) );
+    EXPECT_EQ( A + time*(B - A), center );
+}
+
+// Sweep sphere against triangles tests
+
+TEST(SweepSphereVectorTest, Earliest)
+{
+    // a stack of 7 horizontal triangles: z = 0..6, sphere is falling from above
+    std::vector<PreparedTriangle> triangles;
+    for( unsigned i = 0; i < 7; ++i )
+    {
+        triangles.push_back( PreparedTriangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    SweepHit hit;
+
+    EXPECT_TRUE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_EQ( 6u, hit.triangle_index );
+    EXPECT_EQ( Point(2,2,6), hit.collision_point );
+    EXPECT_EQ( Point(2,2,6.5), hit.sphere_center );
+    EXPECT_DOUBLE_EQ( 3.5/20, hit.time );
+
+    EXPECT_TRUE( sweep_sphere( triangles, Point(2,2,-10), Point(2,2,10), 0.5, hit ) );
+    EXPECT_EQ( 0u, hit.triangle_index );
+    EXPECT_DOUBLE_EQ( 9.5/20, hit.time );
+
+    EXPECT_FALSE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,7), 0.5, hit ) );
+    EXPECT_FALSE( sweep_sphere( std::vector<PreparedTriangle>(), Point(2,2,10), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_THROW( sweep_sphere( triangles, Point(2,2,10), Point(2,2,10), 0.5, hit ), DegeneratedSegmentError );
+}
+
+TEST(SweepSphereVectorTest, QueryModes)
+{
+    // the same stack of triangles
+    std::vector<PreparedTriangle> triangles;
+    for( unsigned i = 0; i < 7; ++i )
+    {
+        triangles.push_back( PreparedTriangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    SweepHit hit;
+    std::vector<SweepHit> hits;
+
+    // any triangle will do, but the hit is consistent
+    EXPECT_TRUE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,-10), 0.5, AnyHit(), hit ) );
+    ASSERT_LT( hit.triangle_index, triangles.size() );
+    EXPECT_EQ( Point(2,2,hit.triangle_index), hit.collision_point );
+    EXPECT_EQ( Point(2,2,hit.triangle_index + 0.5), hit.sphere_center );
+    EXPECT_DOUBLE_EQ( (9.5 - hit.triangle_index)/20, hit.time );
+    EXPECT_FALSE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,7), 0.5, AnyHit(), hit ) );
+
+    // every triangle is touched once, on its own earliest touch
+    EXPECT_TRUE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,-10), 0.5, AllHits(), hits ) );
+    ASSERT_EQ( triangles.size(), hits.size() );
+    std::vector<bool> touched( triangles.size(), false );
+    for( unsigned i = 0; i < hits.size(); ++i )
+    {
+        ASSERT_LT( hits[i].triangle_index, triangles.size() );
+        EXPECT_FALSE( touched[hits[i].triangle_index] );
+        touched[hits[i].triangle_index] = true;
+        EXPECT_DOUBLE_EQ( (9.5 - hits[i].triangle_index)/20, hits[i].time );
+    }
+    EXPECT_FALSE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,7), 0.5, AllHits(), hits ) );
+    EXPECT_TRUE( hits.empty() );
+
+    // the closest one is the same as without the mode
+    EXPECT_TRUE( sweep_sphere( triangles, Point(2,2,10), Point(2,2,-10), 0.5, ClosestHit(), hit ) );
+    EXPECT_EQ( 6u, hit.triangle_index );
+
+    EXPECT_THROW( sweep_sphere( triangles, Point(2,2,10), Point(2,2,10), 0.5, AnyHit(), hit ), DegeneratedSegmentError );
+    EXPECT_THROW( sweep_sphere( triangles, Point(2,2,10), Point(2,2,10), 0.5, AllHits(), hits ), DegeneratedSegmentError );
+}
+
+// Raycast against triangles tests
+
+TEST(RaycastVectorTest, Nearest)
+{
+    // the same stack of triangles, rays of different lengths
+    std::vector<PreparedTriangle> triangles;
+    for( unsigned i = 0; i < 7; ++i )
+    {
+        triangles.push_back( PreparedTriangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    RayHit hit;
+
+    EXPECT_TRUE( raycast( triangles, Point(2,2,10), Vector(0,0,-2), 100, hit ) );
+    EXPECT_EQ( 6u, hit.triangle_index );
+    EXPECT_EQ( Point(2,2,6), hit.collision_point );
+    EXPECT_DOUBLE_EQ( 2, hit.time );
+    EXPECT_NEAR( 0.5, hit.u, 1e-12 ); // (2,2) == 0.5*(2,4) + 0.2*(5,0)
+    EXPECT_NEAR( 0.2, hit.v, 1e-12 );
+
+    EXPECT_TRUE( raycast( triangles, Point(2,2,-10), Vector(0,0,1), 10, hit ) );
+    EXPECT_EQ( 0u, hit.triangle_index );
+    EXPECT_DOUBLE_EQ( 10, hit.time );
+    EXPECT_FALSE( raycast( triangles, Point(2,2,-10), Vector(0,0,1), 9.5, hit ) );
+    EXPECT_FALSE( raycast( triangles, Point(2,2,10), Vector(0,0,1), 100, hit ) );
+    EXPECT_FALSE( raycast( std::vector<PreparedTriangle>(), Point(2,2,10), Vector(0,0,-1), 100, hit ) );
+
+    // any triangle will do
+    EXPECT_TRUE( raycast( triangles, Point(2,2,10), Vector(0,0,-1), 100, AnyHit(), hit ) );
+    ASSERT_LT( hit.triangle_index, triangles.size() );
+    EXPECT_EQ( Point(2,2,hit.triangle_index), hit.collision_point );
+    EXPECT_DOUBLE_EQ( 10 - hit.triangle_index, hit.time );
+    EXPECT_FALSE( raycast( triangles, Point(2,2,10), Vector(0,0,-1), 3, AnyHit(), hit ) );
+
+    EXPECT_THROW( raycast( triangles, Point(2,2,10), Vector(0,0,0), 100, hit ), InvalidLineVectorError );
+    EXPECT_EQ( CollisionStatus::InvalidLineVector, NoThrow::raycast( triangles, Point(2,2,10), Vector(0,0,0), 100, AnyHit(), hit ) );
+}
+
+TEST(ClosestPointVectorTest, Nearest)
+{
+    // the same stack of triangles, points above and beside it
+    std::vector<PreparedTriangle> triangles;
+    for( unsigned i = 0; i < 7; ++i )
+    {
+        triangles.push_back( PreparedTriangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    ClosestPoint result;
+
+    EXPECT_TRUE( closest_point( triangles, Point(2,2,10), 100, result ) );
+    EXPECT_EQ( 6u, result.triangle_index );
+    EXPECT_EQ( Point(2,2,6), result.point );
+    EXPECT_DOUBLE_EQ( 4, result.distance );
+
+    // within the stack the nearest triangle is the one at the same height; at equal distances - the first one
+    EXPECT_TRUE( closest_point( triangles, Point(2.5,-1,3), 100, result ) );
+    EXPECT_EQ( 3u, result.triangle_index );
+    EXPECT_EQ( Point(2.5,0,3), result.point );
+    EXPECT_TRUE( closest_point( triangles, Point(2,2,3.5), 100, result ) );
+    EXPECT_EQ( 3u, result.triangle_index );
+    EXPECT_DOUBLE_EQ( 0.5, result.distance );
+
+    // max_distance is inclusive
+    EXPECT_TRUE( closest_point( triangles, Point(2,2,10), 4, result ) );
+    EXPECT_FALSE( closest_point( triangles, Point(2,2,10), 3.9, result ) );
+    EXPECT_FALSE( closest_point( std::vector<PreparedTriangle>(), Point(2,2,10), 100, result ) );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::closest_point( triangles, Point(2,2,10), -1, result ) );
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::closest_point( &triangles[0], 2, Point(2,2,0), 0, result ) );
+    EXPECT_EQ( 0u, result.triangle_index );
+}
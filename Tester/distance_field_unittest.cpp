@@ -0,0 +1,179 @@
+#include "../Collisions/distance_field.h"
+#include "../Collisions/collision_batch.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace Collisions;
+
+namespace
+{
+    const char * const PATH = "distance_field_unittest.bin";
+
+    // closed octahedron with vertices at `size' from the origin, normals aimed outside
+    std::vector<Triangle> octahedron(double size)
+    {
+        std::vector<Triangle> triangles;
+        for( unsigned i = 0; i < 8; ++i )
+        {
+            const Point a( i & 1 ? size : -size, 0, 0 );
+            const Point b( 0, i & 2 ? size : -size, 0 );
+            const Point c( 0, 0, i & 4 ? size : -size );
+            const Triangle triangle( a, b, c );
+            triangles.push_back( triangle.normal()*(a + b + c) > 0 ? triangle : Triangle( a, c, b ) );
+        }
+        return triangles;
+    }
+}
+
+// Distance field tests
+
+TEST(DistanceFieldTest, Distances)
+{
+    const double size = 3, voxel_size = 0.1, band = 0.5;
+    const MeshBVH mesh( octahedron( size ) );
+    const DistanceField field( mesh, voxel_size, band );
+    const DistanceFieldView view = field.view();
+    EXPECT_GT( field.stored_bricks(), 0u );
+    EXPECT_LT( field.stored_bricks(), view.bricks[0]*view.bricks[1]*view.bricks[2] );
+    EXPECT_EQ( 0u, reinterpret_cast<size_t>( field.data() ) % 8 );
+
+    const double error = voxel_size*std::sqrt( 3.0 )/2 + 1e-5;
+    srand(1);
+    for( unsigned i = 0; i < 2000; ++i )
+    {
+        const Point point = random_point( 2*size );
+        ClosestPoint nearest;
+        ASSERT_TRUE( closest_point( mesh, point, std::numeric_limits<double>::infinity(), nearest ) );
+        // the octahedron is |x| + |y| + |z| = size
+        const double exact = std::fabs( point.x ) + std::fabs( point.y ) + std::fabs( point.z ) < size ? -nearest.distance : nearest.distance;
+
+        EXPECT_LE( view.safe_distance( point ), nearest.distance ) << i;
+        EXPECT_GE( view.safe_distance( point ), 0 ) << i;
+        if( nearest.distance < band )
+        {
+            EXPECT_NEAR( exact, view.distance( point ), error ) << i;
+        }
+        else
+        {
+            EXPECT_LE( std::fabs( view.distance( point ) ), nearest.distance + error ) << i;
+        }
+    }
+
+    // far out of the field
+    EXPECT_NEAR( 100 - size, view.safe_distance( Point(100,0,0) ), 2*band + 2*voxel_size*DistanceField::BRICK_SIZE );
+    EXPECT_LE( view.safe_distance( Point(100,0,0) ), 100 - size );
+}
+
+TEST(DistanceFieldTest, Empty)
+{
+    const DistanceField field( MeshBVH( std::vector<Triangle>() ), 0.5, 1 );
+    EXPECT_EQ( 0u, field.stored_bricks() );
+    EXPECT_EQ( std::numeric_limits<double>::infinity(), field.view().distance( Point(1,2,3) ) );
+    EXPECT_EQ( std::numeric_limits<double>::infinity(), field.view().safe_distance( Point(1,2,3) ) );
+
+    SweepHit hit;
+    EXPECT_FALSE( sweep_sphere( field, MeshBVH( std::vector<Triangle>() ), Point(0,0,0), Point(10,0,0), 1, hit ) );
+}
+
+TEST(DistanceFieldTest, InvalidVoxelSize)
+{
+    const MeshBVH mesh( octahedron( 1 ) );
+    EXPECT_THROW( DistanceField( mesh, 0, 1 ), InvalidVoxelSizeError );
+    EXPECT_THROW( DistanceField( mesh, -1, 1 ), InvalidVoxelSizeError );
+    EXPECT_THROW( DistanceField( mesh, 0.1, -1 ), InvalidVoxelSizeError );
+    EXPECT_THROW( DistanceField( mesh, std::numeric_limits<double>::quiet_NaN(), 1 ), InvalidVoxelSizeError );
+    // too many bricks
+    EXPECT_THROW( DistanceField( mesh, 1e-9, 0 ), InvalidVoxelSizeError );
+}
+
+TEST(DistanceFieldTest, Sweeps)
+{
+    // the same hits as of the hierarchy, both for a closed mesh and a soup of open triangles
+    srand(2);
+    for( unsigned soup = 0; soup < 2; ++soup )
+    {
+        const MeshBVH mesh( soup ? random_mesh( 200, 8 ) : octahedron( 4 ) );
+        const DistanceField field( mesh, 0.25, 1 );
+        for( unsigned i = 0; i < 500; ++i )
+        {
+            const Point start = random_point( 12 ), end = random_point( 12 );
+            const double radius = random_double( 0, i % 10 == 0 ? 2 : 0.5 );
+            SweepHit expected, hit;
+            const bool collided = sweep_sphere( mesh, start, end, radius, expected );
+            ASSERT_EQ( collided, sweep_sphere( field, mesh, start, end, radius, hit ) ) << soup << " " << i;
+            if( collided )
+            {
+                EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << soup << " " << i;
+                if( soup ) // octahedron sides and vertices are shared by triangles: either may be reported
+                {
+                    EXPECT_EQ( expected.triangle_index, hit.triangle_index ) << soup << " " << i;
+                }
+                EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-6 ) << soup << " " << i;
+            }
+        }
+    }
+
+    const MeshBVH mesh( octahedron( 1 ) );
+    const DistanceField field( mesh, 0.1, 0.5 );
+    SweepHit hit;
+    EXPECT_THROW( sweep_sphere( field, mesh, Point(5,0,0), Point(5,0,0), 1, hit ), DegeneratedSegmentError );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sweep_sphere( field, mesh, Point(5,0,0), Point(5,0,0), 1, hit ) );
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sweep_sphere( field, mesh, Point(5,0,0), Point(-5,0,0), 1, hit ) );
+    EXPECT_NEAR( 0.3, hit.time, 1e-9 );
+}
+
+TEST(DistanceFieldTest, Batch)
+{
+    // threads sample the same field
+    srand(3);
+    const MeshBVH mesh( random_mesh( 100, 5 ) );
+    CollisionBatch batch( 4 );
+    const DistanceField serial( mesh, 0.2, 0.5 );
+    const DistanceField parallel( mesh.view(), 0.2, 0.5, batch );
+    ASSERT_EQ( serial.size(), parallel.size() );
+    EXPECT_EQ( 0, memcmp( serial.data(), parallel.data(), serial.size() ) );
+}
+
+TEST(DistanceFieldTest, Blob)
+{
+    const MeshBVH mesh( octahedron( 2 ) );
+    const DistanceField field( mesh, 0.1, 0.3 );
+    field.write( PATH );
+    const DistanceField loaded = DistanceField::read( PATH );
+    ASSERT_EQ( field.size(), loaded.size() );
+    EXPECT_EQ( 0, memcmp( field.data(), loaded.data(), field.size() ) );
+    EXPECT_EQ( field.view().distance( Point(1,1,0.5) ), loaded.view().distance( Point(1,1,0.5) ) );
+
+    // in place
+    const DistanceFieldView view = view_distance_field( field.data(), field.size() );
+    const char *start = static_cast<const char *>( field.data() );
+    EXPECT_TRUE( reinterpret_cast<const char *>( view.brick_indices ) > start && reinterpret_cast<const char *>( view.samples ) < start + field.size() );
+    EXPECT_EQ( field.view().safe_distance( Point(3,0,0) ), view.safe_distance( Point(3,0,0) ) );
+
+    // copies of the blob
+    std::vector<unsigned long long> blob( field.size()/8 );
+    memcpy( blob.data(), field.data(), field.size() );
+    EXPECT_EQ( field.size(), DistanceField( blob.data(), field.size() ).size() );
+    EXPECT_THROW( view_distance_field( blob.data(), field.size() - 8 ), InvalidDistanceFieldError );
+    EXPECT_THROW( view_distance_field( reinterpret_cast<const char *>( blob.data() ) + 1, field.size() - 1 ), InvalidDistanceFieldError );
+    EXPECT_THROW( view_distance_field( NULL, 0 ), InvalidDistanceFieldError );
+
+    unsigned char *bytes = reinterpret_cast<unsigned char *>( blob.data() );
+    bytes[0] ^= 0x40; // signature
+    EXPECT_THROW( DistanceField( blob.data(), field.size() ), InvalidDistanceFieldError );
+    bytes[0] ^= 0x40;
+    bytes[8] ^= 0x40; // version
+    EXPECT_THROW( DistanceField( blob.data(), field.size() ), InvalidDistanceFieldError );
+    bytes[8] ^= 0x40;
+    // a brick index out of samples
+    memset( bytes + ( reinterpret_cast<const char *>( view.brick_indices ) - start ), 0x7f, sizeof(unsigned) );
+    EXPECT_THROW( DistanceField( blob.data(), field.size() ), InvalidDistanceFieldError );
+
+    EXPECT_THROW( DistanceField::read( "no/such/distance_field.bin" ), FileError );
+    remove( PATH );
+}
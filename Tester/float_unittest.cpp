@@ -1,5 +1,8 @@
 #include "../Collisions/collisions.h"
+#include "../Collisions/simd.h"
 #include <gtest/gtest.h>
+#include <cstring>
+#include <limits>
 
 using namespace Collisions;
 
@@ -11,3 +14,159 @@ TEST(FloatingPointTest, Sign)
     EXPECT_EQ( 1, sign(3.3) );
     EXPECT_EQ( -1, sign(-800.008) );
 }
+
+namespace
+{
+    // the original comparison with branches, as a reference
+    bool reference_equal(double a, double b, long long max_ulps, double epsilon)
+    {
+        if( fabs(a - b) <= epsilon )
+        {
+            return true;
+        }
+        long long a_int, b_int, minus_null_int;
+        const double minus_null = -0.0;
+        memcpy( &a_int, &a, sizeof(a_int) );
+        memcpy( &b_int, &b, sizeof(b_int) );
+        memcpy( &minus_null_int, &minus_null, sizeof(minus_null_int) );
+        if( a_int < 0 )
+            a_int = minus_null_int - a_int;
+        if( b_int < 0 )
+            b_int = minus_null_int - b_int;
+        const unsigned long long difference = a_int > b_int ? static_cast<unsigned long long>( a_int ) - b_int
+                                                            : static_cast<unsigned long long>( b_int ) - a_int;
+        return difference <= static_cast<unsigned long long>( max_ulps );
+    }
+
+    struct LooseTolerance
+    {
+        static constexpr long long max_ulps = 1000;
+        static constexpr double epsilon = 1e-6;
+    };
+
+    // pairs of doubles near each other, far from each other, of different signs, and special ones
+    std::vector< std::pair<double, double> > comparison_cases()
+    {
+        const double specials[] = { 0.0, -0.0, 1e-300, -1e-300, 5e-324, -5e-324, 1.0, -1.0, 2.0, -2.0, 1e300, -1e300,
+                                    std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                                    std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::max() };
+        const unsigned count = sizeof(specials)/sizeof(specials[0]);
+        std::vector< std::pair<double, double> > cases;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            for( unsigned j = 0; j < count; ++j )
+            {
+                cases.push_back( std::make_pair( specials[i], specials[j] ) );
+            }
+        }
+        srand(1);
+        for( unsigned i = 0; i < 10000; ++i )
+        {
+            const double a = (rand() - RAND_MAX/2.0)*pow( 10.0, rand() % 40 - 20 );
+            const double ulp = nextafter( a, 2*a + 1 ) - a;
+            cases.push_back( std::make_pair( a, a + ulp*( rand() % 2000 - 1000 ) ) );
+            cases.push_back( std::make_pair( a, (rand() - RAND_MAX/2.0)*1e-13 ) );
+        }
+        return cases;
+    }
+}
+
+TEST(FloatingPointTest, SameAsReference)
+{
+    const std::vector< std::pair<double, double> > cases = comparison_cases();
+    for( unsigned i = 0; i < cases.size(); ++i )
+    {
+        const double a = cases[i].first;
+        const double b = cases[i].second;
+        EXPECT_EQ( reference_equal( a, b, DEFAULT_MAX_ULPS, DEFAULT_EPSILON ), equal( a, b ) ) << a << " " << b;
+        EXPECT_EQ( reference_equal( a, b, 1000, 1e-6 ), equal<LooseTolerance>( a, b ) ) << a << " " << b;
+        EXPECT_EQ( reference_equal( a, b, 7, 0 ), equal( a, b, 7, 0 ) ) << a << " " << b;
+    }
+}
+
+TEST(FloatingPointTest, UlpsOfOppositeHugeDoubles)
+{
+    // distances past 2^63 do not wrap around
+    const double huge = std::numeric_limits<double>::max();
+    long long huge_bits;
+    memcpy( &huge_bits, &huge, sizeof(huge_bits) );
+    EXPECT_EQ( 2*static_cast<unsigned long long>( huge_bits ), _ulps_between( huge, -huge ) );
+    EXPECT_EQ( 2*static_cast<unsigned long long>( huge_bits ), _ulps_between( -huge, huge ) );
+
+    // NaNs with all bits of the payload set are the farthest apart
+    const long long nan_bits = 0x7FFFFFFFFFFFFFFFLL;
+    double nan;
+    memcpy( &nan, &nan_bits, sizeof(nan) );
+    EXPECT_EQ( ~1ull, _ulps_between( nan, -nan ) );
+    EXPECT_FALSE( equal( nan, -nan ) );
+}
+
+TEST(FloatingPointTest, Policies)
+{
+    const double a = 1e6; // far enough from zero for ULPs to matter
+    double b = a;
+    for( unsigned i = 0; i < 100; ++i )
+    {
+        b = nextafter( b, 2*a );
+    }
+
+    EXPECT_FALSE( equal( a, b ) );
+    EXPECT_TRUE( equal< UlpsTolerance<200> >( a, b ) );
+    EXPECT_TRUE( equal<LooseTolerance>( 0, 1e-7 ) );
+    EXPECT_FALSE( equal( 0, 1e-7 ) );
+    EXPECT_TRUE( less_or_equal< UlpsTolerance<200> >( b, a ) );
+    EXPECT_FALSE( less_or_equal( b, a ) );
+    EXPECT_TRUE( greater_or_equal< UlpsTolerance<200> >( a, b ) );
+    EXPECT_FALSE( greater_or_equal( a, b ) );
+
+    EXPECT_FALSE( Vector(a, a, a) == Vector(a, a, b) );
+    EXPECT_TRUE( Vector(a, a, a).equals< UlpsTolerance<200> >( Vector(a, b, a) ) );
+    EXPECT_FALSE( Vector(0, 1e-7, 0).is_zero() );
+    EXPECT_TRUE( Vector(0, 1e-7, 0).is_zero<LooseTolerance>() );
+}
+
+TEST(FloatingPointTest, Floats)
+{
+    EXPECT_EQ( 1, sign(2.5f) );
+    EXPECT_EQ( 1u, _ulps_between( 1.0f, nextafterf( 1.0f, 2.0f ) ) );
+    EXPECT_EQ( 2u, _ulps_between( -nextafterf( 0.0f, 1.0f ), nextafterf( 0.0f, 1.0f ) ) );
+
+    // far from zero: only ULPs count
+    const float a = 1000;
+    float b = a;
+    for( unsigned i = 0; i < DEFAULT_FLOAT_MAX_ULPS; ++i )
+    {
+        b = nextafterf( b, 2*a );
+    }
+    EXPECT_TRUE( equal( a, b ) );
+    EXPECT_TRUE( less_or_equal( b, a ) );
+    EXPECT_FALSE( equal( a, nextafterf( b, 2*a ) ) );
+    EXPECT_FALSE( less_or_equal( nextafterf( b, 2*a ), a ) );
+    // near zero: epsilon of floats
+    EXPECT_TRUE( equal( 0, 1e-6f ) );
+    EXPECT_FALSE( equal( 0, 1e-6 ) );
+    EXPECT_TRUE( equal( -0.0f, 0.0f ) );
+}
+
+TEST(FloatingPointTest, Simd)
+{
+    const std::vector< std::pair<double, double> > cases = comparison_cases();
+    for( unsigned i = 0; i < cases.size(); ++i )
+    {
+        const double a = cases[i].first;
+        const double b = cases[i].second;
+        const bool expected = equal( a, b );
+        const unsigned all_lanes = (1u << Simd::DefaultPack::WIDTH) - 1;
+
+        EXPECT_EQ( expected ? 1u : 0u, Simd::bits( Simd::equal<DefaultTolerance>( Simd::ScalarPack(a), Simd::ScalarPack(b) ) ) ) << a << " " << b;
+        EXPECT_EQ( expected ? all_lanes : 0u, Simd::bits( Simd::equal<DefaultTolerance>( Simd::DefaultPack(a), Simd::DefaultPack(b) ) ) ) << a << " " << b;
+        EXPECT_EQ( equal<LooseTolerance>( a, b ) ? all_lanes : 0u,
+                   Simd::bits( Simd::equal<LooseTolerance>( Simd::DefaultPack(a), Simd::DefaultPack(b) ) ) ) << a << " " << b;
+
+        const Vector A( a, 1, -3 );
+        const Vector B( b, 1, -3 );
+        EXPECT_EQ( expected, A == B ) << a << " " << b;
+        EXPECT_EQ( expected, Simd::equal3<DefaultTolerance>( A, B ) ) << a << " " << b;
+        EXPECT_EQ( expected, Simd::equal3<DefaultTolerance>( Vector( 2, -1, a ), Vector( 2, -1, b ) ) ) << a << " " << b;
+    }
+}
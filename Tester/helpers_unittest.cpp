@@ -1,5 +1,6 @@
 #include "../Collisions/collisions.h"
 #include <gtest/gtest.h>
+#include <cstdlib>
 
 using namespace Collisions;
 
@@ -413,6 +414,27 @@ TEST(PointInsideTriangleTest, BorderSimplex)
     }
 }
 
+TEST(PointInsideTriangleTest, Prepared)
+{
+    const Triangle triangle( Point(1,0,0), Point(0,1,0), Point(0,0,1) );
+    const PreparedTriangle prepared( triangle );
+    const Point points[] = { 
+                                Point(1.0/3, 1.0/3, 1.0/3),
+                                Point(0.5-0.001/2, 0.5-0.001, +0.001),
+                                Point(0.5, 0, 0.5),
+                                Point(0.1, 0, 0.9),
+                                triangle[2],
+                                Point(0.6, -0.1, 0.5),
+                                Point(0.5+0.001/2, 0.5+0.001, -0.001),
+                                Point(100, -50, -49)
+                              };
+    for( unsigned i = 0; i < sizeof(points)/sizeof(points[0]); ++i)
+    {
+        EXPECT_EQ( is_point_inside_triangle( points[i], triangle ), is_point_inside_triangle( points[i], prepared ) ) 
+            << "Point " << points[i] << " is classified differently";
+    }
+}
+
 TEST(PointInsideTriangleTest, BlackTest)
 {
     const Point A(0,0,0);
@@ -425,6 +447,82 @@ TEST(PointInsideTriangleTest, BlackTest)
     EXPECT_THROW( is_point_inside_triangle( C, Triangle(A, A, A) ), DegeneratedTriangleError );
 }
 
+// Closest point on triangle tests
+
+TEST(ClosestPointOnTriangleTest, Regions)
+{
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    const PreparedTriangle prepared( triangle );
+    struct { Point point, nearest; } cases[] = {
+        { Point(2,1,3),   Point(2,1,0) },   // above the face
+        { Point(2,1,-3),  Point(2,1,0) },   // below it
+        { Point(2,1,0),   Point(2,1,0) },   // on it
+        { Point(2.5,-2,1), Point(2.5,0,0) }, // side #2, from (5,0) to (0,0)
+        { Point(-2,1,0),  Point(0,0,0) },   // vertex #0, beyond both its sides
+        { Point(2,5,7),   Point(2,4,0) },   // vertex #1
+        { Point(7,-1,0),  Point(5,0,0) },   // vertex #2
+        { Point(-1,3,0),  Point(1,2,0) },   // side #0: (-1,3) - (1,2) is perpendicular to (2,4)
+    };
+    for( unsigned i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i )
+    {
+        EXPECT_EQ( cases[i].nearest, closest_point_on_triangle( cases[i].point, triangle ) ) << "case #" << i;
+        EXPECT_EQ( cases[i].nearest, closest_point_on_triangle( cases[i].point, prepared ) ) << "case #" << i;
+        EXPECT_DOUBLE_EQ( distance( cases[i].point, cases[i].nearest ), distance_between_point_and_triangle( cases[i].point, triangle ) ) << "case #" << i;
+    }
+
+    // side #1, from (2,4) to (5,0): the point is 1 away from (3.5,2) along its outer normal (4,3)/5
+    EXPECT_EQ( Point(3.5,2,0), closest_point_on_triangle( Point(3.5 + 0.8, 2 + 0.6, 0), prepared ) );
+    EXPECT_DOUBLE_EQ( sqrt(2.0), distance_between_point_and_triangle( Point(3.5 + 0.8, 2 + 0.6, 1), prepared ) );
+}
+
+TEST(ClosestPointOnTriangleTest, NotNearerThanSamples)
+{
+    srand(42);
+    for( unsigned test = 0; test < 200; ++test )
+    {
+        Point vertices[3];
+        for( unsigned i = 0; i < 3; ++i )
+        {
+            vertices[i] = Point( 10.0*rand()/RAND_MAX - 5, 10.0*rand()/RAND_MAX - 5, 10.0*rand()/RAND_MAX - 5 );
+        }
+        const Triangle triangle( vertices[0], vertices[1], vertices[2] );
+        if( triangle.is_degenerated() )
+            continue;
+        const Point point( 20.0*rand()/RAND_MAX - 10, 20.0*rand()/RAND_MAX - 10, 20.0*rand()/RAND_MAX - 10 );
+        const Point nearest = closest_point_on_triangle( point, triangle );
+
+        // the point found is on the triangle and no sample of it is nearer
+        const PreparedTriangle prepared( triangle );
+        double u, v;
+        prepared.barycentric( nearest, u, v );
+        EXPECT_NEAR( 0, distance( nearest, triangle[0] + u*prepared.side(0) - v*prepared.side(2) ), 1e-9 ) << "test #" << test;
+        EXPECT_TRUE( greater_or_equal( u, 0.0 ) && greater_or_equal( v, 0.0 ) && less_or_equal( u + v, 1.0 ) ) << "test #" << test;
+        const unsigned STEPS = 40;
+        for( unsigned i = 0; i <= STEPS; ++i )
+        {
+            for( unsigned j = 0; i + j <= STEPS; ++j )
+            {
+                const Point sample = triangle[0] + (1.0*i/STEPS)*prepared.side(0) - (1.0*j/STEPS)*prepared.side(2);
+                ASSERT_LE( distance( point, nearest ), distance( point, sample ) + 1e-9 ) << "test #" << test;
+            }
+        }
+    }
+}
+
+TEST(ClosestPointOnTriangleTest, Degenerated)
+{
+    // no exceptions: degenerated triangles are taken as their sides
+    const Point A(0,0,0);
+    const Point B(4,0,0);
+    const Point C(2,0,0);
+
+    EXPECT_EQ( Point(3,0,0), closest_point_on_triangle( Point(3,2,0), Triangle(A, B, C) ) );
+    EXPECT_EQ( Point(4,0,0), closest_point_on_triangle( Point(6,1,1), Triangle(A, C, B) ) );
+    EXPECT_EQ( Point(2,0,0), closest_point_on_triangle( Point(2,1,0), Triangle(A, A, B) ) );
+    EXPECT_EQ( A, closest_point_on_triangle( Point(2,1,0), Triangle(A, A, A) ) );
+    EXPECT_DOUBLE_EQ( 1, distance_between_point_and_triangle( Point(2,1,0), Triangle(A, C, B) ) );
+}
+
 // Perpendicular base tests
 
 TEST(PerpendicularBaseTest, Sloping)
@@ -0,0 +1,186 @@
+#include "../Collisions/instance_bvh.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    Transform random_transform(double size)
+    {
+        return Transform( random_point(size), random_point(1), random_double(-3, 3), random_double(0.5, 2) );
+    }
+
+    // triangles of all instances in the world, as the expected result of sweeps
+    std::vector<PreparedTriangle> world_triangles(const std::vector< std::vector<Triangle> > &meshes, const InstanceBVH &instances,
+                                                  /*out*/ std::vector<unsigned> &instance_indices, std::vector<unsigned> &triangle_indices)
+    {
+        std::vector<PreparedTriangle> result;
+        instance_indices.clear();
+        triangle_indices.clear();
+        for( unsigned i = 0; i < instances.size(); ++i )
+        {
+            const InstanceBVH::Instance &instance = instances.instance( i );
+            const std::vector<Triangle> &mesh = meshes[instance.mesh];
+            for( unsigned j = 0; j < mesh.size(); ++j )
+            {
+                const Transform &transform = instance.transform;
+                result.push_back( PreparedTriangle( Triangle( transform.apply( mesh[j][0] ), transform.apply( mesh[j][1] ), transform.apply( mesh[j][2] ) ) ) );
+                instance_indices.push_back( i );
+                triangle_indices.push_back( j );
+            }
+        }
+        return result;
+    }
+}
+
+// Transform tests
+
+TEST(TransformTest, Creation)
+{
+    const Transform identity;
+    EXPECT_EQ( Point(1,2,3), identity.apply( Point(1,2,3) ) );
+    EXPECT_EQ( 1, identity.scale() );
+
+    // a quarter turn around z takes x to y
+    const Transform turn( Vector(10,0,0), Vector(0,0,5), M_PI/2, 2 );
+    EXPECT_EQ( Point(10,2,0), turn.apply( Point(1,0,0) ) );
+    EXPECT_EQ( Point(1,0,0), turn.apply_inverse( Point(10,2,0) ) );
+    const Transform same = Transform::from_quaternion( Vector(10,0,0), 2*std::cos( M_PI/4 ), 0, 0, 2*std::sin( M_PI/4 ), 2 );
+    EXPECT_EQ( Point(20,-4,6), same.apply( Point(-2,-5,3) ) );
+
+    srand( 5 );
+    for( unsigned i = 0; i < 100; ++i )
+    {
+        const Transform transform = random_transform( 10 );
+        const Point a = random_point( 5 );
+        const Point b = random_point( 5 );
+        EXPECT_EQ( a, transform.apply_inverse( transform.apply( a ) ) );
+        // distances are scaled
+        EXPECT_NEAR( transform.scale()*distance( a, b ), distance( transform.apply( a ), transform.apply( b ) ), 1e-9 );
+
+        const BoundingBox box = BoundingBox().add( a ).add( b );
+        const BoundingBox moved = transform.apply( box );
+        for( unsigned corner = 0; corner < 8; ++corner )
+        {
+            const Point point( corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z );
+            EXPECT_TRUE( moved.inflated( 1e-9 ).contains( transform.apply( point ) ) );
+        }
+    }
+
+    EXPECT_THROW( Transform( Vector(0,0,0), Vector(0,0,0), 1 ), InvalidTransformError );
+    EXPECT_NO_THROW( Transform( Vector(0,0,0), Vector(0,0,0), 0 ) );
+    EXPECT_THROW( Transform( Vector(0,0,0), Vector(0,0,1), 1, 0 ), InvalidTransformError );
+    EXPECT_THROW( Transform::from_quaternion( Vector(0,0,0), 0, 0, 0, 0 ), InvalidTransformError );
+}
+
+// Instance hierarchy tests
+
+TEST(InstanceBVHTest, Creation)
+{
+    srand( 7 );
+    const MeshBVH rock( random_mesh( 50, 3 ) );
+    const MeshBVH empty( ( std::vector<Triangle>() ) );
+    InstanceBVH instances;
+    EXPECT_TRUE( instances.empty() );
+    EXPECT_EQ( 0u, instances.add_mesh( rock ) );
+    EXPECT_EQ( 1u, instances.add_mesh( empty ) );
+    EXPECT_THROW( instances.add_instance( 2, Transform() ), OutOfBoundsError );
+
+    for( unsigned i = 0; i < 100; ++i )
+    {
+        EXPECT_EQ( i, instances.add_instance( i % 2, random_transform( 50 ) ) );
+    }
+    EXPECT_TRUE( instances.instance( 1 ).box.is_empty() );
+    EXPECT_EQ( 0u, instances.built_size() );
+    instances.rebuild();
+    EXPECT_EQ( 100u, instances.built_size() );
+    ASSERT_LT( 0u, instances.nodes_count() );
+
+    // every instance is in the box of the root, also after moves
+    for( unsigned i = 0; i < 100; i += 2 )
+    {
+        EXPECT_TRUE( instances.node( 0 ).box.contains( instances.instance( i ).box.min ) );
+    }
+    instances.set_transform( 10, Transform( Vector(1000,0,0) ) );
+    EXPECT_TRUE( instances.node( 0 ).box.contains( instances.instance( 10 ).box.max ) );
+    EXPECT_THROW( instances.set_transform( 100, Transform() ), OutOfBoundsError );
+
+    SweepHit hit;
+    unsigned instance_index;
+    EXPECT_THROW( sweep_sphere( instances, Point(1,1,1), Point(1,1,1), 1, hit, instance_index ), DegeneratedSegmentError );
+    EXPECT_FALSE( sweep_sphere( InstanceBVH(), Point(0,0,0), Point(1,1,1), 1, hit, instance_index ) );
+}
+
+TEST(InstanceBVHTest, SameAsWorldTriangles)
+{
+    srand( 13 );
+    std::vector< std::vector<Triangle> > meshes;
+    meshes.push_back( random_mesh( 40, 3 ) );
+    meshes.push_back( random_mesh( 20, 1 ) );
+    const MeshBVH rock( meshes[0] ), crate( meshes[1] );
+    InstanceBVH instances;
+    instances.add_mesh( rock );
+    instances.add_mesh( crate.view() );
+    for( unsigned i = 0; i < 60; ++i )
+    {
+        instances.add_instance( i % 2, random_transform( 20 ) );
+    }
+    instances.rebuild();
+
+    std::vector<unsigned> expected_instances, expected_triangles;
+    unsigned hits = 0;
+    for( unsigned round = 0; round < 3; ++round )
+    {
+        if( round == 1 )
+        {
+            // moved ones are refitted
+            for( unsigned i = 0; i < 60; i += 3 )
+            {
+                instances.set_transform( i, random_transform( 20 ) );
+            }
+        }
+        if( round == 2 )
+        {
+            // new ones are tested without the hierarchy
+            for( unsigned i = 0; i < 10; ++i )
+            {
+                instances.add_instance( i % 2, random_transform( 20 ) );
+            }
+        }
+        const std::vector<PreparedTriangle> world = world_triangles( meshes, instances, expected_instances, expected_triangles );
+        for( unsigned test = 0; test < 300; ++test )
+        {
+            const Point start = random_point( 25 );
+            const Point end = random_point( 25 );
+            const double R = random_double( 0.1, 2 );
+
+            SweepHit expected, hit;
+            unsigned instance_index = 0;
+            const bool any_hit = sweep_sphere( world, start, end, R, expected );
+            ASSERT_EQ( any_hit, sweep_sphere( instances, start, end, R, hit, instance_index ) ) << "round " << round << ", test #" << test;
+            SweepHit any;
+            unsigned any_instance_index = 0;
+            ASSERT_EQ( any_hit, sweep_sphere( instances, start, end, R, AnyHit(), any, any_instance_index ) ) << "round " << round << ", test #" << test;
+            if( any_hit )
+            {
+                ++hits;
+                EXPECT_LT( any_instance_index, instances.size() );
+                EXPECT_GE( any.time, hit.time - 1e-9 );
+                EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "round " << round << ", test #" << test;
+                EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 );
+                // spheres, starting in touch with several triangles, may report any of them
+                if( expected.time == 0 )
+                {
+                    continue;
+                }
+                EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "round " << round << ", test #" << test;
+                EXPECT_EQ( expected_instances[expected.triangle_index], instance_index );
+                EXPECT_EQ( expected_triangles[expected.triangle_index], hit.triangle_index );
+            }
+        }
+    }
+    EXPECT_LT( 200u, hits );
+}
@@ -0,0 +1,296 @@
+#include "../Collisions/mapped_mesh.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Collisions;
+
+namespace
+{
+    const char * const PATH = "mapped_mesh_unittest.bin";
+
+    // open terrain mesh: random heights from 0 to `height' over a grid of `size'*`size' unit cells
+    void terrain(unsigned size, double height, /*out*/ std::vector<Point> &vertices, std::vector<unsigned> &indices)
+    {
+        for( unsigned i = 0; i <= size; ++i )
+        {
+            for( unsigned j = 0; j <= size; ++j )
+            {
+                vertices.push_back( Point( i, j, random_double(0, height) ) );
+            }
+        }
+        for( unsigned i = 0; i < size; ++i )
+        {
+            for( unsigned j = 0; j < size; ++j )
+            {
+                const unsigned a = i*(size + 1) + j;
+                const unsigned triangles[6] = { a, a + size + 2, a + 1, a, a + size + 1, a + size + 2 };
+                indices.insert( indices.end(), triangles, triangles + 6 );
+            }
+        }
+    }
+
+    void corrupt(const char *path, long offset)
+    {
+        std::FILE *file = fopen( path, "r+b" );
+        ASSERT_TRUE( file != NULL );
+        fseek( file, offset, SEEK_SET );
+        const int byte = fgetc( file );
+        fseek( file, offset, SEEK_SET );
+        fputc( byte ^ 0x40, file );
+        fclose( file );
+    }
+
+    // bytes of the file header, followed by the table of sections: offset, bytes and checksum per section
+    const size_t HEADER_SIZE = 56;
+
+    // checksum of a section, as the writer computes it
+    unsigned long long checksum(const unsigned char *data, size_t bytes)
+    {
+        unsigned long long sum = 0, sum_of_sums = 0;
+        for( size_t i = 0; i < bytes; i += 8 )
+        {
+            unsigned long long word = 0;
+            memcpy( &word, data + i, std::min( bytes - i, static_cast<size_t>( 8 ) ) );
+            sum += word;
+            sum_of_sums += sum;
+        }
+        return sum_of_sums ^ ( sum << 32 | sum >> 32 ) ^ bytes;
+    }
+
+    // replaces nodes of the hierarchy in the file and updates their checksum, so that only verify()
+    // checking the nodes themselves can find them wrong
+    void rewrite_nodes(const char *path, const std::vector<MeshBVH::Node> &nodes)
+    {
+        std::FILE *file = fopen( path, "r+b" );
+        ASSERT_TRUE( file != NULL );
+        unsigned long long entry[3]; // of the nodes section
+        fseek( file, static_cast<long>( HEADER_SIZE + MappedMesh::NODES*sizeof(entry) ), SEEK_SET );
+        ASSERT_EQ( 1u, fread( entry, sizeof(entry), 1, file ) );
+        ASSERT_EQ( nodes.size()*sizeof(MeshBVH::Node), entry[1] );
+        entry[2] = checksum( reinterpret_cast<const unsigned char *>( &nodes[0] ), static_cast<size_t>( entry[1] ) );
+        fseek( file, static_cast<long>( HEADER_SIZE + MappedMesh::NODES*sizeof(entry) ), SEEK_SET );
+        fwrite( entry, sizeof(entry), 1, file );
+        fseek( file, static_cast<long>( entry[0] ), SEEK_SET );
+        fwrite( &nodes[0], sizeof(MeshBVH::Node), nodes.size(), file );
+        fclose( file );
+    }
+
+    // chain of `inner_count' inner nodes, each with a leaf and the next inner node for children
+    std::vector<MeshBVH::Node> chain(const std::vector<MeshBVH::Node> &nodes, unsigned inner_count)
+    {
+        std::vector<MeshBVH::Node> result( nodes );
+        for( unsigned i = 0; i < result.size(); ++i )
+        {
+            const bool inner = i % 2 == 0 && i/2 < inner_count;
+            result[i].first = inner ? i + 1 : 0;
+            result[i].count = inner ? 0 : 1;
+        }
+        return result;
+    }
+}
+
+// Mapped mesh tests
+
+TEST(MappedMeshTest, Creation)
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    terrain( 3, 1, vertices, indices );
+    MappedMesh::write( PATH, vertices, indices );
+    {
+        const MappedMesh mesh( PATH );
+        EXPECT_TRUE( mesh.verify() );
+        EXPECT_EQ( vertices.size(), mesh.vertices_count() );
+        EXPECT_EQ( 18u, mesh.triangles_count() );
+        EXPECT_TRUE( mesh.has_bvh() );
+        EXPECT_EQ( 0u, mesh.file_size() % MappedMesh::SECTION_ALIGNMENT );
+        for( unsigned i = 0; i < vertices.size(); ++i )
+        {
+            EXPECT_EQ( vertices[i], mesh.vertex( i ) );
+        }
+        for( unsigned i = 0; i < mesh.triangles_count(); ++i )
+        {
+            EXPECT_EQ( indices[3*i + 2], mesh.vertex_index( i, 2 ) );
+            // triangles are stored in the order of the hierarchy
+            const unsigned original = mesh.original_index( i );
+            ASSERT_LT( original, mesh.triangles_count() );
+            EXPECT_EQ( mesh.triangle( original )[0], mesh.prepared_triangle( i )[0] );
+        }
+        // sections are aligned in memory too
+        EXPECT_EQ( 0u, reinterpret_cast<size_t>( &mesh.vertex( 0 ) ) % MappedMesh::SECTION_ALIGNMENT );
+        EXPECT_EQ( 0u, reinterpret_cast<size_t>( mesh.bvh().nodes ) % MappedMesh::SECTION_ALIGNMENT );
+        EXPECT_THROW( mesh.vertex( static_cast<unsigned>( vertices.size() ) ), OutOfBoundsError );
+        EXPECT_THROW( mesh.prepared_triangle( 18 ), OutOfBoundsError );
+    }
+
+    MappedMesh::write( PATH, vertices, indices, false );
+    {
+        const MappedMesh mesh( PATH );
+        EXPECT_TRUE( mesh.verify() );
+        EXPECT_FALSE( mesh.has_bvh() );
+        EXPECT_EQ( 5u, mesh.original_index( 5 ) );
+        EXPECT_EQ( mesh.triangle( 5 )[1], mesh.prepared_triangle( 5 )[1] );
+    }
+
+    MappedMesh::write( PATH, std::vector<Point>(), std::vector<unsigned>() );
+    {
+        const MappedMesh mesh( PATH );
+        EXPECT_TRUE( mesh.verify() );
+        EXPECT_TRUE( mesh.empty() );
+        SweepHit hit;
+        EXPECT_FALSE( sweep_sphere( mesh, Point(0,0,0), Point(1,0,0), 1, hit ) );
+    }
+    remove( PATH );
+
+    indices.push_back( 0 );
+    EXPECT_THROW( MappedMesh::write( PATH, vertices, indices ), InvalidIndicesError );
+    indices.push_back( 1 );
+    indices.push_back( 100 );
+    EXPECT_THROW( MappedMesh::write( PATH, vertices, indices ), InvalidIndicesError );
+    indices.back() = 0;
+    EXPECT_THROW( MappedMesh::write( PATH, vertices, indices ), DegeneratedTriangleError );
+}
+
+TEST(MappedMeshTest, SameAsBVH)
+{
+    srand( 17 );
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    terrain( 20, 3, vertices, indices );
+    std::vector<Triangle> triangles;
+    for( unsigned i = 0; i < indices.size(); i += 3 )
+    {
+        triangles.push_back( Triangle( vertices[ indices[i] ], vertices[ indices[i + 1] ], vertices[ indices[i + 2] ] ) );
+    }
+    const MeshBVH bvh( triangles );
+
+    for( unsigned with_bvh = 0; with_bvh < 2; ++with_bvh )
+    {
+        MappedMesh::write( PATH, vertices, indices, with_bvh != 0 );
+        const MappedMesh mesh( PATH );
+        unsigned hits = 0;
+        for( unsigned test = 0; test < 300; ++test )
+        {
+            const Point start = Point( 10, 10, 5 ) + random_point( 10 );
+            const Point end = Point( 10, 10, 0 ) + random_point( 10 );
+            const double R = random_double( 0.1, 1 );
+
+            SweepHit expected, hit;
+            const bool any_hit = sweep_sphere( bvh, start, end, R, expected );
+            ASSERT_EQ( any_hit, sweep_sphere( mesh, start, end, R, hit ) ) << "test #" << test;
+            if( any_hit )
+            {
+                ++hits;
+                EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+                EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 ) << "test #" << test;
+                ASSERT_LT( hit.triangle_index, mesh.triangles_count() );
+            }
+        }
+        EXPECT_LT( 100u, hits );
+    }
+    remove( PATH );
+}
+
+TEST(MappedMeshTest, InvalidFiles)
+{
+    EXPECT_THROW( MappedMesh mesh( "no_such_file.bin" ), FileError );
+
+    // not a mesh
+    std::FILE *file = fopen( PATH, "wb" );
+    ASSERT_TRUE( file != NULL );
+    for( unsigned i = 0; i < 1000; ++i )
+    {
+        fputc( 'x', file );
+    }
+    fclose( file );
+    EXPECT_THROW( MappedMesh mesh( PATH ), InvalidMeshFileError );
+
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    terrain( 4, 1, vertices, indices );
+    MappedMesh::write( PATH, vertices, indices );
+    // other version
+    corrupt( PATH, 8 );
+    EXPECT_THROW( MappedMesh mesh( PATH ), InvalidMeshFileError );
+    corrupt( PATH, 8 );
+    {
+        // a broken section is found by verify() only
+        corrupt( PATH, 600 );
+        const MappedMesh mesh( PATH );
+        EXPECT_FALSE( mesh.verify() );
+    }
+
+    // truncated
+    MappedMesh::write( PATH, vertices, indices );
+    file = fopen( PATH, "rb" );
+    ASSERT_TRUE( file != NULL );
+    std::vector<char> content( 100000 );
+    content.resize( fread( &content[0], 1, content.size(), file ) );
+    fclose( file );
+    file = fopen( PATH, "wb" );
+    ASSERT_TRUE( file != NULL );
+    fwrite( &content[0], 1, content.size() - 64, file );
+    fclose( file );
+    EXPECT_THROW( MappedMesh mesh( PATH ), InvalidMeshFileError );
+    remove( PATH );
+}
+
+TEST(MappedMeshTest, InvalidNodes)
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    terrain( 16, 1, vertices, indices );
+    MappedMesh::write( PATH, vertices, indices );
+    std::vector<MeshBVH::Node> nodes;
+    {
+        const MappedMesh mesh( PATH );
+        EXPECT_TRUE( mesh.verify() );
+        const BvhView bvh = mesh.bvh();
+        nodes.assign( bvh.nodes, bvh.nodes + bvh.nodes_count );
+        ASSERT_FALSE( nodes[0].is_leaf() );
+        ASSERT_LT( 2*MeshBVH::MAX_DEPTH + 1, nodes.size() );
+    }
+    rewrite_nodes( PATH, nodes );
+    EXPECT_TRUE( MappedMesh( PATH ).verify() );
+
+    // children before their parent or out of the nodes
+    std::vector<MeshBVH::Node> wrong( nodes );
+    wrong[0].first = 0;
+    rewrite_nodes( PATH, wrong );
+    EXPECT_FALSE( MappedMesh( PATH ).verify() );
+    wrong[0].first = static_cast<unsigned>( nodes.size() ) - 1;
+    rewrite_nodes( PATH, wrong );
+    EXPECT_FALSE( MappedMesh( PATH ).verify() );
+
+    // a leaf out of the triangles
+    wrong = nodes;
+    unsigned leaf = 0;
+    while( !nodes[leaf].is_leaf() )
+    {
+        ++leaf;
+    }
+    wrong[leaf].count = 16*16*2 - wrong[leaf].first + 1;
+    rewrite_nodes( PATH, wrong );
+    EXPECT_FALSE( MappedMesh( PATH ).verify() );
+
+    // the deepest chain allowed, and one node deeper
+    rewrite_nodes( PATH, chain( nodes, MeshBVH::MAX_DEPTH - 1 ) );
+    {
+        const MappedMesh mesh( PATH );
+        EXPECT_TRUE( mesh.verify() );
+        SweepHit hit;
+        sweep_sphere( mesh, Point(-1,-1,-1), Point(17,17,2), 1, hit );
+    }
+    rewrite_nodes( PATH, chain( nodes, MeshBVH::MAX_DEPTH ) );
+    EXPECT_FALSE( MappedMesh( PATH ).verify() );
+
+    // written by a build allowing deeper hierarchies
+    MappedMesh::write( PATH, vertices, indices );
+    corrupt( PATH, 29 ); // the second byte of the recorded MeshBVH::MAX_DEPTH
+    EXPECT_THROW( MappedMesh mesh( PATH ), InvalidMeshFileError );
+    remove( PATH );
+}
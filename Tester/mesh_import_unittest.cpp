@@ -0,0 +1,332 @@
+#include "../Collisions/mesh_import.h"
+#include "../Collisions/collision_batch.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace Collisions;
+
+namespace
+{
+    const char * const OBJ_PATH = "mesh_import_unittest.obj";
+    const char * const STL_PATH = "mesh_import_unittest.stl";
+    const char * const PLY_PATH = "mesh_import_unittest.ply";
+
+    void write_file(const char *path, const std::string &content)
+    {
+        std::FILE *file = fopen( path, "wb" );
+        ASSERT_TRUE( file != NULL );
+        fwrite( content.data(), 1, content.size(), file );
+        fclose( file );
+    }
+
+    void append_float(std::string &content, float value)
+    {
+        unsigned char bytes[4];
+        memcpy( bytes, &value, 4 );
+        content.append( reinterpret_cast<const char *>( bytes ), 4 ); // tests run on little endian machines
+    }
+
+    void append_uint(std::string &content, unsigned value)
+    {
+        for( unsigned i = 0; i < 4; ++i )
+        {
+            content.push_back( static_cast<char>( ( value >> 8*i ) & 0xFF ) );
+        }
+    }
+
+    Triangle triangle(const ImportedMesh &mesh, unsigned index)
+    {
+        return Triangle( mesh.vertices[ mesh.indices[3*index] ], mesh.vertices[ mesh.indices[3*index + 1] ], mesh.vertices[ mesh.indices[3*index + 2] ] );
+    }
+
+    // open terrain of `size'*`size' unit cells with random heights as OBJ text, with relative indices in odd rows
+    std::string terrain_obj(unsigned size)
+    {
+        std::string content = "# terrain\n";
+        char line[200];
+        for( unsigned i = 0; i <= size; ++i )
+        {
+            for( unsigned j = 0; j <= size; ++j )
+            {
+                sprintf( line, "v %u %u %.17g\n", i, j, static_cast<double>( rand() )/RAND_MAX );
+                content += line;
+            }
+        }
+        for( unsigned i = 0; i < size; ++i )
+        {
+            for( unsigned j = 0; j < size; ++j )
+            {
+                const int a = i*(size + 1) + j + 1;
+                const int b = a + size + 1;
+                if( i % 2 == 0 )
+                {
+                    sprintf( line, "f %d/1 %d/2 %d/3 %d/4\n", a, b, b + 1, a + 1 );
+                }
+                else
+                {
+                    const int count = (size + 1)*(size + 1);
+                    sprintf( line, "f %d//1 %d//2 %d//3 %d//4\n", a - count - 1, b - count - 1, b - count, a - count );
+                }
+                content += line;
+            }
+        }
+        return content;
+    }
+}
+
+// Mesh import tests
+
+TEST(MeshImportTest, ParseDouble)
+{
+    const char * const numbers[] = { "0", "-0", "1", "+2.5", "-3.25e2", "0.1", "1e22", "1e-22", "123456789012345",
+                                     "3.141592653589793238462643", "1e23", "2.2250738585072014e-308", "1.7976931348623157e308",
+                                     ".5", "5.", "0.000000000000000000000000000001", "123456789012345678901234567890", "1E+5" };
+    for( unsigned i = 0; i < sizeof(numbers)/sizeof(numbers[0]); ++i )
+    {
+        const char *end = numbers[i] + strlen( numbers[i] );
+        double value;
+        ASSERT_EQ( end, parse_double( numbers[i], end, value ) ) << numbers[i];
+        EXPECT_EQ( strtod( numbers[i], NULL ), value ) << numbers[i];
+    }
+    // random ones, as written by printf
+    srand( 3 );
+    for( unsigned i = 0; i < 10000; ++i )
+    {
+        char number[64];
+        const double expected = ( rand() - RAND_MAX/2.0 )/( rand() + 1.0 )*pow( 10.0, rand() % 40 - 20 );
+        sprintf( number, i % 2 == 0 ? "%.17g" : "%.6f", expected );
+        double value;
+        ASSERT_EQ( number + strlen( number ), parse_double( number, number + strlen( number ), value ) ) << number;
+        ASSERT_EQ( strtod( number, NULL ), value ) << number;
+    }
+
+    // the position after the number, `e' without digits is not a part of it
+    const char text[] = "1.5e x";
+    double value;
+    EXPECT_EQ( text + 3, parse_double( text, text + strlen( text ), value ) );
+    EXPECT_EQ( 1.5, value );
+    // the end is respected
+    EXPECT_EQ( text + 1, parse_double( text, text + 1, value ) );
+    EXPECT_EQ( 1, value );
+    EXPECT_TRUE( parse_double( text + 4, text + strlen( text ), value ) == NULL );
+    EXPECT_TRUE( parse_double( "-.", "-." + 2, value ) == NULL );
+}
+
+TEST(MeshImportTest, Obj)
+{
+    write_file( OBJ_PATH, "# square and a triangle\n"
+                          "o object\n"
+                          "v 0 0 0\n"
+                          "v 1 0 0\r\n"
+                          "vn 0 0 1\n"
+                          "v 1 1 0\n"
+                          "v 0 1 0\n"
+                          "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+                          "v 0 0 1\n"
+                          "  f -1 -5 -4\n"
+                          "f 1 2 2\n" // degenerated
+                          "s off" );
+    ImportedMesh mesh;
+    import_obj( OBJ_PATH, mesh );
+    ASSERT_EQ( 5u, mesh.vertices.size() );
+    EXPECT_EQ( Point( 1, 1, 0 ), mesh.vertices[2] );
+    ASSERT_EQ( 3u, mesh.triangles_count() );
+    const unsigned expected[] = { 0, 1, 2, 0, 2, 3, 4, 0, 1 };
+    EXPECT_TRUE( std::equal( expected, expected + 9, mesh.indices.begin() ) );
+    ASSERT_EQ( 1u, mesh.dropped_triangles.size() );
+    EXPECT_EQ( 3u, mesh.dropped_triangles[0] );
+
+    // no number
+    write_file( OBJ_PATH, "v 0 0 0\nv 1 0 0\nv 1 x 0\n" );
+    EXPECT_THROW( import_obj( OBJ_PATH, mesh ), MeshFormatError );
+    // a face of two vertices
+    write_file( OBJ_PATH, "v 0 0 0\nv 1 0 0\nf 1 2\n" );
+    EXPECT_THROW( import_obj( OBJ_PATH, mesh ), MeshFormatError );
+    // out of the vertices, before and after
+    write_file( OBJ_PATH, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n" );
+    EXPECT_THROW( import_obj( OBJ_PATH, mesh ), MeshFormatError );
+    write_file( OBJ_PATH, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf -4 -2 -1\n" );
+    EXPECT_THROW( import_obj( OBJ_PATH, mesh ), MeshFormatError );
+    write_file( OBJ_PATH, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 0 1 2\n" );
+    EXPECT_THROW( import_obj( OBJ_PATH, mesh ), MeshFormatError );
+    remove( OBJ_PATH );
+
+    EXPECT_THROW( import_obj( "no_such_file.obj", mesh ), FileError );
+}
+
+TEST(MeshImportTest, ObjWithBatch)
+{
+    srand( 11 );
+    write_file( OBJ_PATH, terrain_obj( 60 ) );
+    ImportedMesh expected, mesh;
+    import_obj( OBJ_PATH, expected );
+    EXPECT_EQ( 61u*61u, expected.vertices.size() );
+    EXPECT_EQ( 2u*60u*60u, expected.triangles_count() );
+    EXPECT_TRUE( expected.dropped_triangles.empty() );
+    // the first triangle of the second row is given by relative indices
+    EXPECT_EQ( 1, triangle( expected, 120 )[0].x );
+    EXPECT_EQ( 0, triangle( expected, 120 )[0].y );
+
+    CollisionBatch batch( 4 );
+    import_mesh( OBJ_PATH, mesh, batch );
+    EXPECT_TRUE( expected.vertices == mesh.vertices );
+    EXPECT_TRUE( expected.indices == mesh.indices );
+    remove( OBJ_PATH );
+}
+
+TEST(MeshImportTest, Stl)
+{
+    // two triangles of a square, sharing two vertices, and a degenerated one
+    const char * const text = "solid square\n"
+                              "  facet normal 0 0 1\n"
+                              "    outer loop\n"
+                              "      vertex 0 0 0\n"
+                              "      vertex 1 0 0\n"
+                              "      vertex 1 1 0\n"
+                              "    endloop\n"
+                              "  endfacet\n"
+                              "  facet normal 0 0 1\n"
+                              "    outer loop\n"
+                              "      vertex 0 0 0\n"
+                              "      vertex 1 1 0\n"
+                              "      vertex -0 1 0\n"
+                              "    endloop\n"
+                              "  endfacet\n"
+                              "  facet normal 0 0 1\n"
+                              "    outer loop\n"
+                              "      vertex 0 0 0\n"
+                              "      vertex 1 1 0\n"
+                              "      vertex 2 2 0\n"
+                              "    endloop\n"
+                              "  endfacet\n"
+                              "endsolid square\n";
+    write_file( STL_PATH, text );
+    ImportedMesh ascii;
+    import_stl( STL_PATH, ascii );
+    EXPECT_EQ( 5u, ascii.vertices.size() );
+    ASSERT_EQ( 2u, ascii.triangles_count() );
+    const unsigned expected[] = { 0, 1, 2, 0, 2, 3 };
+    EXPECT_TRUE( std::equal( expected, expected + 6, ascii.indices.begin() ) );
+    ASSERT_EQ( 1u, ascii.dropped_triangles.size() );
+    EXPECT_EQ( 2u, ascii.dropped_triangles[0] );
+
+    // the same in binary, with a header starting with "solid" too
+    const float corners[9][3] = { {0,0,0}, {1,0,0}, {1,1,0}, {0,0,0}, {1,1,0}, {-0.0f,1,0}, {0,0,0}, {1,1,0}, {2,2,0} };
+    std::string binary = "solid but binary";
+    binary.resize( 80, ' ' );
+    append_uint( binary, 3 );
+    for( unsigned i = 0; i < 3; ++i )
+    {
+        append_float( binary, 0 );
+        append_float( binary, 0 );
+        append_float( binary, 1 );
+        for( unsigned j = 0; j < 9; ++j )
+        {
+            append_float( binary, corners[3*i + j/3][j % 3] );
+        }
+        binary.append( 2, '\0' );
+    }
+    write_file( STL_PATH, binary );
+    ImportedMesh mesh;
+    import_mesh( STL_PATH, mesh );
+    EXPECT_TRUE( ascii.vertices == mesh.vertices );
+    EXPECT_TRUE( ascii.indices == mesh.indices );
+    EXPECT_TRUE( ascii.dropped_triangles == mesh.dropped_triangles );
+
+    CollisionBatch batch( 3 );
+    import_stl( STL_PATH, mesh, batch );
+    EXPECT_TRUE( ascii.indices == mesh.indices );
+
+    // truncated binary is not text
+    write_file( STL_PATH, binary.substr( 0, binary.size() - 1 ) );
+    EXPECT_THROW( import_stl( STL_PATH, mesh ), MeshFormatError );
+    // not a whole triangle
+    write_file( STL_PATH, std::string( text, strstr( text, "      vertex 1 1 0" ) ) );
+    EXPECT_THROW( import_stl( STL_PATH, mesh ), MeshFormatError );
+    remove( STL_PATH );
+}
+
+TEST(MeshImportTest, Ply)
+{
+    const std::string header = "ply\n"
+                               "format ascii 1.0\n"
+                               "comment a square\n"
+                               "element vertex 4\n"
+                               "property float x\n"
+                               "property float y\n"
+                               "property float z\n"
+                               "property uchar red\n"
+                               "element face 1\n"
+                               "property list uchar int vertex_indices\n"
+                               "property list uchar float texcoord\n"
+                               "end_header\n";
+    write_file( PLY_PATH, header + "0 0 0 255\n1 0 0 255\n1 1 0 255\n0 1 0 255\n4 0 1 2 3 2 0.5 0.5\n" );
+    ImportedMesh ascii;
+    import_ply( PLY_PATH, ascii );
+    ASSERT_EQ( 4u, ascii.vertices.size() );
+    EXPECT_EQ( Point( 1, 1, 0 ), ascii.vertices[2] );
+    ASSERT_EQ( 2u, ascii.triangles_count() );
+    const unsigned expected[] = { 0, 1, 2, 0, 2, 3 };
+    EXPECT_TRUE( std::equal( expected, expected + 6, ascii.indices.begin() ) );
+
+    // binary ones in both orders
+    for( unsigned big_endian = 0; big_endian < 2; ++big_endian )
+    {
+        std::string content = "ply\nformat ";
+        content += big_endian ? "binary_big_endian" : "binary_little_endian";
+        content += " 1.0\nelement vertex 4\nproperty double x\nproperty double y\nproperty double z\nproperty short s\n"
+                   "element face 1\nproperty list uchar uint vertex_index\nend_header\n";
+        for( unsigned i = 0; i < 4; ++i )
+        {
+            const double coordinates[3] = { ascii.vertices[i].x, ascii.vertices[i].y, ascii.vertices[i].z };
+            for( unsigned j = 0; j < 3; ++j )
+            {
+                unsigned char bytes[8];
+                memcpy( bytes, &coordinates[j], 8 );
+                if( big_endian )
+                {
+                    std::reverse( bytes, bytes + 8 );
+                }
+                content.append( reinterpret_cast<const char *>( bytes ), 8 );
+            }
+            content.append( "\xFF\xFE", 2 );
+        }
+        content.push_back( 4 );
+        for( unsigned i = 0; i < 4; ++i )
+        {
+            char index[4] = { 0, 0, 0, static_cast<char>( i ) };
+            if( !big_endian )
+            {
+                std::reverse( index, index + 4 );
+            }
+            content.append( index, 4 );
+        }
+        write_file( PLY_PATH, content );
+        ImportedMesh mesh;
+        import_mesh( PLY_PATH, mesh );
+        EXPECT_TRUE( ascii.vertices == mesh.vertices ) << big_endian;
+        EXPECT_TRUE( ascii.indices == mesh.indices ) << big_endian;
+    }
+
+    ImportedMesh mesh;
+    // too few values
+    write_file( PLY_PATH, header + "0 0 0 255\n1 0 0 255\n1 1 0\n0 1 0 255\n4 0 1 2 3 2 0.5 0.5\n" );
+    EXPECT_THROW( import_ply( PLY_PATH, mesh ), MeshFormatError );
+    // index out of the vertices
+    write_file( PLY_PATH, header + "0 0 0 255\n1 0 0 255\n1 1 0 255\n0 1 0 255\n4 0 1 2 4 2 0.5 0.5\n" );
+    EXPECT_THROW( import_ply( PLY_PATH, mesh ), MeshFormatError );
+    // unknown type
+    write_file( PLY_PATH, "ply\nformat ascii 1.0\nelement vertex 1\nproperty half x\nend_header\n0\n" );
+    EXPECT_THROW( import_ply( PLY_PATH, mesh ), MeshFormatError );
+    // no format
+    write_file( PLY_PATH, "ply\nelement vertex 0\nend_header\n" );
+    EXPECT_THROW( import_ply( PLY_PATH, mesh ), MeshFormatError );
+    remove( PLY_PATH );
+
+    EXPECT_THROW( import_mesh( "mesh.3ds", mesh ), MeshFormatError );
+}
@@ -0,0 +1,319 @@
+#include "../Collisions/indexed_mesh.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    // adds a triangle, with normal aimed to the given direction
+    void add_triangle(const std::vector<Point> &vertices, std::vector<unsigned> &indices, unsigned a, unsigned b, unsigned c, const Vector &outside)
+    {
+        if( Triangle( vertices[a], vertices[b], vertices[c] ).normal()*outside < 0 )
+            std::swap( b, c );
+        indices.push_back( a );
+        indices.push_back( b );
+        indices.push_back( c );
+    }
+
+    // unit cube: 8 vertices, 12 triangles
+    void cube(/*out*/ std::vector<Point> &vertices, std::vector<unsigned> &indices)
+    {
+        for( unsigned i = 0; i < 8; ++i )
+        {
+            vertices.push_back( Point( i & 1, (i >> 1) & 1, (i >> 2) & 1 ) );
+        }
+        const unsigned faces[6][4] = { {0,1,3,2}, {4,5,7,6}, {0,1,5,4}, {2,3,7,6}, {0,2,6,4}, {1,3,7,5} };
+        const Point center( 0.5, 0.5, 0.5 );
+        for( unsigned i = 0; i < 6; ++i )
+        {
+            const Vector outside = (vertices[faces[i][0]] + vertices[faces[i][2]])/2 - center;
+            add_triangle( vertices, indices, faces[i][0], faces[i][1], faces[i][2], outside );
+            add_triangle( vertices, indices, faces[i][0], faces[i][2], faces[i][3], outside );
+        }
+    }
+
+    // closed convex mesh: sphere of latitude and longitude lines around the origin
+    IndexedMesh uv_sphere(double radius, unsigned stacks, unsigned slices)
+    {
+        const double PI = 3.14159265358979323846;
+        std::vector<Point> vertices;
+        std::vector<unsigned> indices;
+        vertices.push_back( Point(0, 0, radius) );
+        for( unsigned i = 1; i < stacks; ++i )
+        {
+            const double phi = PI*i/stacks;
+            for( unsigned j = 0; j < slices; ++j )
+            {
+                const double theta = 2*PI*j/slices;
+                vertices.push_back( radius*Point( sin(phi)*cos(theta), sin(phi)*sin(theta), cos(phi) ) );
+            }
+        }
+        vertices.push_back( Point(0, 0, -radius) );
+        const unsigned south = static_cast<unsigned>( vertices.size() ) - 1;
+        for( unsigned j = 0; j < slices; ++j )
+        {
+            const unsigned next = (j + 1) % slices;
+            add_triangle( vertices, indices, 0, 1 + j, 1 + next, vertices[1 + j] );
+            add_triangle( vertices, indices, south, south - slices + j, south - slices + next, vertices[south - slices + j] );
+            for( unsigned i = 1; i + 1 < stacks; ++i )
+            {
+                const unsigned a = 1 + (i - 1)*slices + j, b = 1 + (i - 1)*slices + next;
+                const unsigned c = a + slices, d = b + slices;
+                add_triangle( vertices, indices, a, b, d, vertices[a] );
+                add_triangle( vertices, indices, a, d, c, vertices[a] );
+            }
+        }
+        return IndexedMesh( vertices, indices );
+    }
+
+    // open terrain mesh: random heights from 0 to `height' over a grid of `size'*`size' unit cells, aimed up
+    IndexedMesh terrain(unsigned size, double height)
+    {
+        std::vector<Point> vertices;
+        std::vector<unsigned> indices;
+        for( unsigned i = 0; i <= size; ++i )
+        {
+            for( unsigned j = 0; j <= size; ++j )
+            {
+                vertices.push_back( Point( i, j, random_double(0, height) ) );
+            }
+        }
+        const Vector up(0, 0, 1);
+        for( unsigned i = 0; i < size; ++i )
+        {
+            for( unsigned j = 0; j < size; ++j )
+            {
+                const unsigned a = i*(size + 1) + j;
+                add_triangle( vertices, indices, a, a + 1, a + size + 2, up );
+                add_triangle( vertices, indices, a, a + size + 2, a + size + 1, up );
+            }
+        }
+        return IndexedMesh( vertices, indices );
+    }
+
+    std::vector<PreparedTriangle> prepared_triangles(const IndexedMesh &mesh)
+    {
+        std::vector<PreparedTriangle> triangles;
+        for( unsigned i = 0; i < mesh.triangles_count(); ++i )
+        {
+            triangles.push_back( PreparedTriangle( mesh.triangle( i ) ) );
+        }
+        return triangles;
+    }
+
+    // compares the mesh sweep with the sweep over its triangles, returns the number of hits
+    unsigned expect_same_as_triangles(const IndexedMesh &mesh, const std::vector<PreparedTriangle> &triangles,
+                                      const Point &start, const Point &end, double R)
+    {
+        SweepHit expected, hit;
+        const bool expected_result = sweep_sphere( triangles, start, end, R, expected );
+        const bool result = sweep_sphere( mesh, start, end, R, hit );
+        EXPECT_EQ( expected_result, result ) << start << " " << end << " " << R;
+        if( !expected_result || !result )
+            return 0;
+        EXPECT_NEAR( expected.time, hit.time, 1e-9 );
+        EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 );
+        EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 );
+        EXPECT_LT( hit.triangle_index, mesh.triangles_count() );
+        return 1;
+    }
+}
+
+TEST(IndexedMeshTest, Creation)
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    cube( vertices, indices );
+    const IndexedMesh mesh( vertices, indices );
+
+    EXPECT_EQ( 8u, mesh.vertices_count() );
+    EXPECT_EQ( 12u, mesh.triangles_count() );
+    EXPECT_EQ( 18u, mesh.edges_count() );
+    EXPECT_FALSE( mesh.empty() );
+    EXPECT_EQ( mesh.vertex( indices[4] ), mesh.triangle( 1 )[1] );
+
+    // diagonals of faces are flat, sides of the cube are convex
+    unsigned skipped = 0;
+    for( unsigned i = 0; i < mesh.edges_count(); ++i )
+    {
+        const IndexedMesh::Edge &edge = mesh.edge( i );
+        ASSERT_NE( IndexedMesh::NO_TRIANGLE, edge.triangles[1] );
+        for( unsigned j = 0; j < 2; ++j )
+        {
+            // both triangles have the edge as a side, and the other one as a neighbour through it
+            unsigned sides = 0;
+            for( unsigned side = 0; side < 3; ++side )
+            {
+                if( mesh.triangle_edge( edge.triangles[j], side ) == i )
+                {
+                    EXPECT_EQ( edge.triangles[1 - j], mesh.neighbour( edge.triangles[j], side ) );
+                    ++sides;
+                }
+            }
+            EXPECT_EQ( 1u, sides );
+        }
+        const bool diagonal = distance( mesh.vertex( edge.vertices[0] ), mesh.vertex( edge.vertices[1] ) ) > 1.1;
+        EXPECT_EQ( diagonal, edge.skipped );
+        skipped += edge.skipped;
+    }
+    EXPECT_EQ( 6u, skipped );
+    for( unsigned i = 0; i < mesh.vertices_count(); ++i )
+    {
+        EXPECT_FALSE( mesh.is_vertex_skipped( i ) );
+        EXPECT_LE( 3u, mesh.vertex_corners_count( i ) );
+        for( unsigned j = 0; j < mesh.vertex_corners_count( i ); ++j )
+        {
+            EXPECT_EQ( i, indices[ mesh.vertex_corner( i, j ) ] );
+        }
+    }
+
+    // the same from float and double buffers
+    std::vector<float> floats;
+    std::vector<double> doubles;
+    for( unsigned i = 0; i < vertices.size(); ++i )
+    {
+        floats.push_back( static_cast<float>( vertices[i].x ) );
+        floats.push_back( static_cast<float>( vertices[i].y ) );
+        floats.push_back( static_cast<float>( vertices[i].z ) );
+        doubles.push_back( vertices[i].x );
+        doubles.push_back( vertices[i].y );
+        doubles.push_back( vertices[i].z );
+    }
+    const IndexedMesh from_floats( &floats[0], 8, &indices[0], static_cast<unsigned>( indices.size() ) );
+    const IndexedMesh from_doubles( &doubles[0], 8, &indices[0], static_cast<unsigned>( indices.size() ) );
+    EXPECT_EQ( 18u, from_floats.edges_count() );
+    EXPECT_EQ( 18u, from_doubles.edges_count() );
+    EXPECT_EQ( mesh.vertex( 7 ), from_floats.vertex( 7 ) );
+    EXPECT_EQ( mesh.vertex( 7 ), from_doubles.vertex( 7 ) );
+}
+
+TEST(IndexedMeshTest, ConcaveAndBoundary)
+{
+    // two triangles, folded along the common edge: a valley, seen from above
+    std::vector<Point> vertices;
+    vertices.push_back( Point(0, 0, 0) );
+    vertices.push_back( Point(0, 2, 0) );
+    vertices.push_back( Point(-1, 1, 1) );
+    vertices.push_back( Point(1, 1, 1) );
+    std::vector<unsigned> indices;
+    const Vector up(0, 0, 1);
+    add_triangle( vertices, indices, 0, 1, 2, up );
+    add_triangle( vertices, indices, 0, 1, 3, up );
+
+    const IndexedMesh valley( vertices, indices );
+    EXPECT_EQ( 5u, valley.edges_count() );
+    unsigned boundary = 0;
+    for( unsigned i = 0; i < valley.edges_count(); ++i )
+    {
+        const IndexedMesh::Edge &edge = valley.edge( i );
+        if( edge.triangles[1] == IndexedMesh::NO_TRIANGLE )
+        {
+            ++boundary;
+            EXPECT_FALSE( edge.skipped );
+        }
+        else
+        {
+            EXPECT_TRUE( edge.skipped );
+        }
+    }
+    EXPECT_EQ( 4u, boundary );
+
+    // a ridge: the same edge is convex
+    vertices[2].z = vertices[3].z = -1;
+    indices.clear();
+    add_triangle( vertices, indices, 0, 1, 2, up );
+    add_triangle( vertices, indices, 0, 1, 3, up );
+    const IndexedMesh ridge( vertices, indices );
+    for( unsigned i = 0; i < ridge.edges_count(); ++i )
+    {
+        EXPECT_FALSE( ridge.edge( i ).skipped );
+    }
+
+    // the sphere, falling into the valley, touches both faces at once, but not the bottom edge
+    SweepHit hit;
+    const double R = 0.5;
+    EXPECT_TRUE( sweep_sphere( valley, Point(0, 1, 3), Point(0, 1, -1), R, hit ) );
+    EXPECT_NEAR( R*sqrt(2.0), hit.sphere_center.z, 1e-12 );
+    EXPECT_NEAR( 0, distance( Point(0, 1, 0), hit.collision_point ) - R, 1e-12 );
+}
+
+TEST(IndexedMeshTest, SameAsTriangles)
+{
+    srand(12);
+    const IndexedMesh sphere = uv_sphere( 2, 12, 16 );
+    const std::vector<PreparedTriangle> sphere_triangles = prepared_triangles( sphere );
+    unsigned hits = 0;
+    for( unsigned i = 0; i < 2000; ++i )
+    {
+        const double R = random_double(0.05, 1);
+        Point start = random_point(4);
+        while( start.norm() < 2 + R + 0.01 )
+        {
+            start = random_point(4);
+        }
+        hits += expect_same_as_triangles( sphere, sphere_triangles, start, random_point(3), R );
+    }
+    EXPECT_LT( 200u, hits );
+
+    const unsigned SIZE = 8;
+    const IndexedMesh ground = terrain( SIZE, 2 );
+    const std::vector<PreparedTriangle> ground_triangles = prepared_triangles( ground );
+    unsigned skipped = 0;
+    for( unsigned i = 0; i < ground.edges_count(); ++i )
+    {
+        skipped += ground.edge( i ).skipped;
+    }
+    EXPECT_LT( 0u, skipped );
+    hits = 0;
+    for( unsigned i = 0; i < 2000; ++i )
+    {
+        // from above, staying over the terrain
+        const double R = random_double(0.05, 1);
+        const Point start( random_double(0, SIZE), random_double(0, SIZE), 2 + R + random_double(0.01, 2) );
+        const Point end( random_double(0, SIZE), random_double(0, SIZE), random_double(-1, 4) );
+        hits += expect_same_as_triangles( ground, ground_triangles, start, end, R );
+    }
+    EXPECT_LT( 200u, hits );
+}
+
+TEST(IndexedMeshTest, Memory)
+{
+    // a closed mesh takes several times less memory than its prepared triangles (about 2.8 times)
+    const IndexedMesh sphere = uv_sphere( 1, 64, 64 );
+    EXPECT_GT( sphere.triangles_count()*sizeof(PreparedTriangle), 5*sphere.memory_size()/2 );
+}
+
+TEST(IndexedMeshTest, BlackTest)
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned> indices;
+    cube( vertices, indices );
+
+    std::vector<unsigned> partial( indices.begin(), indices.end() - 1 );
+    EXPECT_THROW( IndexedMesh( vertices, partial ), InvalidIndicesError );
+    std::vector<unsigned> outside( indices );
+    outside[5] = 8;
+    EXPECT_THROW( IndexedMesh( vertices, outside ), InvalidIndicesError );
+    std::vector<unsigned> degenerated( indices );
+    degenerated[1] = degenerated[0];
+    EXPECT_THROW( IndexedMesh( vertices, degenerated ), DegeneratedTriangleError );
+
+    const IndexedMesh mesh( vertices, indices );
+    EXPECT_THROW( mesh.vertex( 8 ), OutOfBoundsError );
+    EXPECT_THROW( mesh.triangle( 12 ), OutOfBoundsError );
+    EXPECT_THROW( mesh.edge( 18 ), OutOfBoundsError );
+
+    SweepHit hit;
+    const Point A(2, 2, 2);
+    EXPECT_THROW( sweep_sphere( mesh, A, A, 0.5, hit ), DegeneratedSegmentError );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sweep_sphere( mesh, A, A, 0.5, hit ) );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::sweep_sphere( mesh, A, A + Point(1, 0, 0), 0.5, hit ) );
+
+    const std::vector<Point> no_vertices;
+    const std::vector<unsigned> no_indices;
+    const IndexedMesh empty( no_vertices, no_indices );
+    EXPECT_TRUE( empty.empty() );
+    EXPECT_FALSE( sweep_sphere( empty, A, -A, 0.5, hit ) );
+}
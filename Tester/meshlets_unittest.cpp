@@ -0,0 +1,234 @@
+#include "../Collisions/meshlets.h"
+#include "../Collisions/stats.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    // closed convex prop: a UV sphere of `rings' x `segments' quads, split into triangles
+    std::vector<Triangle> uv_sphere(double radius, unsigned rings, unsigned segments)
+    {
+        const double PI = 3.14159265358979323846;
+        std::vector<Triangle> triangles;
+        for( unsigned i = 0; i < rings; ++i )
+        {
+            for( unsigned j = 0; j < segments; ++j )
+            {
+                Point corners[4];
+                for( unsigned k = 0; k < 4; ++k )
+                {
+                    const double theta = PI*(i + k/2)/rings;
+                    const double phi = 2*PI*(j + k%2)/segments;
+                    corners[k] = Point( radius*sin(theta)*cos(phi), radius*sin(theta)*sin(phi), radius*cos(theta) );
+                }
+                if( i != 0 )
+                    triangles.push_back( Triangle( corners[0], corners[1], corners[2] ) );
+                if( i + 1 != rings )
+                    triangles.push_back( Triangle( corners[1], corners[3], corners[2] ) );
+            }
+        }
+        return triangles;
+    }
+}
+
+// Meshlet mesh tests
+
+TEST(MeshletMeshTest, Creation)
+{
+    const std::vector<Triangle> triangles = uv_sphere( 10, 32, 32 );
+    const MeshletMesh mesh( triangles );
+    ASSERT_EQ( triangles.size(), mesh.size() );
+    EXPECT_FALSE( mesh.empty() );
+    EXPECT_GE( mesh.meshlets_count(), triangles.size()/MeshletMesh::MAX_TRIANGLES );
+
+    // meshlets cover the mesh in order, each bounds its triangles and their normals
+    std::vector<unsigned> seen( triangles.size(), 0 );
+    unsigned next = 0;
+    for( unsigned i = 0; i < mesh.meshlets_count(); ++i )
+    {
+        const MeshletMesh::Meshlet &meshlet = mesh.meshlet( i );
+        EXPECT_EQ( next, meshlet.first );
+        EXPECT_GT( meshlet.count, MeshletMesh::MAX_TRIANGLES/2 );
+        EXPECT_LE( meshlet.count, MeshletMesh::MAX_TRIANGLES );
+        EXPECT_NEAR( 1, meshlet.axis.norm(), 1e-12 );
+        EXPECT_GT( meshlet.cone_cos, 0.5 ) << i; // patches of a smooth sphere
+        for( unsigned j = meshlet.first; j < meshlet.first + meshlet.count; ++j )
+        {
+            const PreparedTriangle &triangle = mesh.triangle( j );
+            for( unsigned k = 0; k < 3; ++k )
+            {
+                EXPECT_LE( distance( meshlet.center, triangle[k] ), meshlet.radius + 1e-12 );
+            }
+            EXPECT_GE( triangle.normal()*meshlet.axis, meshlet.cone_cos - 1e-12 );
+            const double height = (meshlet.center - triangle[0])*triangle.normal();
+            EXPECT_GE( height, meshlet.center_heights[0] - 1e-12 );
+            EXPECT_LE( height, meshlet.center_heights[1] + 1e-12 );
+            EXPECT_EQ( triangles[ mesh.original_index( j ) ][0], triangle[0] );
+            ++seen[ mesh.original_index( j ) ];
+        }
+        next += meshlet.count;
+    }
+    EXPECT_EQ( triangles.size(), next );
+    EXPECT_EQ( triangles.size(), static_cast<size_t>( std::count( seen.begin(), seen.end(), 1u ) ) );
+
+    EXPECT_THROW( mesh.triangle( mesh.size() ), OutOfBoundsError );
+    EXPECT_THROW( mesh.meshlet( mesh.meshlets_count() ), OutOfBoundsError );
+    EXPECT_THROW( MeshletMesh( std::vector<Triangle>( 1, Triangle( Point(0,0,0), Point(1,1,1), Point(2,2,2) ) ) ), DegeneratedTriangleError );
+}
+
+TEST(MeshletMeshTest, Small)
+{
+    // a mesh, smaller than a meshlet, is a single one; a cube has no normal cone
+    const Point A(0,0,0), B(1,0,0), C(1,1,0), D(0,1,0), E(0,0,1), F(1,0,1), G(1,1,1), H(0,1,1);
+    const Triangle faces[12] = { Triangle(A,C,B), Triangle(A,D,C), Triangle(E,F,G), Triangle(E,G,H), Triangle(A,B,F), Triangle(A,F,E),
+                                 Triangle(B,C,G), Triangle(B,G,F), Triangle(C,D,H), Triangle(C,H,G), Triangle(D,A,E), Triangle(D,E,H) };
+    const MeshletMesh cube( std::vector<Triangle>( faces, faces + 12 ) );
+    ASSERT_EQ( 1u, cube.meshlets_count() );
+    EXPECT_EQ( 12u, cube.meshlet(0).count );
+    EXPECT_LE( cube.meshlet(0).cone_cos, 0 );
+
+    SweepHit hit;
+    EXPECT_TRUE( sweep_sphere( cube, Point(3,0.5,0.5), Point(-3,0.5,0.5), 0.5, hit ) );
+    EXPECT_DOUBLE_EQ( 1.5/6, hit.time );
+    EXPECT_EQ( Point(1,0.5,0.5), hit.collision_point );
+    EXPECT_EQ( Point(1.5,0.5,0.5), hit.sphere_center );
+    EXPECT_TRUE( faces[hit.triangle_index][0].x == 1 || faces[hit.triangle_index][1].x == 1 );
+
+    const MeshletMesh empty( ( std::vector<Triangle>() ) );
+    EXPECT_TRUE( empty.empty() );
+    EXPECT_EQ( 0u, empty.meshlets_count() );
+    EXPECT_FALSE( sweep_sphere( empty, Point(0,0,0), Point(1,0,0), 1, hit ) );
+
+    EXPECT_THROW( sweep_sphere( cube, Point(3,0,0), Point(3,0,0), 1, hit ), DegeneratedSegmentError );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sweep_sphere( cube, Point(3,0,0), Point(3,0,0), 1, hit ) );
+}
+
+TEST(MeshletMeshTest, Random)
+{
+    // the same hits, as for the triangle array, whatever is culled
+    srand(1);
+    for( unsigned soup = 0; soup < 2; ++soup )
+    {
+        const std::vector<Triangle> triangles = soup ? random_mesh( 500, 10 ) : uv_sphere( 10, 24, 24 );
+        const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+        const MeshletMesh mesh( prepared );
+        for( unsigned i = 0; i < 1000; ++i )
+        {
+            // ways from all around, inside and outside of the sphere, many of them short
+            const Point start = random_point( 15 );
+            const Point end = start + random_point( i % 2 ? 3 : 30 );
+            const double radius = random_double( 0, 2 );
+            SweepHit expected, hit;
+            const bool collided = sweep_sphere( prepared, start, end, radius, expected );
+            ASSERT_EQ( collided, sweep_sphere( mesh, start, end, radius, hit ) ) << soup << " " << i;
+            if( collided )
+            {
+                EXPECT_NEAR( expected.time, hit.time, 1e-12 ) << soup << " " << i;
+                EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 ) << soup << " " << i;
+                // the same triangle, unless two triangles are touched at once
+                if( expected.triangle_index == hit.triangle_index )
+                {
+                    EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << soup << " " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(MeshletMeshTest, HemisphereNormals)
+{
+    // Bowls of 6 triangles: a flat bottom and walls around the z axis, with normals tilted from +z towards the axis
+    // by up to 84 degrees. Their cones are wide, and spheres below the bottom come to it from behind the cone.
+    // The same hits, as for the triangle array.
+    const double PI = 3.14159265358979323846;
+    srand(1);
+    unsigned hits = 0;
+    for( unsigned i = 0; i < 20000; ++i )
+    {
+        std::vector<PreparedTriangle> triangles;
+        for( unsigned k = 0; k < 6; ++k )
+        {
+            const double angle = 2*PI*k/5 + random_double( -0.5, 0.5 );
+            const double tilt = ( k == 0 ? random_double( 0, 20 ) : random_double( 20, 84 ) )*PI/180;
+            const Vector outwards( cos(angle), sin(angle), 0 );
+            const Vector normal = Vector( 0, 0, cos(tilt) ) - sin(tilt)*outwards;
+            const Vector along = cross_product( normal, outwards ).normalized();
+            const Vector across = cross_product( normal, along );
+            const Point center = k == 0 ? Point( random_double( -0.3, 0.3 ), random_double( -0.3, 0.3 ), -2 )
+                                        : Point( 0, 0, random_double( -2, 0 ) ) + random_double( 1, 2.5 )*outwards;
+            const PreparedTriangle triangle( center + along, center - along + 0.5*across, center - along - 0.5*across );
+            triangles.push_back( triangle.normal()*normal > 0 ? triangle : PreparedTriangle( triangle[0], triangle[2], triangle[1] ) );
+        }
+        const MeshletMesh mesh( triangles );
+        const Point start( random_double( -0.5, 0.5 ), random_double( -0.5, 0.5 ), random_double( -4, -2 ) );
+        const Point end = start + random_point( 1 );
+        const double radius = random_double( 0.2, 1.5 );
+
+        SweepHit expected, hit;
+        const CollisionStatus status = NoThrow::sweep_sphere( &triangles[0], 6, start, end, radius, expected );
+        ASSERT_EQ( status, NoThrow::sweep_sphere( mesh, start, end, radius, hit ) ) << i;
+        if( status == CollisionStatus::Hit )
+        {
+            ++hits;
+            EXPECT_NEAR( expected.time, hit.time, 1e-12 ) << i;
+        }
+    }
+    EXPECT_LT( 1000u, hits );
+}
+
+TEST(MeshletMeshTest, Culling)
+{
+    // flat ground of 32 x 32 quads: cones are exact, every meshlet is culled by them
+    std::vector<Triangle> ground;
+    for( unsigned i = 0; i < 32; ++i )
+    {
+        for( unsigned j = 0; j < 32; ++j )
+        {
+            const Point a( i, j, 0 ), b( i + 1, j, 0 ), c( i, j + 1, 0 ), d( i + 1, j + 1, 0 );
+            ground.push_back( Triangle( a, b, c ) );
+            ground.push_back( Triangle( b, d, c ) );
+        }
+    }
+    const MeshletMesh flat( ground );
+    SweepHit hit;
+    reset_stats();
+    EXPECT_FALSE( sweep_sphere( flat, Point(-1,5,0.6), Point(33,20,0.6), 0.5, hit ) );  // sliding over it
+    EXPECT_FALSE( sweep_sphere( flat, Point(16,16,-0.6), Point(10,10,-5), 0.5, hit ) ); // leaving it below
+    Stats result = stats();
+    if( stats_enabled() )
+    {
+        EXPECT_EQ( 2*flat.meshlets_count(), result[Counter::MeshletsCulledByBounds] + result[Counter::MeshletsCulledByCone] );
+        EXPECT_GT( result[Counter::MeshletsCulledByCone], 0u );
+        EXPECT_EQ( 0u, result[Counter::MeshletsTested] );
+    }
+    EXPECT_TRUE( sweep_sphere( flat, Point(-1,5,0.6), Point(33,20,0.4), 0.5, hit ) );
+
+    // sphere: leaving it from its surface outwards, and from inside it towards its center, only a few
+    // meshlets near the way are tested
+    const MeshletMesh mesh( uv_sphere( 10, 32, 32 ) );
+    reset_stats();
+    EXPECT_FALSE( sweep_sphere( mesh, Point(0,11,0), Point(0,15,0), 0.5, hit ) );
+    EXPECT_FALSE( sweep_sphere( mesh, Point(3,-1,2), Point(1,0,1), 0.5, hit ) );
+    result = stats();
+    if( stats_enabled() )
+    {
+        EXPECT_EQ( 2*mesh.meshlets_count(), result[Counter::MeshletsCulledByBounds] + result[Counter::MeshletsCulledByCone] + result[Counter::MeshletsTested] );
+        EXPECT_LE( result[Counter::MeshletsTested], mesh.meshlets_count()/8 );
+    }
+
+    // hitting it: meshlets, entered after the earliest hit, or which the way passes by, are not tested
+    reset_stats();
+    EXPECT_TRUE( sweep_sphere( mesh, Point(0,0,30), Point(0,0,-30), 0.5, hit ) );
+    EXPECT_NEAR( 0, hit.collision_point.x, 1e-12 );
+    EXPECT_NEAR( 10, hit.collision_point.z, 1e-12 );
+    result = stats();
+    if( stats_enabled() )
+    {
+        EXPECT_LT( result[Counter::MeshletsTested], mesh.meshlets_count()/4 );
+    }
+}
@@ -0,0 +1,112 @@
+#include "../Collisions/sphere_packet.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using namespace Collisions;
+
+TEST(SpherePacketTest, Creation)
+{
+    SpherePacket packet;
+    EXPECT_TRUE( packet.empty() );
+    for( unsigned i = 0; i < SpherePacket::MAX_SIZE; ++i )
+    {
+        packet.add( Point(i,0,0), Point(i,1,2), 0.5 + i );
+    }
+    EXPECT_EQ( SpherePacket::MAX_SIZE, packet.size() );
+    EXPECT_EQ( Point(3,0,0), packet.segment_start(3) );
+    EXPECT_EQ( Point(3,1,2), packet.segment_end(3) );
+    EXPECT_EQ( 3.5, packet.radius[3] );
+    EXPECT_THROW( packet.add( Point(0,0,0), Point(1,1,1), 1 ), OutOfBoundsError );
+    EXPECT_THROW( packet.segment_start( SpherePacket::MAX_SIZE ), OutOfBoundsError );
+
+    packet.clear();
+    EXPECT_TRUE( packet.empty() );
+    EXPECT_THROW( packet.segment_end(0), OutOfBoundsError );
+}
+
+TEST(SpherePacketTest, Earliest)
+{
+    // a stack of horizontal triangles: z = 0..19, spheres are falling from above
+    std::vector<Triangle> triangles;
+    for( unsigned i = 0; i < 20; ++i )
+    {
+        triangles.push_back( Triangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    const MeshBVH mesh( triangles );
+    SpherePacket packet;
+    packet.add( Point(2,2,30), Point(2,2,-10), 0.5 );
+    packet.add( Point(2,2,-10), Point(2,2,30), 0.5 );
+    packet.add( Point(2,2,7.7), Point(2,2,-10), 0.5 );
+    packet.add( Point(10,2,7.7), Point(10,2,-10), 0.5 );
+    packet.add( Point(2,2,7.7), Point(2,2,7.7), 0.5 );
+    BatchResult results[SpherePacket::MAX_SIZE];
+
+    sweep_sphere( mesh, packet, results );
+    ASSERT_EQ( CollisionStatus::Hit, results[0].status );
+    EXPECT_EQ( 19u, results[0].hit.triangle_index );
+    EXPECT_EQ( Point(2,2,19), results[0].hit.collision_point );
+    EXPECT_EQ( Point(2,2,19.5), results[0].hit.sphere_center );
+    EXPECT_DOUBLE_EQ( 10.5/40, results[0].hit.time );
+    ASSERT_EQ( CollisionStatus::Hit, results[1].status );
+    EXPECT_EQ( 0u, results[1].hit.triangle_index );
+    ASSERT_EQ( CollisionStatus::Hit, results[2].status );
+    EXPECT_EQ( 7u, results[2].hit.triangle_index );
+    EXPECT_EQ( CollisionStatus::Miss, results[3].status );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, results[4].status );
+}
+
+TEST(SpherePacketTest, SameAsOneByOne)
+{
+    srand(4242);
+    const std::vector<Triangle> triangles = random_mesh( 500, 10 );
+    const MeshBVH mesh( triangles );
+
+    unsigned hits = 0;
+    for( unsigned test = 0; test < 200; ++test )
+    {
+        // a bundle from about the same origin: spread, or random (the packet still must be right)
+        const Point origin = random_point(15);
+        const Point target = random_point(15);
+        const double spread = test % 4 == 0 ? 20 : random_double(0, 2);
+        SpherePacket packet;
+        const unsigned size = 1 + test % SpherePacket::MAX_SIZE;
+        for( unsigned i = 0; i < size; ++i )
+        {
+            packet.add( origin + random_point(0.5), target + random_point(spread), random_double(0.1, 1) );
+        }
+
+        BatchResult results[SpherePacket::MAX_SIZE];
+        sweep_sphere( mesh.view(), packet, results );
+        for( unsigned i = 0; i < size; ++i )
+        {
+            SweepHit expected;
+            const bool any_hit = sweep_sphere( mesh, packet.segment_start(i), packet.segment_end(i), packet.radius[i], expected );
+            ASSERT_EQ( to_status( any_hit ), results[i].status ) << "test #" << test << ", sphere " << i;
+            if( !any_hit )
+                continue;
+
+            ++hits;
+            const SweepHit &hit = results[i].hit;
+            ASSERT_LT( hit.triangle_index, triangles.size() );
+            EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test << ", sphere " << i;
+            EXPECT_NEAR( 0, distance( expected.sphere_center, hit.sphere_center ), 1e-9 ) << "test #" << test << ", sphere " << i;
+            // the same triangle, unless two triangles are touched at once
+            if( expected.triangle_index == hit.triangle_index )
+            {
+                EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "test #" << test << ", sphere " << i;
+            }
+        }
+    }
+    EXPECT_LT( 100u, hits );
+}
+
+TEST(SpherePacketTest, EmptyMesh)
+{
+    const MeshBVH mesh( ( std::vector<Triangle>() ) );
+    SpherePacket packet;
+    packet.add( Point(0,0,0), Point(1,1,1), 1 );
+    BatchResult results[1];
+    sweep_sphere( mesh, packet, results );
+    EXPECT_EQ( CollisionStatus::Miss, results[0].status );
+}
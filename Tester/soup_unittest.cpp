@@ -0,0 +1,253 @@
+#include "../Collisions/triangle_soup.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using namespace Collisions;
+
+// Triangle soup tests
+
+TEST(TriangleSoupTest, Creation)
+{
+    std::vector<Triangle> triangles;
+    for( unsigned i = 0; i < 6; ++i )
+    {
+        triangles.push_back( Triangle( Point(i,0,0), Point(i,1,0), Point(i,0,1) ) );
+    }
+    const TriangleSoup soup( triangles );
+
+    EXPECT_EQ( 6u, soup.size() );
+    EXPECT_EQ( 2u, soup.blocks_count() );
+    for( unsigned i = 0; i < soup.size(); ++i )
+    {
+        for( unsigned j = 0; j < 3; ++j )
+        {
+            EXPECT_EQ( triangles[i][j], soup[i][j] );
+        }
+    }
+    // bounds of the 6th triangle, copied to padding lanes
+    const TriangleSoup::BlockBounds &bounds = soup.block_bounds( 1 );
+    EXPECT_EQ( 5, bounds.box_min[0][1] );
+    EXPECT_EQ( 5, bounds.box_max[0][3] );
+    EXPECT_EQ( 1, bounds.box_max[1][3] );
+    EXPECT_EQ( 0, bounds.box_min[2][2] );
+    const PreparedTriangle last( triangles[5] );
+    EXPECT_EQ( last.normal().x, bounds.normal[0][1] );
+    EXPECT_EQ( last.plane_offset(), bounds.offset[3] );
+    EXPECT_THROW( soup.block_bounds( 2 ), OutOfBoundsError );
+}
+
+TEST(TriangleSoupTest, BlackTest)
+{
+    TriangleSoup soup;
+    const Point A(1,2,3), B(2,3,4), C(3,4,5);
+
+    EXPECT_TRUE( soup.empty() );
+    EXPECT_THROW( soup.add( Triangle(A, B, C) ), DegeneratedTriangleError );
+    EXPECT_TRUE( soup.empty() );
+    EXPECT_THROW( soup[0], OutOfBoundsError );
+    EXPECT_THROW( soup.block(0), OutOfBoundsError );
+}
+
+// Sweep sphere tests
+
+TEST(SweepSphereTest, Empty)
+{
+    const TriangleSoup soup;
+    SweepHit hit;
+
+    EXPECT_FALSE( sweep_sphere( soup, Point(0,0,0), Point(1,1,1), 1, hit ) );
+}
+
+TEST(SweepSphereTest, SameAsSingleTriangle)
+{
+    const double R = 0.32;
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    TriangleSoup soup;
+    soup.add( triangle );
+    const Vector L( 0, 0, 2*R );
+    const Point inner(2,2,0);
+    const Point A = triangle[1] + Point(0,0,R);
+    const Point B = triangle[0] - Point(R,R,0);
+
+    SweepHit hit;
+
+    EXPECT_TRUE(  sweep_sphere( soup, inner-L, inner+L, R, hit ) ); // plane
+    EXPECT_EQ( inner, hit.collision_point );
+    EXPECT_DOUBLE_EQ( 0.25, hit.time );
+    EXPECT_EQ( inner - Vector(0,0,R), hit.sphere_center );
+    EXPECT_EQ( 0u, hit.triangle_index );
+    EXPECT_TRUE(  sweep_sphere( soup, Point(4,-2*R,0), Point(4,6+R,0), R, hit ) ); // side
+    EXPECT_EQ( Point(4,0,0), hit.collision_point );
+    EXPECT_TRUE(  sweep_sphere( soup, Point(7,-1,0), Point(3,+1,0), R, hit ) ); // vertex
+    EXPECT_EQ( triangle[2], hit.collision_point );
+    EXPECT_TRUE(  sweep_sphere( soup, A, B, R, hit ) );
+    EXPECT_EQ( triangle[1], hit.collision_point );
+    EXPECT_TRUE(  sweep_sphere( soup, B, A, R, hit ) );
+    EXPECT_EQ( triangle[0], hit.collision_point );
+    EXPECT_FALSE( sweep_sphere( soup, Point(2,2*R,0), Point(2,-3*R,0), R, hit ) ); // moving outside
+    EXPECT_FALSE( sweep_sphere( soup, Point(2,2,1), Point(2,2,1+R), R, hit ) );
+}
+
+TEST(SweepSphereTest, Earliest)
+{
+    // a stack of 7 horizontal triangles: z = 0..6, sphere is falling from above
+    TriangleSoup soup;
+    for( unsigned i = 0; i < 7; ++i )
+    {
+        soup.add( Triangle( Point(0,0,i), Point(2,4,i), Point(5,0,i) ) );
+    }
+    SweepHit hit;
+
+    EXPECT_TRUE( sweep_sphere( soup, Point(2,2,10), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_EQ( 6u, hit.triangle_index );
+    EXPECT_EQ( Point(2,2,6), hit.collision_point );
+    EXPECT_EQ( Point(2,2,6.5), hit.sphere_center );
+
+    EXPECT_TRUE( sweep_sphere( soup, Point(2,2,-10), Point(2,2,10), 0.5, hit ) );
+    EXPECT_EQ( 0u, hit.triangle_index );
+
+    EXPECT_TRUE( sweep_sphere( soup, Point(2,2,3.7), Point(2,2,-10), 0.5, hit ) );
+    EXPECT_EQ( 3u, hit.triangle_index );
+}
+
+TEST(SweepSphereTest, Random)
+{
+    srand(12345);
+    for( unsigned test = 0; test < 200; ++test )
+    {
+        std::vector<Triangle> triangles;
+        const unsigned count = 1 + rand() % 11;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            triangles.push_back( Triangle( random_point(5), random_point(5), random_point(5) ) );
+        }
+        const TriangleSoup soup( triangles );
+        const Point start = random_point(10);
+        const Point end = random_point(10);
+        const double R = random_double(0.1, 2);
+
+        bool any_hit = false;
+        Point point;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            any_hit = sphere_and_triangle_collision( start, end, R, triangles[i], point ) || any_hit;
+        }
+
+        SweepHit hit;
+        const bool soup_hit = sweep_sphere( soup, start, end, R, hit );
+        ASSERT_EQ( any_hit, soup_hit ) << "test #" << test;
+        if( soup_hit )
+        {
+            ASSERT_LT( hit.triangle_index, count );
+            EXPECT_TRUE( sphere_and_triangle_collision( start, end, R, triangles[hit.triangle_index], point ) );
+            EXPECT_GE( hit.time, 0 );
+            EXPECT_LE( hit.time, 1 );
+
+            // the same result, as sweeping triangle by triangle
+            SweepHit expected;
+            ASSERT_TRUE( sweep_sphere( std::vector<PreparedTriangle>( triangles.begin(), triangles.end() ), start, end, R, expected ) );
+            EXPECT_EQ( expected.triangle_index, hit.triangle_index ) << "test #" << test;
+            EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+            EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "test #" << test;
+        }
+    }
+}
+
+TEST(SweepSphereTest, SameAsVectorOnMesh)
+{
+    // many blocks, most of them far from the sphere way, and many hits on the way of long sweeps
+    srand(2024);
+    const std::vector<Triangle> triangles = random_mesh( 500, 10 );
+    const TriangleSoup soup( triangles );
+    const std::vector<PreparedTriangle> prepared( triangles.begin(), triangles.end() );
+    unsigned hits = 0;
+    for( unsigned test = 0; test < 500; ++test )
+    {
+        const Point start = random_point(12);
+        const Point end = test % 2 == 0 ? start + random_point(3) : random_point(12);
+        const double R = random_double(0.1, 1);
+
+        SweepHit expected, hit;
+        const bool any_hit = sweep_sphere( prepared, start, end, R, expected );
+        ASSERT_EQ( any_hit, sweep_sphere( soup, start, end, R, hit ) ) << "test #" << test;
+        if( any_hit )
+        {
+            ++hits;
+            EXPECT_EQ( expected.triangle_index, hit.triangle_index ) << "test #" << test;
+            EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+        }
+    }
+    EXPECT_LT( 100u, hits );
+    EXPECT_GT( 400u, hits );
+}
+
+TEST(SweepSphereTest, BlackTest)
+{
+    TriangleSoup soup;
+    soup.add( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    const Point A(1, 1, 1);
+    SweepHit hit;
+
+    EXPECT_THROW( sweep_sphere( soup, A, A, 0.5, hit ), DegeneratedSegmentError );
+}
+
+TEST(SweepSphereTest, NoThrow)
+{
+    TriangleSoup soup;
+    soup.add( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    const Point A(2, 2, 1);
+    SweepHit hit;
+
+    EXPECT_EQ( CollisionStatus::Hit, NoThrow::sweep_sphere( soup, A, -A, 0.5, hit ) );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::sweep_sphere( soup, A, 2*A, 0.5, hit ) );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sweep_sphere( soup, A, A, 0.5, hit ) );
+}
+
+// Raycast tests
+
+TEST(RaycastSoupTest, SameAsVector)
+{
+    srand(4321);
+    unsigned hits = 0;
+    for( unsigned test = 0; test < 300; ++test )
+    {
+        std::vector<Triangle> triangles;
+        const unsigned count = 1 + rand() % 11;
+        for( unsigned i = 0; i < count; ++i )
+        {
+            triangles.push_back( Triangle( random_point(5), random_point(5), random_point(5) ) );
+        }
+        const TriangleSoup soup( triangles );
+        const Point origin = random_point(10);
+        const Vector direction = triangles[0][0] + random_point(2) - origin;
+        const double max_time = random_double(0, 2);
+
+        RayHit expected, hit;
+        const bool any_hit = raycast( std::vector<PreparedTriangle>( triangles.begin(), triangles.end() ), origin, direction, max_time, expected );
+        ASSERT_EQ( any_hit, raycast( soup, origin, direction, max_time, hit ) ) << "test #" << test;
+        if( !any_hit )
+            continue;
+
+        ++hits;
+        EXPECT_EQ( expected.triangle_index, hit.triangle_index ) << "test #" << test;
+        EXPECT_NEAR( expected.time, hit.time, 1e-9 ) << "test #" << test;
+        EXPECT_NEAR( expected.u, hit.u, 1e-9 ) << "test #" << test;
+        EXPECT_NEAR( expected.v, hit.v, 1e-9 ) << "test #" << test;
+        EXPECT_NEAR( 0, distance( expected.collision_point, hit.collision_point ), 1e-9 ) << "test #" << test;
+    }
+    EXPECT_LT( 50u, hits );
+}
+
+TEST(RaycastSoupTest, BlackTest)
+{
+    TriangleSoup soup;
+    soup.add( Triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) ) );
+    RayHit hit;
+
+    EXPECT_TRUE( raycast( soup, Point(2,2,1), Vector(0,0,-1), 2, hit ) );
+    EXPECT_EQ( Point(2,2,0), hit.collision_point );
+    EXPECT_FALSE( raycast( TriangleSoup(), Point(2,2,1), Vector(0,0,-1), 2, hit ) );
+    EXPECT_THROW( raycast( soup, Point(2,2,1), Vector(0,0,0), 2, hit ), InvalidLineVectorError );
+    EXPECT_EQ( CollisionStatus::Miss, NoThrow::raycast( soup, Point(2,2,1), Vector(0,0,1), 2, hit ) );
+}
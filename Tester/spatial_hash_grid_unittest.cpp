@@ -0,0 +1,189 @@
+#include "../Collisions/spatial_hash_grid.h"
+#include "../Collisions/collision_batch.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    // pairs of spheres with intersecting boxes, found by testing all pairs
+    std::vector<SpherePair> all_pairs(const MovingSpheres &spheres)
+    {
+        std::vector<SpherePair> result;
+        for( unsigned i = 0; i < spheres.size(); ++i )
+        {
+            const BoundingBox box = bounding_box( spheres.segment_start( i ), spheres.segment_end( i ), spheres.radius( i ) );
+            for( unsigned j = i + 1; j < spheres.size(); ++j )
+            {
+                if( box.intersects( bounding_box( spheres.segment_start( j ), spheres.segment_end( j ), spheres.radius( j ) ) ) )
+                {
+                    result.push_back( SpherePair( i, j ) );
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<SpherePair> sorted(std::vector<SpherePair> pairs)
+    {
+        std::sort( pairs.begin(), pairs.end() );
+        return pairs;
+    }
+}
+
+// Spatial hash grid tests
+
+TEST(SpatialHashGridTest, Trivial)
+{
+    MovingSpheres spheres;
+    spheres.add( Point(0.5,0.5,0.5), Point(0.5,0.5,0.5), 0.4 );
+    spheres.add( Point(1.3,0.5,0.5), Point(1.3,0.5,0.5), 0.4 );     // the next cell, touching the first one
+    spheres.add( Point(-0.2,-0.2,0.5), Point(-0.2,-0.2,0.5), 0.4 ); // a diagonal neighbour of the first one
+    spheres.add( Point(5.5,0.5,0.5), Point(5.5,0.5,0.5), 0.4 );     // far away
+    SpatialHashGrid grid( 1 );
+    grid.rebuild( spheres );
+    EXPECT_EQ( 1, grid.cell_size() );
+    EXPECT_EQ( 4u, grid.size() );
+    EXPECT_EQ( 0u, grid.large_count() );
+    EXPECT_EQ( 4u, grid.cells_count() );
+
+    const unsigned slot = grid.find_cell( 5, 0, 0 );
+    ASSERT_NE( SpatialHashGrid::NO_CELL, slot );
+    EXPECT_EQ( 1u, grid.cell( slot ).count );
+    EXPECT_EQ( 3u, grid.item( grid.cell( slot ).first ).index );
+    EXPECT_EQ( 5, grid.cell( slot ).x );
+    EXPECT_EQ( 0, grid.cell( slot ).z );
+    EXPECT_EQ( SpatialHashGrid::NO_CELL, grid.find_cell( 2, 0, 0 ) );
+    EXPECT_EQ( SpatialHashGrid::NO_CELL, grid.find_cell( 100, 0, 0 ) );
+    const unsigned diagonal = grid.find_cell( -1, -1, 0 );
+    ASSERT_NE( SpatialHashGrid::NO_CELL, diagonal );
+    EXPECT_EQ( -1, grid.cell( diagonal ).y );
+    EXPECT_EQ( 2u, grid.item( grid.cell( diagonal ).first ).index );
+    EXPECT_THROW( grid.cell( grid.cells_count() ), OutOfBoundsError );
+
+    std::vector<SpherePair> pairs;
+    grid.find_pairs( pairs );
+    pairs = sorted( pairs );
+    ASSERT_EQ( 2u, pairs.size() );
+    EXPECT_TRUE( SpherePair( 0, 1 ) == pairs[0] );
+    EXPECT_TRUE( SpherePair( 0, 2 ) == pairs[1] );
+
+    // rebuilding drops the old cells
+    spheres.clear();
+    grid.rebuild( spheres );
+    EXPECT_EQ( 0u, grid.size() );
+    EXPECT_EQ( SpatialHashGrid::NO_CELL, grid.find_cell( 5, 0, 0 ) );
+    grid.find_pairs( pairs );
+    EXPECT_TRUE( pairs.empty() );
+
+    EXPECT_THROW( SpatialHashGrid( -1 ), InvalidCellSizeError );
+}
+
+TEST(SpatialHashGridTest, AutoCellSize)
+{
+    srand( 16 );
+    MovingSpheres spheres;
+    for( unsigned i = 0; i < 1000; ++i )
+    {
+        const Point start = random_point( 50 );
+        spheres.add( start, start + random_point( 0.5 ), i % 200 == 0 ? 10 : random_double( 0.1, 0.5 ) );
+    }
+    SpatialHashGrid grid;
+    grid.rebuild( spheres );
+    // not smaller than usual boxes, but much smaller than the biggest ones
+    EXPECT_LT( 1.0, grid.cell_size() );
+    EXPECT_GT( 2.1, grid.cell_size() );
+    EXPECT_EQ( 1000u, grid.size() );
+    EXPECT_LE( 5u, grid.large_count() );
+    EXPECT_GT( 20u, grid.large_count() );
+}
+
+TEST(SpatialHashGridTest, SameAsAllPairs)
+{
+    srand( 17 );
+    CollisionBatch batch( 3 );
+    const double cell_sizes[] = { 0, 0.5, 3 };  // automatic, smaller than most boxes, bigger than most of them
+    for( unsigned frame = 0; frame < 6; ++frame )
+    {
+        MovingSpheres spheres;
+        for( unsigned i = 0; i < 500; ++i )
+        {
+            const Point start = random_point( 15 );
+            const Point end = i % 4 == 0 ? start : start + random_point( 1 );
+            // some outliers much bigger than the rest
+            spheres.add( start, end, i % 50 == 0 ? random_double( 2, 8 ) : random_double( 0.1, 1 ) );
+        }
+        const std::vector<SpherePair> expected = all_pairs( spheres );
+        EXPECT_LT( 100u, expected.size() );
+
+        SpatialHashGrid grid( cell_sizes[frame % 3] );
+        std::vector<SpherePair> pairs;
+        grid.rebuild( spheres );
+        grid.find_pairs( pairs );
+        EXPECT_TRUE( expected == sorted( pairs ) );
+        EXPECT_LT( 0u, grid.large_count() );
+
+        // the same with threads
+        grid.rebuild( spheres, batch );
+        grid.find_pairs( pairs, batch );
+        EXPECT_TRUE( expected == sorted( pairs ) );
+    }
+}
+
+TEST(SpatialHashGridTest, FarAway)
+{
+    // cell coordinates of far away spheres are clamped: they share border cells, but pairs are the same
+    srand( 19 );
+    CollisionBatch batch( 2 );
+    MovingSpheres spheres;
+    for( unsigned i = 0; i < 300; ++i )
+    {
+        const Point start = i % 3 == 0 ? 1e12*random_point( 1 ) + random_point( 3 ) : random_point( 10 );
+        spheres.add( start, start + random_point( 1 ), random_double( 0.5, 1 ) );
+    }
+    spheres.add( Point(1e15,0,0), Point(1e15,0,0), 1 );
+    spheres.add( Point(1e15,0,1), Point(1e15,0,1), 1 );
+    const std::vector<SpherePair> expected = all_pairs( spheres );
+
+    SpatialHashGrid grid( 5 );
+    std::vector<SpherePair> pairs;
+    grid.rebuild( spheres );
+    grid.find_pairs( pairs );
+    EXPECT_TRUE( expected == sorted( pairs ) );
+    EXPECT_LT( 0u, pairs.size() );
+    EXPECT_EQ( 0u, grid.large_count() );
+    grid.rebuild( spheres, batch );
+    grid.find_pairs( pairs, batch );
+    EXPECT_TRUE( expected == sorted( pairs ) );
+}
+
+TEST(SpatialHashGridTest, SphereCandidates)
+{
+    srand( 18 );
+    MovingSpheres spheres;
+    for( unsigned i = 0; i < 300; ++i )
+    {
+        const Point start = random_point( 10 );
+        spheres.add( start, start + random_point( 2 ), random_double( 0.1, 1 ) );
+    }
+    SpatialHashGrid grid;
+    grid.rebuild( spheres );
+    std::vector<SpherePair> candidates;
+    grid.find_pairs( candidates );
+    EXPECT_LT( candidates.size(), 300u*299/2/10 );
+
+    // the same hits, as of testing all pairs
+    std::vector<SpherePairHit> hits, expected;
+    sphere_and_sphere_collisions( spheres, sorted( candidates ), hits );
+    sphere_and_sphere_collisions( spheres, expected );
+    ASSERT_EQ( expected.size(), hits.size() );
+    for( unsigned i = 0; i < hits.size(); ++i )
+    {
+        EXPECT_EQ( expected[i].first, hits[i].first );
+        EXPECT_EQ( expected[i].second, hits[i].second );
+        EXPECT_EQ( expected[i].time_of_impact, hits[i].time_of_impact );
+    }
+}
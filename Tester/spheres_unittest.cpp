@@ -0,0 +1,164 @@
+#include "../Collisions/moving_spheres.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    // random spheres in a box of `size', some of them staying in place
+    void add_random_spheres(MovingSpheres &spheres, unsigned count, double size)
+    {
+        for( unsigned i = 0; i < count; ++i )
+        {
+            const Point start = random_point( size );
+            const Point end = i % 5 == 0 ? start : start + random_point( size/4 );
+            spheres.add( start, end, random_double( 0.01, size/10 ) );
+        }
+    }
+
+    // hits of sphere_and_sphere_collision for the pair, or false
+    bool expected_hit(const MovingSpheres &spheres, unsigned first, unsigned second, /*out*/ double &time)
+    {
+        if( spheres.segment_start( first ) == spheres.segment_end( first ) && spheres.segment_start( second ) == spheres.segment_end( second ) )
+        {
+            // both stay in place: not a valid input of the finder
+            time = 0;
+            return less_or_equal( distance( spheres.segment_start( first ), spheres.segment_start( second ) ), spheres.radius( first ) + spheres.radius( second ) );
+        }
+        Point point;
+        return NoThrow::sphere_and_sphere_collision( spheres.segment_start( first ), spheres.segment_end( first ), spheres.radius( first ),
+                                                     spheres.segment_start( second ), spheres.segment_end( second ), spheres.radius( second ),
+                                                     point, time ) == CollisionStatus::Hit;
+    }
+}
+
+// Moving spheres tests
+
+TEST(MovingSpheresTest, Add)
+{
+    MovingSpheres spheres;
+    EXPECT_TRUE( spheres.empty() );
+
+    const unsigned COUNT = MovingSpheres::BLOCK_SIZE + 3;
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        spheres.add( Point(i, 0, 0), Point(i, 1, 0), 0.5 + i );
+    }
+    EXPECT_EQ( COUNT, spheres.size() );
+    EXPECT_EQ( 2u, spheres.blocks_count() );
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        EXPECT_EQ( Point(i, 0, 0), spheres.segment_start( i ) );
+        EXPECT_EQ( Point(i, 1, 0), spheres.segment_end( i ) );
+        EXPECT_EQ( 0.5 + i, spheres.radius( i ) );
+    }
+    // padding is a copy of the last sphere
+    EXPECT_EQ( 0.5 + COUNT - 1, spheres.block( 1 ).radius[MovingSpheres::BLOCK_SIZE - 1] );
+    EXPECT_THROW( spheres.segment_start( COUNT ), OutOfBoundsError );
+    EXPECT_THROW( spheres.block( 2 ), OutOfBoundsError );
+
+    spheres.clear();
+    EXPECT_TRUE( spheres.empty() );
+    EXPECT_EQ( 0u, spheres.blocks_count() );
+}
+
+TEST(MovingSpheresTest, Trivial)
+{
+    MovingSpheres spheres;
+    spheres.add( Point(-3, 0, 0), Point(1, 0, 0), 2 );
+    spheres.add( Point(3, 0, 0), Point(-1, 0, 0), 1 );
+    spheres.add( Point(0, 10, 0), Point(0, 10, 0), 1 );  // far away
+    spheres.add( Point(0, 10, 0), Point(0, 11, 0), 1 );  // intersecting the previous one from the start
+    std::vector<SpherePairHit> hits;
+
+    sphere_and_sphere_collisions( spheres, hits );
+    ASSERT_EQ( 2u, hits.size() );
+    EXPECT_EQ( 0u, hits[0].first );
+    EXPECT_EQ( 1u, hits[0].second );
+    EXPECT_DOUBLE_EQ( 3.0/8, hits[0].time_of_impact );
+    EXPECT_EQ( 2u, hits[1].first );
+    EXPECT_EQ( 3u, hits[1].second );
+    EXPECT_EQ( 0, hits[1].time_of_impact );
+
+    std::vector<SpherePair> pairs;
+    pairs.push_back( SpherePair( 1, 0 ) );
+    pairs.push_back( SpherePair( 0, 2 ) );
+    pairs.push_back( SpherePair( 3, 2 ) );
+    sphere_and_sphere_collisions( spheres, pairs, hits );
+    ASSERT_EQ( 2u, hits.size() );
+    EXPECT_EQ( 1u, hits[0].first );
+    EXPECT_EQ( 0u, hits[0].second );
+    EXPECT_DOUBLE_EQ( 3.0/8, hits[0].time_of_impact );
+    EXPECT_EQ( 3u, hits[1].first );
+    EXPECT_EQ( 2u, hits[1].second );
+
+    pairs.push_back( SpherePair( 0, 4 ) );
+    EXPECT_THROW( sphere_and_sphere_collisions( spheres, pairs, hits ), OutOfBoundsError );
+
+    spheres.clear();
+    sphere_and_sphere_collisions( spheres, hits );
+    EXPECT_TRUE( hits.empty() );
+}
+
+TEST(MovingSpheresTest, AllPairsSameAsFinder)
+{
+    srand( 14 );
+    MovingSpheres spheres;
+    add_random_spheres( spheres, 203, 10 ); // the last block is partial
+    std::vector<SpherePairHit> hits;
+    sphere_and_sphere_collisions( spheres, hits );
+
+    unsigned hit_index = 0;
+    for( unsigned first = 0; first < spheres.size(); ++first )
+    {
+        for( unsigned second = first + 1; second < spheres.size(); ++second )
+        {
+            double time;
+            if( !expected_hit( spheres, first, second, time ) )
+                continue;
+
+            ASSERT_LT( hit_index, hits.size() );
+            EXPECT_EQ( first, hits[hit_index].first );
+            EXPECT_EQ( second, hits[hit_index].second );
+            EXPECT_NEAR( time, hits[hit_index].time_of_impact, 1e-9 );
+            ++hit_index;
+        }
+    }
+    EXPECT_EQ( hit_index, hits.size() );
+    EXPECT_LT( 20u, hit_index );
+}
+
+TEST(MovingSpheresTest, PairsSameAsFinder)
+{
+    srand( 15 );
+    MovingSpheres spheres;
+    add_random_spheres( spheres, 64, 10 );
+    std::vector<SpherePair> pairs;
+    for( unsigned i = 0; i < 1001; ++i )
+    {
+        pairs.push_back( SpherePair( rand() % spheres.size(), rand() % spheres.size() ) );
+    }
+    std::vector<SpherePairHit> hits;
+    sphere_and_sphere_collisions( spheres, pairs, hits );
+
+    unsigned hit_index = 0;
+    for( unsigned i = 0; i < pairs.size(); ++i )
+    {
+        double time;
+        // a sphere always hits itself
+        if( pairs[i].first != pairs[i].second && !expected_hit( spheres, pairs[i].first, pairs[i].second, time ) )
+            continue;
+
+        ASSERT_LT( hit_index, hits.size() );
+        EXPECT_EQ( pairs[i].first, hits[hit_index].first );
+        EXPECT_EQ( pairs[i].second, hits[hit_index].second );
+        if( pairs[i].first != pairs[i].second )
+        {
+            EXPECT_NEAR( time, hits[hit_index].time_of_impact, 1e-9 );
+        }
+        ++hit_index;
+    }
+    EXPECT_EQ( hit_index, hits.size() );
+}
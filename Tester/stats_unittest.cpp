@@ -0,0 +1,109 @@
+#include "../Collisions/collisions.h"
+#include "../Collisions/stats.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+using namespace Collisions;
+
+// Stats tests: counters are checked only if the library is compiled with them
+
+TEST(StatsTest, Names)
+{
+    EXPECT_STREQ( "LineAndPlaneCalls", counter_name( Counter::LineAndPlaneCalls ) );
+    EXPECT_STREQ( "ErrorsThrown", counter_name( Counter::ErrorsThrown ) );
+    EXPECT_STREQ( "Unknown", counter_name( Counter::Count ) );
+}
+
+TEST(StatsTest, TriangleStages)
+{
+    const Triangle triangle( Point(0,0,0), Point(2,4,0), Point(5,0,0) );
+    const double R = 0.5;
+    Point point;
+
+    reset_stats();
+    EXPECT_TRUE(  sphere_and_triangle_collision( Point(2,2,1), Point(2,2,-1), R, triangle, point ) );  // plane
+    EXPECT_TRUE(  sphere_and_triangle_collision( Point(4,-2,0), Point(4,6,0), R, triangle, point ) );  // side
+    EXPECT_TRUE(  sphere_and_triangle_collision( Point(7,-1,0), Point(3,1,0), R, triangle, point ) );  // vertex
+    EXPECT_FALSE( sphere_and_triangle_collision( Point(2,2,1), Point(2,2,2), R, triangle, point ) );   // miss
+    const Stats result = stats();
+
+    if( !stats_enabled() )
+    {
+        for( unsigned i = 0; i < COUNTERS_COUNT; ++i )
+        {
+            EXPECT_EQ( 0u, result.counters[i] );
+        }
+        return;
+    }
+    EXPECT_EQ( 4u, result[Counter::SphereAndTriangleCalls] );
+    EXPECT_EQ( 3u, result[Counter::SphereAndTriangleHits] );
+    EXPECT_EQ( 4u, result[Counter::TriangleKernelCalls] );
+    EXPECT_EQ( 1u, result[Counter::TrianglePlaneRejects] ); // the miss: moving away from the plane
+    EXPECT_EQ( 1u, result[Counter::TrianglePlaneHits] );
+    EXPECT_EQ( 3u, result[Counter::TriangleEdgeTests] ); // only sides, through which the sphere moves inside
+    EXPECT_EQ( 1u, result[Counter::TriangleEdgeHits] );
+    EXPECT_EQ( 1u, result[Counter::TriangleVertexTests] );
+    EXPECT_EQ( 1u, result[Counter::TriangleVertexHits] );
+    EXPECT_EQ( 1u, result[Counter::TriangleMisses] );
+    EXPECT_EQ( 0u, result[Counter::ErrorsThrown] );
+
+    std::ostringstream stream;
+    stream << result;
+    EXPECT_NE( std::string::npos, stream.str().find( "TrianglePlaneHits: 1" ) );
+    EXPECT_EQ( std::string::npos, stream.str().find( "ErrorsThrown" ) );
+}
+
+TEST(StatsTest, Errors)
+{
+    const Point A(1,2,3);
+    Point point;
+
+    reset_stats();
+    EXPECT_THROW( sphere_and_point_collision( A, A, 1, A ), DegeneratedSegmentError );
+    EXPECT_EQ( CollisionStatus::DegenerateSegment, NoThrow::sphere_and_point_collision( A, A, 1, A ) );
+    EXPECT_THROW( Triangle( A, A, A ).normal(), DegeneratedTriangleError );
+    const Stats result = stats();
+
+    if( stats_enabled() )
+    {
+        EXPECT_EQ( 2u, result[Counter::SphereAndPointCalls] );
+        EXPECT_EQ( 0u, result[Counter::SphereAndPointHits] );
+        EXPECT_EQ( 2u, result[Counter::ErrorsThrown] );
+    }
+    else
+    {
+        EXPECT_EQ( 0u, result[Counter::ErrorsThrown] );
+    }
+}
+
+TEST(StatsTest, Threads)
+{
+    const Point A(1,2,3);
+    const unsigned THREADS_COUNT = 4;
+    const unsigned CALLS_COUNT = 1000;
+
+    reset_stats();
+    std::vector<std::thread> threads;
+    for( unsigned i = 0; i < THREADS_COUNT; ++i )
+    {
+        threads.push_back( std::thread( [&]()
+        {
+            for( unsigned j = 0; j < CALLS_COUNT; ++j )
+            {
+                sphere_and_point_collision( A, -A, 1, Point(0,0,0) );
+            }
+        } ) );
+    }
+    for( unsigned i = 0; i < THREADS_COUNT; ++i )
+    {
+        threads[i].join();
+    }
+    // counters of finished threads are kept
+    const Stats result = stats();
+    EXPECT_EQ( stats_enabled() ? THREADS_COUNT*CALLS_COUNT : 0, result[Counter::SphereAndPointCalls] );
+    EXPECT_EQ( stats_enabled() ? THREADS_COUNT*CALLS_COUNT : 0, result[Counter::SphereAndPointHits] );
+
+    reset_stats();
+    EXPECT_EQ( 0u, stats()[Counter::SphereAndPointCalls] );
+}
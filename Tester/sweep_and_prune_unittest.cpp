@@ -0,0 +1,231 @@
+#include "../Collisions/sweep_and_prune.h"
+#include "test_helpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Collisions;
+
+namespace
+{
+    // intersecting pairs of alive objects, found by testing all pairs
+    std::vector<SpherePair> all_pairs(const SweepAndPrune &sap, unsigned max_id, const std::vector<bool> &is_static)
+    {
+        std::vector<SpherePair> result;
+        for( unsigned i = 0; i < max_id; ++i )
+        {
+            for( unsigned j = i + 1; j < max_id; ++j )
+            {
+                if( sap.contains( i ) && sap.contains( j ) && !( is_static[i] && is_static[j] ) && sap.box( i ).intersects( sap.box( j ) ) )
+                {
+                    result.push_back( SpherePair( i, j ) );
+                }
+            }
+        }
+        return result;
+    }
+
+    // pairs of `from', which are not in `what' (both sorted)
+    std::vector<SpherePair> difference(const std::vector<SpherePair> &from, const std::vector<SpherePair> &what)
+    {
+        std::vector<SpherePair> result;
+        std::set_difference( from.begin(), from.end(), what.begin(), what.end(), std::back_inserter( result ) );
+        return result;
+    }
+
+    std::vector<SpherePair> sorted(std::vector<SpherePair> pairs)
+    {
+        std::sort( pairs.begin(), pairs.end() );
+        return pairs;
+    }
+}
+
+// Sweep and prune tests
+
+TEST(SweepAndPruneTest, Trivial)
+{
+    SweepAndPrune sap;
+    EXPECT_TRUE( sap.empty() );
+    const unsigned a = sap.add( BoundingBox( Point(0,0,0), Point(1,1,1) ) );
+    const unsigned b = sap.add( BoundingBox( Point(0.5,0.5,0.5), Point(2,2,2) ) );
+    const unsigned c = sap.add( BoundingBox( Point(3,0,0), Point(4,1,1) ) );
+    EXPECT_EQ( 3u, sap.size() );
+    EXPECT_EQ( 0u, sap.pairs_count() ); // not updated yet
+
+    sap.update_pairs();
+    ASSERT_EQ( 1u, sap.added_pairs().size() );
+    EXPECT_EQ( a, sap.added_pairs()[0].first );
+    EXPECT_EQ( b, sap.added_pairs()[0].second );
+    EXPECT_TRUE( sap.removed_pairs().empty() );
+    EXPECT_TRUE( sap.has_pair( b, a ) );
+    EXPECT_FALSE( sap.has_pair( a, c ) );
+
+    // c touches b, a goes away
+    sap.update_box( c, BoundingBox( Point(2,0,0), Point(4,1,1) ) );
+    sap.update_box( a, BoundingBox( Point(-2,0,0), Point(-1,1,1) ) );
+    sap.update_pairs();
+    ASSERT_EQ( 1u, sap.added_pairs().size() );
+    EXPECT_EQ( b, sap.added_pairs()[0].first );
+    EXPECT_EQ( c, sap.added_pairs()[0].second );
+    ASSERT_EQ( 1u, sap.removed_pairs().size() );
+    EXPECT_EQ( a, sap.removed_pairs()[0].first );
+    EXPECT_EQ( b, sap.removed_pairs()[0].second );
+    EXPECT_EQ( 1u, sap.pairs_count() );
+
+    // nothing changes
+    sap.update_pairs();
+    EXPECT_TRUE( sap.added_pairs().empty() );
+    EXPECT_TRUE( sap.removed_pairs().empty() );
+    // moving away and back between updates
+    sap.update_box( c, BoundingBox( Point(5,0,0), Point(6,1,1) ) );
+    sap.update_box( c, BoundingBox( Point(1.5,0,0), Point(4,1,1) ) );
+    sap.update_pairs();
+    EXPECT_TRUE( sap.added_pairs().empty() );
+    EXPECT_TRUE( sap.removed_pairs().empty() );
+}
+
+TEST(SweepAndPruneTest, Spheres)
+{
+    SweepAndPrune sap;
+    const unsigned a = sap.add( Point(0,0,0), Point(4,0,0), 0.5 );
+    const unsigned b = sap.add( Point(2,2,0), Point(2,1,0), 0.5 ); // box of the way touches the other one
+    const unsigned c = sap.add( Point(2,3,0), Point(2,3,0), 0.5 ); // staying in place
+    sap.update_pairs();
+    EXPECT_TRUE( sap.has_pair( a, b ) );
+    EXPECT_TRUE( sap.has_pair( b, c ) );
+    EXPECT_FALSE( sap.has_pair( a, c ) );
+
+    sap.update_box( c, Point(2,3,0), Point(2,0,0), 0.5 );
+    sap.update_pairs();
+    EXPECT_TRUE( sap.has_pair( a, c ) );
+}
+
+TEST(SweepAndPruneTest, AddAndRemove)
+{
+    SweepAndPrune sap;
+    const BoundingBox box( Point(0,0,0), Point(1,1,1) );
+    const unsigned a = sap.add( box );
+    const unsigned b = sap.add( box );
+    const unsigned c = sap.add( box, true );
+    const unsigned d = sap.add( box, true );
+    sap.update_pairs();
+    EXPECT_EQ( 5u, sap.pairs_count() ); // all but the pair of static ones
+    EXPECT_FALSE( sap.has_pair( c, d ) );
+
+    sap.remove( b );
+    EXPECT_FALSE( sap.contains( b ) );
+    EXPECT_EQ( 3u, sap.size() );
+    EXPECT_EQ( 2u, sap.pairs_count() );
+    // the id is not reused before update, so that its removed pairs are not mixed with the new ones
+    const unsigned e = sap.add( box );
+    EXPECT_NE( b, e );
+    sap.update_pairs();
+    EXPECT_EQ( 3u, sap.removed_pairs().size() );
+    EXPECT_EQ( 3u, sap.added_pairs().size() );
+    EXPECT_TRUE( sap.has_pair( a, e ) );
+    // ... and reused after it
+    EXPECT_EQ( b, sap.add( box ) );
+    sap.update_pairs();
+    EXPECT_EQ( 4u, sap.added_pairs().size() );
+
+    EXPECT_THROW( sap.remove( 100 ), OutOfBoundsError );
+    EXPECT_THROW( sap.update_box( 100, box ), OutOfBoundsError );
+    EXPECT_THROW( sap.add( BoundingBox() ), EmptyBoxError );
+    EXPECT_THROW( sap.update_box( a, BoundingBox() ), EmptyBoxError );
+}
+
+TEST(SweepAndPruneTest, SameAsAllPairs)
+{
+    srand( 15 );
+    const unsigned COUNT = 300;
+    SweepAndPrune sap;
+    std::vector<Point> positions;
+    std::vector<bool> is_static;
+    for( unsigned i = 0; i < COUNT; ++i )
+    {
+        positions.push_back( random_point( 20 ) );
+        is_static.push_back( i % 10 == 0 );
+        sap.add( bounding_box( positions[i], positions[i], random_double( 0.5, 2 ) ), is_static[i] );
+    }
+
+    std::vector<SpherePair> previous;
+    for( unsigned frame = 0; frame < 20; ++frame )
+    {
+        for( unsigned i = 0; i < positions.size(); ++i )
+        {
+            if( !sap.contains( i ) || is_static[i] )
+                continue;
+            const Point next = positions[i] + random_point( 1 );
+            sap.update_box( i, positions[i], next, 1 );
+            positions[i] = next;
+        }
+        // some objects leave and come back
+        const unsigned leaving = rand() % COUNT;
+        if( sap.contains( leaving ) )
+        {
+            sap.remove( leaving );
+        }
+        if( frame % 3 == 0 )
+        {
+            const Point position = random_point( 20 );
+            const unsigned id = sap.add( position, position, 1 );
+            if( id == positions.size() )
+            {
+                positions.push_back( position );
+                is_static.push_back( false );
+            }
+            positions[id] = position;
+            is_static[id] = false;
+        }
+        sap.update_pairs();
+
+        std::vector<SpherePair> pairs;
+        sap.get_pairs( pairs );
+        const std::vector<SpherePair> expected = all_pairs( sap, static_cast<unsigned>( positions.size() ), is_static );
+        ASSERT_EQ( expected.size(), pairs.size() );
+        EXPECT_TRUE( std::equal( expected.begin(), expected.end(), pairs.begin() ) );
+        EXPECT_TRUE( sorted( sap.added_pairs() ) == difference( expected, previous ) );
+        EXPECT_TRUE( sorted( sap.removed_pairs() ) == difference( previous, expected ) );
+        previous = expected;
+
+        // ends are sorted
+        for( unsigned axis = 0; axis < 3; ++axis )
+        {
+            for( unsigned i = 1; i < 2*sap.size(); ++i )
+            {
+                EXPECT_LE( sap.endpoint( axis, i - 1 ).value, sap.endpoint( axis, i ).value );
+            }
+        }
+    }
+}
+
+TEST(SweepAndPruneTest, SphereCandidates)
+{
+    srand( 16 );
+    MovingSpheres spheres;
+    SweepAndPrune sap;
+    for( unsigned i = 0; i < 200; ++i )
+    {
+        const Point start = random_point( 10 );
+        const Point end = start + random_point( 2 );
+        const double radius = random_double( 0.1, 1 );
+        spheres.add( start, end, radius );
+        EXPECT_EQ( i, sap.add( start, end, radius ) );
+    }
+    sap.update_pairs();
+
+    // the same hits, as of testing all pairs
+    std::vector<SpherePair> candidates;
+    sap.get_pairs( candidates );
+    EXPECT_LT( candidates.size(), 200u*199/2/10 );
+    std::vector<SpherePairHit> hits, expected;
+    sphere_and_sphere_collisions( spheres, candidates, hits );
+    sphere_and_sphere_collisions( spheres, expected );
+    ASSERT_EQ( expected.size(), hits.size() );
+    for( unsigned i = 0; i < hits.size(); ++i )
+    {
+        EXPECT_EQ( expected[i].first, hits[i].first );
+        EXPECT_EQ( expected[i].second, hits[i].second );
+        EXPECT_EQ( expected[i].time_of_impact, hits[i].time_of_impact );
+    }
+}
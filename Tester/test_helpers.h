@@ -0,0 +1,29 @@
+#pragma once
+#include "../Collisions/collisions.h"
+#include <cstdlib>
+#include <vector>
+
+// Random input shared by the unit tests. It is made by rand(), so tests call srand before using it
+// when they need the same input on every run.
+
+inline double random_double(double from, double to)
+{
+    return from + (to - from)*rand()/RAND_MAX;
+}
+
+inline Collisions::Point random_point(double size)
+{
+    return Collisions::Point( random_double(-size, size), random_double(-size, size), random_double(-size, size) );
+}
+
+// `count' small triangles, scattered in a cube
+inline std::vector<Collisions::Triangle> random_mesh(unsigned count, double size)
+{
+    std::vector<Collisions::Triangle> triangles;
+    for( unsigned i = 0; i < count; ++i )
+    {
+        const Collisions::Point center = random_point(size);
+        triangles.push_back( Collisions::Triangle( center + random_point(1), center + random_point(1), center + random_point(1) ) );
+    }
+    return triangles;
+}
@@ -139,6 +139,26 @@ TEST(PointTest, Divide)
     EXPECT_EQ( p3, p1/d );
 }
 
+TEST(PointTest, Float)
+{
+    const PointF A( 1, 2, 3 );
+    EXPECT_EQ( PointF( 2, 4, 6 ), 2*A );
+    EXPECT_EQ( PointF( 0, 0, 0 ), A - A );
+    EXPECT_FLOAT_EQ( 14, A*A );
+    EXPECT_EQ( PointF( -3, 6, -3 ), cross_product( A, PointF( 4, 5, 6 ) ) );
+
+    // precisions are converted explicitly
+    const Point B( A );
+    EXPECT_EQ( Point( 1, 2, 3 ), B );
+    EXPECT_EQ( A, PointF( B ) );
+
+    // floats are compared with their own tolerance
+    EXPECT_EQ( A, PointF( 1, 2, 3.000001f ) );
+    EXPECT_NE( B, Point( 1, 2, 3.000001 ) );
+    EXPECT_TRUE( VectorF( 0, 1e-6f, 0 ).is_zero() );
+    EXPECT_FALSE( Vector( 0, 1e-6, 0 ).is_zero() );
+}
+
 TEST(PointTest, ScalarMultiply)
 {
     const double a = 2, b = 3, c = 4.8;
@@ -286,3 +306,71 @@ TEST(TriangleTest, BlackTest)
     EXPECT_THROW( triangle.normal(), DegeneratedTriangleError );
 }
 
+TEST(TriangleTest, IsDegenerated)
+{
+    EXPECT_TRUE( Triangle( Point(1,2,3), Point(2,3,4), Point(3,4,5) ).is_degenerated() );
+    EXPECT_TRUE( Triangle( Point(1,2,3), Point(1,2,3), Point(3,4,5) ).is_degenerated() );
+    EXPECT_FALSE( Triangle( Point(0,0,0), Point(1,2,0), Point(3,0,0) ).is_degenerated() );
+}
+
+
+// Prepared triangle class tests
+
+TEST(PreparedTriangleTest, Creation)
+{
+    const Point A(1,2,3), B(2,3,4), C(3,3,3);
+    const PreparedTriangle triangle(A, B, C);
+
+    EXPECT_EQ(A, triangle[0]);
+    EXPECT_EQ(B, triangle[1]);
+    EXPECT_EQ(C, triangle[2]);
+    EXPECT_EQ(B - A, triangle.side(0));
+    EXPECT_EQ(C - B, triangle.side(1));
+    EXPECT_EQ(A - C, triangle.side(2));
+}
+
+TEST(PreparedTriangleTest, SameAsTriangle)
+{
+    const Triangle triangle( Point(0,0,0), Point(1,2,0), Point(3,0,0) );
+    const PreparedTriangle prepared( triangle );
+
+    EXPECT_EQ( triangle.normal(), prepared.normal() );
+    for( unsigned i = 0; i < 3; ++i )
+    {
+        EXPECT_EQ( triangle.side_outer_normal(i), prepared.side_outer_normal(i) );
+    }
+}
+
+TEST(PreparedTriangleTest, PlaneOffset)
+{
+    const PreparedTriangle triangle( Point(1,0,0), Point(0,0,1), Point(0,1,0) );
+
+    EXPECT_DOUBLE_EQ( 1/sqrt(3.0), triangle.plane_offset() );
+    EXPECT_TRUE( equal( triangle.plane_offset(), triangle.normal()*Point(1.0/3, 1.0/3, 1.0/3) ) );
+}
+
+TEST(PreparedTriangleTest, Barycentric)
+{
+    const PreparedTriangle triangle( Point(1,1,1), Point(3,1,1), Point(1,5,1) );
+    double ru, rv;
+
+    triangle.barycentric( Point(2,3,1), ru, rv );
+    EXPECT_DOUBLE_EQ( 0.5, ru );
+    EXPECT_DOUBLE_EQ( 0.5, rv );
+
+    triangle.barycentric( Point(1,1,7), ru, rv ); // projection is used
+    EXPECT_TRUE( equal( 0, ru ) );
+    EXPECT_TRUE( equal( 0, rv ) );
+}
+
+TEST(PreparedTriangleTest, BlackTest)
+{
+    const Point A(1,2,3), B(2,3,4), C(3,4,5);
+    const PreparedTriangle triangle( Point(0,0,0), Point(1,2,0), Point(3,0,0) );
+
+    EXPECT_THROW( PreparedTriangle(A, B, C), DegeneratedTriangleError );
+    EXPECT_THROW( PreparedTriangle(A, A, A), DegeneratedTriangleError );
+    EXPECT_THROW( triangle[3], OutOfBoundsError );
+    EXPECT_THROW( triangle.side(3), OutOfBoundsError );
+    EXPECT_THROW( triangle.side_outer_normal(3), OutOfBoundsError );
+}